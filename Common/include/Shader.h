@@ -51,9 +51,18 @@ public:
 		{
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 		}
-		const GLchar* vShaderCode = vertexCode.c_str();
-		const GLchar * fShaderCode = fragmentCode.c_str();
-		// 2. Compile shaders
+		compile(vertexCode.c_str(), fragmentCode.c_str());
+	}
+	// Builds the program from source code that is already in memory (e.g. read from an asset pack)
+	static Shader fromSource(const std::string& vertexCode, const std::string& fragmentCode)
+	{
+		Shader shader;
+		shader.compile(vertexCode.c_str(), fragmentCode.c_str());
+		return shader;
+	}
+	// 2. Compile shaders
+	void compile(const GLchar* vShaderCode, const GLchar* fShaderCode)
+	{
 		GLuint vertex, fragment;
 		GLint success;
 		GLchar infoLog[512];
@@ -102,34 +111,68 @@ public:
 		glUseProgram(this->ID);
 	}
 
-	void setBool(const std::string& name, bool value) const
+	// The const char* overloads avoid building a std::string for every call with a literal (several per object per frame)
+	void setBool(const char* name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), (int)value);
+		glUniform1i(glGetUniformLocation(this->ID, name), (int)value);
 	}
 	// ------------------------------------------------------------------------
-	void setInt(const std::string& name, int value) const
+	void setInt(const char* name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), value);
+		glUniform1i(glGetUniformLocation(this->ID, name), value);
 	}
 	// ------------------------------------------------------------------------
-	void setFloat(const std::string& name, float value) const
+	void setFloat(const char* name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(this->ID, name.c_str()), value);
+		glUniform1f(glGetUniformLocation(this->ID, name), value);
 	}
 	// ------------------------------------------------------------------------
+	void setVec3(const char* name, float v1, float v2, float v3) const
+	{
+		glUniform3f(glGetUniformLocation(this->ID, name), v1, v2, v3);
+	}
+
+	void setVec4(const char* name, float v1, float v2, float v3, float v4) const
+	{
+		glUniform4f(glGetUniformLocation(this->ID, name), v1, v2, v3,v4);
+	}
+
+	void setMat4(const char* name, float *v) const
+	{
+		glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, GL_FALSE, v);
+	}
+	// ------------------------------------------------------------------------
+	void setBool(const std::string& name, bool value) const
+	{
+		setBool(name.c_str(), value);
+	}
+
+	void setInt(const std::string& name, int value) const
+	{
+		setInt(name.c_str(), value);
+	}
+
+	void setFloat(const std::string& name, float value) const
+	{
+		setFloat(name.c_str(), value);
+	}
+
 	void setVec3(const std::string& name, float v1, float v2, float v3) const
 	{
-		glUniform3f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3);
+		setVec3(name.c_str(), v1, v2, v3);
 	}
 
 	void setVec4(const std::string& name, float v1, float v2, float v3, float v4) const
 	{
-		glUniform4f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3,v4);
+		setVec4(name.c_str(), v1, v2, v3, v4);
 	}
 
 	void setMat4(const std::string& name, float *v) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(this->ID, name.c_str()), 1, GL_FALSE, v);
+		setMat4(name.c_str(), v);
 	}
+
+private:
+	Shader() : ID(0) {}
 };
 
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+// Contadores de uma thread (s ela escreve; os outros s leem)
+struct AllocationCounters {
+	atomic<uint64_t> allocations{ 0 }, bytes{ 0 };
+	atomic<bool> frameThread{ false };
+};
+
+// Contagem das alocaes do heap (operator new), por thread. Os operadores globais que chamam onAllocate so
+// definidos em Origem.cpp; sem eles tudo fica em zero. Nada aqui aloca: cada thread ganha na
+// primeira alocao uma posio de uma tabela fixa, e as threads que fazem o quadro (principal, simulao e
+// JobSystem) se marcam com markFrameThread para entrar na soma por quadro.
+class AllocationTracker
+{
+public:
+	static const int maxThreads = 128;
+
+	static void onAllocate(size_t size) {
+		AllocationCounters* counters = getCounters();
+		if (counters == nullptr)
+			return;
+		counters->allocations.store(counters->allocations.load(memory_order_relaxed) + 1, memory_order_relaxed);
+		counters->bytes.store(counters->bytes.load(memory_order_relaxed) + size, memory_order_relaxed);
+	}
+
+	static void markFrameThread() {
+		AllocationCounters* counters = getCounters();
+		if (counters != nullptr)
+			counters->frameThread = true;
+	}
+
+	// Alocaes da thread que chama desde o incio (para medir um trecho pela diferena)
+	static uint64_t getThreadAllocations() {
+		AllocationCounters* counters = getCounters();
+		return counters != nullptr ? counters->allocations.load(memory_order_relaxed) : 0;
+	}
+
+	static uint64_t getThreadBytes() {
+		AllocationCounters* counters = getCounters();
+		return counters != nullptr ? counters->bytes.load(memory_order_relaxed) : 0;
+	}
+
+	// Soma das threads do quadro desde o incio
+	static void getFrameTotals(uint64_t& allocations, uint64_t& bytes) {
+		allocations = bytes = 0;
+		int count = std::min(nextSlot.load(memory_order_acquire), maxThreads);
+		for (int i = 0; i < count; ++i)
+			if (slots[i].frameThread.load(memory_order_relaxed)) {
+				allocations += slots[i].allocations.load(memory_order_relaxed);
+				bytes += slots[i].bytes.load(memory_order_relaxed);
+			}
+	}
+
+	// Maior memria residente do processo at agora, em bytes (0 se o sistema no informa)
+	static size_t getPeakResidentBytes() {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return counters.PeakWorkingSetSize;
+		return 0;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0;
+		// Em KB no Linux
+		return (size_t)usage.ru_maxrss * 1024;
+#endif
+	}
+
+private:
+	inline static AllocationCounters slots[maxThreads];
+	inline static atomic<int> nextSlot{ 0 };
+	inline static thread_local int slot = -1;
+
+	// nullptr quando a tabela acabou (as threads a mais no so contadas)
+	static AllocationCounters* getCounters() {
+		if (slot < 0)
+			slot = nextSlot.fetch_add(1, memory_order_acq_rel);
+		return slot < maxThreads ? &slots[slot] : nullptr;
+	}
+};
\ No newline at end of file
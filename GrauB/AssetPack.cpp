@@ -0,0 +1,296 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
+#include "MappedFile.cpp"
+#include "LZ4.cpp"
+
+using namespace std;
+
+// Pacote de assets em um nico arquivo (.pak), lido mapeado em memria:
+//   cabealho (32 bytes): "GBPK", verso, nmero de entradas, nmero de posies do ndice, deslocamentos do ndice e dos nomes
+//   ndice de hash: posies de 16 bytes (hash FNV-1a de 64 bits do caminho, entrada + 1 ou 0 se vazia), sondagem linear
+//   entradas de 40 bytes: deslocamento e tamanho dos dados gravados, tamanho original, nome (deslocamento, tamanho) e flags
+//   nomes dos caminhos e, por fim, os dados de cada arquivo alinhados em 16 bytes (comprimidos em LZ4 ou no)
+class AssetPack
+{
+public:
+	static const uint32_t version = 1;
+	static const uint32_t flagLZ4 = 1;
+
+	bool open(const string& filepath) {
+		entryCount = 0;
+		if (!file.open(filepath))
+			return false;
+		if (file.size() < headerSize || memcmp(file.data(), magic, 4) != 0) {
+			std::cerr << "Pacote de assets invlido: " << filepath << std::endl;
+			file.close();
+			return false;
+		}
+
+		uint32_t header[4];
+		uint64_t offsets[2];
+		memcpy(header, file.data(), sizeof(header));
+		memcpy(offsets, file.data() + 16, sizeof(offsets));
+		if (header[1] != version) {
+			std::cerr << "Verso do pacote de assets no suportada (" << header[1] << "): " << filepath << std::endl;
+			file.close();
+			return false;
+		}
+
+		uint32_t count = header[2], slots = header[3];
+		uint64_t indexEnd = offsets[0] + (uint64_t)slots * slotSize + (uint64_t)count * entrySize;
+		if (slots == 0 || (slots & (slots - 1)) != 0 || count > slots || indexEnd > file.size() || offsets[1] > file.size() || offsets[1] < indexEnd) {
+			std::cerr << "ndice do pacote de assets corrompido: " << filepath << std::endl;
+			file.close();
+			return false;
+		}
+
+		slotCount = slots;
+		slotTable = file.data() + offsets[0];
+		entryTable = slotTable + (size_t)slots * slotSize;
+		strings = file.data() + offsets[1];
+		stringsSize = file.size() - offsets[1];
+		entryCount = count;
+
+		// Confere os limites de todas as entradas uma vez, para que as consultas no precisem
+		for (uint32_t i = 0; i < entryCount; ++i) {
+			Entry entry = getEntry(i);
+			if (entry.dataOffset > file.size() || entry.storedSize > file.size() - entry.dataOffset ||
+				entry.pathOffset > stringsSize || entry.pathLength > stringsSize - entry.pathOffset ||
+				(!(entry.flags & flagLZ4) && entry.storedSize != entry.size)) {
+				std::cerr << "Entrada " << i << " do pacote de assets corrompida: " << filepath << std::endl;
+				entryCount = 0;
+				file.close();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool isOpen() const {
+		return entryCount > 0;
+	}
+
+	int size() const {
+		return (int)entryCount;
+	}
+
+	// ndice da entrada com este caminho (j normalizado) ou -1
+	int find(const string& path) const {
+		if (entryCount == 0)
+			return -1;
+		uint64_t hash = hashPath(path);
+		for (uint32_t probe = 0; probe < slotCount; ++probe) {
+			const unsigned char* slot = slotTable + (size_t)((hash + probe) & (slotCount - 1)) * slotSize;
+			uint64_t slotHash;
+			uint32_t slotEntry;
+			memcpy(&slotHash, slot, 8);
+			memcpy(&slotEntry, slot + 8, 4);
+			if (slotEntry == 0)
+				return -1;
+			if (slotHash == hash && slotEntry <= entryCount && getPath(slotEntry - 1) == path)
+				return (int)slotEntry - 1;
+		}
+		return -1;
+	}
+
+	string getPath(int index) const {
+		Entry entry = getEntry(index);
+		return string((const char*)strings + entry.pathOffset, entry.pathLength);
+	}
+
+	bool isCompressed(int index) const {
+		return (getEntry(index).flags & flagLZ4) != 0;
+	}
+
+	// Bytes como esto no pacote (comprimidos ou no); aponta direto para a memria mapeada
+	const unsigned char* getStoredData(int index) const {
+		return file.data() + getEntry(index).dataOffset;
+	}
+
+	size_t getStoredSize(int index) const {
+		return (size_t)getEntry(index).storedSize;
+	}
+
+	// Tamanho original do arquivo
+	size_t getSize(int index) const {
+		return (size_t)getEntry(index).size;
+	}
+
+	bool decompress(int index, vector<unsigned char>& output) const {
+		output.resize(getSize(index));
+		if (!LZ4::decompress(getStoredData(index), getStoredSize(index), output.data(), output.size())) {
+			std::cerr << "Entrada comprimida invlida no pacote de assets: " << getPath(index) << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// Barras normais, sem "./" e com "pasta/.." resolvido, para que o mesmo arquivo tenha sempre o mesmo nome.
+	// Caminhos absolutos mantm a raiz ("/" ou "C:/"), e um ".." na raiz  descartado.
+	static string normalizePath(const string& path) {
+		vector<string> parts;
+		string normalized = path;
+		for (char& c : normalized)
+			if (c == '\\')
+				c = '/';
+
+		string root;
+		if (normalized.size() >= 2 && normalized[1] == ':' && isalpha((unsigned char)normalized[0]))
+			root = normalized.substr(0, 2);
+		if (normalized.size() > root.size() && normalized[root.size()] == '/')
+			root += '/';
+		bool absolute = !root.empty() && root.back() == '/';
+
+		size_t start = root.size();
+		while (start <= normalized.size()) {
+			size_t end = normalized.find('/', start);
+			if (end == string::npos)
+				end = normalized.size();
+			string part = normalized.substr(start, end - start);
+			if (part == "..") {
+				if (!parts.empty() && parts.back() != "..")
+					parts.pop_back();
+				else if (!absolute)
+					parts.push_back(part);
+			}
+			else if (!part.empty() && part != ".")
+				parts.push_back(part);
+			start = end + 1;
+		}
+
+		string result = root;
+		for (size_t i = 0; i < parts.size(); ++i)
+			result += (i == 0 ? "" : "/") + parts[i];
+		return result;
+	}
+
+	// Grava o pacote com os arquivos (nome dentro do pacote, caminho no disco). Arquivos que o LZ4 reduz
+	// em pelo menos 10% so gravados comprimidos; os demais (JPG, KTX2...) ficam como esto, para leitura sem cpia.
+	static bool write(const string& packPath, const vector<pair<string, string>>& files) {
+		uint32_t count = (uint32_t)files.size();
+		uint32_t slots = 1;
+		while (slots < count * 2)
+			slots *= 2;
+
+		vector<vector<unsigned char>> stored(count);
+		vector<uint64_t> sizes(count);
+		vector<uint32_t> flags(count, 0);
+		string names;
+		vector<uint32_t> nameOffsets(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			MappedFile source(files[i].second);
+			if (!source.isOpen())
+				return false;
+			sizes[i] = source.size();
+			vector<unsigned char> compressed = LZ4::compress(source.data(), source.size());
+			if (compressed.size() * 10 <= source.size() * 9) {
+				stored[i] = std::move(compressed);
+				flags[i] = flagLZ4;
+			}
+			else {
+				stored[i].assign(source.data(), source.data() + source.size());
+			}
+			nameOffsets[i] = (uint32_t)names.size();
+			names += normalizePath(files[i].first);
+		}
+
+		uint64_t indexOffset = headerSize;
+		uint64_t stringsOffset = indexOffset + (uint64_t)slots * slotSize + (uint64_t)count * entrySize;
+		uint64_t dataOffset = align(stringsOffset + names.size());
+
+		vector<unsigned char> index((size_t)(stringsOffset - indexOffset), 0);
+		vector<uint64_t> dataOffsets(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			string path = normalizePath(files[i].first);
+			uint64_t hash = hashPath(path);
+			uint32_t slot = (uint32_t)(hash & (slots - 1));
+			while (true) {
+				uint32_t used;
+				memcpy(&used, index.data() + (size_t)slot * slotSize + 8, 4);
+				if (used == 0)
+					break;
+				slot = (slot + 1) & (slots - 1);
+			}
+			uint32_t entryNumber = i + 1;
+			memcpy(index.data() + (size_t)slot * slotSize, &hash, 8);
+			memcpy(index.data() + (size_t)slot * slotSize + 8, &entryNumber, 4);
+
+			dataOffsets[i] = dataOffset;
+			uint64_t entry[3] = { dataOffset, stored[i].size(), sizes[i] };
+			uint32_t name[4] = { nameOffsets[i], (uint32_t)path.size(), flags[i], 0 };
+			unsigned char* target = index.data() + (size_t)slots * slotSize + (size_t)i * entrySize;
+			memcpy(target, entry, sizeof(entry));
+			memcpy(target + sizeof(entry), name, sizeof(name));
+			dataOffset = align(dataOffset + stored[i].size());
+		}
+
+		std::ofstream output(packPath, std::ios::binary);
+		if (!output.is_open()) {
+			std::cerr << "Erro ao criar o pacote de assets: " << packPath << std::endl;
+			return false;
+		}
+		uint32_t header[4] = { 0, version, count, slots };
+		memcpy(header, magic, 4);
+		uint64_t offsets[2] = { indexOffset, stringsOffset };
+		output.write((const char*)header, sizeof(header));
+		output.write((const char*)offsets, sizeof(offsets));
+		output.write((const char*)index.data(), index.size());
+		output.write(names.data(), names.size());
+
+		uint64_t position = stringsOffset + names.size();
+		const char padding[16] = {};
+		for (uint32_t i = 0; i < count; ++i) {
+			output.write(padding, (std::streamsize)(dataOffsets[i] - position));
+			output.write((const char*)stored[i].data(), stored[i].size());
+			position = dataOffsets[i] + stored[i].size();
+		}
+		return output.good();
+	}
+
+private:
+	static constexpr char magic[4] = { 'G', 'B', 'P', 'K' };
+	static const size_t headerSize = 32, slotSize = 16, entrySize = 40;
+
+	struct Entry {
+		uint64_t dataOffset, storedSize, size;
+		uint32_t pathOffset, pathLength, flags;
+	};
+
+	MappedFile file;
+	uint32_t entryCount = 0, slotCount = 0;
+	const unsigned char* slotTable = nullptr;
+	const unsigned char* entryTable = nullptr;
+	const unsigned char* strings = nullptr;
+	size_t stringsSize = 0;
+
+	Entry getEntry(int index) const {
+		Entry entry;
+		const unsigned char* source = entryTable + (size_t)index * entrySize;
+		memcpy(&entry.dataOffset, source, 8);
+		memcpy(&entry.storedSize, source + 8, 8);
+		memcpy(&entry.size, source + 16, 8);
+		memcpy(&entry.pathOffset, source + 24, 4);
+		memcpy(&entry.pathLength, source + 28, 4);
+		memcpy(&entry.flags, source + 32, 4);
+		return entry;
+	}
+
+	static uint64_t hashPath(const string& path) {
+		uint64_t hash = 14695981039346656037ull;
+		for (unsigned char c : path) {
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static uint64_t align(uint64_t offset) {
+		return (offset + 15) & ~(uint64_t)15;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,152 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <filesystem>
+#include "AssetPack.cpp"
+#include "MeshLoader.cpp"
+#include "MaterialLibrary.cpp"
+#include "SceneCompiler.cpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+// Ferramenta que junta os assets de uma cena num pacote: GrauB --pack [Scene.json] [Assets.pak].
+// Entram o JSON da cena e a verso compilada dela, os shaders, as malhas, os MTL, as texturas e os caches KTX2 que j existirem para elas.
+class AssetPacker
+{
+public:
+	static int run(int argc, char** argv) {
+		string scenePath = argc > 0 ? argv[0] : "Scene.json";
+		string packPath = argc > 1 ? argv[1] : "Assets.pak";
+
+		// A cena vai compilada para o pacote, para que a carga no precise analisar o JSON
+		vector<unsigned char> image;
+		if (!SceneCompiler::compileFile(scenePath, image) || !SceneCompiler::write(SceneCompiler::getCachePath(scenePath), image))
+			return -1;
+
+		vector<string> files = collectSceneAssets(scenePath);
+		if (files.empty())
+			return -1;
+
+		vector<pair<string, string>> entries;
+		size_t looseBytes = 0;
+		for (const auto& file : files) {
+			entries.push_back({ file, file });
+			looseBytes += (size_t)std::filesystem::file_size(file);
+		}
+		if (!AssetPack::write(packPath, entries))
+			return -1;
+
+		std::cout << packPath << ": " << files.size() << " arquivos, " << looseBytes / 1048576.0 << " MB -> "
+			<< std::filesystem::file_size(packPath) / 1048576.0 << " MB" << std::endl;
+		return 0;
+	}
+
+	// Arquivos que a cena l na carga, na ordem em que so usados, sem repeties
+	static vector<string> collectSceneAssets(const string& scenePath) {
+		vector<string> files;
+		set<string> added;
+		auto add = [&](const string& path) {
+			if (path.empty() || !added.insert(AssetPack::normalizePath(path)).second)
+				return;
+			std::error_code error;
+			if (std::filesystem::is_regular_file(path, error))
+				files.push_back(path);
+			else
+				std::cerr << "Asset no encontrado, fica fora do pacote: " << path << std::endl;
+		};
+
+		json scene;
+		try {
+			std::ifstream file(scenePath);
+			if (!file.is_open()) {
+				std::cerr << "No foi possvel abrir o arquivo JSON: " << scenePath << std::endl;
+				return {};
+			}
+			file >> scene;
+		}
+		catch (const json::exception& e) {
+			std::cerr << "Erro ao ler a cena " << scenePath << ": " << e.what() << std::endl;
+			return {};
+		}
+
+		add(scenePath);
+		if (std::filesystem::exists(SceneCompiler::getCachePath(scenePath)))
+			add(SceneCompiler::getCachePath(scenePath));
+		add("VShader.vs");
+		add("FShader.fs");
+		for (const auto& obj : scene.value("objects", json::array())) {
+			// Uma primitiva no tem arquivo de malha, s o MTL
+			string materialFileName;
+			if (obj.contains("primitive")) {
+				materialFileName = obj["primitive"].value("material", "");
+			}
+			else {
+				string meshPath = obj.value("objFilePath", "");
+				add(meshPath);
+				string extension = MeshLoader::getExtension(meshPath);
+				if (extension == "glb" || extension == "gltf") {
+					addGLTFDependencies(meshPath, add);
+					continue;
+				}
+
+				vector<GLfloat> vbuffer;
+				vector<MaterialRange> materialRanges;
+				if (!MeshLoader::readMeshFile(meshPath, vbuffer, materialFileName, materialRanges))
+					continue;
+			}
+			if (materialFileName.empty())
+				continue;
+			add(materialFileName);
+			for (const auto& texture : MaterialLibrary::load(materialFileName)->diffuseMaps) {
+				add(texture);
+				for (const auto& cache : findTextureCaches(texture))
+					add(cache);
+			}
+		}
+		return files;
+	}
+
+private:
+	// Caches KTX2 gerados para a textura ("Terra.jpg.bc1.ktx2", "Terra.jpg.2048x1024.bc1.ktx2"...)
+	static vector<string> findTextureCaches(const string& texture) {
+		vector<string> caches;
+		std::error_code error;
+		std::filesystem::path texturePath(texture);
+		std::filesystem::path directory = texturePath.has_parent_path() ? texturePath.parent_path() : std::filesystem::path(".");
+		string prefix = texturePath.filename().string() + ".";
+		for (const auto& item : std::filesystem::directory_iterator(directory, error)) {
+			string name = item.path().filename().string();
+			if (name.size() > prefix.size() + 5 && name.compare(0, prefix.size(), prefix) == 0 && name.compare(name.size() - 5, 5, ".ktx2") == 0)
+				caches.push_back(texturePath.has_parent_path() ? (directory / name).generic_string() : name);
+		}
+		std::sort(caches.begin(), caches.end());
+		return caches;
+	}
+
+	// Arquivos externos de um .gltf (buffers .bin e imagens); um GLB costuma ter tudo dentro dele
+	template <typename AddFunction>
+	static void addGLTFDependencies(const string& path, AddFunction& add) {
+		if (MeshLoader::getExtension(path) != "gltf")
+			return;
+		json document;
+		try {
+			std::ifstream file(path);
+			file >> document;
+		}
+		catch (const json::exception&) {
+			return;
+		}
+		string directory = std::filesystem::path(path).has_parent_path() ? std::filesystem::path(path).parent_path().generic_string() + "/" : "";
+		for (const char* list : { "buffers", "images" })
+			for (const auto& item : document.value(list, json::array())) {
+				string uri = item.value("uri", "");
+				if (!uri.empty() && uri.rfind("data:", 0) != 0)
+					add(directory + uri);
+			}
+	}
+};
\ No newline at end of file
@@ -0,0 +1,1549 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+#include <memory_resource>
+#include <thread>
+#include "MeshLoader.cpp"
+#include "MappedFile.cpp"
+#include "GLTFLoader.cpp"
+#include "TextureLoader.cpp"
+#include "AssetPacker.cpp"
+#include "SceneCompiler.cpp"
+#include "SceneLoader.cpp"
+#include "JobSystem.cpp"
+#include "Profiler.cpp"
+#include "LinearArena.cpp"
+#include "AllocationTracker.cpp"
+#include "NBody.cpp"
+#include "KeplerOrbits.cpp"
+#include "ParticleSystem.cpp"
+#include "Primitives.cpp"
+#include "ImpostorRenderer.cpp"
+#include "ClusteredLights.cpp"
+#include "ShadowMap.cpp"
+#include <GLFW/glfw3.h>
+
+using namespace std;
+
+// Modos de benchmark executados pela linha de comando: GrauB --bench <modo> [argumentos]
+class Benchmark
+{
+public:
+	static int run(int argc, char** argv) {
+		string mode = argc > 0 ? argv[0] : "";
+		vector<string> args(argv + (argc > 0 ? 1 : 0), argv + argc);
+
+		if (mode == "loaders")
+			return benchmarkLoaders(args);
+		if (mode == "gltf")
+			return benchmarkGLTF(args);
+		if (mode == "textures")
+			return benchmarkTextures(args);
+		if (mode == "upload")
+			return benchmarkUpload(args);
+		if (mode == "residency")
+			return benchmarkResidency(args);
+		if (mode == "pack")
+			return benchmarkPack(args);
+		if (mode == "scene")
+			return benchmarkScene(args);
+		if (mode == "load")
+			return benchmarkLoad(args);
+		if (mode == "jobs")
+			return benchmarkJobs(args);
+		if (mode == "profiler")
+			return benchmarkProfiler(args);
+		if (mode == "arena")
+			return benchmarkArena(args);
+		if (mode == "nbody")
+			return benchmarkNBody(args);
+		if (mode == "kepler")
+			return benchmarkKepler(args);
+		if (mode == "particles")
+			return benchmarkParticles(args);
+		if (mode == "primitives")
+			return benchmarkPrimitives(args);
+		if (mode == "impostors")
+			return benchmarkImpostors(args);
+		if (mode == "lights")
+			return benchmarkLights(args);
+		if (mode == "shadows")
+			return benchmarkShadows(args);
+
+		std::cerr << "Modo de benchmark desconhecido: " << mode << std::endl;
+		std::cerr << "Modos disponveis: loaders, gltf, textures, upload, residency, pack, scene, load, jobs, profiler, arena, nbody, kepler, particles, primitives, impostors, lights, shadows" << std::endl;
+		return -1;
+	}
+
+	static double elapsedMs(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	// Mede a vazo de cada leitor de malha: GrauB --bench loaders [iteracoes] arquivo...
+	static int benchmarkLoaders(vector<string> files) {
+		int iterations = 20;
+		if (!files.empty() && isdigit((unsigned char)files[0][0])) {
+			iterations = std::max(1, atoi(files[0].c_str()));
+			files.erase(files.begin());
+		}
+		if (files.empty())
+			files = { "Sol.obj", "../3D_Models/Cube/cube.obj", "../3D_Models/Cube/cube.ply", "../3D_Models/Cube/cube.stl" };
+
+		struct FormatTotals { double ms = 0.0, bytes = 0.0, vertices = 0.0; };
+		map<string, FormatTotals> totals;
+
+		std::cout << std::fixed << std::setprecision(3);
+		for (const auto& file : files) {
+			size_t fileSize = MappedFile(file).size();
+			vector<GLfloat> vbuffer;
+			string materialFileName;
+			vector<MaterialRange> materialRanges;
+			double totalMs = 0.0;
+
+			for (int i = 0; i < iterations; ++i) {
+				vbuffer.clear();
+				materialRanges.clear();
+				auto start = std::chrono::steady_clock::now();
+				if (!MeshLoader::readMeshFile(file, vbuffer, materialFileName, materialRanges))
+					return -1;
+				totalMs += elapsedMs(start);
+			}
+
+			double msPerLoad = totalMs / iterations;
+			size_t numVertices = vbuffer.size() / MeshLoader::stride;
+			std::cout << file << ": " << msPerLoad << " ms/carga, " << numVertices << " vrtices, "
+				<< (fileSize / 1048576.0) / (msPerLoad / 1000.0) << " MB/s" << std::endl;
+
+			FormatTotals& format = totals[MeshLoader::getExtension(file)];
+			format.ms += totalMs;
+			format.bytes += (double)fileSize * iterations;
+			format.vertices += (double)numVertices * iterations;
+		}
+
+		std::cout << "--- por formato ---" << std::endl;
+		for (const auto& entry : totals) {
+			double seconds = entry.second.ms / 1000.0;
+			std::cout << entry.first << ": " << (entry.second.bytes / 1048576.0) / seconds << " MB/s, "
+				<< (entry.second.vertices / 1e6) / seconds << " Mvrtices/s" << std::endl;
+		}
+		return 0;
+	}
+
+	// Compara a carga de um GLB com a do OBJ equivalente, com as mesmas etapas dos dois lados: leitura do arquivo (e do
+	// MTL) e envio dos vrtices, ndices e texturas para a GPU, at o glFinish. Os objetos criados so apagados a cada
+	// iterao. GrauB --bench gltf arquivo.glb arquivo.obj [iteracoes]
+	static int benchmarkGLTF(const vector<string>& args) {
+		if (args.size() < 2) {
+			std::cerr << "Uso: --bench gltf arquivo.glb arquivo.obj [iteracoes]" << std::endl;
+			return -1;
+		}
+		int iterations = args.size() > 2 ? std::max(1, atoi(args[2].c_str())) : 20;
+
+		GLFWwindow* window = createHiddenContext();
+		if (window == nullptr)
+			return -1;
+		auto finish = [window](int result) {
+			glfwDestroyWindow(window);
+			glfwTerminate();
+			return result;
+		};
+
+		// Leitura e envio, em ms somados
+		double glbMs[2] = {}, objMs[2] = {};
+		for (int i = 0; i < iterations; ++i) {
+			GLTFModel model;
+			auto start = std::chrono::steady_clock::now();
+			if (!model.parse(args[0]))
+				return finish(-1);
+			glbMs[0] += elapsedMs(start);
+			start = std::chrono::steady_clock::now();
+			if (!model.upload())
+				return finish(-1);
+			glFinish();
+			glbMs[1] += elapsedMs(start);
+			model.release();
+		}
+
+		for (int i = 0; i < iterations; ++i) {
+			vector<GLfloat> vbuffer;
+			string materialFileName;
+			vector<MaterialRange> materialRanges;
+			auto start = std::chrono::steady_clock::now();
+			if (!MeshLoader::readMeshFile(args[1], vbuffer, materialFileName, materialRanges))
+				return finish(-1);
+			shared_ptr<MaterialLibrary> library = MaterialLibrary::read(materialFileName);
+			objMs[0] += elapsedMs(start);
+
+			// Os mesmos atributos do SceneObjInfo
+			start = std::chrono::steady_clock::now();
+			GLuint VBO = createBuffer(vbuffer.size() * sizeof(GLfloat), vbuffer.data()), VAO;
+			glGenVertexArrays(1, &VAO);
+			glBindVertexArray(VAO);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			const int sizes[4] = { 3, 3, 2, 3 }, offsets[4] = { 0, 3, 6, 8 };
+			for (int attribute = 0; attribute < 4; ++attribute) {
+				glVertexAttribPointer(attribute, sizes[attribute], GL_FLOAT, GL_FALSE, MeshLoader::stride * sizeof(GLfloat),
+					(GLvoid*)(offsets[attribute] * sizeof(GLfloat)));
+				glEnableVertexAttribArray(attribute);
+			}
+			glBindVertexArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			library->loadTextures();
+			glFinish();
+			objMs[1] += elapsedMs(start);
+
+			glDeleteVertexArrays(1, &VAO);
+			glDeleteBuffers(1, &VBO);
+			for (int m = 0; m < library->size(); ++m)
+				if (library->getTextureId(m) != 0)
+					TextureLoader::releaseTexture(library->getTextureId(m));
+		}
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << args[0] << ": " << (glbMs[0] + glbMs[1]) / iterations << " ms/carga (leitura " << glbMs[0] / iterations
+			<< ", envio " << glbMs[1] / iterations << "; " << MappedFile(args[0]).size() / 1024 << " KB, buffers enviados sem reempacotar)" << std::endl;
+		std::cout << args[1] << ": " << (objMs[0] + objMs[1]) / iterations << " ms/carga (leitura " << objMs[0] / iterations
+			<< ", envio " << objMs[1] / iterations << "; " << MappedFile(args[1]).size() / 1024 << " KB)" << std::endl;
+		std::cout << "GLB " << (objMs[0] + objMs[1]) / std::max(glbMs[0] + glbMs[1], 1e-9) << "x mais rpido que o OBJ" << std::endl;
+		return finish(0);
+	}
+
+	// Contexto OpenGL com janela invisvel, para os modos que precisam enviar dados para a GPU
+	static GLFWwindow* createHiddenContext() {
+		glfwInit();
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		GLFWwindow* window = glfwCreateWindow(64, 64, "GrauB benchmark", nullptr, nullptr);
+		if (window == nullptr) {
+			std::cerr << "Falha ao criar o contexto OpenGL" << std::endl;
+			glfwTerminate();
+			return nullptr;
+		}
+		glfwMakeContextCurrent(window);
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+			std::cerr << "Falha ao inicializar o GLAD" << std::endl;
+			glfwTerminate();
+			return nullptr;
+		}
+		return window;
+	}
+
+	// Framebuffer de width x height com cor RGBA8 e profundidade (os dois renderbuffers vo para renderbuffers), j
+	// ligado, com a viewport e o teste de profundidade
+	static GLuint createFramebuffer(int width, int height, GLuint renderbuffers[2]) {
+		GLuint framebuffer;
+		glGenFramebuffers(1, &framebuffer);
+		glGenRenderbuffers(2, renderbuffers);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+		glViewport(0, 0, width, height);
+		glEnable(GL_DEPTH_TEST);
+		return framebuffer;
+	}
+
+	// Buffer de instncias ligado ao VAO com os atributos do VShader.vs: matriz de modelo (4-7) e camada (8, -1: textura
+	// 2D), 17 floats por instncia
+	static GLuint createInstanceBuffer(GLuint VAO) {
+		GLuint instanceVBO;
+		glGenBuffers(1, &instanceVBO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		for (int column = 0; column < 4; ++column) {
+			glVertexAttribPointer(4 + column, 4, GL_FLOAT, GL_FALSE, 17 * sizeof(GLfloat), (GLvoid*)(column * 4 * sizeof(GLfloat)));
+			glEnableVertexAttribArray(4 + column);
+			glVertexAttribDivisor(4 + column, 1);
+		}
+		glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, 17 * sizeof(GLfloat), (GLvoid*)(16 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(8);
+		glVertexAttribDivisor(8, 1);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return instanceVBO;
+	}
+
+	// Compara o caminho sem compresso (decodifica + glTexImage2D + glGenerateMipmap) com as texturas BC:
+	// compresso na primeira execuo e leitura do cache KTX2 nas seguintes.
+	// GrauB --bench textures [bc1|bc3|bc7|auto] arquivo...
+	static int benchmarkTextures(vector<string> files) {
+		string compression = "auto";
+		if (!files.empty() && (files[0] == "bc1" || files[0] == "bc3" || files[0] == "bc7" || files[0] == "auto")) {
+			compression = files[0];
+			files.erase(files.begin());
+		}
+		if (files.empty())
+			files = { "Sol.jpg", "Mercurio.jpg", "Venus.jpg", "Terra.jpg", "Marte.jpg", "Jupiter.jpg", "Saturno.jpg", "Urano.jpg", "Netuno.jpg" };
+
+		GLFWwindow* window = createHiddenContext();
+		if (window == nullptr)
+			return -1;
+
+		double rawDecodeMs = 0.0, rawUploadMs = 0.0, bakeMs = 0.0, cacheReadMs = 0.0, cacheUploadMs = 0.0;
+		size_t rawBytes = 0, compressedBytes = 0;
+
+		std::cout << std::fixed << std::setprecision(2);
+		for (const auto& file : files) {
+			// Caminho sem compresso
+			auto start = std::chrono::steady_clock::now();
+			int width, height, channels;
+			unsigned char* data = stbi_load(file.c_str(), &width, &height, &channels, 0);
+			if (data == nullptr) {
+				std::cerr << "Falha ao carregar a textura: " << file << std::endl;
+				return -1;
+			}
+			double decodeMs = elapsedMs(start);
+
+			start = std::chrono::steady_clock::now();
+			GLuint raw = TextureLoader::createTexture(data, width, height, channels);
+			glFinish();
+			double uploadMs = elapsedMs(start);
+			stbi_image_free(data);
+			size_t rawSize = (size_t)width * height * channels * 4 / 3;
+			TextureLoader::releaseTexture(raw);
+
+			// Compresso completa (primeira execuo) e gravao do cache
+			TextureCompressor::Format format = TextureBaker::chooseFormat(compression, channels);
+			if (!TextureLoader::isFormatSupported(format))
+				return -1;
+			CompressedImage image;
+			start = std::chrono::steady_clock::now();
+			if (!TextureBaker::bake(file, format, image))
+				return -1;
+			double fileBakeMs = elapsedMs(start);
+			string cachePath = TextureBaker::getCachePath(file, format);
+			KTX2File::write(cachePath, image);
+
+			// Execues seguintes: l o KTX2 e envia os nveis comprimidos
+			start = std::chrono::steady_clock::now();
+			CompressedImage cached;
+			if (!KTX2File::read(cachePath, cached))
+				return -1;
+			double readMs = elapsedMs(start);
+
+			start = std::chrono::steady_clock::now();
+			GLuint compressed = TextureLoader::createCompressedTexture(cached);
+			glFinish();
+			double compressedUploadMs = elapsedMs(start);
+			size_t compressedSize = 0;
+			for (const auto& level : cached.levels)
+				compressedSize += level.size();
+			TextureLoader::releaseTexture(compressed);
+
+			std::cout << file << " (" << width << "x" << height << ", " << TextureBaker::getFormatName(format) << "): "
+				<< "sem compresso " << decodeMs << " + " << uploadMs << " ms, " << rawSize / 1048576.0 << " MB | "
+				<< "compresso " << fileBakeMs << " ms | "
+				<< "cache KTX2 " << readMs << " + " << compressedUploadMs << " ms, " << compressedSize / 1048576.0 << " MB" << std::endl;
+
+			rawDecodeMs += decodeMs;
+			rawUploadMs += uploadMs;
+			bakeMs += fileBakeMs;
+			cacheReadMs += readMs;
+			cacheUploadMs += compressedUploadMs;
+			rawBytes += rawSize;
+			compressedBytes += compressedSize;
+		}
+
+		double rawTotal = rawDecodeMs + rawUploadMs, cachedTotal = cacheReadMs + cacheUploadMs;
+		std::cout << "--- total (" << files.size() << " texturas) ---" << std::endl;
+		std::cout << "Envio para a GPU: " << rawUploadMs << " ms sem compresso, " << cacheUploadMs << " ms comprimido" << std::endl;
+		std::cout << "Inicializao: " << rawTotal << " ms sem compresso, " << cachedTotal << " ms com o cache KTX2 ("
+			<< rawTotal / std::max(cachedTotal, 1e-9) << "x), " << bakeMs << " ms na primeira execuo" << std::endl;
+		std::cout << "VRAM: " << rawBytes / 1048576.0 << " MB -> " << compressedBytes / 1048576.0 << " MB ("
+			<< (double)rawBytes / std::max<size_t>(compressedBytes, 1) << "x menor)" << std::endl;
+
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return 0;
+	}
+
+	// Tempo de cada quadro quando texturas e malhas so carregadas no meio da execuo: tudo de uma vez
+	// (glTexImage2D / glBufferData sncronos) contra o UploadManager com oramento por quadro.
+	// Grava o trao quadro a quadro em upload_trace.csv. GrauB --bench upload [oramento em MB] arquivo...
+	static int benchmarkUpload(vector<string> files) {
+		double frameBudgetMB = 4.0;
+		if (!files.empty() && isdigit((unsigned char)files[0][0])) {
+			frameBudgetMB = std::max(0.0625, atof(files[0].c_str()));
+			files.erase(files.begin());
+		}
+		if (files.empty())
+			files = { "Sol.jpg", "Mercurio.jpg", "Venus.jpg", "Terra.jpg", "Marte.jpg", "Jupiter.jpg", "Saturno.jpg", "Urano.jpg", "Netuno.jpg", "Sol.obj" };
+
+		GLFWwindow* window = createHiddenContext();
+		if (window == nullptr)
+			return -1;
+
+		const int loadFrame = 30, minFrames = 120, maxFrames = 5000;
+		vector<double> syncFrames, streamedFrames;
+		vector<size_t> streamedBytes;
+		vector<GLuint> textures, buffers;
+
+		// Carga sncrona: decodifica e envia tudo no quadro loadFrame
+		for (int frame = 0; frame < minFrames; ++frame) {
+			auto start = std::chrono::steady_clock::now();
+			simulateFrame();
+			if (frame == loadFrame) {
+				for (const auto& file : files) {
+					if (MeshLoader::getExtension(file) == "obj") {
+						vector<GLfloat> vbuffer;
+						if (!loadMeshData(file, vbuffer))
+							return -1;
+						buffers.push_back(createBuffer(vbuffer.size() * sizeof(GLfloat), vbuffer.data()));
+						continue;
+					}
+					int width, height, channels;
+					unsigned char* data = stbi_load(file.c_str(), &width, &height, &channels, 0);
+					if (data == nullptr) {
+						std::cerr << "Falha ao carregar a textura: " << file << std::endl;
+						return -1;
+					}
+					textures.push_back(TextureLoader::createTexture(data, width, height, channels));
+					stbi_image_free(data);
+				}
+			}
+			glFinish();
+			syncFrames.push_back(elapsedMs(start));
+		}
+		releaseUploadTargets(textures, buffers);
+
+		// Carga pelo UploadManager: pede tudo no quadro loadFrame e segue desenhando
+		{
+			UploadManager uploads(32u << 20, (size_t)(frameBudgetMB * 1024 * 1024));
+			uploads.initialize();
+			for (int frame = 0; frame < maxFrames && (frame < minFrames || !uploads.isIdle()); ++frame) {
+				auto start = std::chrono::steady_clock::now();
+				simulateFrame();
+				if (frame == loadFrame) {
+					for (const auto& file : files) {
+						if (MeshLoader::getExtension(file) == "obj") {
+							vector<GLfloat> vbuffer;
+							if (!loadMeshData(file, vbuffer))
+								return -1;
+							size_t size = vbuffer.size() * sizeof(GLfloat);
+							buffers.push_back(createBuffer(size, nullptr));
+							const unsigned char* bytes = (const unsigned char*)vbuffer.data();
+							uploads.streamBuffer(buffers.back(), vector<unsigned char>(bytes, bytes + size));
+							continue;
+						}
+						textures.push_back(uploads.streamTexture(file));
+					}
+				}
+				uploads.update();
+				glFinish();
+				streamedFrames.push_back(elapsedMs(start));
+				streamedBytes.push_back(uploads.getBytesLastFrame());
+			}
+		}
+		releaseUploadTargets(textures, buffers);
+
+		std::ofstream trace("upload_trace.csv");
+		trace << "quadro;sincrono_ms;upload_manager_ms;bytes_enviados" << std::endl;
+		for (size_t frame = 0; frame < std::max(syncFrames.size(), streamedFrames.size()); ++frame) {
+			trace << frame << ";" << (frame < syncFrames.size() ? to_string(syncFrames[frame]) : "") << ";"
+				<< (frame < streamedFrames.size() ? to_string(streamedFrames[frame]) : "") << ";"
+				<< (frame < streamedBytes.size() ? to_string(streamedBytes[frame]) : "") << std::endl;
+		}
+
+		std::cout << std::fixed << std::setprecision(2);
+		printFrameTimes("Sncrono", syncFrames);
+		printFrameTimes("UploadManager (" + to_string((int)(frameBudgetMB * 1024)) + " KB/quadro)", streamedFrames);
+		std::cout << "Dados disponveis aps " << streamedFrames.size() - loadFrame << " quadros; trao gravado em upload_trace.csv" << std::endl;
+
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return 0;
+	}
+
+	// Quadro de referncia: s limpa a tela, para que o tempo medido seja o custo das cargas
+	static void simulateFrame() {
+		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+
+	static bool loadMeshData(const string& file, vector<GLfloat>& vbuffer) {
+		string materialFileName;
+		vector<MaterialRange> materialRanges;
+		return MeshLoader::readMeshFile(file, vbuffer, materialFileName, materialRanges);
+	}
+
+	static GLuint createBuffer(size_t size, const void* data) {
+		GLuint buffer;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return buffer;
+	}
+
+	static void releaseUploadTargets(vector<GLuint>& textures, vector<GLuint>& buffers) {
+		for (GLuint texture : textures)
+			TextureLoader::releaseTexture(texture);
+		glDeleteBuffers((GLsizei)buffers.size(), buffers.data());
+		textures.clear();
+		buffers.clear();
+	}
+
+	static void printFrameTimes(const string& name, vector<double> frames) {
+		double total = 0.0;
+		int hitches = 0;
+		for (double ms : frames) {
+			total += ms;
+			if (ms > 1000.0 / 60.0)
+				++hitches;
+		}
+		std::sort(frames.begin(), frames.end());
+		std::cout << name << ": mdia " << total / frames.size() << " ms, p99 " << frames[std::min(frames.size() - 1, frames.size() * 99 / 100)]
+			<< " ms, pior quadro " << frames.back() << " ms, " << hitches << " quadros acima de 16,7 ms" << std::endl;
+	}
+
+	// Percorre uma fila de esferas texturizadas (uma por arquivo, a 10 unidades uma da outra) com a cmera a
+	// 2 unidades delas e mostra o TextureResidency carregando e descartando mipmaps dentro do oramento.
+	// GrauB --bench residency [oramento em MB] arquivo...
+	static int benchmarkResidency(vector<string> files) {
+		double budgetMB = 16.0;
+		if (!files.empty() && isdigit((unsigned char)files[0][0])) {
+			budgetMB = std::max(1.0, atof(files[0].c_str()));
+			files.erase(files.begin());
+		}
+		if (files.empty())
+			files = { "Sol.jpg", "Mercurio.jpg", "Venus.jpg", "Terra.jpg", "Marte.jpg", "Jupiter.jpg", "Saturno.jpg", "Urano.jpg", "Netuno.jpg" };
+
+		GLFWwindow* window = createHiddenContext();
+		if (window == nullptr)
+			return -1;
+
+		const int frames = 600;
+		const float spacing = 10.0f, radius = 1.0f, screenHeight = 1000.0f, fov = glm::radians(45.0f);
+		size_t peakBytes = 0;
+		{
+			TextureResidency residency((size_t)(budgetMB * 1024 * 1024));
+			residency.initialize();
+			vector<GLuint> textures;
+			for (const auto& file : files) {
+				GLuint texID = residency.registerTexture(file);
+				if (texID == 0)
+					return -1;
+				textures.push_back(texID);
+			}
+			std::cout << std::fixed << std::setprecision(2);
+			std::cout << "Cauda de " << textures.size() << " texturas: " << residency.getResidentBytes() / 1048576.0 << " MB" << std::endl;
+
+			float end = spacing * (textures.size() - 1);
+			for (int frame = 0; frame < frames || residency.getPendingRequests() > 0; ++frame) {
+				float cameraX = std::min((float)frame / frames, 1.0f) * (end + 2.0f * spacing) - spacing;
+				for (size_t i = 0; i < textures.size(); ++i) {
+					float distance = glm::length(glm::vec2(spacing * i - cameraX, 2.0f));
+					residency.requestSize(textures[i], radius / (distance * glm::tan(fov / 2.0f)) * screenHeight);
+				}
+				residency.update();
+				glFinish();
+				peakBytes = std::max(peakBytes, residency.getResidentBytes());
+
+				if (frame % 60 == 0) {
+					std::cout << "quadro " << frame << ": " << residency.getResidentBytes() / 1048576.0 << " MB residentes, "
+						<< residency.getPendingRequests() << " pendentes, " << residency.getEvictions() << " descartes, nveis";
+					for (GLuint texID : textures)
+						std::cout << " " << residency.getResidentLevel(texID);
+					std::cout << std::endl;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			}
+			std::cout << "Pico de " << peakBytes / 1048576.0 << " MB para um oramento de " << budgetMB << " MB, "
+				<< residency.getEvictions() << " nveis descartados" << std::endl;
+			for (GLuint texID : textures)
+				glDeleteTextures(1, &texID);
+		}
+
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return 0;
+	}
+
+	// L todos os assets da cena como arquivos soltos e pelo pacote: tempo a frio (arquivos tirados do cache
+	// do sistema antes) e a quente, e quantos arquivos foram abertos. GrauB --bench pack [Scene.json] [Assets.pak]
+	static int benchmarkPack(const vector<string>& args) {
+		string scenePath = args.size() > 0 ? args[0] : "Scene.json";
+		string packPath = args.size() > 1 ? args[1] : "Assets.pak";
+
+		vector<string> files = AssetPacker::collectSceneAssets(scenePath);
+		if (files.empty())
+			return -1;
+		std::error_code error;
+		if (!std::filesystem::exists(packPath, error)) {
+			char* packArgs[2] = { (char*)scenePath.c_str(), (char*)packPath.c_str() };
+			if (AssetPacker::run(2, packArgs) != 0)
+				return -1;
+		}
+
+		std::cout << std::fixed << std::setprecision(2);
+		for (bool cold : { true, false }) {
+			bool dropped = true;
+			if (cold)
+				for (const auto& file : files)
+					dropped = MappedFile::dropFromCache(file) && dropped;
+			int opened = MappedFile::filesOpened;
+			auto start = std::chrono::steady_clock::now();
+			size_t checksum = readAll(files);
+			double looseMs = elapsedMs(start);
+			int looseOpened = MappedFile::filesOpened - opened;
+
+			if (cold)
+				dropped = MappedFile::dropFromCache(packPath) && dropped;
+			opened = MappedFile::filesOpened;
+			start = std::chrono::steady_clock::now();
+			if (!VirtualFileSystem::mount(packPath))
+				return -1;
+			size_t packedChecksum = readAll(files);
+			double packMs = elapsedMs(start);
+			int packOpened = MappedFile::filesOpened - opened;
+			VirtualFileSystem::unmount();
+
+			if (checksum != packedChecksum) {
+				std::cerr << "O contedo lido do pacote difere dos arquivos soltos" << std::endl;
+				return -1;
+			}
+			string label = !cold ? "a quente" : dropped ? "a frio" : "a frio (cache do sistema no pde ser limpo)";
+			std::cout << "Leitura " << label << ": " << files.size() << " arquivos soltos em " << looseMs << " ms (" << looseOpened
+				<< " arquivos abertos), pacote em " << packMs << " ms (" << packOpened << " arquivo aberto)" << std::endl;
+		}
+		return 0;
+	}
+
+	// Tempo de carga da cena em JSON e compilada, com cenas sintticas de 1 mil, 100 mil e 1 milho de objetos
+	// (s a leitura da descrio, sem malhas nem GPU): GrauB --bench scene [objetos...]
+	static int benchmarkScene(const vector<string>& args) {
+		vector<int> counts;
+		for (const auto& arg : args)
+			counts.push_back(std::max(1, atoi(arg.c_str())));
+		if (counts.empty())
+			counts = { 1000, 100000, 1000000 };
+
+		std::cout << std::fixed << std::setprecision(2);
+		for (int count : counts) {
+			string jsonPath = "bench_scene_" + std::to_string(count) + ".json";
+			string imagePath = SceneCompiler::getCachePath(jsonPath);
+			if (!writeSyntheticScene(jsonPath, count))
+				return -1;
+
+			// Caminho do JSON: anlise do documento inteiro e converso dos objetos
+			auto start = std::chrono::steady_clock::now();
+			json j;
+			{
+				VirtualFile file(jsonPath);
+				j = json::parse(file.data(), file.data() + file.size());
+			}
+			double parseMs = elapsedMs(start);
+			start = std::chrono::steady_clock::now();
+			vector<unsigned char> image = SceneCompiler::compile(j);
+			double convertMs = elapsedMs(start);
+			j = json();
+			if (!SceneCompiler::write(imagePath, image))
+				return -1;
+
+			// Cena compilada: mapeamento e validao, depois a leitura de cada registro como a Scene faz
+			start = std::chrono::steady_clock::now();
+			SceneImage scene;
+			if (!scene.open(imagePath))
+				return -1;
+			double openMs = elapsedMs(start);
+			start = std::chrono::steady_clock::now();
+			size_t curvePoints = 0;
+			for (int i = 0; i < scene.getNumObjects(); ++i)
+				curvePoints += scene.getObjectAux(i).curvePoints.size();
+			double readMs = elapsedMs(start);
+
+			size_t jsonBytes = MappedFile(jsonPath).size();
+			std::cout << count << " objetos (" << curvePoints << " pontos de curva): JSON " << jsonBytes / 1048576.0 << " MB em "
+				<< parseMs + convertMs << " ms (anlise " << parseMs << " ms, converso " << convertMs << " ms); compilada "
+				<< scene.size() / 1048576.0 << " MB em " << openMs + readMs << " ms (abertura " << openMs << " ms, registros "
+				<< readMs << " ms) - " << (parseMs + convertMs) / std::max(openMs + readMs, 1e-9) << "x mais rpida" << std::endl;
+
+			scene.close();
+			std::error_code error;
+			std::filesystem::remove(jsonPath, error);
+			std::filesystem::remove(imagePath, error);
+		}
+		return 0;
+	}
+
+	// Fase de CPU da carga da cena (malhas, MTL, texturas e curvas) com 1 a 16 threads, no Scene.json e numa cena
+	// sinttica de 100 mil objetos; texturas sem compresso e sem GPU: GrauB --bench load [cena.json] [threads...]
+	static int benchmarkLoad(const vector<string>& args) {
+		vector<string> scenes;
+		vector<int> threadCounts;
+		for (const auto& arg : args) {
+			if (isdigit((unsigned char)arg[0]))
+				threadCounts.push_back(std::max(1, atoi(arg.c_str())));
+			else
+				scenes.push_back(arg);
+		}
+		if (threadCounts.empty())
+			threadCounts = { 1, 2, 4, 8, 16 };
+		string syntheticPath;
+		if (scenes.empty()) {
+			scenes.push_back("Scene.json");
+			syntheticPath = "bench_load_100000.json";
+			if (!writeSyntheticScene(syntheticPath, 100000))
+				return -1;
+			scenes.push_back(syntheticPath);
+		}
+
+		std::cout << std::fixed << std::setprecision(2);
+		for (const auto& scenePath : scenes) {
+			SceneImage image;
+			if (!SceneCompiler::loadOrCompile(scenePath, image))
+				return -1;
+			std::cout << scenePath << " (" << image.getNumObjects() << " objetos):" << std::endl;
+
+			// Uma carga antes das medidas para que os arquivos j estejam no cache do sistema
+			{
+				JobSystem jobs(1);
+				SceneLoader loader;
+				loader.load(image, jobs, true);
+			}
+			double baseMs = 0;
+			for (int threads : threadCounts) {
+				JobSystem jobs(threads);
+				double best = 1e30;
+				SceneLoader bestLoader;
+				for (int run = 0; run < 3; ++run) {
+					SceneLoader loader;
+					loader.load(image, jobs, true);
+					if (loader.getTotalMs() < best) {
+						best = loader.getTotalMs();
+						bestLoader.meshMs = loader.meshMs;
+						bestLoader.materialMs = loader.materialMs;
+						bestLoader.textureMs = loader.textureMs;
+						bestLoader.curveMs = loader.curveMs;
+					}
+				}
+				if (baseMs == 0)
+					baseMs = best;
+				std::cout << "  " << std::setw(2) << threads << " thread(s): " << std::setw(8) << best << " ms (malhas " << bestLoader.meshMs
+					<< ", MTL " << bestLoader.materialMs << ", texturas " << bestLoader.textureMs << ", curvas " << bestLoader.curveMs
+					<< ") - " << baseMs / best << "x" << std::endl;
+			}
+			image.close();
+		}
+
+		if (!syntheticPath.empty()) {
+			std::error_code error;
+			std::filesystem::remove(syntheticPath, error);
+			std::filesystem::remove(SceneCompiler::getCachePath(syntheticPath), error);
+		}
+		return 0;
+	}
+
+	// Custo do JobSystem com 1 a 16 threads: fib(32) com uma tarefa por chamada acima de fib(15), soma de 16 milhes
+	// de floats com parallelFor e tarefas vazias (custo de criar, agendar e esperar cada uma): GrauB --bench jobs [threads...]
+	static int benchmarkJobs(const vector<string>& args) {
+		vector<int> threadCounts;
+		for (const auto& arg : args)
+			threadCounts.push_back(std::max(1, atoi(arg.c_str())));
+		if (threadCounts.empty())
+			threadCounts = { 1, 2, 4, 8, 16 };
+
+		vector<float> values(1 << 24);
+		for (size_t i = 0; i < values.size(); ++i)
+			values[i] = (float)(i % 1000) * 0.001f;
+
+		std::cout << std::fixed << std::setprecision(2);
+		// Referncia sem tarefas; os ganhos abaixo so em relao  primeira linha (o JobSystem com uma thread)
+		long long fibSerial = 0;
+		double fibSerialMs = 1e30;
+		for (int run = 0; run < 3; ++run) {
+			auto start = std::chrono::steady_clock::now();
+			fibSerial = fibonacci(32);
+			fibSerialMs = std::min(fibSerialMs, elapsedMs(start));
+		}
+		double sumSerial = sumRange(values, 0, (int)values.size());
+		std::cout << "Sem tarefas: fib(32) = " << fibSerial << " em " << fibSerialMs << " ms" << std::endl;
+		double fibBaseMs = 0, sumBaseMs = 0;
+
+		const int emptyJobs = 100000, batch = JobSystem::maxJobs / 2;
+		for (int threads : threadCounts) {
+			JobSystem jobs(threads);
+			double fibMs = 1e30, sumMs = 1e30, emptyMs = 1e30;
+			long long fib = 0;
+			double sum = 0;
+			for (int run = 0; run < 3; ++run) {
+				auto start = std::chrono::steady_clock::now();
+				fibonacciJob(jobs, 32, fib);
+				fibMs = std::min(fibMs, elapsedMs(start));
+
+				start = std::chrono::steady_clock::now();
+				int grain = (int)values.size() / (threads * 8);
+				vector<double> partial(values.size() / grain + 1, 0.0);
+				jobs.parallelFor((int)values.size(), grain, [&](int begin, int end) {
+					partial[begin / grain] = sumRange(values, begin, end);
+				});
+				sum = 0;
+				for (double total : partial)
+					sum += total;
+				sumMs = std::min(sumMs, elapsedMs(start));
+
+				start = std::chrono::steady_clock::now();
+				for (int done = 0; done < emptyJobs; done += batch) {
+					Job* root = jobs.createJob(nullptr);
+					for (int i = 0; i < std::min(batch, emptyJobs - done); ++i)
+						jobs.run(jobs.createChild(root, nullptr));
+					jobs.run(root);
+					jobs.wait(root);
+				}
+				emptyMs = std::min(emptyMs, elapsedMs(start));
+			}
+			if (fibBaseMs == 0) {
+				fibBaseMs = fibMs;
+				sumBaseMs = sumMs;
+			}
+			std::cout << std::setw(2) << threads << " thread(s): fib " << fibMs << " ms (" << fibBaseMs / fibMs << "x"
+				<< (fib == fibSerial ? "" : ", RESULTADO ERRADO") << "), soma " << sumMs << " ms (" << sumBaseMs / sumMs << "x"
+				<< (std::abs(sum - sumSerial) < 1e-6 * sumSerial ? "" : ", RESULTADO ERRADO") << "), tarefa vazia "
+				<< emptyMs * 1e6 / emptyJobs << " ns" << std::endl;
+		}
+		return 0;
+	}
+
+	// Custo de uma zona do perfil desligado e ligado (comparado a um lao sem zona) e um trao de exemplo com a soma
+	// em paralelo do modo jobs, gravado em profiler_trace.json: GrauB --bench profiler [zonas] [threads]
+	static int benchmarkProfiler(const vector<string>& args) {
+		int zones = args.size() > 0 ? std::max(1, atoi(args[0].c_str())) : 10000000;
+		int threads = args.size() > 1 ? std::max(1, atoi(args[1].c_str())) : 4;
+		// As zonas vo para a fila da thread; esvazia antes de ela encher
+		const int collectEvery = (int)ProfileRing::capacity / 2;
+
+		std::cout << std::fixed << std::setprecision(2);
+		volatile uint64_t sink = 0;
+		double baseMs = 1e30, disabledMs = 1e30, enabledMs = 1e30;
+		for (int run = 0; run < 3; ++run) {
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < zones; ++i)
+				sink = sink + i;
+			baseMs = std::min(baseMs, elapsedMs(start));
+
+			Profiler::setEnabled(false);
+			start = std::chrono::steady_clock::now();
+			for (int i = 0; i < zones; ++i) {
+				PROFILE_ZONE("benchmark");
+				sink = sink + i;
+			}
+			disabledMs = std::min(disabledMs, elapsedMs(start));
+
+			Profiler::setEnabled(true);
+			start = std::chrono::steady_clock::now();
+			for (int done = 0; done < zones; done += collectEvery) {
+				for (int i = done; i < std::min(zones, done + collectEvery); ++i) {
+					PROFILE_ZONE("benchmark");
+					sink = sink + i;
+				}
+				Profiler::collect();
+			}
+			enabledMs = std::min(enabledMs, elapsedMs(start));
+			Profiler::setEnabled(false);
+		}
+		std::cout << zones << " zonas: sem zona " << baseMs * 1e6 / zones << " ns, desligado +" << (disabledMs - baseMs) * 1e6 / zones
+			<< " ns, ligado +" << (enabledMs - baseMs) * 1e6 / zones << " ns por zona (com a coleta)" << std::endl;
+
+		vector<float> values(1 << 24);
+		for (size_t i = 0; i < values.size(); ++i)
+			values[i] = (float)(i % 1000) * 0.001f;
+		JobSystem jobs(threads);
+		Profiler::setThreadName("Main");
+		Profiler::setEnabled(true);
+		Profiler::startCapture();
+		for (int frame = 0; frame < 20; ++frame) {
+			PROFILE_ZONE("frame");
+			int grain = (int)values.size() / (threads * 8);
+			jobs.parallelFor((int)values.size(), grain, [&](int begin, int end) {
+				PROFILE_ZONE("sumRange");
+				sink = sink + (uint64_t)sumRange(values, begin, end);
+			});
+		}
+		Profiler::setEnabled(false);
+		Profiler::collect();
+		Profiler::printSummary(std::cout);
+		return Profiler::writeTrace("profiler_trace.json") ? 0 : -1;
+	}
+
+	// Temporrios de uma leitura de malha (vetores que crescem por push_back, como em readOBJFile, e uma tabela) alocados
+	// pelo heap, por um pool e pela arena linear; depois a compilao e a carga de uma cena sinttica, com as alocaes
+	// e o pico de memria residente: GrauB --bench arena [iteracoes] [vertices] [objetos]
+	static int benchmarkArena(const vector<string>& args) {
+		int iterations = args.size() > 0 ? std::max(1, atoi(args[0].c_str())) : 200;
+		int count = args.size() > 1 ? std::max(1, atoi(args[1].c_str())) : 20000;
+		int objects = args.size() > 2 ? std::max(1, atoi(args[2].c_str())) : 100000;
+		AllocationTracker::markFrameThread();
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "Temporrios de uma malha com " << count << " vrtices (" << iterations << " vezes):" << std::endl;
+		std::pmr::unsynchronized_pool_resource pool;
+		const char* names[] = { "heap", "pool", "arena" };
+		for (int variant = 0; variant < 3; ++variant) {
+			uint64_t allocations = AllocationTracker::getThreadAllocations();
+			double checksum = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < iterations; ++i) {
+				if (variant == 2) {
+					ArenaScope scratch;
+					checksum += fillTemporaries(scratch.resource(), count);
+				}
+				else {
+					checksum += fillTemporaries(variant == 0 ? std::pmr::new_delete_resource() : &pool, count);
+				}
+			}
+			double ms = elapsedMs(start);
+			std::cout << "  " << std::setw(5) << names[variant] << ": " << std::setw(8) << ms / iterations << " ms e "
+				<< std::setw(8) << (double)(AllocationTracker::getThreadAllocations() - allocations) / iterations << " alocaes por leitura"
+				<< " (" << checksum << ")" << std::endl;
+		}
+		std::cout << "  arena da thread: pico de " << LinearArena::scratch().getPeak() << " bytes em "
+			<< LinearArena::scratch().getCapacity() << " reservados (" << LinearArena::scratch().getUpstreamAllocations() << " blocos pedidos)" << std::endl;
+
+		string path = "bench_arena_" + to_string(objects) + ".json";
+		if (!writeSyntheticScene(path, objects))
+			return -1;
+		std::error_code error;
+		std::filesystem::remove(SceneCompiler::getCachePath(path), error);
+		uint64_t allocations, bytes, lastAllocations, lastBytes;
+		AllocationTracker::getFrameTotals(lastAllocations, lastBytes);
+		auto report = [&](const char* phase, std::chrono::steady_clock::time_point start) {
+			double ms = elapsedMs(start);
+			AllocationTracker::getFrameTotals(allocations, bytes);
+			std::cout << "  " << phase << ": " << std::setw(9) << ms << " ms, " << std::setw(9) << allocations - lastAllocations << " alocaes ("
+				<< (bytes - lastBytes) / (1024.0 * 1024.0) << " MB); pico residente " << AllocationTracker::getPeakResidentBytes() / (1024.0 * 1024.0)
+				<< " MB" << std::endl;
+			lastAllocations = allocations;
+			lastBytes = bytes;
+		};
+
+		std::cout << path << " (" << objects << " objetos):" << std::endl;
+		auto start = std::chrono::steady_clock::now();
+		SceneImage image;
+		if (!SceneCompiler::loadOrCompile(path, image))
+			return -1;
+		report("compilao", start);
+		{
+			JobSystem jobs;
+			start = std::chrono::steady_clock::now();
+			SceneLoader loader;
+			loader.load(image, jobs, true);
+			report("leitura   ", start);
+		}
+		image.close();
+		std::filesystem::remove(path, error);
+		std::filesystem::remove(SceneCompiler::getCachePath(path), error);
+		return 0;
+	}
+
+	// Interaes por segundo da soma direta e da octree com 1 thread e com todas, num disco de corpos com massa em
+	// torno de uma estrela (a soma direta s at 20 mil corpos), e o desvio de energia de cada uma em 10 s simulados
+	// com 2000 corpos: GrauB --bench nbody [passos] [corpos...]
+	static int benchmarkNBody(const vector<string>& args) {
+		int steps = args.size() > 0 ? std::max(1, atoi(args[0].c_str())) : 3;
+		vector<int> counts;
+		for (size_t i = 1; i < args.size(); ++i)
+			counts.push_back(std::max(1, atoi(args[i].c_str())));
+		if (counts.empty())
+			counts = { 1000, 10000, 100000 };
+		vector<int> threadCounts = { 1 };
+		if (std::thread::hardware_concurrency() > 1)
+			threadCounts.push_back((int)std::thread::hardware_concurrency());
+
+		std::cout << std::fixed << std::setprecision(2);
+		for (int count : counts) {
+			std::cout << count << " corpos (" << steps << " passos):" << std::endl;
+			for (int threads : threadCounts) {
+				JobSystem jobs(threads);
+				for (int tree = 0; tree < 2; ++tree) {
+					if (!tree && count > 20000)
+						continue;
+					NBody bodies = makeDisk(count, tree != 0);
+					bodies.computeAccelerations(jobs);
+					uint64_t interactions = 0;
+					auto start = std::chrono::steady_clock::now();
+					for (int step = 0; step < steps; ++step) {
+						bodies.step(1.0f / 60.0f, jobs);
+						interactions += bodies.getInteractions();
+					}
+					double ms = elapsedMs(start);
+					std::cout << "  " << std::setw(2) << threads << " thread(s), " << (bodies.isUsingTree() ? "octree" : "direta") << ": "
+						<< std::setw(9) << ms / steps << " ms/passo, " << std::setw(8) << interactions / (ms * 1000.0) << " M interaes/s";
+					if (bodies.isUsingTree())
+						std::cout << " (" << interactions / steps / count << " por corpo, " << bodies.getNumNodes() << " clulas)";
+					std::cout << std::endl;
+				}
+			}
+		}
+
+		JobSystem jobs;
+		std::cout << std::scientific << "Desvio de energia em 600 passos de 1/60 s com 2000 corpos:" << std::endl;
+		for (int tree = 0; tree < 2; ++tree) {
+			NBody bodies = makeDisk(2000, tree != 0);
+			double initial = bodies.getEnergy(jobs);
+			for (int step = 0; step < 600; ++step)
+				bodies.step(1.0f / 60.0f, jobs);
+			std::cout << "  " << (tree ? "octree" : "direta") << ": " << (bodies.getEnergy(jobs) - initial) / std::abs(initial) << std::endl;
+		}
+		return 0;
+	}
+
+	// Tempo por rbita da avaliao em lote (SSE, 1 thread e todas) comparada a uma por vez em double com std::sin,
+	// e o maior erro de posio em relao a ela, num cinturo pouco excntrico e num com excentricidade at 0.9:
+	// GrauB --bench kepler [orbitas] [avaliacoes]
+	static int benchmarkKepler(const vector<string>& args) {
+		int count = args.size() > 0 ? std::max(1, atoi(args[0].c_str())) : 1000000;
+		int evaluations = args.size() > 1 ? std::max(1, atoi(args[1].c_str())) : 20;
+		vector<int> threadCounts = { 1 };
+		if (std::thread::hardware_concurrency() > 1)
+			threadCounts.push_back((int)std::thread::hardware_concurrency());
+
+		std::cout << std::fixed << std::setprecision(2);
+		vector<glm::vec3> positions(count);
+		for (float maxEccentricity : { 0.1f, 0.9f }) {
+			KeplerOrbits orbits;
+			orbits.addBelt(count, 56.0f, 60.0f, maxEccentricity, 5.0f, 1000.0f, 1);
+			std::cout << count << " rbitas com excentricidade at " << maxEccentricity << " (" << evaluations << " avaliaes):" << std::endl;
+
+			// A referncia  lenta: mede s as primeiras rbitas
+			int sampled = std::min(count, 100000);
+			double reference = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < sampled; ++i)
+				reference += orbits.getReferencePosition(i, 1000.0).x;
+			double referenceNs = elapsedMs(start) * 1e6 / sampled;
+			std::cout << "  referncia (double): " << std::setw(7) << referenceNs << " ns/rbita (" << reference << ")" << std::endl;
+
+			for (int threads : threadCounts) {
+				JobSystem jobs(threads);
+				start = std::chrono::steady_clock::now();
+				for (int evaluation = 0; evaluation < evaluations; ++evaluation)
+					orbits.evaluate(1000.0 + evaluation / 60.0, glm::vec3(0), positions.data(), jobs);
+				double ms = elapsedMs(start) / evaluations;
+				std::cout << "  lote, " << std::setw(2) << threads << " thread(s): " << std::setw(7) << ms * 1e6 / count << " ns/rbita, "
+					<< std::setw(7) << ms << " ms por avaliao (" << std::setprecision(1) << referenceNs * count / (ms * 1e6)
+					<< std::setprecision(2) << "x)" << std::endl;
+			}
+
+			double worst = 0;
+			orbits.evaluate(1000.0, glm::vec3(0), positions.data(), 0, count);
+			for (int i = 0; i < sampled; ++i)
+				worst = std::max(worst, glm::length(glm::dvec3(positions[i]) - orbits.getReferencePosition(i, 1000.0)));
+			std::cout << "  maior erro de posio: " << std::scientific << worst << std::fixed << std::endl;
+		}
+		return 0;
+	}
+
+	// Partculas atualizadas por ms (integrao, idade, remoo e emisso) e o tempo de gerar a cpia para o desenho,
+	// com 1 thread e com todas, num emissor j cheio (100 mil e 1 milho de partculas):
+	// GrauB --bench particles [passos] [particulas...]
+	static int benchmarkParticles(const vector<string>& args) {
+		int steps = args.size() > 0 ? std::max(1, atoi(args[0].c_str())) : 60;
+		vector<int> counts;
+		for (size_t i = 1; i < args.size(); ++i)
+			counts.push_back(std::max(1, atoi(args[i].c_str())));
+		if (counts.empty())
+			counts = { 100000, 1000000 };
+		vector<int> threadCounts = { 1 };
+		if (std::thread::hardware_concurrency() > 1)
+			threadCounts.push_back((int)std::thread::hardware_concurrency());
+
+		std::cout << std::fixed << std::setprecision(2);
+		vector<glm::vec4> particles;
+		vector<ParticleBatch> batches;
+		for (int count : counts) {
+			std::cout << count << " partculas (" << steps << " passos):" << std::endl;
+			for (int threads : threadCounts) {
+				JobSystem jobs(threads);
+				// Vida mdia de 2 s: com count / 2 por segundo o emissor fica cheio depois de uns 3 s
+				ParticleSystem system;
+				system.emitters.emplace_back(count, count / 2.0f, 2.0f, 3.0f, 0.3f, 10.0f, 0.5f, 0.1f, glm::vec3(1.0f), 1);
+				for (int step = 0; step < 12; ++step)
+					system.update(0.25f, jobs);
+
+				size_t updated = 0;
+				auto start = std::chrono::steady_clock::now();
+				for (int step = 0; step < steps; ++step) {
+					updated += system.getNumParticles();
+					system.update(1.0f / 60.0f, jobs);
+				}
+				double ms = elapsedMs(start);
+				start = std::chrono::steady_clock::now();
+				for (int step = 0; step < steps; ++step)
+					system.write(particles, batches, jobs);
+				double writeMs = elapsedMs(start) / steps;
+				std::cout << "  " << std::setw(2) << threads << " thread(s): " << std::setw(7) << ms / steps << " ms/passo, "
+					<< std::setw(9) << updated / ms << " partculas/ms, cpia " << std::setw(6) << writeMs << " ms ("
+					<< system.getNumParticles() << " vivas)" << std::endl;
+			}
+		}
+		return 0;
+	}
+
+	// Tempo de gerao de cada primitiva com 1 thread e com todas, numa tesselagem alta:
+	// GrauB --bench primitives [tesselagem] [repeticoes]
+	static int benchmarkPrimitives(const vector<string>& args) {
+		int tessellation = args.size() > 0 ? std::max(1, atoi(args[0].c_str())) : 1024;
+		int repetitions = args.size() > 1 ? std::max(1, atoi(args[1].c_str())) : 5;
+		vector<int> threadCounts = { 1 };
+		if (std::thread::hardware_concurrency() > 1)
+			threadCounts.push_back((int)std::thread::hardware_concurrency());
+
+		std::cout << std::fixed << std::setprecision(2) << "Tesselagem " << tessellation << " (" << repetitions << " repeties):" << std::endl;
+		vector<GLfloat> vbuffer;
+		vector<GLuint> indices;
+		string materialFileName;
+		for (const char* type : { "uvsphere", "icosphere", "cube", "cylinder", "torus" }) {
+			string path = Primitives::makePath(type, tessellation, "");
+			for (int threads : threadCounts) {
+				JobSystem jobs(threads);
+				auto start = std::chrono::steady_clock::now();
+				for (int repetition = 0; repetition < repetitions; ++repetition)
+					Primitives::generate(path, vbuffer, indices, materialFileName, &jobs);
+				double ms = elapsedMs(start) / repetitions;
+				size_t vertices = vbuffer.size() / MeshLoader::stride;
+				std::cout << "  " << std::setw(9) << type << ", " << std::setw(2) << threads << " thread(s): " << std::setw(8) << ms << " ms, "
+					<< vertices << " vrtices, " << indices.size() / 3 << " tringulos (" << vertices / (ms * 1000.0) << " M vrtices/s)" << std::endl;
+			}
+		}
+		return 0;
+	}
+
+	// Esferas texturizadas pequenas na tela (a esfera UV de 64 segmentos do Scene.json) desenhadas com a malha, numa
+	// chamada instanciada, e como impostores, num framebuffer de 1280x720: tempo por quadro (com glFinish) e
+	// diferena entre as duas imagens. GrauB --bench impostors [quadros] [esferas...]
+	static int benchmarkImpostors(const vector<string>& args) {
+		int frames = args.size() > 0 ? std::max(1, atoi(args[0].c_str())) : 20;
+		vector<int> counts;
+		for (size_t i = 1; i < args.size(); ++i)
+			counts.push_back(std::max(1, atoi(args[i].c_str())));
+		if (counts.empty())
+			counts = { 1000, 10000, 100000 };
+
+		GLFWwindow* window = createHiddenContext();
+		if (window == nullptr)
+			return -1;
+		const int width = 1280, height = 720;
+		GLuint renderbuffers[2];
+		GLuint framebuffer = createFramebuffer(width, height, renderbuffers);
+
+		{
+			Shader shader("VShader.vs", "FShader.fs");
+			SceneObjInfo sphere(Primitives::makePath("uvsphere", 64, "Terra.mtl"));
+			const MaterialLibrary* library = sphere.materialLibrary.get();
+			int material = sphere.subMeshes.front().material;
+			ImpostorRenderer impostors;
+			glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / height, 0.1f, 1000.0f);
+			glm::vec3 lightPosition(200.0f, 100.0f, 0.0f), lightColor(1.0f);
+
+			GLuint instanceVBO = createInstanceBuffer(sphere.VAO);
+
+			std::mt19937 random(1);
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+			std::cout << std::fixed << std::setprecision(2) << sphere.numVertices / 3 << " tringulos por esfera, " << frames << " quadros:" << std::endl;
+			for (int count : counts) {
+				// Esferas de raio 0.5 a 1.5 entre 150 e 400 unidades da cmera, dentro do campo de viso (5 a 20 pixels)
+				vector<GLfloat> instanceData((size_t)count * 17);
+				impostors.clear();
+				for (int i = 0; i < count; ++i) {
+					float distance = 150.0f + 250.0f * unit(random);
+					glm::vec3 position((unit(random) * 2.0f - 1.0f) * distance * 0.7f, (unit(random) * 2.0f - 1.0f) * distance * 0.38f, -distance);
+					glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+					model = glm::rotate(model, unit(random) * glm::two_pi<float>(), glm::vec3(0.0f, 1.0f, 0.0f));
+					model = glm::scale(model, glm::vec3(0.5f + unit(random)));
+					memcpy(&instanceData[(size_t)i * 17], glm::value_ptr(model), 16 * sizeof(GLfloat));
+					instanceData[(size_t)i * 17 + 16] = -1.0f;
+					impostors.add(model, sphere.boundingRadius, library, material);
+				}
+				glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+				glBufferData(GL_ARRAY_BUFFER, instanceData.size() * sizeof(GLfloat), instanceData.data(), GL_STATIC_DRAW);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+				vector<unsigned char> images[2];
+				double ms[2];
+				for (int mode = 0; mode < 2; ++mode) {
+					auto drawFrame = [&]() {
+						glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+						glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+						if (mode == 1) {
+							impostors.render(view, projection, glm::vec3(0.0f), lightPosition, lightColor, nullptr, width, height, false, nullptr);
+							return;
+						}
+						shader.Use();
+						shader.setMat4("view", glm::value_ptr(view));
+						shader.setMat4("projection", glm::value_ptr(projection));
+						shader.setVec3("camera_pos", 0.0f, 0.0f, 0.0f);
+						shader.setVec3("light_pos", lightPosition.x, lightPosition.y, lightPosition.z);
+						shader.setVec3("light_color", lightColor.r, lightColor.g, lightColor.b);
+						shader.setInt("tex_buffer", 0);
+						shader.setInt("tex_array", 1);
+						shader.setBool("instanced", true);
+						SceneObj::beginFrame();
+						SceneObj::useMaterial(&shader, library, material);
+						glBindVertexArray(sphere.VAO);
+						glDrawElementsInstanced(GL_TRIANGLES, sphere.numVertices, sphere.indexType, (GLvoid*)0, count);
+						glBindVertexArray(0);
+					};
+					drawFrame();
+					glFinish();
+					auto start = std::chrono::steady_clock::now();
+					for (int frame = 0; frame < frames; ++frame)
+						drawFrame();
+					glFinish();
+					ms[mode] = elapsedMs(start) / frames;
+					images[mode].resize((size_t)width * height * 4);
+					glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, images[mode].data());
+				}
+
+				// S os pixels cobertos por alguma das duas imagens entram na comparao
+				size_t covered = 0, differing = 0;
+				double difference = 0.0;
+				for (size_t p = 0; p < images[0].size(); p += 4) {
+					const unsigned char* a = &images[0][p];
+					const unsigned char* b = &images[1][p];
+					if (a[0] + a[1] + a[2] + b[0] + b[1] + b[2] == 0)
+						continue;
+					++covered;
+					int largest = 0;
+					for (int channel = 0; channel < 3; ++channel) {
+						int delta = std::abs(a[channel] - b[channel]);
+						difference += delta;
+						largest = std::max(largest, delta);
+					}
+					if (largest > 24)
+						++differing;
+				}
+				std::cout << "  " << std::setw(6) << count << " esferas: malha " << std::setw(7) << ms[0] << " ms/quadro, impostores "
+					<< std::setw(7) << ms[1] << " ms/quadro (" << std::setprecision(1) << ms[0] / std::max(ms[1], 1e-6) << "x); diferena mdia "
+					<< difference / std::max<size_t>(covered * 3, 1) << " por canal, " << 100.0 * differing / std::max<size_t>(covered, 1)
+					<< "% de " << covered << " pixels cobertos com mais de 24" << std::setprecision(2) << std::endl;
+			}
+			glDeleteBuffers(1, &instanceVBO);
+			glDeleteProgram(shader.ID);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(2, renderbuffers);
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return 0;
+	}
+
+	// Luzes pontuais sorteadas no frustum, entre 15 e 55 unidades da cmera: tempo da distribuio nos aglomerados na CPU
+	// (com uma thread e com todas) e, num framebuffer de 1280x720 com quatro camadas de esferas, tempo por quadro (com
+	// glFinish) com os aglomerados e percorrendo todas as luzes em cada fragmento, mais a diferena entre as duas imagens.
+	// GrauB --bench lights [quadros] [luzes...]
+	static int benchmarkLights(const vector<string>& args) {
+		int frames = args.size() > 0 ? std::max(1, atoi(args[0].c_str())) : 10;
+		vector<int> counts;
+		for (size_t i = 1; i < args.size(); ++i)
+			counts.push_back(std::min(std::max(1, atoi(args[i].c_str())), ClusteredLights::maxLights));
+		if (counts.empty())
+			counts = { 1, 64, 1024, 4096 };
+
+		const int width = 1280, height = 720;
+		const float aspect = (float)width / height, tanHalfFov = std::tan(glm::radians(22.5f));
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f);
+		ClusteredLights lights(16, 9, 24);
+		auto fillLights = [&](ClusteredLights& target, int count) {
+			std::mt19937 random(count);
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+			target.clear();
+			for (int i = 0; i < count; ++i) {
+				float depth = 15.0f + 40.0f * unit(random);
+				glm::vec3 position((unit(random) * 2.0f - 1.0f) * depth * tanHalfFov * aspect, (unit(random) * 2.0f - 1.0f) * depth * tanHalfFov, -depth);
+				target.add(position, 4.0f, glm::vec3(unit(random), unit(random), unit(random)));
+			}
+		};
+
+		std::cout << std::fixed << std::setprecision(3) << "Distribuio em " << lights.getNumClusters() << " aglomerados:" << std::endl;
+		for (int count : counts) {
+			fillLights(lights, count);
+			std::cout << "  " << std::setw(5) << count << " luzes:";
+			for (int threads : { 1, 0 }) {
+				JobSystem jobs(threads);
+				lights.build(view, projection, jobs);
+				auto start = std::chrono::steady_clock::now();
+				const int runs = 50;
+				for (int run = 0; run < runs; ++run)
+					lights.build(view, projection, jobs);
+				std::cout << " " << elapsedMs(start) / runs << " ms com " << jobs.getNumThreads() << " thread(s);";
+			}
+			std::cout << " " << lights.getNumIndices() << " ndices (" << std::setprecision(1)
+				<< (double)lights.getNumIndices() / lights.getNumClusters() << " luzes por aglomerado)" << std::setprecision(3) << std::endl;
+		}
+
+		GLFWwindow* window = createHiddenContext();
+		if (window == nullptr)
+			return -1;
+		GLuint renderbuffers[2];
+		GLuint framebuffer = createFramebuffer(width, height, renderbuffers);
+
+		{
+			Shader shader("VShader.vs", "FShader.fs");
+			SceneObjInfo sphere(Primitives::makePath("uvsphere", 32, "Terra.mtl"));
+			const MaterialLibrary* library = sphere.materialLibrary.get();
+			int material = sphere.subMeshes.front().material;
+			GLuint instanceVBO = createInstanceBuffer(sphere.VAO);
+			// Outro objeto: os buffers dele precisam ser apagados antes do contexto
+			ClusteredLights gpuLights(16, 9, 24);
+			JobSystem jobs;
+
+			// Grade de 32 x 18 esferas por camada, da mais prxima para a mais distante (o teste de profundidade
+			// descarta o que fica atrs)
+			vector<GLfloat> instanceData;
+			for (int layer = 0; layer < 4; ++layer) {
+				float depth = 20.0f + 10.0f * layer, cell = 2.0f * depth * tanHalfFov / 18.0f;
+				for (int row = 0; row < 18; ++row)
+					for (int column = 0; column < 32; ++column) {
+						glm::vec3 position((column - 15.5f + 0.5f * (layer % 2)) * cell, (row - 8.5f + 0.5f * (layer % 2)) * cell, -depth);
+						glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(0.45f * cell / sphere.boundingRadius));
+						instanceData.insert(instanceData.end(), glm::value_ptr(model), glm::value_ptr(model) + 16);
+						instanceData.push_back(-1.0f);
+					}
+			}
+			int spheres = (int)instanceData.size() / 17;
+			glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+			glBufferData(GL_ARRAY_BUFFER, instanceData.size() * sizeof(GLfloat), instanceData.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			shader.Use();
+			shader.setMat4("view", glm::value_ptr(view));
+			shader.setMat4("projection", glm::value_ptr(projection));
+			shader.setVec3("camera_pos", 0.0f, 0.0f, 0.0f);
+			// Luz principal fraca, para que as pontuais dominem a imagem
+			shader.setVec3("light_pos", 0.0f, 100.0f, 0.0f);
+			shader.setVec3("light_color", 0.1f, 0.1f, 0.1f);
+			shader.setInt("tex_buffer", 0);
+			shader.setInt("tex_array", 1);
+			shader.setBool("instanced", true);
+
+			std::cout << std::setprecision(2) << spheres << " esferas, " << frames << " quadros:" << std::endl;
+			for (int count : counts) {
+				fillLights(gpuLights, count);
+				vector<unsigned char> images[2];
+				double ms[2];
+				for (int clustered = 1; clustered >= 0; --clustered) {
+					// Com aglomerados a distribuio e o envio fazem parte do quadro
+					auto drawFrame = [&]() {
+						glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+						glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+						if (clustered)
+							gpuLights.build(view, projection, jobs);
+						gpuLights.upload();
+						gpuLights.bind(&shader, width, height, clustered != 0);
+						SceneObj::beginFrame();
+						SceneObj::useMaterial(&shader, library, material);
+						glBindVertexArray(sphere.VAO);
+						glDrawElementsInstanced(GL_TRIANGLES, sphere.numVertices, sphere.indexType, (GLvoid*)0, spheres);
+						glBindVertexArray(0);
+					};
+					drawFrame();
+					glFinish();
+					auto start = std::chrono::steady_clock::now();
+					for (int frame = 0; frame < frames; ++frame)
+						drawFrame();
+					glFinish();
+					ms[clustered] = elapsedMs(start) / frames;
+					images[clustered].resize((size_t)width * height * 4);
+					glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, images[clustered].data());
+				}
+
+				// As duas imagens deveriam ser iguais: uma luz fora da lista do aglomerado aparece aqui
+				int largest = 0;
+				for (size_t p = 0; p < images[0].size(); ++p)
+					largest = std::max(largest, std::abs(images[0][p] - images[1][p]));
+				std::cout << "  " << std::setw(5) << count << " luzes: aglomerados " << std::setw(8) << ms[1] << " ms/quadro, todas "
+					<< std::setw(8) << ms[0] << " ms/quadro (" << std::setprecision(1) << ms[0] / std::max(ms[1], 1e-6)
+					<< "x); maior diferena entre as imagens " << largest << std::setprecision(2) << std::endl;
+			}
+			glDeleteBuffers(1, &instanceVBO);
+			glDeleteProgram(shader.ID);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(2, renderbuffers);
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return 0;
+	}
+
+	// Esferas paradas espalhadas em volta de uma luz pontual e algumas girando em torno dela, num mapa de sombra cbico
+	// de 1024: tempo por quadro (com glFinish) e tringulos desenhados por quadro com as paradas no mapa guardado e com
+	// todas desenhadas a cada quadro. GrauB --bench shadows [quadros] [esferas...]
+	static int benchmarkShadows(const vector<string>& args) {
+		int frames = args.size() > 0 ? std::max(1, atoi(args[0].c_str())) : 50;
+		vector<int> counts;
+		for (size_t i = 1; i < args.size(); ++i)
+			counts.push_back(std::max(1, atoi(args[i].c_str())));
+		if (counts.empty())
+			counts = { 100, 1000, 10000 };
+		const int moving = 16;
+
+		GLFWwindow* window = createHiddenContext();
+		if (window == nullptr)
+			return -1;
+
+		{
+			SceneObjInfo sphere(Primitives::makePath("uvsphere", 32, "Terra.mtl"));
+			ShadowMap shadowMap(1024, 0.5f, 200.0f, 30);
+			glm::vec3 lightPosition(0.0f);
+			std::mt19937 random(1);
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+			std::cout << std::fixed << std::setprecision(2) << sphere.numVertices / 3 << " tringulos por esfera, " << moving
+				<< " em movimento, " << frames << " quadros:" << std::endl;
+			for (int count : counts) {
+				// Esferas de raio 0.3 a 1 entre 5 e 60 unidades da luz, em todas as direes (s renderDepth  usado, sem
+				// o shader da cena)
+				vector<SceneObj> objects;
+				vector<glm::mat4> models(count), scales(count);
+				objects.reserve(count);
+				for (int i = 0; i < count; ++i) {
+					glm::vec3 direction(unit(random) * 2.0f - 1.0f, unit(random) * 2.0f - 1.0f, unit(random) * 2.0f - 1.0f);
+					glm::vec3 position = glm::normalize(direction + glm::vec3(0.0f, 0.0f, 1e-3f)) * (5.0f + 55.0f * unit(random));
+					scales[i] = glm::scale(glm::mat4(1.0f), glm::vec3((0.3f + 0.7f * unit(random)) / sphere.boundingRadius));
+					models[i] = glm::translate(glm::mat4(1.0f), position) * scales[i];
+					objects.emplace_back(position.x, position.y, position.z, sphere, glm::mat4(1.0f), nullptr);
+				}
+				auto moveSpheres = [&](int frame) {
+					for (int i = 0; i < moving && i < count; ++i) {
+						float angle = frame * 0.02f + i, distance = 8.0f + i;
+						models[i] = glm::translate(glm::mat4(1.0f), glm::vec3(std::cos(angle) * distance, 0.0f, std::sin(angle) * distance)) * scales[i];
+					}
+				};
+
+				double ms[2];
+				size_t triangles[2];
+				for (int caching = 1; caching >= 0; --caching) {
+					shadowMap.caching = caching != 0;
+					shadowMap.invalidate();
+					// Quadros at as esferas paradas entrarem no mapa guardado
+					for (int frame = 0; frame <= shadowMap.staticFrames; ++frame) {
+						moveSpheres(frame);
+						shadowMap.render(lightPosition, objects, models);
+					}
+					glFinish();
+					triangles[caching] = 0;
+					auto start = std::chrono::steady_clock::now();
+					for (int frame = 0; frame < frames; ++frame) {
+						moveSpheres(shadowMap.staticFrames + 1 + frame);
+						shadowMap.render(lightPosition, objects, models);
+						triangles[caching] += shadowMap.getTrianglesDrawn();
+					}
+					glFinish();
+					ms[caching] = elapsedMs(start) / frames;
+					triangles[caching] /= frames;
+				}
+				std::cout << "  " << std::setw(6) << count << " esferas: guardado " << std::setw(8) << ms[1] << " ms/quadro ("
+					<< triangles[1] << " tringulos), todas a cada quadro " << std::setw(8) << ms[0] << " ms/quadro (" << triangles[0]
+					<< " tringulos) (" << std::setprecision(1) << ms[0] / std::max(ms[1], 1e-6) << "x)" << std::setprecision(2) << std::endl;
+			}
+		}
+
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		return 0;
+	}
+
+	// Estrela de massa 1000 e um disco de count corpos entre os raios 20 e 40, com massa total 1
+	static NBody makeDisk(int count, bool tree) {
+		NBody bodies(1.0f, 0.05f, 0.5f, tree ? 0 : count + 1);
+		int star = bodies.addBody(glm::vec3(0.0f), glm::vec3(0.0f), 1000.0f);
+		bodies.addBelt(star, count, 20.0f, 40.0f, 1.0f, 1.0f / count, 1);
+		return bodies;
+	}
+
+	static double fillTemporaries(std::pmr::memory_resource* resource, int count) {
+		std::pmr::vector<glm::vec3> vertices(resource), normals(resource);
+		std::pmr::vector<glm::vec2> textureCoordinates(resource);
+		std::pmr::unordered_map<int, int> groups(resource);
+		for (int i = 0; i < count; ++i) {
+			vertices.push_back(glm::vec3((float)i, 0.0f, 1.0f));
+			normals.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+			textureCoordinates.push_back(glm::vec2((float)i, 0.0f));
+			if (i % 16 == 0)
+				groups[i] = i;
+		}
+		return vertices.back().x + normals.size() + textureCoordinates.size() + groups.size();
+	}
+
+	static double sumRange(const vector<float>& values, int begin, int end) {
+		double total = 0;
+		for (int i = begin; i < end; ++i)
+			total += values[i];
+		return total;
+	}
+
+	static long long fibonacci(int n) {
+		return n < 2 ? n : fibonacci(n - 1) + fibonacci(n - 2);
+	}
+
+	// Duas tarefas filhas por chamada; quem espera executa outras tarefas enquanto isso
+	static void fibonacciJob(JobSystem& jobs, int n, long long& result) {
+		if (n <= 15) {
+			result = fibonacci(n);
+			return;
+		}
+		long long a = 0, b = 0;
+		Job* group = jobs.createJob(nullptr);
+		jobs.run(jobs.createChild(group, [&jobs, n, &a]() { fibonacciJob(jobs, n - 1, a); }));
+		jobs.run(jobs.createChild(group, [&jobs, n, &b]() { fibonacciJob(jobs, n - 2, b); }));
+		jobs.run(group);
+		jobs.wait(group);
+		result = a + b;
+	}
+
+	// Cena com as malhas do sistema solar repetidas em posies aleatrias; um objeto a cada oito segue uma curva,
+	// com os pontos em strings como no Scene.json
+	static bool writeSyntheticScene(const string& path, int count) {
+		const char* meshes[] = { "Sol.obj", "Mercurio.obj", "Venus.obj", "Terra.obj", "Marte.obj", "Jupiter.obj", "Saturno.obj", "Urano.obj", "Netuno.obj" };
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			std::cerr << "Erro ao criar a cena de teste: " << path << std::endl;
+			return false;
+		}
+		srand(1);
+		auto random = []() { return (rand() % 20000) / 100.0f - 100.0f; };
+		file << "{\"camera\":{\"fov\":45.0,\"nearPlane\":0.1,\"farPlane\":100.0,\"positionX\":0.0,\"positionY\":0.0,\"positionZ\":10.0},"
+			<< "\"light\":{\"lightPositionX\":-20.0,\"lightPositionY\":0.0,\"lightPositionZ\":0.0,\"lightColorR\":1.0,\"lightColorG\":1.0,\"lightColorB\":1.0},"
+			<< "\"objects\":[";
+		for (int i = 0; i < count; ++i) {
+			file << (i > 0 ? "," : "") << "{\"transfObjectId\":" << i + 1 << ",\"objFilePath\":\"" << meshes[i % 9] << "\",\"positionX\":" << random()
+				<< ",\"positionY\":" << random() << ",\"positionZ\":" << random() << ",\"scale\":1,\"rotate\":\"y\",\"rotateSpeed\":100";
+			if (i % 8 == 0) {
+				file << ",\"curveEnable\":true,\"curvePoints\":[";
+				for (int p = 0; p < 4; ++p)
+					file << (p > 0 ? "," : "") << "[\"" << random() << "\",\"" << random() << "\",\"" << random() << "\"]";
+				file << "]";
+			}
+			file << "}";
+		}
+		file << "]}";
+		return file.good();
+	}
+
+	// Abre cada arquivo pelo VirtualFileSystem e soma os bytes, para que todas as pginas sejam de fato lidas
+	static size_t readAll(const vector<string>& files) {
+		size_t checksum = 0;
+		for (const auto& path : files) {
+			VirtualFile file(path);
+			for (size_t i = 0; i < file.size(); ++i)
+				checksum += file.data()[i];
+		}
+		return checksum;
+	}
+};
\ No newline at end of file
@@ -15,6 +15,13 @@ public:
 	}
 
     void generateCurve(int pointsPerSegment)
+	{
+		generateCurvePoints(pointsPerSegment);
+		createBuffers();
+	}
+
+	// S calcula os pontos da curva (sem OpenGL), o que permite ger-la fora da thread principal
+	void generateCurvePoints(int pointsPerSegment)
 	{
 		float step = 1.0 / (float)pointsPerSegment;
 
@@ -43,7 +50,10 @@ public:
 				curvePoints.push_back(p);
 			}
 		}
+	}
 
+	void createBuffers()
+	{
 		//Gera o VAO
 		GLuint VBO;
 
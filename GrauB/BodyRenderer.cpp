@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "../Common/include/Shader.h"
+#include "SceneSnapshot.cpp"
+#include "SceneObj.cpp"
+#include "Profiler.cpp"
+
+using namespace std;
+
+// Desenha os corpos da gravitao que no so objetos da cena (o cinturo de asteroides) como pontos redondos, com
+// o tamanho caindo com a distncia. As posies mudam a cada passo: o buffer  "rfo" a cada quadro (glBufferData
+// com nullptr antes de copiar), ento o driver entrega memria nova em vez de esperar o desenho anterior terminar.
+class BodyRenderer
+{
+public:
+	BodyRenderer(glm::vec3 color = glm::vec3(0.55f, 0.5f, 0.45f), float pointSize = 60.0f)
+		: shader(Shader::fromSource(vertexSource, fragmentSource)), color(color), pointSize(pointSize)
+	{
+		glGenBuffers(1, &VBO);
+		glGenVertexArrays(1, &VAO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+		glEnableVertexAttribArray(0);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	~BodyRenderer()
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+		glDeleteProgram(shader.ID);
+	}
+
+	BodyRenderer(const BodyRenderer&) = delete;
+	BodyRenderer& operator=(const BodyRenderer&) = delete;
+
+	// Usa a cmera da cpia; o programa de shader da cena precisa ser religado depois (o chamador faz isso)
+	void render(const SceneSnapshot& snapshot)
+	{
+		PROFILE_ZONE("BodyRenderer::render");
+		if (snapshot.bodies.empty())
+			return;
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, snapshot.bodies.size() * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, snapshot.bodies.size() * sizeof(glm::vec3), snapshot.bodies.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		shader.Use();
+		glm::mat4 view = snapshot.view, projection = snapshot.projection;
+		shader.setMat4("view", glm::value_ptr(view));
+		shader.setMat4("projection", glm::value_ptr(projection));
+		shader.setVec3("body_color", color.r, color.g, color.b);
+		shader.setFloat("point_size", pointSize);
+		glEnable(GL_PROGRAM_POINT_SIZE);
+		glBindVertexArray(VAO);
+		SceneObj::countDraw(GL_POINTS, (GLsizei)snapshot.bodies.size());
+		glDrawArrays(GL_POINTS, 0, (GLsizei)snapshot.bodies.size());
+		glBindVertexArray(0);
+		glDisable(GL_PROGRAM_POINT_SIZE);
+	}
+
+private:
+	Shader shader;
+	GLuint VAO = 0, VBO = 0;
+	glm::vec3 color;
+	float pointSize;
+
+	inline static const char* vertexSource = R"(#version 330 core
+layout (location = 0) in vec3 position;
+uniform mat4 view;
+uniform mat4 projection;
+uniform float point_size;
+out float depth;
+void main()
+{
+	vec4 eye = view * vec4(position, 1.0);
+	gl_Position = projection * eye;
+	depth = -eye.z;
+	gl_PointSize = clamp(point_size / max(depth, 0.001), 1.0, 8.0);
+}
+)";
+
+	inline static const char* fragmentSource = R"(#version 330 core
+in float depth;
+out vec4 color;
+uniform vec3 body_color;
+void main()
+{
+	// Ponto redondo, mais escuro na borda
+	vec2 offset = gl_PointCoord * 2.0 - 1.0;
+	float distance2 = dot(offset, offset);
+	if (distance2 > 1.0)
+		discard;
+	color = vec4(body_color * (1.0 - 0.5 * distance2), 1.0);
+}
+)";
+};
\ No newline at end of file
@@ -22,16 +22,44 @@ public:
 
 	void updateProjection()
 	{
-		glm::mat4 projection = glm::perspective(fov, aspectRatio, nearPlane, farPlane);
+		glm::mat4 projection = getProjectionMatrix();
 		shader->setMat4("projection", glm::value_ptr(projection));
 	}
 
 	void updateViewMatrix()
 	{
-		glm::mat4 view = glm::lookAt(position, position + frontDirection, upDirection);
+		glm::mat4 view = getViewMatrix();
 		shader->setMat4("view", glm::value_ptr(view));
 	}
 
+	glm::mat4 getProjectionMatrix() const {
+		return glm::perspective(fov, aspectRatio, nearPlane, farPlane);
+	}
+
+	glm::mat4 getViewMatrix() const {
+		return glm::lookAt(position, position + frontDirection, upDirection);
+	}
+
+	const glm::vec3& getPosition() const {
+		return position;
+	}
+
+	float getFov() const {
+		return fov;
+	}
+
+	float getNearPlane() const {
+		return nearPlane;
+	}
+
+	float getFarPlane() const {
+		return farPlane;
+	}
+
+	int getHeight() const {
+		return height;
+	}
+
 	void updateCameraPosition() {
 		shader->setVec3("camera_pos", position.x, position.y, position.z);
 	}
@@ -54,10 +82,33 @@ public:
 		this->upDirection = upDirection;
 	}
 
+	// fov em radianos; valores <= 0 mantm o atual (chamar updateProjection depois)
+	void setProjection(float fov, float nearPlane, float farPlane) {
+		if (fov > 0.0f)
+			this->fov = fov;
+		if (nearPlane > 0.0f)
+			this->nearPlane = nearPlane;
+		if (farPlane > 0.0f)
+			this->farPlane = farPlane;
+	}
+
+	// Dimetro aproximado, em pixels, de uma esfera de raio "radius" centrada em "center"
+	float getProjectedSize(const glm::vec3& center, float radius) const {
+		return getProjectedSize(center, radius, position, fov, height);
+	}
+
+	// O mesmo para uma cmera guardada (ex.: a cpia da simulao usada pelo desenho)
+	static float getProjectedSize(const glm::vec3& center, float radius, const glm::vec3& position, float fov, int height) {
+		float distance = glm::length(center - position);
+		if (distance <= radius)
+			return (float)height;
+		return radius / (distance * glm::tan(fov / 2.0f)) * height;
+	}
+
+	// S muda o campo de viso: a projeo  enviada pelo desenho a cada quadro (a rolagem  tratada na simulao)
 	void scrollCamera(double yOffset) {
 		fov -= (yOffset * scrollSpeed);
 		fov = glm::clamp(fov, minFov, maxFov);
-		updateProjection();
 	}
 
 	void moveCamera(int key) {
@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Bezier.cpp"
+#include "Camera.cpp"
+#include "SceneSnapshot.cpp"
+
+using namespace std;
+
+// Volta fechada da cmera em torno dos objetos da cena, feita com quatro trechos de Bezier (um quarto de crculo
+// cada, subindo e descendo um pouco) e sempre olhando para o centro deles. A posio depende s do tempo simulado,
+// ento duas execues com os mesmos passos passam pelos mesmos pontos.
+class CameraPath
+{
+public:
+	// duration  o tempo, em segundos, de uma volta completa
+	CameraPath(const SceneSnapshot& snapshot, double duration) : duration(duration)
+	{
+		center = glm::vec3(0);
+		for (const auto& model : snapshot.models)
+			center += glm::vec3(model[3]);
+		if (!snapshot.models.empty())
+			center /= (float)snapshot.models.size();
+		float radius = 0;
+		for (const auto& model : snapshot.models)
+			radius = std::max(radius, glm::length(glm::vec3(model[3]) - center));
+		radius = std::max(radius * 1.2f, 5.0f);
+
+		// Pontos de controle de um crculo no plano XZ (k aproxima um quarto de crculo com uma cbica)
+		const float k = 0.5523f;
+		vector<glm::vec3> controlPoints;
+		for (int i = 0; i < 4; ++i) {
+			float angle = i * glm::half_pi<float>();
+			float nextAngle = (i + 1) * glm::half_pi<float>();
+			glm::vec3 start = center + glm::vec3(cos(angle) * radius, (i % 2 == 0 ? 0.25f : -0.1f) * radius, sin(angle) * radius);
+			glm::vec3 end = center + glm::vec3(cos(nextAngle) * radius, ((i + 1) % 2 == 0 ? 0.25f : -0.1f) * radius, sin(nextAngle) * radius);
+			glm::vec3 startTangent = glm::vec3(-sin(angle), 0, cos(angle)) * radius * k;
+			glm::vec3 endTangent = glm::vec3(-sin(nextAngle), 0, cos(nextAngle)) * radius * k;
+			if (i == 0)
+				controlPoints.push_back(start);
+			controlPoints.push_back(start + startTangent);
+			controlPoints.push_back(end - endTangent);
+			controlPoints.push_back(end);
+		}
+
+		Bezier curve;
+		curve.setControlPoints(controlPoints);
+		curve.generateCurvePoints(pointsPerSegment);
+		for (int i = 0; i < curve.getNbCurvePoints(); ++i)
+			points.push_back(curve.getPointOnCurve(i));
+	}
+
+	// Coloca a cmera no ponto do caminho correspondente ao tempo simulado
+	void apply(Camera& camera, double time) const
+	{
+		if (points.size() < 2)
+			return;
+		double u = std::fmod(time / duration, 1.0) * (points.size() - 1);
+		size_t i = std::min((size_t)u, points.size() - 2);
+		glm::vec3 position = glm::mix(points[i], points[i + 1], (float)(u - i));
+		camera.setPosition(position);
+		camera.setFrontDirection(glm::normalize(center - position));
+		camera.setUpDirection(glm::vec3(0, 1, 0));
+	}
+
+private:
+	static const int pointsPerSegment = 200;
+
+	double duration;
+	glm::vec3 center;
+	vector<glm::vec3> points;
+};
\ No newline at end of file
@@ -0,0 +1,278 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "../Common/include/Shader.h"
+#include "JobSystem.cpp"
+#include "Profiler.cpp"
+
+using namespace std;
+
+// Luzes pontuais da cena, distribudas em aglomerados a cada quadro: o frustum da cmera  dividido em tilesX x tilesY
+// ladrilhos na tela e slices fatias de profundidade (exponenciais entre near e far) e cada aglomerado guarda os ndices
+// das luzes cuja esfera pode toc-lo. A distribuio roda nas threads do JobSystem, uma fatia por tarefa. O FShader.fs
+// l a lista do aglomerado do fragmento em texturas de buffer (a OpenGL 3.3 no tem SSBO): as luzes na unidade 2, o
+// incio e o tamanho da lista de cada aglomerado na 3 e os ndices, de 16 bits, na 4.
+class ClusteredLights
+{
+public:
+	static constexpr int maxLights = 65536;
+	// Teto da reserva de ndices de cada fatia (2 MB); acima dele as listas ainda crescem sob demanda
+	static constexpr size_t maxSliceIndices = (size_t)1 << 20;
+
+	const int tilesX, tilesY, slices;
+
+	ClusteredLights(int tilesX, int tilesY, int slices)
+		: tilesX(std::max(tilesX, 1)), tilesY(std::max(tilesY, 1)), slices(std::max(slices, 1))
+	{
+		clusters.resize((size_t)this->tilesX * this->tilesY * this->slices);
+		sliceIndices.resize(this->slices);
+		sliceRanges.resize(this->slices);
+		sliceOffsets.resize(this->slices);
+	}
+
+	~ClusteredLights()
+	{
+		if (textures[0] != 0) {
+			glDeleteTextures(3, textures);
+			glDeleteBuffers(3, buffers);
+		}
+	}
+
+	ClusteredLights(const ClusteredLights&) = delete;
+	ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+	void clear() {
+		lights.clear();
+	}
+
+	size_t size() const {
+		return lights.size() / 2;
+	}
+
+	// Luz de raio radius em position (no mundo); color j vem multiplicada pela intensidade
+	void add(const glm::vec3& position, float radius, const glm::vec3& color) {
+		if ((int)size() >= maxLights || radius <= 0.0f)
+			return;
+		lights.push_back(glm::vec4(position, radius));
+		lights.push_back(glm::vec4(color, 0.0f));
+	}
+
+	// Reserva as listas para count luzes (no pior caso, cada luz em todos os ladrilhos de cada fatia, at
+	// maxSliceIndices ndices por fatia), para que o build no aloque quando a cmera se move
+	void reserve(int count) {
+		count = std::min(std::max(count, 0), maxLights);
+		if (count <= reservedLights)
+			return;
+		reservedLights = count;
+		size_t perSlice = std::min((size_t)count * tilesX * tilesY, maxSliceIndices);
+		lights.reserve((size_t)count * 2);
+		bounds.reserve(count);
+		for (int slice = 0; slice < slices; ++slice) {
+			sliceRanges[slice].reserve(count);
+			sliceIndices[slice].reserve(perSlice);
+		}
+		indices.reserve(perSlice * slices);
+	}
+
+	// Distribui as luzes nos aglomerados do frustum de view e projection (uma projeo de glm::perspective)
+	void build(const glm::mat4& view, const glm::mat4& projection, JobSystem& jobs) {
+		PROFILE_ZONE("ClusteredLights::build");
+		reserve((int)size());
+		nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+		farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+		tanX = 1.0f / projection[0][0];
+		tanY = 1.0f / projection[1][1];
+		depthScale = slices / std::log(farPlane / nearPlane);
+		depthBias = -std::log(nearPlane) * depthScale;
+
+		// Centro no espao da viso e fatias de cada luz
+		int count = (int)size();
+		bounds.resize(count);
+		jobs.parallelFor(count, 1024, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i) {
+				const glm::vec4& light = lights[i * 2];
+				Bounds& bound = bounds[i];
+				bound.center = glm::vec3(view * glm::vec4(glm::vec3(light), 1.0f));
+				bound.radius = light.w;
+				bound.minDepth = std::max(-bound.center.z - light.w, nearPlane);
+				bound.maxDepth = std::min(-bound.center.z + light.w, farPlane);
+				bound.firstSlice = bound.minDepth <= bound.maxDepth ? getSlice(bound.minDepth) : 1;
+				bound.lastSlice = bound.minDepth <= bound.maxDepth ? getSlice(bound.maxDepth) : 0;
+			}
+		});
+		jobs.parallelFor(slices, 1, [&](int begin, int end) {
+			for (int slice = begin; slice < end; ++slice)
+				binSlice(slice);
+		});
+
+		// Junta as listas das fatias numa s
+		size_t total = 0;
+		for (int slice = 0; slice < slices; ++slice) {
+			sliceOffsets[slice] = (uint32_t)total;
+			total += sliceIndices[slice].size();
+		}
+		indices.resize(total);
+		jobs.parallelFor(slices, 1, [&](int begin, int end) {
+			for (int slice = begin; slice < end; ++slice) {
+				if (!sliceIndices[slice].empty())
+					memcpy(indices.data() + sliceOffsets[slice], sliceIndices[slice].data(), sliceIndices[slice].size() * sizeof(uint16_t));
+				glm::uvec2* cluster = &clusters[(size_t)slice * tilesX * tilesY];
+				for (int c = 0; c < tilesX * tilesY; ++c)
+					cluster[c].x += sliceOffsets[slice];
+			}
+		});
+	}
+
+	// Envia as luzes e as listas do ltimo build (recriando os buffers para no esperar pelo quadro anterior)
+	void upload() {
+		PROFILE_ZONE("ClusteredLights::upload");
+		if (textures[0] == 0) {
+			const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+			glGenBuffers(3, buffers);
+			glGenTextures(3, textures);
+			for (int i = 0; i < 3; ++i) {
+				glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+				glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+				glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+				glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+			}
+			glBindTexture(GL_TEXTURE_BUFFER, 0);
+		}
+		uploadBuffer(buffers[0], lights.data(), lights.size() * sizeof(glm::vec4));
+		uploadBuffer(buffers[1], clusters.data(), clusters.size() * sizeof(glm::uvec2));
+		uploadBuffer(buffers[2], indices.data(), indices.size() * sizeof(uint16_t));
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+
+	// Liga os buffers e passa para o shader os parmetros dos aglomerados de uma tela width x height; sem clustered
+	// cada fragmento percorre todas as luzes
+	void bind(const Shader* shader, int width, int height, bool clustered) const {
+		for (int i = 0; i < 3; ++i) {
+			glActiveTexture(GL_TEXTURE2 + i);
+			glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+		}
+		glActiveTexture(GL_TEXTURE0);
+		shader->setInt("num_lights", textures[0] != 0 ? (int)size() : 0);
+		shader->setBool("clustered_lights", clustered);
+		shader->setVec3("cluster_count", (float)tilesX, (float)tilesY, (float)slices);
+		shader->setVec4("cluster_scale", (float)tilesX / width, (float)tilesY / height, depthScale, depthBias);
+	}
+
+	// Desliga as luzes pontuais no shader da cena
+	static void unbind(const Shader* shader) {
+		shader->setInt("num_lights", 0);
+		shader->setBool("clustered_lights", false);
+	}
+
+	size_t getNumIndices() const {
+		return indices.size();
+	}
+
+	int getNumClusters() const {
+		return (int)clusters.size();
+	}
+
+	// Incio e tamanho da lista do aglomerado e os ndices (para conferir a distribuio sem a GPU)
+	const glm::uvec2& getCluster(int tileX, int tileY, int slice) const {
+		return clusters[((size_t)slice * tilesY + tileY) * tilesX + tileX];
+	}
+
+	const uint16_t* getIndices() const {
+		return indices.data();
+	}
+
+	// Fatia da profundidade depth (distncia ao plano da cmera), com a mesma conta do FShader.fs
+	int getSlice(float depth) const {
+		return std::min(std::max((int)std::floor(std::log(depth) * depthScale + depthBias), 0), slices - 1);
+	}
+
+private:
+	struct Bounds {
+		glm::vec3 center;
+		float radius, minDepth, maxDepth;
+		int firstSlice, lastSlice;
+	};
+
+	// Ladrilhos [x0, x1] x [y0, y1] tocados por uma luz numa fatia
+	struct Range {
+		uint16_t light, x0, x1, y0, y1;
+	};
+
+	// Posio e raio, cor: dois vec4 por luz, no formato da textura de buffer
+	vector<glm::vec4> lights;
+	vector<Bounds> bounds;
+	// Incio (em indices) e tamanho da lista de cada aglomerado, na ordem x, y, fatia
+	vector<glm::uvec2> clusters;
+	vector<uint16_t> indices;
+	vector<vector<uint16_t>> sliceIndices;
+	vector<vector<Range>> sliceRanges;
+	vector<uint32_t> sliceOffsets;
+	int reservedLights = 0;
+	float nearPlane = 0.1f, farPlane = 100.0f, tanX = 1.0f, tanY = 1.0f, depthScale = 1.0f, depthBias = 0.0f;
+	GLuint buffers[3] = {}, textures[3] = {};
+
+	// Monta as listas dos aglomerados de uma fatia (s escreve os dados dela): os ladrilhos de cada luz vm da caixa
+	// da esfera projetada nas duas profundidades do trecho dela dentro da fatia, e as listas so preenchidas por
+	// contagem, com as luzes em ordem
+	void binSlice(int slice) {
+		float sliceNear = std::exp((slice - depthBias) / depthScale), sliceFar = std::exp((slice + 1 - depthBias) / depthScale);
+		vector<Range>& ranges = sliceRanges[slice];
+		ranges.clear();
+		glm::uvec2* cluster = &clusters[(size_t)slice * tilesX * tilesY];
+		for (int c = 0; c < tilesX * tilesY; ++c)
+			cluster[c] = glm::uvec2(0);
+
+		for (int i = 0; i < (int)bounds.size(); ++i) {
+			const Bounds& bound = bounds[i];
+			if (slice < bound.firstSlice || slice > bound.lastSlice)
+				continue;
+			float depths[2] = { std::max(bound.minDepth, sliceNear), std::min(bound.maxDepth, sliceFar) };
+			float left = 1.0f, right = -1.0f, bottom = 1.0f, top = -1.0f;
+			for (float depth : depths) {
+				left = std::min(left, (bound.center.x - bound.radius) / (depth * tanX));
+				right = std::max(right, (bound.center.x + bound.radius) / (depth * tanX));
+				bottom = std::min(bottom, (bound.center.y - bound.radius) / (depth * tanY));
+				top = std::max(top, (bound.center.y + bound.radius) / (depth * tanY));
+			}
+			if (left > 1.0f || right < -1.0f || bottom > 1.0f || top < -1.0f)
+				continue;
+			Range range = { (uint16_t)i, getTile(left, tilesX), getTile(right, tilesX), getTile(bottom, tilesY), getTile(top, tilesY) };
+			ranges.push_back(range);
+			for (int y = range.y0; y <= range.y1; ++y)
+				for (int x = range.x0; x <= range.x1; ++x)
+					++cluster[y * tilesX + x].y;
+		}
+
+		uint32_t total = 0;
+		for (int c = 0; c < tilesX * tilesY; ++c) {
+			cluster[c].x = total;
+			total += cluster[c].y;
+			cluster[c].y = 0;
+		}
+		vector<uint16_t>& out = sliceIndices[slice];
+		out.resize(total);
+		for (const Range& range : ranges)
+			for (int y = range.y0; y <= range.y1; ++y)
+				for (int x = range.x0; x <= range.x1; ++x) {
+					glm::uvec2& entry = cluster[y * tilesX + x];
+					out[entry.x + entry.y++] = range.light;
+				}
+	}
+
+	// Ladrilho da coordenada de tela ndc (de -1 a 1)
+	static uint16_t getTile(float ndc, int tiles) {
+		return (uint16_t)std::min(std::max((int)std::floor((ndc * 0.5f + 0.5f) * tiles), 0), tiles - 1);
+	}
+
+	static void uploadBuffer(GLuint buffer, const void* data, size_t bytes) {
+		glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+		glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(bytes, 16), nullptr, GL_STREAM_DRAW);
+		if (bytes > 0)
+			glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+	}
+};
\ No newline at end of file
@@ -4,24 +4,76 @@ in vec2 tex_coord_shader;
 in vec3 final_color;
 in vec3 frag_pos;
 in vec3 scaled_normal;
+in float view_depth;
+flat in int layer_shader;
 
 out vec4 color;
 
 uniform sampler2D tex_buffer;
+uniform sampler2DArray tex_array;
 
 //Propriedades da superficie
-uniform float ka;
-uniform float kd;
-uniform float ks;
+uniform vec3 ka;
+uniform vec3 kd;
+uniform vec3 ks;
 uniform float q;
 
 //Propriedades da fonte de luz
 uniform vec3 light_pos;
 uniform vec3 light_color;
 
+//Luzes pontuais (ClusteredLights): posio e raio, cor; incio e tamanho da lista de cada aglomerado; ndices das luzes
+layout (binding = 2) uniform samplerBuffer light_data;
+layout (binding = 3) uniform usamplerBuffer cluster_data;
+layout (binding = 4) uniform usamplerBuffer light_indices;
+uniform int num_lights;
+uniform bool clustered_lights;
+uniform vec3 cluster_count;
+//Ladrilhos por pixel (xy) e escala e deslocamento do logaritmo da profundidade (zw)
+uniform vec4 cluster_scale;
+
+//Sombra da luz principal (ShadowMap): mapa cbico de profundidade e os planos near e far e o vis da comparao
+layout (binding = 5) uniform samplerCubeShadow shadow_map;
+uniform bool shadows;
+uniform vec3 shadow_params;
+
 //Posio da Camera
 uniform vec3 camera_pos;
 
+//Frao da luz principal que chega ao fragmento: a profundidade que a face do cubo gravaria para ele (a mesma
+//projeo de 90 graus do ShadowMap) comparada com a do mapa
+float getShadow()
+{
+	if (!shadows)
+		return 1.0;
+	vec3 from_light = frag_pos - light_pos;
+	vec3 distances = abs(from_light);
+	float major = max(distances.x, max(distances.y, distances.z));
+	float n = shadow_params.x, f = shadow_params.y;
+	if (major <= n || major >= f)
+		return 1.0;
+	float depth = ((f + n) / (f - n) - 2.0 * f * n / ((f - n) * major)) * 0.5 + 0.5;
+	return texture(shadow_map, vec4(from_light, depth - shadow_params.z));
+}
+
+//Parcelas difusa e especular de uma luz pontual, que some no raio dela
+void addPointLight(int index, vec3 N, vec3 V, inout vec3 diffuse, inout vec3 specular)
+{
+	vec4 position_radius = texelFetch(light_data, index * 2);
+	vec3 point_color = texelFetch(light_data, index * 2 + 1).rgb;
+	vec3 to_light = position_radius.xyz - frag_pos;
+	float distance2 = dot(to_light, to_light);
+	float radius2 = position_radius.w * position_radius.w;
+	if (distance2 >= radius2)
+		return;
+	float falloff = 1.0 - distance2 / radius2;
+	falloff *= falloff;
+	vec3 L = to_light * inversesqrt(distance2);
+	diffuse += kd * max(dot(N, L), 0.0) * point_color * falloff;
+	vec3 R = reflect(-L, N);
+	specular += ks * pow(max(dot(R, V), 0.0), q) * point_color * falloff;
+}
+
 void main()
 {
 	//color = final_color;
@@ -31,19 +83,36 @@ void main()
 	vec3 ambient = ka * light_color;
 
 	//Clculo da parcela de iluminao difusa
+	float shadow = getShadow();
 	vec3 N = normalize(scaled_normal);
 	vec3 L = normalize(light_pos - frag_pos);
 	float diff = max(dot(N,L),0.0);
-	vec3 diffuse = kd * diff * light_color;
+	vec3 diffuse = kd * diff * light_color * shadow;
 
 	//Clculo da parcela de iluminao especular
 	vec3 V = normalize(camera_pos - frag_pos);
 	vec3 R = normalize(reflect(-L,N));
 	float spec = max(dot(R,V),0.0);
 	spec = pow(spec,q);
-	vec3 specular = ks * spec * light_color;
+	vec3 specular = ks * spec * light_color * shadow;
+
+	//Luzes pontuais: s as do aglomerado do fragmento ou, sem aglomerados, todas
+	if (clustered_lights)
+	{
+		ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy * cluster_scale.xy), int(floor(log(view_depth) * cluster_scale.z + cluster_scale.w)));
+		cluster = clamp(cluster, ivec3(0), ivec3(cluster_count) - 1);
+		uvec2 list = texelFetch(cluster_data, (cluster.z * int(cluster_count.y) + cluster.y) * int(cluster_count.x) + cluster.x).rg;
+		for (uint k = 0u; k < list.y; ++k)
+			addPointLight(int(texelFetch(light_indices, int(list.x + k)).r), N, V, diffuse, specular);
+	}
+	else
+	{
+		for (int i = 0; i < num_lights; ++i)
+			addPointLight(i, N, V, diffuse, specular);
+	}
 
-	vec3 result = (ambient + diffuse) * vec3(texture(tex_buffer, tex_coord_shader)) + specular;
+	vec3 tex_color = layer_shader >= 0 ? vec3(texture(tex_array, vec3(tex_coord_shader, layer_shader))) : vec3(texture(tex_buffer, tex_coord_shader));
+	vec3 result = (ambient + diffuse) * tex_color + specular;
 
 	color = vec4(result,1.0);
 };
\ No newline at end of file
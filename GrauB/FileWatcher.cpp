@@ -0,0 +1,192 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include "AssetPack.cpp"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Avisa quando arquivos vigiados so gravados. No Linux usa inotify nas pastas dos arquivos (editores costumam
+// gravar um arquivo novo e renome-lo por cima do antigo, o que um vigia no prprio arquivo perderia); nos
+// demais sistemas uma thread compara a data de modificao dos arquivos a cada pollInterval.
+class FileWatcher
+{
+public:
+	struct Change {
+		string path;
+		// Quando a primeira gravao foi notada (a latncia da recarga  medida a partir daqui)
+		std::chrono::steady_clock::time_point detected;
+	};
+
+	FileWatcher(int pollIntervalMs = 250) : pollInterval(pollIntervalMs) {}
+
+	~FileWatcher()
+	{
+		stop();
+	}
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// Registra um arquivo; pode ser chamado antes ou depois de start()
+	void watch(const string& filepath)
+	{
+		string path = AssetPack::normalizePath(filepath);
+		lock_guard<mutex> lock(watchMutex);
+		if (!watched.insert({ path, getWriteTime(path) }).second)
+			return;
+#ifdef __linux__
+		string directory = std::filesystem::path(path).has_parent_path() ? std::filesystem::path(path).parent_path().string() : ".";
+		if (inotifyFd >= 0 && !directories.count(directory))
+			addDirectory(directory);
+		directories.insert({ directory, -1 });
+#endif
+	}
+
+	bool isWatching(const string& filepath)
+	{
+		lock_guard<mutex> lock(watchMutex);
+		return watched.count(AssetPack::normalizePath(filepath)) > 0;
+	}
+
+	void start()
+	{
+#ifdef __linux__
+		inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (inotifyFd < 0)
+			std::cerr << "inotify indisponvel; os arquivos sero comparados a cada " << pollInterval << " ms" << std::endl;
+		lock_guard<mutex> lock(watchMutex);
+		for (auto& directory : directories)
+			if (inotifyFd >= 0)
+				addDirectory(directory.first);
+#endif
+		running = true;
+		worker = thread(&FileWatcher::watchLoop, this);
+	}
+
+	void stop()
+	{
+		running = false;
+		if (worker.joinable())
+			worker.join();
+#ifdef __linux__
+		if (inotifyFd >= 0)
+			::close(inotifyFd);
+		inotifyFd = -1;
+#endif
+	}
+
+	// Arquivos alterados desde a ltima chamada, depois de ficarem quietMs sem novas gravaes
+	// (um editor pode gravar o mesmo arquivo mais de uma vez seguida)
+	vector<Change> takeChanges(int quietMs = 50)
+	{
+		vector<Change> changes;
+		auto now = std::chrono::steady_clock::now();
+		lock_guard<mutex> lock(changeMutex);
+		for (auto it = pending.begin(); it != pending.end();) {
+			if (now - it->second.last >= std::chrono::milliseconds(quietMs)) {
+				changes.push_back({ it->first, it->second.first });
+				it = pending.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+		return changes;
+	}
+
+private:
+	struct PendingChange {
+		std::chrono::steady_clock::time_point first, last;
+	};
+
+	int pollInterval;
+	thread worker;
+	atomic<bool> running{ false };
+	mutex watchMutex, changeMutex;
+	map<string, std::filesystem::file_time_type> watched;
+	map<string, PendingChange> pending;
+#ifdef __linux__
+	int inotifyFd = -1;
+	// Pasta -> descritor do inotify
+	map<string, int> directories;
+
+	void addDirectory(const string& directory)
+	{
+		int descriptor = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (descriptor < 0)
+			std::cerr << "No foi possvel vigiar a pasta: " << directory << std::endl;
+		directories[directory] = descriptor;
+	}
+#endif
+
+	static std::filesystem::file_time_type getWriteTime(const string& path)
+	{
+		std::error_code error;
+		return std::filesystem::last_write_time(path, error);
+	}
+
+	void notify(const string& path)
+	{
+		auto now = std::chrono::steady_clock::now();
+		lock_guard<mutex> lock(changeMutex);
+		auto inserted = pending.insert({ path, { now, now } });
+		if (!inserted.second)
+			inserted.first->second.last = now;
+	}
+
+	void watchLoop()
+	{
+#ifdef __linux__
+		if (inotifyFd >= 0) {
+			alignas(inotify_event) char buffer[4096];
+			while (running) {
+				pollfd descriptor = { inotifyFd, POLLIN, 0 };
+				if (poll(&descriptor, 1, 100) <= 0)
+					continue;
+				ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+				for (ssize_t offset = 0; offset < length;) {
+					const inotify_event* event = (const inotify_event*)(buffer + offset);
+					offset += sizeof(inotify_event) + event->len;
+					if (event->len == 0)
+						continue;
+
+					lock_guard<mutex> lock(watchMutex);
+					for (const auto& directory : directories) {
+						if (directory.second != event->wd)
+							continue;
+						string path = AssetPack::normalizePath(directory.first + "/" + event->name);
+						if (watched.count(path))
+							notify(path);
+					}
+				}
+			}
+			return;
+		}
+#endif
+		while (running) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(pollInterval));
+			lock_guard<mutex> lock(watchMutex);
+			for (auto& file : watched) {
+				auto writeTime = getWriteTime(file.first);
+				if (writeTime != file.second) {
+					file.second = writeTime;
+					notify(file.first);
+				}
+			}
+		}
+	}
+};
\ No newline at end of file
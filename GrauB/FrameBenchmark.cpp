@@ -0,0 +1,127 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include "SceneSnapshot.cpp"
+
+using namespace std;
+
+// Medidas do modo --benchmark: tempo de cada quadro (entre duas trocas de buffer, sem vsync), chamadas de desenho,
+// tringulos e alocaes do heap. Os primeiros quadros s aquecem caches e drivers e ficam de fora; depois deles
+// o quadro no deveria alocar nada (os vetores daqui so reservados no construtor para no contarem).
+class FrameBenchmark
+{
+public:
+	FrameBenchmark(int frames, int warmupFrames = 60) : frames(frames), warmupFrames(warmupFrames) {
+		frameMs.reserve(frames);
+		drawCalls.reserve(frames);
+		triangles.reserve(frames);
+		allocations.reserve(frames);
+		bytes.reserve(frames);
+	}
+
+	int getTotalFrames() const {
+		return warmupFrames + frames;
+	}
+
+	bool isFinished() const {
+		return frame >= warmupFrames + frames;
+	}
+
+	// Quadros medidos que alocaram alguma coisa
+	int getAllocatingFrames() const {
+		return (int)std::count_if(allocations.begin(), allocations.end(), [](uint64_t count) { return count > 0; });
+	}
+
+	// Chamado logo depois de cada troca de buffers, com o que foi desenhado e alocado no quadro
+	void endFrame(int drawCalls, size_t triangles, uint64_t allocations = 0, uint64_t bytes = 0) {
+		auto now = std::chrono::steady_clock::now();
+		if (frame >= warmupFrames) {
+			frameMs.push_back(std::chrono::duration<double, std::milli>(now - last).count());
+			this->drawCalls.push_back(drawCalls);
+			this->triangles.push_back(triangles);
+			this->allocations.push_back(allocations);
+			this->bytes.push_back(bytes);
+		}
+		last = now;
+		frame++;
+	}
+
+	// Resumo no console e um quadro por linha em csvPath; checksum identifica o estado final da cena, que 
+	// o mesmo em execues com a mesma entrada
+	void report(ostream& out, const string& csvPath, double stepMs, uint64_t checksum) const {
+		if (frameMs.empty())
+			return;
+		vector<double> sorted = frameMs;
+		std::sort(sorted.begin(), sorted.end());
+		double total = 0, totalDrawCalls = 0, totalTriangles = 0;
+		uint64_t totalAllocations = 0, totalBytes = 0, maxAllocations = 0;
+		for (size_t i = 0; i < frameMs.size(); ++i) {
+			total += frameMs[i];
+			totalDrawCalls += drawCalls[i];
+			totalTriangles += (double)triangles[i];
+			totalAllocations += allocations[i];
+			totalBytes += bytes[i];
+			maxAllocations = std::max(maxAllocations, allocations[i]);
+		}
+
+		auto flags = out.flags();
+		auto precision = out.precision();
+		out << std::fixed << std::setprecision(3);
+		out << "Benchmark: " << frameMs.size() << " quadros (mais " << warmupFrames << " de aquecimento), "
+			<< frameMs.size() * 1000.0 / total << " quadros/s" << endl;
+		out << "  tempo do quadro (ms): mdia " << total / frameMs.size() << ", p50 " << percentile(sorted, 0.50)
+			<< ", p95 " << percentile(sorted, 0.95) << ", p99 " << percentile(sorted, 0.99) << ", mximo " << sorted.back() << endl;
+		out << "  por quadro: " << totalDrawCalls / frameMs.size() << " chamadas de desenho, "
+			<< (size_t)(totalTriangles / frameMs.size()) << " tringulos; passo da simulao " << stepMs << " ms" << endl;
+		out << "  alocaes: " << getAllocatingFrames() << " quadros alocaram; mdia " << (double)totalAllocations / frameMs.size()
+			<< " (" << (double)totalBytes / frameMs.size() << " bytes) e mximo " << maxAllocations << " por quadro" << endl;
+		out << "  estado final: " << std::hex << checksum << std::dec << endl;
+		out.flags(flags);
+		out.precision(precision);
+
+		ofstream csv(csvPath);
+		if (!csv.is_open()) {
+			std::cerr << "Erro ao gravar " << csvPath << std::endl;
+			return;
+		}
+		csv << "quadro;ms;chamadas;triangulos;alocacoes;bytes\n";
+		for (size_t i = 0; i < frameMs.size(); ++i)
+			csv << i << ";" << frameMs[i] << ";" << drawCalls[i] << ";" << triangles[i] << ";" << allocations[i] << ";" << bytes[i] << "\n";
+		out << "  tempos por quadro gravados em " << csvPath << endl;
+	}
+
+	// FNV-1a das matrizes de modelo e da cmera
+	static uint64_t checksum(const SceneSnapshot& snapshot) {
+		uint64_t hash = 14695981039346656037ull;
+		auto add = [&hash](const void* data, size_t size) {
+			const unsigned char* bytes = (const unsigned char*)data;
+			for (size_t i = 0; i < size; ++i)
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+		};
+		if (!snapshot.models.empty())
+			add(snapshot.models.data(), snapshot.models.size() * sizeof(glm::mat4));
+		add(&snapshot.view, sizeof(snapshot.view));
+		add(&snapshot.cameraPosition, sizeof(snapshot.cameraPosition));
+		return hash;
+	}
+
+private:
+	int frames, warmupFrames;
+	int frame = 0;
+	std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+	vector<double> frameMs;
+	vector<int> drawCalls;
+	vector<size_t> triangles;
+	vector<uint64_t> allocations, bytes;
+
+	static double percentile(const vector<double>& sorted, double fraction) {
+		return sorted[std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()))];
+	}
+};
\ No newline at end of file
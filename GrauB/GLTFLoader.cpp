@@ -0,0 +1,488 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "VirtualFileSystem.cpp"
+#include "TextureLoader.cpp"
+#include "MaterialLibrary.cpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+// Primitiva de um mesh glTF j enviada para a GPU
+struct GLTFPrimitive {
+	GLuint VAO = 0;
+	int count = 0;
+	GLenum mode = GL_TRIANGLES;
+	GLenum indexType = 0;
+	size_t indexOffset = 0;
+	int material = -1;
+};
+
+// Instncia de um mesh na hierarquia de ns, com a transformao acumulada dos ns pais
+struct GLTFNodeInstance {
+	int mesh;
+	glm::mat4 transform;
+};
+
+// Importador de glTF 2.0 (GLB ou .gltf + .bin): os buffers ficam mapeados em memria e cada
+// bufferView  entregue diretamente ao glBufferData, sem reempacotar os vrtices
+class GLTFModel
+{
+public:
+	vector<GLTFPrimitive> primitives;
+	vector<vector<int>> meshes;
+	shared_ptr<MaterialLibrary> materials = make_shared<MaterialLibrary>();
+	vector<GLTFNodeInstance> instances;
+
+	GLTFModel() {}
+
+	GLTFModel(const GLTFModel&) = delete;
+	GLTFModel& operator=(const GLTFModel&) = delete;
+
+	bool load(const string& filepath) {
+		if (!parse(filepath))
+			return false;
+		if (!upload()) {
+			release();
+			return false;
+		}
+		return true;
+	}
+
+	// Etapa de CPU: mapeia o arquivo, l o JSON e resolve os buffers (no usa a OpenGL)
+	bool parse(const string& filepath) {
+		this->filepath = filepath;
+		file = make_unique<VirtualFile>(filepath);
+		if (!file->isOpen() || file->size() < 4) {
+			std::cerr << "Erro ao abrir o arquivo glTF: " << filepath << std::endl;
+			return false;
+		}
+
+		const unsigned char* data = file->data();
+		size_t size = file->size();
+		const unsigned char* binChunk = nullptr;
+		size_t binSize = 0;
+
+		try {
+			if (memcmp(data, "glTF", 4) == 0) {
+				// GLB: cabealho de 12 bytes seguido dos chunks JSON e BIN
+				uint32_t version, length;
+				if (size < 20)
+					return reportInvalid("GLB truncado");
+				memcpy(&version, data + 4, 4);
+				memcpy(&length, data + 8, 4);
+				if (version != 2 || length > size)
+					return reportInvalid("verso de GLB no suportada");
+
+				size_t offset = 12;
+				while (offset + 8 <= length) {
+					uint32_t chunkLength, chunkType;
+					memcpy(&chunkLength, data + offset, 4);
+					memcpy(&chunkType, data + offset + 4, 4);
+					const unsigned char* chunk = data + offset + 8;
+					if (offset + 8 + chunkLength > length)
+						return reportInvalid("chunk truncado");
+
+					if (chunkType == 0x4E4F534A)
+						document = json::parse(chunk, chunk + chunkLength);
+					else if (chunkType == 0x004E4942) {
+						binChunk = chunk;
+						binSize = chunkLength;
+					}
+					offset += 8 + ((chunkLength + 3) & ~3u);
+				}
+			}
+			else {
+				document = json::parse(data, data + size);
+			}
+		}
+		catch (const json::exception& e) {
+			return reportInvalid(e.what());
+		}
+
+		// Campos ausentes ou com o tipo errado lanam json::exception e tornam o arquivo invlido
+		try {
+			return resolveBuffers(binChunk, binSize);
+		}
+		catch (const json::exception& e) {
+			return reportInvalid(e.what());
+		}
+	}
+
+	// Etapa de GPU: cria um VBO por bufferView, os VAOs das primitivas e as texturas dos materiais
+	bool upload() {
+		try {
+			return uploadDocument();
+		}
+		catch (const json::exception& e) {
+			glBindVertexArray(0);
+			return reportInvalid(e.what());
+		}
+	}
+
+	// Apaga os VAOs, os buffers e as texturas criados por upload (quando nenhum objeto usa mais as primitivas)
+	void release() {
+		for (auto& primitive : primitives)
+			glDeleteVertexArrays(1, &primitive.VAO);
+		if (!viewBuffers.empty())
+			glDeleteBuffers((GLsizei)viewBuffers.size(), viewBuffers.data());
+		for (int m = 0; m < materials->size(); ++m)
+			if (materials->getTextureId(m) != 0)
+				TextureLoader::releaseTexture(materials->getTextureId(m));
+		primitives.clear();
+		meshes.clear();
+		viewBuffers.clear();
+	}
+
+	// Buffers de vrtices e ndices criados por upload (um por bufferView usado)
+	const vector<GLuint>& getViewBuffers() const {
+		return viewBuffers;
+	}
+
+private:
+	struct BufferRange {
+		const unsigned char* data;
+		size_t size;
+	};
+
+	string filepath;
+	json document;
+	unique_ptr<VirtualFile> file;
+	vector<unique_ptr<VirtualFile>> externalFiles;
+	vector<BufferRange> buffers;
+	vector<BufferRange> bufferViews;
+	vector<GLuint> viewBuffers;
+
+	// Resolve cada buffer (o chunk BIN do GLB ou um arquivo .bin externo, tambm mapeado) e cada bufferView
+	bool resolveBuffers(const unsigned char* binChunk, size_t binSize) {
+		if (!document.contains("asset") || !document.contains("meshes"))
+			return reportInvalid("'asset' ou 'meshes' no encontrado");
+
+		for (const auto& buffer : document.value("buffers", json::array())) {
+			BufferRange range;
+			if (!buffer.contains("uri")) {
+				range = { binChunk, binSize };
+			}
+			else {
+				string uri = buffer.at("uri").get<string>();
+				if (uri.rfind("data:", 0) == 0)
+					return reportInvalid("buffers embutidos em data URI no so suportados");
+				externalFiles.push_back(make_unique<VirtualFile>(getDirectory() + uri));
+				range = { externalFiles.back()->data(), externalFiles.back()->size() };
+			}
+			if (range.data == nullptr || range.size < buffer.value("byteLength", (size_t)0))
+				return reportInvalid("buffer ausente ou menor que o declarado");
+			buffers.push_back(range);
+		}
+
+		for (const auto& view : document.value("bufferViews", json::array())) {
+			size_t bufferIndex = view.value("buffer", (size_t)0);
+			size_t offset = view.value("byteOffset", (size_t)0);
+			size_t length = view.at("byteLength").get<size_t>();
+			if (bufferIndex >= buffers.size() || offset > buffers[bufferIndex].size || length > buffers[bufferIndex].size - offset)
+				return reportInvalid("bufferView fora do buffer");
+			bufferViews.push_back({ buffers[bufferIndex].data + offset, length });
+		}
+
+		collectInstances();
+		return true;
+	}
+
+	// Corpo de upload(), que trata as excees do json
+	bool uploadDocument() {
+		glBindVertexArray(0);
+		viewBuffers.assign(bufferViews.size(), 0);
+
+		for (const auto& material : document.value("materials", json::array()))
+			loadMaterial(material);
+
+		for (const auto& mesh : document.at("meshes")) {
+			vector<int> meshPrimitives;
+			for (const auto& primitive : mesh.at("primitives")) {
+				GLTFPrimitive gltfPrimitive;
+				if (!createPrimitive(primitive, gltfPrimitive))
+					return false;
+				meshPrimitives.push_back((int)primitives.size());
+				primitives.push_back(gltfPrimitive);
+			}
+			meshes.push_back(meshPrimitives);
+		}
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return true;
+	}
+
+	string getDirectory() const {
+		size_t pos = filepath.find_last_of("/\\");
+		return pos == string::npos ? "" : filepath.substr(0, pos + 1);
+	}
+
+	// Percorre a hierarquia de ns da cena padro acumulando as transformaes
+	void collectInstances() {
+		const json nodes = document.value("nodes", json::array());
+		vector<int> roots;
+
+		if (document.contains("scenes") && !document["scenes"].empty()) {
+			size_t sceneIndex = std::min(document.value("scene", (size_t)0), document["scenes"].size() - 1);
+			for (const auto& root : document["scenes"][sceneIndex].value("nodes", json::array()))
+				roots.push_back(root);
+		}
+		else {
+			vector<bool> isChild(nodes.size(), false);
+			for (const auto& node : nodes)
+				for (const auto& child : node.value("children", json::array()))
+					if (child < nodes.size())
+						isChild[child] = true;
+			for (size_t i = 0; i < nodes.size(); ++i)
+				if (!isChild[i])
+					roots.push_back((int)i);
+		}
+
+		for (int root : roots)
+			visitNode(nodes, root, glm::mat4(1.0f), 0);
+	}
+
+	void visitNode(const json& nodes, int index, const glm::mat4& parentTransform, int depth) {
+		if (index < 0 || index >= (int)nodes.size() || depth > 64)
+			return;
+
+		const json& node = nodes[index];
+		glm::mat4 transform = parentTransform * getLocalTransform(node);
+
+		if (node.contains("mesh"))
+			instances.push_back({ node["mesh"].get<int>(), transform });
+
+		for (const auto& child : node.value("children", json::array()))
+			visitNode(nodes, child, transform, depth + 1);
+	}
+
+	static glm::mat4 getLocalTransform(const json& node) {
+		if (node.contains("matrix")) {
+			float values[16];
+			for (int i = 0; i < 16; ++i)
+				values[i] = node.at("matrix").at(i).get<float>();
+			return glm::make_mat4(values);
+		}
+
+		glm::mat4 transform = glm::mat4(1.0f);
+		if (node.contains("translation")) {
+			const auto& t = node.at("translation");
+			transform = glm::translate(transform, glm::vec3(t.at(0).get<float>(), t.at(1).get<float>(), t.at(2).get<float>()));
+		}
+		if (node.contains("rotation")) {
+			const auto& r = node.at("rotation");
+			transform = transform * glm::mat4_cast(glm::quat(r.at(3).get<float>(), r.at(0).get<float>(), r.at(1).get<float>(), r.at(2).get<float>()));
+		}
+		if (node.contains("scale")) {
+			const auto& s = node.at("scale");
+			transform = glm::scale(transform, glm::vec3(s.at(0).get<float>(), s.at(1).get<float>(), s.at(2).get<float>()));
+		}
+		return transform;
+	}
+
+	GLuint getViewBuffer(size_t viewIndex) {
+		if (viewBuffers[viewIndex] == 0) {
+			glGenBuffers(1, &viewBuffers[viewIndex]);
+			glBindBuffer(GL_ARRAY_BUFFER, viewBuffers[viewIndex]);
+			glBufferData(GL_ARRAY_BUFFER, bufferViews[viewIndex].size, bufferViews[viewIndex].data, GL_STATIC_DRAW);
+		}
+		return viewBuffers[viewIndex];
+	}
+
+	// Liga um accessor a um atributo do VAO apontando direto para o VBO do seu bufferView
+	bool bindAccessor(size_t accessorIndex, GLuint location) {
+		const json* accessor = getElement("accessors", accessorIndex);
+		if (accessor == nullptr)
+			return reportInvalid("accessor inexistente");
+		if (!accessor->contains("bufferView") || accessor->contains("sparse"))
+			return reportInvalid("accessors esparsos ou sem bufferView no so suportados");
+
+		size_t viewIndex = accessor->at("bufferView").get<size_t>();
+		const json* view = getElement("bufferViews", viewIndex);
+		if (view == nullptr || viewIndex >= bufferViews.size())
+			return reportInvalid("bufferView inexistente");
+		GLint components = getComponentCount(accessor->at("type").get<string>());
+		GLenum componentType = accessor->at("componentType").get<GLenum>();
+		size_t stride = view->value("byteStride", (size_t)0);
+		size_t offset = accessor->value("byteOffset", (size_t)0);
+		size_t elementSize = components * getComponentSize(componentType);
+		if (elementSize == 0)
+			return reportInvalid("tipo de accessor no suportado");
+		if (!fitsInView(viewIndex, offset, accessor->at("count").get<size_t>(), stride, elementSize))
+			return reportInvalid("accessor fora do bufferView");
+
+		glBindBuffer(GL_ARRAY_BUFFER, getViewBuffer(viewIndex));
+		// Atributos quantizados (inteiros normalizados) so convertidos pela prpria GPU
+		glVertexAttribPointer(location, components, componentType, accessor->value("normalized", false) ? GL_TRUE : GL_FALSE,
+			(GLsizei)stride, (GLvoid*)offset);
+		glEnableVertexAttribArray(location);
+		return true;
+	}
+
+	// Em caso de erro o VAO j criado  apagado, pois a primitiva no entra em primitives
+	bool createPrimitive(const json& primitive, GLTFPrimitive& gltfPrimitive) {
+		glGenVertexArrays(1, &gltfPrimitive.VAO);
+		glBindVertexArray(gltfPrimitive.VAO);
+		bool created;
+		try {
+			created = bindPrimitive(primitive, gltfPrimitive);
+		}
+		catch (const json::exception& e) {
+			created = reportInvalid(e.what());
+		}
+		glBindVertexArray(0);
+		if (!created)
+			glDeleteVertexArrays(1, &gltfPrimitive.VAO);
+		return created;
+	}
+
+	bool bindPrimitive(const json& primitive, GLTFPrimitive& gltfPrimitive) {
+		const json& attributes = primitive.at("attributes");
+		if (!attributes.contains("POSITION"))
+			return reportInvalid("primitiva sem POSITION");
+
+		gltfPrimitive.mode = primitive.value("mode", 4);
+		gltfPrimitive.material = primitive.value("material", -1);
+
+		// Mesmas localizaes do VShader.vs: posio, cor, coordenada de textura e normal
+		const char* names[4] = { "POSITION", "COLOR_0", "TEXCOORD_0", "NORMAL" };
+		for (GLuint location = 0; location < 4; ++location) {
+			if (attributes.contains(names[location])) {
+				if (!bindAccessor(attributes[names[location]], location))
+					return false;
+			}
+			else {
+				glDisableVertexAttribArray(location);
+			}
+		}
+		// Sem COLOR_0 usa a mesma cor fixa dos leitores de OBJ
+		if (!attributes.contains("COLOR_0"))
+			glVertexAttrib3f(1, 1.0f, 0.0f, 1.0f);
+
+		// bindAccessor j conferiu que o accessor de POSITION existe
+		gltfPrimitive.count = getElement("accessors", attributes.at("POSITION").get<size_t>())->at("count").get<int>();
+
+		if (primitive.contains("indices")) {
+			const json* accessor = getElement("accessors", primitive.at("indices").get<size_t>());
+			if (accessor == nullptr || !accessor->contains("bufferView"))
+				return reportInvalid("ndices sem bufferView");
+			size_t viewIndex = accessor->at("bufferView").get<size_t>();
+			GLenum indexType = accessor->at("componentType").get<GLenum>();
+			size_t offset = accessor->value("byteOffset", (size_t)0);
+			int count = accessor->at("count").get<int>();
+			if (indexType != GL_UNSIGNED_BYTE && indexType != GL_UNSIGNED_SHORT && indexType != GL_UNSIGNED_INT)
+				return reportInvalid("tipo de ndice no suportado");
+			if (viewIndex >= bufferViews.size() || count < 0 || !fitsInView(viewIndex, offset, (size_t)count, 0, getComponentSize(indexType)))
+				return reportInvalid("ndices fora do bufferView");
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, getViewBuffer(viewIndex));
+			gltfPrimitive.indexType = indexType;
+			gltfPrimitive.indexOffset = offset;
+			gltfPrimitive.count = count;
+		}
+		return true;
+	}
+
+	// count elementos de elementSize bytes, a cada stride bytes (0 = juntos) a partir de offset, cabem no bufferView
+	bool fitsInView(size_t viewIndex, size_t offset, size_t count, size_t stride, size_t elementSize) const {
+		size_t size = bufferViews[viewIndex].size;
+		if (count == 0)
+			return offset <= size;
+		if (offset > size || elementSize > size - offset)
+			return false;
+		size_t step = stride != 0 ? stride : elementSize;
+		return count - 1 <= (size - offset - elementSize) / step;
+	}
+
+	// Elemento de um array do documento ("accessors", "textures"...), ou nullptr se o ndice estiver fora dele
+	const json* getElement(const char* arrayName, size_t index) const {
+		auto array = document.find(arrayName);
+		if (array == document.end() || !array->is_array() || index >= array->size())
+			return nullptr;
+		return &(*array)[index];
+	}
+
+	// Material PBR do glTF aproximado para os coeficientes de Phong usados pelo FShader.fs
+	void loadMaterial(const json& material) {
+		const json pbr = material.value("pbrMetallicRoughness", json::object());
+
+		glm::vec3 baseColor = glm::vec3(1.0f);
+		if (pbr.contains("baseColorFactor")) {
+			const auto& c = pbr.at("baseColorFactor");
+			baseColor = glm::vec3(c.at(0).get<float>(), c.at(1).get<float>(), c.at(2).get<float>());
+		}
+		float metallic = pbr.value("metallicFactor", 1.0f);
+		float roughness = pbr.value("roughnessFactor", 1.0f);
+
+		// Aproximao: metais refletem pouco difusamente e tm especular da cor base;
+		// a rugosidade vira o expoente de Blinn-Phong equivalente (2 / alfa^2 - 2)
+		glm::vec3 kd = baseColor * (1.0f - 0.5f * metallic);
+		glm::vec3 ka = 0.2f * kd;
+		glm::vec3 ks = glm::mix(glm::vec3(0.04f), baseColor, metallic) * (1.0f - 0.75f * roughness);
+		float alpha = std::max(roughness * roughness, 0.01f);
+		float ns = glm::clamp(2.0f / (alpha * alpha) - 2.0f, 1.0f, 1024.0f);
+
+		GLuint textureId = 0;
+		if (pbr.contains("baseColorTexture"))
+			textureId = loadImage(pbr.at("baseColorTexture").at("index").get<size_t>());
+
+		materials->addMaterial(material.value("name", ""), ka, kd, ks, ns, "", textureId);
+	}
+
+	GLuint loadImage(size_t textureIndex) {
+		const json* texture = getElement("textures", textureIndex);
+		if (texture == nullptr || !texture->contains("source"))
+			return 0;
+
+		const json* image = getElement("images", texture->at("source").get<size_t>());
+		if (image == nullptr)
+			return 0;
+		if (image->contains("bufferView")) {
+			size_t viewIndex = image->at("bufferView").get<size_t>();
+			if (viewIndex >= bufferViews.size())
+				return 0;
+			const BufferRange& view = bufferViews[viewIndex];
+			return TextureLoader::loadTextureFromMemory(view.data, view.size, true);
+		}
+
+		string uri = image->value("uri", "");
+		if (uri.empty() || uri.rfind("data:", 0) == 0)
+			return 0;
+
+		VirtualFile imageFile(getDirectory() + uri);
+		return TextureLoader::loadTextureFromMemory(imageFile.data(), imageFile.size(), true);
+	}
+
+	static size_t getComponentSize(GLenum componentType) {
+		switch (componentType) {
+		case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+		case GL_SHORT: case GL_UNSIGNED_SHORT: return 2;
+		case GL_UNSIGNED_INT: case GL_FLOAT: return 4;
+		default: return 0;
+		}
+	}
+
+	static GLint getComponentCount(const string& type) {
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4" || type == "MAT2") return 4;
+		return 0;
+	}
+
+	bool reportInvalid(const string& reason) const {
+		std::cerr << "Arquivo glTF invlido (" << reason << "): " << filepath << std::endl;
+		return false;
+	}
+};
@@ -0,0 +1,416 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <glad/glad.h>
+#include "../Common/include/Shader.h"
+#include "FileWatcher.cpp"
+#include "Scene.cpp"
+
+using namespace std;
+
+// Recarrega o Scene.json, as malhas, os MTL, as texturas e os shaders quando so gravados, sem fechar o programa.
+// Cada mudana vira um trabalho em duas partes: a leitura do arquivo (parse, decodificao da imagem, compilao
+// da cena) roda numa thread prpria e a aplicao (tudo o que toca a OpenGL ou a lista de objetos) roda na thread
+// principal em update(), entre dois quadros. Se a leitura falhar, a verso anterior continua em uso.
+class HotReload
+{
+public:
+	HotReload(Scene& scene, Shader& shader, const string& scenePath, const string& vertexPath, const string& fragmentPath,
+		function<void()> onShaderReloaded)
+		: scene(scene), shader(shader), scenePath(scenePath), vertexPath(vertexPath), fragmentPath(fragmentPath),
+		onShaderReloaded(onShaderReloaded), watcher(scene.getHotReloadSettings().pollIntervalMs)
+	{
+		auto image = make_shared<SceneImage>();
+		if (SceneCompiler::loadOrCompile(scenePath, *image))
+			liveScene = image;
+
+		watcher.watch(scenePath);
+		watcher.watch(vertexPath);
+		watcher.watch(fragmentPath);
+		watchSceneFiles();
+		watcher.start();
+		running = true;
+		worker = thread(&HotReload::workLoop, this);
+	}
+
+	~HotReload()
+	{
+		{
+			lock_guard<mutex> lock(jobMutex);
+			running = false;
+		}
+		jobReady.notify_all();
+		if (worker.joinable())
+			worker.join();
+		watcher.stop();
+	}
+
+	HotReload(const HotReload&) = delete;
+	HotReload& operator=(const HotReload&) = delete;
+
+	// Uma vez por quadro: agenda as leituras dos arquivos alterados e aplica as que terminaram. Retorna true
+	// quando a lista de objetos da cena mudou (ponteiros para scene.sceneObject deixam de valer).
+	bool update()
+	{
+		for (const auto& change : watcher.takeChanges())
+			schedule(change);
+
+		{
+			lock_guard<mutex> lock(jobMutex);
+			done.assign(finished.begin(), finished.end());
+			finished.clear();
+		}
+
+		bool structural = false;
+		for (const auto& job : done) {
+			if (!job->loaded) {
+				std::cerr << "No foi possvel recarregar " << job->change.path << "; a verso anterior continua em uso" << std::endl;
+				continue;
+			}
+			structural = job->apply() || structural;
+			std::cout << "Recarregado: " << job->change.path << " em "
+				<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job->change.detected).count() << " ms" << std::endl;
+		}
+		// Objetos e materiais novos podem trazer arquivos que ainda no so vigiados
+		if (!done.empty())
+			watchSceneFiles();
+		done.clear();
+		return structural;
+	}
+
+private:
+	struct Job {
+		FileWatcher::Change change;
+		// Roda na thread de leitura
+		function<bool()> read;
+		// Roda na thread principal; retorna true se a lista de objetos mudou
+		function<bool()> apply;
+		bool loaded = false;
+	};
+
+	Scene& scene;
+	Shader& shader;
+	string scenePath, vertexPath, fragmentPath;
+	function<void()> onShaderReloaded;
+	FileWatcher watcher;
+	// Caminho normalizado -> caminho como aparece na cena ou no MTL
+	unordered_map<string, string> meshPaths, materialPaths, texturePaths;
+
+	thread worker;
+	mutex jobMutex, sceneMutex;
+	condition_variable jobReady;
+	bool running = false;
+	deque<shared_ptr<Job>> pending, finished;
+	// Trabalhos terminados que update est aplicando (membro para no alocar a cada quadro)
+	vector<shared_ptr<Job>> done;
+	// ltima verso compilada do Scene.json, base da comparao com a prxima
+	shared_ptr<const SceneImage> liveScene;
+
+	void workLoop()
+	{
+		while (true) {
+			shared_ptr<Job> job;
+			{
+				unique_lock<mutex> lock(jobMutex);
+				jobReady.wait(lock, [this] { return !running || !pending.empty(); });
+				if (!running)
+					return;
+				job = pending.front();
+				pending.pop_front();
+			}
+			job->loaded = job->read();
+			lock_guard<mutex> lock(jobMutex);
+			finished.push_back(job);
+		}
+	}
+
+	void enqueue(const FileWatcher::Change& change, function<bool()> read, function<bool()> apply)
+	{
+		auto job = make_shared<Job>();
+		job->change = change;
+		job->read = read;
+		job->apply = apply;
+		{
+			lock_guard<mutex> lock(jobMutex);
+			pending.push_back(job);
+		}
+		jobReady.notify_one();
+	}
+
+	void schedule(const FileWatcher::Change& change)
+	{
+		const string& path = change.path;
+		if (path == AssetPack::normalizePath(scenePath))
+			scheduleScene(change);
+		else if (path == AssetPack::normalizePath(vertexPath) || path == AssetPack::normalizePath(fragmentPath))
+			scheduleShader(change);
+		else if (materialPaths.count(path))
+			scheduleMaterial(change, materialPaths[path]);
+		else if (meshPaths.count(path))
+			scheduleMesh(change, meshPaths[path]);
+		else if (texturePaths.count(path))
+			scheduleTexture(change, texturePaths[path]);
+	}
+
+	// Compila o Scene.json de novo e compara com a verso anterior: luz e cmera so trocadas, objetos alterados
+	// so atualizados (as malhas novas j vm lidas) e os demais blocos s valem no prximo incio do programa
+	void scheduleScene(const FileWatcher::Change& change)
+	{
+		struct SceneChanges {
+			shared_ptr<SceneImage> image = make_shared<SceneImage>();
+			vector<int> objects;
+			bool light = false, camera = false, options = false;
+			unordered_map<string, MeshData> meshes;
+		};
+		auto changes = make_shared<SceneChanges>();
+
+		enqueue(change, [this, changes]() {
+			vector<unsigned char> bytes;
+			if (!SceneCompiler::compileFile(scenePath, bytes))
+				return false;
+			SceneCompiler::write(SceneCompiler::getCachePath(scenePath), bytes);
+			if (!changes->image->load(std::move(bytes)))
+				return false;
+
+			shared_ptr<const SceneImage> previous;
+			{
+				lock_guard<mutex> lock(sceneMutex);
+				previous = liveScene;
+				liveScene = changes->image;
+			}
+			compareScenes(previous.get(), *changes->image, *changes);
+			return true;
+		}, [this, changes]() {
+			const SceneImageSettings& settings = changes->image->getSettings();
+			scene.reloadSettings(settings, changes->light, changes->camera);
+			if (changes->options)
+				std::cout << "Scene.json: mudanas nos blocos de texturas, envio, residncia, simulao, gravitao e cinturo de rbitas valem a partir do prximo incio" << std::endl;
+			return scene.reloadObjects(*changes->image, changes->objects, changes->meshes);
+		});
+	}
+
+	template <typename Changes>
+	static void compareScenes(const SceneImage* previous, const SceneImage& current, Changes& changes)
+	{
+		const SceneImageSettings& settings = current.getSettings();
+		SceneImageSettings before = previous != nullptr ? previous->getSettings() : SceneImageSettings();
+		uint32_t cameraFlags = SceneImageSettings::hasCamera | SceneImageSettings::hasCameraPosition |
+			SceneImageSettings::hasCameraFront | SceneImageSettings::hasCameraUp;
+
+		changes.light = (settings.flags & SceneImageSettings::hasLight) != (before.flags & SceneImageSettings::hasLight) ||
+			memcmp(settings.lightPosition, before.lightPosition, sizeof(settings.lightPosition)) != 0 ||
+			memcmp(settings.lightColor, before.lightColor, sizeof(settings.lightColor)) != 0;
+		changes.camera = (settings.flags & cameraFlags) != (before.flags & cameraFlags) ||
+			memcmp(&settings.camera, &before.camera, sizeof(settings.camera)) != 0;
+		changes.options = !sameOptions(settings, before) ||
+			(previous != nullptr && getCompression(current) != getCompression(*previous));
+
+		int numPrevious = previous != nullptr ? previous->getNumObjects() : 0;
+		for (int i = 0; i < std::max(current.getNumObjects(), numPrevious); ++i) {
+			if (i >= current.getNumObjects()) {
+				changes.objects.push_back(i);
+				continue;
+			}
+			SceneObjAux obj = current.getObjectAux(i);
+			SceneObjAux old = i < numPrevious ? previous->getObjectAux(i) : SceneObjAux();
+			if (i < numPrevious && sameObject(obj, old))
+				continue;
+			changes.objects.push_back(i);
+
+			// Malha que o objeto ainda no usava: j  lida aqui, fora da thread principal
+			string extension = MeshLoader::getExtension(obj.objFilePath);
+			if ((i >= numPrevious || obj.objFilePath != old.objFilePath) && extension != "glb" && extension != "gltf" &&
+				!changes.meshes.count(obj.objFilePath)) {
+				MeshData data;
+				if (SceneObjInfo::readMesh(obj.objFilePath, data))
+					changes.meshes[obj.objFilePath] = std::move(data);
+			}
+		}
+	}
+
+	static bool sameObject(const SceneObjAux& a, const SceneObjAux& b)
+	{
+		return a.transfObjectId == b.transfObjectId && a.x == b.x && a.y == b.y && a.z == b.z && a.scale == b.scale &&
+			a.rotateSpeed == b.rotateSpeed && a.curveEnable == b.curveEnable && a.objFilePath == b.objFilePath &&
+			a.rotate == b.rotate && a.curvePoints == b.curvePoints && a.mass == b.mass && a.velocity == b.velocity &&
+			memcmp(&a.orbit, &b.orbit, sizeof(a.orbit)) == 0 && memcmp(&a.particles, &b.particles, sizeof(a.particles)) == 0 &&
+			memcmp(&a.light, &b.light, sizeof(a.light)) == 0 && a.castShadows == b.castShadows;
+	}
+
+	static bool sameOptions(const SceneImageSettings& a, const SceneImageSettings& b)
+	{
+		return a.atlas.enabled == b.atlas.enabled && a.atlas.pageSize == b.atlas.pageSize && a.atlas.padding == b.atlas.padding &&
+			a.atlas.maxTextureSize == b.atlas.maxTextureSize && a.textureArrays.enabled == b.textureArrays.enabled &&
+			a.textureArrays.width == b.textureArrays.width && a.textureArrays.height == b.textureArrays.height &&
+			a.upload.enabled == b.upload.enabled && a.upload.ringSizeMB == b.upload.ringSizeMB &&
+			a.upload.frameBudgetMB == b.upload.frameBudgetMB && a.residency.enabled == b.residency.enabled &&
+			a.residency.budgetMB == b.residency.budgetMB && a.residency.tailSize == b.residency.tailSize &&
+			a.hotReload.enabled == b.hotReload.enabled && a.hotReload.pollIntervalMs == b.hotReload.pollIntervalMs &&
+			a.simulation.enabled == b.simulation.enabled && a.simulation.stepsPerSecond == b.simulation.stepsPerSecond &&
+			a.simulation.maxStepsPerFrame == b.simulation.maxStepsPerFrame && a.gravity.enabled == b.gravity.enabled &&
+			a.gravity.circularVelocities == b.gravity.circularVelocities && a.gravity.G == b.gravity.G &&
+			a.gravity.softening == b.gravity.softening && a.gravity.theta == b.gravity.theta &&
+			a.gravity.directLimit == b.gravity.directLimit && a.gravity.substeps == b.gravity.substeps &&
+			a.gravity.asteroids == b.gravity.asteroids && a.gravity.asteroidInnerRadius == b.gravity.asteroidInnerRadius &&
+			a.gravity.asteroidOuterRadius == b.gravity.asteroidOuterRadius && a.gravity.asteroidThickness == b.gravity.asteroidThickness &&
+			a.gravity.asteroidMass == b.gravity.asteroidMass && a.gravity.asteroidSeed == b.gravity.asteroidSeed &&
+			memcmp(&a.orbitBelt, &b.orbitBelt, sizeof(a.orbitBelt)) == 0;
+	}
+
+	static string getCompression(const SceneImage& image)
+	{
+		const SceneImageSettings& settings = image.getSettings();
+		return settings.flags & SceneImageSettings::hasCompression ? image.getString(settings.compressionFormat) : "";
+	}
+
+	// OBJ, PLY e STL so lidos na thread de leitura; um glTF cria os buffers enquanto  lido, ento os objetos
+	// dele so recriados na thread principal
+	void scheduleMesh(const FileWatcher::Change& change, const string& objFilePath)
+	{
+		string extension = MeshLoader::getExtension(objFilePath);
+		if (extension == "glb" || extension == "gltf") {
+			enqueue(change, []() { return true; }, [this, objFilePath]() {
+				shared_ptr<const SceneImage> image;
+				{
+					lock_guard<mutex> lock(sceneMutex);
+					image = liveScene;
+				}
+				if (!image)
+					return false;
+				vector<int> indices;
+				for (const auto& obj : scene.sceneObject)
+					if (obj.sceneObjInfo.getObjFilePath() == objFilePath && obj.sceneIndex >= 0 &&
+						std::find(indices.begin(), indices.end(), obj.sceneIndex) == indices.end())
+						indices.push_back(obj.sceneIndex);
+				return scene.reloadObjects(*image, indices, {}, true);
+			});
+			return;
+		}
+
+		auto data = make_shared<MeshData>();
+		enqueue(change, [objFilePath, data]() {
+			return SceneObjInfo::readMesh(objFilePath, *data);
+		}, [this, objFilePath, data]() {
+			scene.reloadMesh(objFilePath, *data);
+			return false;
+		});
+	}
+
+	// Os ndices de material das sub-malhas dependem da ordem dos materiais no MTL, ento as malhas que usam
+	// o arquivo so lidas de novo junto com ele
+	void scheduleMaterial(const FileWatcher::Change& change, const string& mtlFilePath)
+	{
+		auto library = make_shared<shared_ptr<MaterialLibrary>>();
+		auto meshes = make_shared<vector<pair<string, MeshData>>>();
+		for (const auto& path : scene.getMeshesUsingMaterial(mtlFilePath))
+			meshes->push_back({ path, MeshData() });
+
+		enqueue(change, [mtlFilePath, library, meshes]() {
+			*library = MaterialLibrary::read(mtlFilePath);
+			for (auto& mesh : *meshes)
+				if (!SceneObjInfo::readMesh(mesh.first, mesh.second))
+					return false;
+			return (*library)->size() > 0;
+		}, [this, mtlFilePath, library, meshes]() {
+			MaterialLibrary::replace(mtlFilePath, *library);
+			for (const auto& mesh : *meshes)
+				scene.reloadMesh(mesh.first, mesh.second);
+			return false;
+		});
+	}
+
+	// A textura  reescrita no mesmo identificador (ou na mesma camada do array), ento os materiais no mudam
+	void scheduleTexture(const FileWatcher::Change& change, const string& filepath)
+	{
+		if (TextureResidency::current != nullptr) {
+			std::cout << "Textura alterada: " << filepath << " (com a residncia de texturas ligada, vale a partir do prximo incio)" << std::endl;
+			return;
+		}
+
+		TextureArray* textureArray = scene.textureArray.get();
+		if (textureArray != nullptr && textureArray->contains(filepath)) {
+			auto layer = make_shared<TextureArray::LayerData>();
+			enqueue(change, [textureArray, filepath, layer]() {
+				return textureArray->readLayer(filepath, *layer);
+			}, [textureArray, filepath, layer]() {
+				textureArray->updateLayer(filepath, *layer);
+				return false;
+			});
+			return;
+		}
+
+		GLuint texID = TextureLoader::findTexture(filepath);
+		auto source = make_shared<TextureLoader::TextureSource>();
+		if (texID == 0 || !TextureLoader::prepareSource(filepath, *source)) {
+			std::cout << "Textura alterada: " << filepath << " (est num atlas; vale a partir do prximo incio)" << std::endl;
+			return;
+		}
+		enqueue(change, [filepath, source]() {
+			return TextureLoader::readSource(filepath, *source);
+		}, [texID, source]() {
+			TextureLoader::updateTexture(texID, *source);
+			return false;
+		});
+	}
+
+	// O programa novo s substitui o anterior se compilar e ligar; com erro, o shader antigo continua em uso
+	void scheduleShader(const FileWatcher::Change& change)
+	{
+		auto sources = make_shared<pair<string, string>>();
+		enqueue(change, [this, sources]() {
+			VirtualFile vertexFile(vertexPath), fragmentFile(fragmentPath);
+			if (!vertexFile.isOpen() || !fragmentFile.isOpen())
+				return false;
+			sources->first = vertexFile.toString();
+			sources->second = fragmentFile.toString();
+			return true;
+		}, [this, sources]() {
+			Shader reloaded = Shader::fromSource(sources->first, sources->second);
+			GLint linked = 0;
+			glGetProgramiv(reloaded.ID, GL_LINK_STATUS, &linked);
+			if (!linked) {
+				glDeleteProgram(reloaded.ID);
+				std::cerr << "Shader com erro; o programa anterior continua em uso" << std::endl;
+				return false;
+			}
+			glDeleteProgram(shader.ID);
+			shader.ID = reloaded.ID;
+			glUseProgram(shader.ID);
+			if (onShaderReloaded)
+				onShaderReloaded();
+			return false;
+		});
+	}
+
+	// Vigia os arquivos de malha, os MTL e as texturas usados pelos objetos atuais (uma primitiva s tem o MTL)
+	void watchSceneFiles()
+	{
+		for (const auto& obj : scene.sceneObject) {
+			const string& objFilePath = obj.sceneObjInfo.getObjFilePath();
+			if (!Primitives::isPrimitive(objFilePath))
+				addWatch(meshPaths, objFilePath);
+			const string& mtlFilePath = obj.sceneObjInfo.getMaterialFilePath();
+			if (!mtlFilePath.empty())
+				addWatch(materialPaths, mtlFilePath);
+			for (const auto& diffuseMap : obj.sceneObjInfo.materialLibrary->diffuseMaps)
+				if (!diffuseMap.empty())
+					addWatch(texturePaths, diffuseMap);
+		}
+	}
+
+	void addWatch(unordered_map<string, string>& paths, const string& filepath)
+	{
+		string path = AssetPack::normalizePath(filepath);
+		if (paths.insert({ path, filepath }).second)
+			watcher.watch(filepath);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,330 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "../Common/include/Shader.h"
+#include "MaterialLibrary.cpp"
+#include "SceneObj.cpp"
+#include "ClusteredLights.cpp"
+#include "ShadowMap.cpp"
+#include "Profiler.cpp"
+
+using namespace std;
+
+// Desenha esferas como um quadrado voltado para a cmera (4 vrtices em vez da malha inteira): o fragment shader
+// intersecta o raio da cmera com a esfera e calcula a profundidade, a normal e a coordenada de textura (a mesma da
+// esfera UV das Primitives) do ponto atingido, com a mesma iluminao de Phong do FShader.fs (luz principal e luzes
+// pontuais, sombra do ShadowMap). As esferas so agrupadas por textura, uma chamada instanciada por grupo. A escala
+// do modelo precisa ser uniforme.
+class ImpostorRenderer
+{
+public:
+	ImpostorRenderer() : shader(Shader::fromSource(vertexSource, fragmentSource))
+	{
+		const GLfloat corners[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &cornerVBO);
+		glGenBuffers(1, &instanceVBO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, cornerVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)0);
+		glEnableVertexAttribArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		for (int attribute = 1; attribute <= instanceVectors; ++attribute) {
+			glEnableVertexAttribArray(attribute);
+			glVertexAttribDivisor(attribute, 1);
+		}
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		shader.Use();
+		shader.setInt("tex_buffer", 0);
+		shader.setInt("tex_array", 1);
+		shader.setInt("light_data", 2);
+		shader.setInt("cluster_data", 3);
+		shader.setInt("light_indices", 4);
+		shader.setInt("shadow_map", 5);
+	}
+
+	~ImpostorRenderer()
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &cornerVBO);
+		glDeleteBuffers(1, &instanceVBO);
+		glDeleteProgram(shader.ID);
+	}
+
+	ImpostorRenderer(const ImpostorRenderer&) = delete;
+	ImpostorRenderer& operator=(const ImpostorRenderer&) = delete;
+
+	void clear() {
+		instances.clear();
+		textures.clear();
+	}
+
+	size_t size() const {
+		return instances.size();
+	}
+
+	// Esfera de raio radius (no espao do modelo, em torno da origem dele) com o material e a textura do objeto
+	void add(const glm::mat4& model, float radius, const MaterialLibrary* library, int material) {
+		bool valid = material >= 0 && material < library->size();
+		Instance instance;
+		instance.model = model;
+		instance.uvTransform = valid ? library->uvTransforms[material] : glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+		instance.ambient = glm::vec4(valid ? library->ambient[material] : glm::vec3(0.2f), valid ? library->shininess[material] : 32.0f);
+		instance.diffuse = glm::vec4(valid ? library->diffuse[material] : glm::vec3(0.8f), (float)library->getTextureLayer(material));
+		instance.specular = glm::vec4(valid ? library->specular[material] : glm::vec3(0.5f), radius);
+		instances.push_back(instance);
+		textures.push_back(library->getTextureId(material));
+	}
+
+	// Usa o seu prprio programa de shader; o da cena precisa ser religado depois (o chamador faz isso). Desenhar
+	// depois dos objetos: as texturas ligadas aqui no passam pelo controle de SceneObj::useMaterial. lights (pode ser
+	// nulo) so as luzes pontuais j distribudas para a tela width x height, como no shader da cena; shadowMap (pode
+	// ser nulo)  o mapa j desenhado neste quadro.
+	void render(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPosition,
+		const glm::vec3& lightPosition, const glm::vec3& lightColor, const ClusteredLights* lights, int width, int height, bool clustered,
+		const ShadowMap* shadowMap) {
+		PROFILE_ZONE("ImpostorRenderer::render");
+		if (instances.empty())
+			return;
+
+		// Agrupa por textura (as de array depois das 2D)
+		order.resize(instances.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			order[i] = (int)i;
+		std::sort(order.begin(), order.end(), [this](int a, int b) {
+			bool arrayA = instances[a].diffuse.w >= 0.0f, arrayB = instances[b].diffuse.w >= 0.0f;
+			return arrayA != arrayB ? arrayB : textures[a] < textures[b];
+		});
+		sorted.resize(instances.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			sorted[i] = instances[order[i]];
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		glBufferData(GL_ARRAY_BUFFER, sorted.size() * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sorted.size() * sizeof(Instance), sorted.data());
+
+		shader.Use();
+		glm::mat4 viewMatrix = view, projectionMatrix = projection;
+		shader.setMat4("view", glm::value_ptr(viewMatrix));
+		shader.setMat4("projection", glm::value_ptr(projectionMatrix));
+		shader.setVec3("camera_pos", cameraPosition.x, cameraPosition.y, cameraPosition.z);
+		shader.setVec3("light_pos", lightPosition.x, lightPosition.y, lightPosition.z);
+		shader.setVec3("light_color", lightColor.r, lightColor.g, lightColor.b);
+		if (lights != nullptr)
+			lights->bind(&shader, width, height, clustered);
+		else
+			ClusteredLights::unbind(&shader);
+		if (shadowMap != nullptr)
+			shadowMap->bind(&shader);
+		else
+			ShadowMap::unbind(&shader);
+		glBindVertexArray(VAO);
+		for (size_t first = 0; first < sorted.size();) {
+			GLuint texture = textures[order[first]];
+			bool arrayTexture = sorted[first].diffuse.w >= 0.0f;
+			size_t end = first + 1;
+			while (end < sorted.size() && textures[order[end]] == texture && (sorted[end].diffuse.w >= 0.0f) == arrayTexture)
+				++end;
+
+			if (arrayTexture) {
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+				glActiveTexture(GL_TEXTURE0);
+			}
+			else {
+				glBindTexture(GL_TEXTURE_2D, texture);
+			}
+			for (int slot = 0; slot < instanceVectors; ++slot)
+				glVertexAttribPointer(1 + slot, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+					(GLvoid*)(first * sizeof(Instance) + slot * sizeof(glm::vec4)));
+			SceneObj::countDraw(GL_TRIANGLE_STRIP, 4, (GLsizei)(end - first));
+			glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)(end - first));
+			first = end;
+		}
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+private:
+	// Matriz de modelo (atributos 1-4), transformao da textura no atlas (5), ka e q (6), kd e camada da textura
+	// de array, -1 para a 2D (7), ks e raio no espao do modelo (8)
+	struct Instance {
+		glm::mat4 model;
+		glm::vec4 uvTransform, ambient, diffuse, specular;
+	};
+	static const int instanceVectors = 8;
+
+	Shader shader;
+	GLuint VAO = 0, cornerVBO = 0, instanceVBO = 0;
+	vector<Instance> instances, sorted;
+	vector<GLuint> textures;
+	vector<int> order;
+
+	inline static const char* vertexSource = R"(#version 330 core
+layout (location = 0) in vec2 corner;
+layout (location = 1) in mat4 instance_model;
+layout (location = 5) in vec4 instance_uv_transform;
+layout (location = 6) in vec4 instance_ambient;
+layout (location = 7) in vec4 instance_diffuse;
+layout (location = 8) in vec4 instance_specular;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 camera_pos;
+out vec3 quad_pos;
+flat out vec3 center;
+flat out float radius;
+flat out mat3 inverse_rotation;
+flat out vec4 uv_transform;
+flat out vec4 ambient_q;
+flat out vec4 diffuse_layer;
+flat out vec3 specular_color;
+void main()
+{
+	float scale = length(instance_model[0].xyz);
+	center = instance_model[3].xyz;
+	radius = instance_specular.w * scale;
+	inverse_rotation = transpose(mat3(instance_model) / scale);
+	uv_transform = instance_uv_transform;
+	ambient_q = instance_ambient;
+	diffuse_layer = instance_diffuse;
+	specular_color = instance_specular.xyz;
+
+	// Quadrado perpendicular  linha at a cmera, grande o bastante para cobrir o cone tangente  esfera
+	vec3 forward = camera_pos - center;
+	float camera_distance = length(forward);
+	forward /= camera_distance;
+	vec3 right = normalize(cross(abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0), forward));
+	vec3 up = cross(forward, right);
+	float half_size = radius * camera_distance / sqrt(max(camera_distance * camera_distance - radius * radius, 1e-6));
+	quad_pos = center + (right * corner.x + up * corner.y) * half_size;
+	gl_Position = projection * view * vec4(quad_pos, 1.0);
+}
+)";
+
+	inline static const char* fragmentSource = R"(#version 330 core
+in vec3 quad_pos;
+flat in vec3 center;
+flat in float radius;
+flat in mat3 inverse_rotation;
+flat in vec4 uv_transform;
+flat in vec4 ambient_q;
+flat in vec4 diffuse_layer;
+flat in vec3 specular_color;
+out vec4 color;
+uniform sampler2D tex_buffer;
+uniform sampler2DArray tex_array;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 light_pos;
+uniform vec3 light_color;
+uniform vec3 camera_pos;
+uniform samplerBuffer light_data;
+uniform usamplerBuffer cluster_data;
+uniform usamplerBuffer light_indices;
+uniform int num_lights;
+uniform bool clustered_lights;
+uniform vec3 cluster_count;
+uniform vec4 cluster_scale;
+uniform samplerCubeShadow shadow_map;
+uniform bool shadows;
+uniform vec3 shadow_params;
+const float PI = 3.14159265;
+
+// Sombra da luz principal, como a getShadow do FShader.fs
+float getShadow(vec3 frag_pos)
+{
+	if (!shadows)
+		return 1.0;
+	vec3 from_light = frag_pos - light_pos;
+	vec3 distances = abs(from_light);
+	float major = max(distances.x, max(distances.y, distances.z));
+	float n = shadow_params.x, f = shadow_params.y;
+	if (major <= n || major >= f)
+		return 1.0;
+	float depth = ((f + n) / (f - n) - 2.0 * f * n / ((f - n) * major)) * 0.5 + 0.5;
+	return texture(shadow_map, vec4(from_light, depth - shadow_params.z));
+}
+
+// Luz pontual como a addPointLight do FShader.fs, com o material da instncia
+void addPointLight(int index, vec3 frag_pos, vec3 N, vec3 V, inout vec3 diffuse, inout vec3 specular)
+{
+	vec4 position_radius = texelFetch(light_data, index * 2);
+	vec3 point_color = texelFetch(light_data, index * 2 + 1).rgb;
+	vec3 to_light = position_radius.xyz - frag_pos;
+	float distance2 = dot(to_light, to_light);
+	float radius2 = position_radius.w * position_radius.w;
+	if (distance2 >= radius2)
+		return;
+	float falloff = 1.0 - distance2 / radius2;
+	falloff *= falloff;
+	vec3 L = to_light * inversesqrt(distance2);
+	diffuse += diffuse_layer.rgb * max(dot(N, L), 0.0) * point_color * falloff;
+	vec3 R = reflect(-L, N);
+	specular += specular_color * pow(max(dot(R, V), 0.0), ambient_q.a) * point_color * falloff;
+}
+
+void main()
+{
+	// Ponto mais prximo em que o raio da cmera at este ponto do quadrado entra na esfera
+	vec3 ray = normalize(quad_pos - camera_pos);
+	vec3 offset = camera_pos - center;
+	float b = dot(offset, ray);
+	float h = b * b - dot(offset, offset) + radius * radius;
+	vec3 frag_pos = camera_pos + ray * (-b - sqrt(max(h, 0.0)));
+	vec3 N = (frag_pos - center) / radius;
+
+	// Coordenada de textura da esfera UV no espao do modelo, com v invertido como no VShader.vs. As derivadas em u
+	// vm da coordenada sem a costura perto deste pixel, seno a costura escolheria o menor mipmap.
+	vec3 local = inverse_rotation * N;
+	float u = 0.25 + atan(local.x, local.z) / (2.0 * PI);
+	vec2 tex_coord = vec2(fract(u), 0.5 - asin(clamp(local.y, -1.0, 1.0)) / PI);
+	float seamless = fract(u + 0.5);
+	vec2 dx = dFdx(tex_coord), dy = dFdy(tex_coord);
+	float seamlessDx = dFdx(seamless), seamlessDy = dFdy(seamless);
+	if (abs(seamlessDx) + abs(seamlessDy) < abs(dx.x) + abs(dy.x)) {
+		dx.x = seamlessDx;
+		dy.x = seamlessDy;
+	}
+	if (h < 0.0)
+		discard;
+	vec4 clip = projection * view * vec4(frag_pos, 1.0);
+	gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+	// Mesmos termos do FShader.fs
+	vec3 ambient = ambient_q.rgb * light_color;
+	float shadow = getShadow(frag_pos);
+	vec3 L = normalize(light_pos - frag_pos);
+	float diff = max(dot(N, L), 0.0);
+	vec3 diffuse = diffuse_layer.rgb * diff * light_color * shadow;
+	vec3 V = normalize(camera_pos - frag_pos);
+	vec3 R = normalize(reflect(-L, N));
+	float spec = pow(max(dot(R, V), 0.0), ambient_q.a);
+	vec3 specular = specular_color * spec * light_color * shadow;
+	if (clustered_lights) {
+		float view_depth = -(view * vec4(frag_pos, 1.0)).z;
+		ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy * cluster_scale.xy), int(floor(log(view_depth) * cluster_scale.z + cluster_scale.w)));
+		cluster = clamp(cluster, ivec3(0), ivec3(cluster_count) - 1);
+		uvec2 list = texelFetch(cluster_data, (cluster.z * int(cluster_count.y) + cluster.y) * int(cluster_count.x) + cluster.x).rg;
+		for (uint k = 0u; k < list.y; ++k)
+			addPointLight(int(texelFetch(light_indices, int(list.x + k)).r), frag_pos, N, V, diffuse, specular);
+	}
+	else {
+		for (int i = 0; i < num_lights; ++i)
+			addPointLight(i, frag_pos, N, V, diffuse, specular);
+	}
+
+	tex_coord = tex_coord * uv_transform.xy + uv_transform.zw;
+	dx *= uv_transform.xy;
+	dy *= uv_transform.xy;
+	vec3 tex_color = diffuse_layer.a >= 0.0 ? textureGrad(tex_array, vec3(tex_coord, diffuse_layer.a), dx, dy).rgb :
+		textureGrad(tex_buffer, tex_coord, dx, dy).rgb;
+	color = vec4((ambient + diffuse) * tex_color + specular, 1.0);
+}
+)";
+};
\ No newline at end of file
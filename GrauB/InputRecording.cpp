@@ -0,0 +1,98 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+using namespace std;
+
+// Evento de entrada recebido pelos callbacks da GLFW e repassado  simulao
+struct InputEvent {
+	enum Type { keyEvent, cursorEvent, scrollEvent };
+
+	Type type;
+	int key = 0, action = 0;
+	double x = 0, y = 0;
+};
+
+// Eventos de entrada gravados com o passo da simulao em que foram aplicados. Reproduzidos nos mesmos passos,
+// levam a cena pelos mesmos estados em qualquer execuo, no importa a taxa de quadros.
+// Arquivo de texto: "GrauB input <verso> <passos por segundo>" e uma linha "passo tipo tecla ao x y" por evento.
+class InputRecording
+{
+public:
+	static const int version = 1;
+
+	struct Entry {
+		uint64_t step;
+		InputEvent event;
+	};
+
+	float stepsPerSecond = 60.0f;
+
+	void add(uint64_t step, const vector<InputEvent>& events) {
+		for (const auto& event : events)
+			entries.push_back({ step, event });
+	}
+
+	// Junta a events os eventos do passo step, a partir da posio next (avanada at o primeiro evento de um passo seguinte)
+	void getEvents(uint64_t step, size_t& next, vector<InputEvent>& events) const {
+		while (next < entries.size() && entries[next].step < step)
+			next++;
+		for (; next < entries.size() && entries[next].step == step; ++next)
+			events.push_back(entries[next].event);
+	}
+
+	bool isFinished(size_t next) const {
+		return next >= entries.size();
+	}
+
+	size_t size() const {
+		return entries.size();
+	}
+
+	uint64_t getLastStep() const {
+		return entries.empty() ? 0 : entries.back().step;
+	}
+
+	bool save(const string& path) const {
+		ofstream file(path);
+		if (!file.is_open()) {
+			std::cerr << "Erro ao gravar a entrada: " << path << std::endl;
+			return false;
+		}
+		file.precision(std::numeric_limits<double>::max_digits10);
+		file << "GrauB input " << version << " " << stepsPerSecond << "\n";
+		for (const auto& entry : entries)
+			file << entry.step << " " << (int)entry.event.type << " " << entry.event.key << " " << entry.event.action << " "
+				<< entry.event.x << " " << entry.event.y << "\n";
+		return file.good();
+	}
+
+	bool load(const string& path) {
+		ifstream file(path);
+		string magic, kind;
+		int fileVersion = 0;
+		if (!(file >> magic >> kind >> fileVersion >> stepsPerSecond) || magic != "GrauB" || kind != "input" || fileVersion != version) {
+			std::cerr << "Gravao de entrada invlida ou de outra verso: " << path << std::endl;
+			return false;
+		}
+		entries.clear();
+		Entry entry;
+		int type;
+		while (file >> entry.step >> type >> entry.event.key >> entry.event.action >> entry.event.x >> entry.event.y) {
+			entry.event.type = (InputEvent::Type)type;
+			entries.push_back(entry);
+		}
+		if (!file.eof()) {
+			std::cerr << "Erro ao ler a gravao de entrada: " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+private:
+	vector<Entry> entries;
+};
\ No newline at end of file
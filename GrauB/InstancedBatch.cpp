@@ -0,0 +1,170 @@
+#pragma once
+#include <vector>
+#include <cstring>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "../Common/include/Shader.h"
+#include "SceneObj.cpp"
+
+using namespace std;
+
+// Objetos com o mesmo VAO, a mesma textura de array e os mesmos coeficientes de material, desenhados numa
+// nica chamada instanciada. Cada instncia leva a sua matriz de modelo e a camada da sua textura.
+class InstancedBatch
+{
+public:
+	GLuint VAO;
+	GLenum drawMode, indexType;
+	size_t indexOffset;
+	SubMesh subMesh;
+	GLuint arrayTexture;
+	vector<int> objects;
+
+	InstancedBatch(const SceneObj& obj, int objectIndex)
+		: VAO(obj.sceneObjInfo.VAO), drawMode(obj.sceneObjInfo.drawMode), indexType(obj.sceneObjInfo.indexType),
+		indexOffset(obj.sceneObjInfo.indexOffset), subMesh(obj.sceneObjInfo.subMeshes.front()),
+		arrayTexture(obj.sceneObjInfo.materialLibrary->getTextureId(subMesh.material))
+	{
+		objects.push_back(objectIndex);
+	}
+
+	// S objetos de uma nica sub-malha com textura de array podem ser instanciados
+	static bool canInstance(const SceneObj& obj) {
+		const SceneObjInfo& info = obj.sceneObjInfo;
+		return info.VAO != 0 && info.subMeshes.size() == 1 && info.materialLibrary->getTextureLayer(info.subMeshes.front().material) >= 0;
+	}
+
+	bool accepts(const SceneObj& obj, const vector<SceneObj>& sceneObjects) const {
+		const SceneObjInfo& info = obj.sceneObjInfo;
+		const SubMesh& other = info.subMeshes.front();
+		if (info.VAO != VAO || other.first != subMesh.first || other.count != subMesh.count ||
+			info.materialLibrary->getTextureId(other.material) != arrayTexture)
+			return false;
+
+		const SceneObjInfo& firstInfo = sceneObjects[objects.front()].sceneObjInfo;
+		return sameCoefficients(*firstInfo.materialLibrary, subMesh.material, *info.materialLibrary, other.material);
+	}
+
+	// Cria o buffer de instncias e um VAO s do lote: o da malha  compartilhado com outros lotes e objetos, ento os
+	// atributos 0-3 e o buffer de ndices so copiados dele e os atributos 4-7 (matriz de modelo) e 8 (camada) apontam
+	// para o buffer deste lote
+	void initializeBuffers() {
+		glGenBuffers(1, &instanceVBO);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		glBufferData(GL_ARRAY_BUFFER, objects.size() * instanceStride * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+
+		glGenVertexArrays(1, &batchVAO);
+		copyMeshAttributes(VAO, batchVAO);
+		glBindVertexArray(batchVAO);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		for (int column = 0; column < 4; ++column) {
+			glVertexAttribPointer(4 + column, 4, GL_FLOAT, GL_FALSE, instanceStride * sizeof(GLfloat), (GLvoid*)(column * 4 * sizeof(GLfloat)));
+			glEnableVertexAttribArray(4 + column);
+			glVertexAttribDivisor(4 + column, 1);
+		}
+		glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, instanceStride * sizeof(GLfloat), (GLvoid*)(16 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(8);
+		glVertexAttribDivisor(8, 1);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		instanceData.resize(objects.size() * instanceStride);
+	}
+
+	// models traz as matrizes de modelo de todos os objetos da cena, na ordem de sceneObjects; os objetos marcados
+	// em skipped (ex.: os desenhados como impostores neste quadro) ficam de fora
+	void render(const Shader* shader, const vector<SceneObj>& sceneObjects, const vector<glm::mat4>& models, const vector<unsigned char>& skipped) {
+		PROFILE_ZONE("InstancedBatch::render");
+		if (!sceneObjects[objects.front()].isUploaded())
+			return;
+
+		GLsizei count = 0;
+		for (int index : objects) {
+			if (index < (int)skipped.size() && skipped[index])
+				continue;
+			const SceneObj& obj = sceneObjects[index];
+			GLfloat* instance = instanceData.data() + (size_t)count++ * instanceStride;
+			memcpy(instance, glm::value_ptr(models[index]), 16 * sizeof(GLfloat));
+			instance[16] = (GLfloat)obj.sceneObjInfo.materialLibrary->getTextureLayer(obj.sceneObjInfo.subMeshes.front().material);
+		}
+		if (count == 0)
+			return;
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, (size_t)count * instanceStride * sizeof(GLfloat), instanceData.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		const SceneObj& first = sceneObjects[objects.front()];
+		SceneObj::useMaterial(shader, first.sceneObjInfo.materialLibrary.get(), subMesh.material);
+		shader->setBool("instanced", true);
+
+		glBindVertexArray(batchVAO);
+		SceneObj::countDraw(drawMode, subMesh.count, count);
+		if (indexType != 0)
+			glDrawElementsInstanced(drawMode, subMesh.count, indexType, (GLvoid*)(indexOffset + subMesh.first * getIndexSize(indexType)), count);
+		else
+			glDrawArraysInstanced(drawMode, subMesh.first, subMesh.count, count);
+		glBindVertexArray(0);
+
+		shader->setBool("instanced", false);
+	}
+
+	void release() {
+		glDeleteVertexArrays(1, &batchVAO);
+		glDeleteBuffers(1, &instanceVBO);
+		batchVAO = 0;
+		instanceVBO = 0;
+	}
+
+private:
+	// Matriz de modelo (16 floats) e camada da textura (1 float)
+	static const int instanceStride = 17;
+
+	GLuint batchVAO = 0, instanceVBO = 0;
+	vector<GLfloat> instanceData;
+
+	// Repete em target os atributos 0-3 (posio, cor, coordenada de textura e normal) e o buffer de ndices de source,
+	// lidos da OpenGL: servem tanto para as malhas do SceneObjInfo quanto para as primitivas glTF
+	static void copyMeshAttributes(GLuint source, GLuint target) {
+		struct Attribute {
+			GLint enabled, buffer, size, type, normalized, stride;
+			void* pointer;
+		} attributes[4];
+		GLint elements = 0;
+		glBindVertexArray(source);
+		glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elements);
+		for (int i = 0; i < 4; ++i) {
+			Attribute& attribute = attributes[i];
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &attribute.enabled);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &attribute.buffer);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_SIZE, &attribute.size);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_TYPE, &attribute.type);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &attribute.normalized);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &attribute.stride);
+			glGetVertexAttribPointerv(i, GL_VERTEX_ATTRIB_ARRAY_POINTER, &attribute.pointer);
+		}
+
+		glBindVertexArray(target);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elements);
+		for (int i = 0; i < 4; ++i) {
+			const Attribute& attribute = attributes[i];
+			if (!attribute.enabled)
+				continue;
+			glBindBuffer(GL_ARRAY_BUFFER, attribute.buffer);
+			glVertexAttribPointer(i, attribute.size, attribute.type, attribute.normalized ? GL_TRUE : GL_FALSE, attribute.stride, attribute.pointer);
+			glEnableVertexAttribArray(i);
+		}
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	static bool sameCoefficients(const MaterialLibrary& a, int ma, const MaterialLibrary& b, int mb) {
+		return a.ambient[ma] == b.ambient[mb] && a.diffuse[ma] == b.diffuse[mb] && a.specular[ma] == b.specular[mb] &&
+			a.shininess[ma] == b.shininess[mb] && a.uvTransforms[ma] == b.uvTransforms[mb];
+	}
+
+	static size_t getIndexSize(GLenum indexType) {
+		return indexType == GL_UNSIGNED_BYTE ? 1 : indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,316 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include "Profiler.cpp"
+
+using namespace std;
+
+// Tarefa do JobSystem. unfinished conta a prpria tarefa mais as filhas que ainda no terminaram; a me s
+// termina depois de todas as filhas, ento esperar por ela espera pelo grupo inteiro.
+struct Job {
+	function<void()> task;
+	Job* parent = nullptr;
+	atomic<int> unfinished{ 0 };
+};
+
+// Fila de tarefas de uma thread (deque de Chase-Lev): a dona empilha e desempilha pelo fundo sem travas
+// e as outras threads roubam pelo topo com uma nica comparao atmica
+class JobDeque
+{
+public:
+	JobDeque(int capacity) : buffer(capacity), mask(capacity - 1) {}
+
+	// S a thread dona
+	void push(Job* job)
+	{
+		int64_t b = bottom.load(memory_order_relaxed);
+		buffer[b & mask].store(job, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+		bottom.store(b + 1, memory_order_relaxed);
+	}
+
+	// S a thread dona; a ltima tarefa  disputada com quem estiver roubando
+	Job* pop()
+	{
+		int64_t b = bottom.load(memory_order_relaxed) - 1;
+		bottom.store(b, memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+		int64_t t = top.load(memory_order_relaxed);
+		if (t > b) {
+			bottom.store(b + 1, memory_order_relaxed);
+			return nullptr;
+		}
+		Job* job = buffer[b & mask].load(memory_order_relaxed);
+		if (t == b) {
+			if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+				job = nullptr;
+			bottom.store(b + 1, memory_order_relaxed);
+		}
+		return job;
+	}
+
+	// Qualquer thread
+	Job* steal()
+	{
+		int64_t t = top.load(memory_order_acquire);
+		atomic_thread_fence(memory_order_seq_cst);
+		int64_t b = bottom.load(memory_order_acquire);
+		if (t >= b)
+			return nullptr;
+		Job* job = buffer[t & mask].load(memory_order_relaxed);
+		if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+			return nullptr;
+		return job;
+	}
+
+private:
+	vector<atomic<Job*>> buffer;
+	int64_t mask;
+	alignas(64) atomic<int64_t> top{ 0 };
+	alignas(64) atomic<int64_t> bottom{ 0 };
+};
+
+// Agendador de tarefas com roubo de trabalho: cada thread tem a sua fila e, sem nada para fazer, rouba das
+// outras. A thread que cria o sistema (a principal)  a thread 0 e trabalha enquanto espera em wait(), ento
+// numThreads inclui ela. Tarefas s podem ser criadas por ela, de dentro de outras tarefas ou por uma thread externa
+// registrada com attachThread (cada uma com a sua fila, de onde as demais tambm roubam).
+// Cada thread reaproveita as suas tarefas num anel de maxJobs posies: uma tarefa vale at a sua thread
+// criar outras maxJobs, o que limita quantas podem estar pendentes ao mesmo tempo.
+class JobSystem
+{
+public:
+	static const int maxJobs = 16384;
+
+	// Sistema usado pela cena e pelo lao principal (criado em main)
+	inline static JobSystem* current = nullptr;
+
+	// 0 usa o nmero de ncleos da mquina; externalThreads reserva filas para threads criadas fora do sistema
+	JobSystem(int numThreads = 0, int externalThreads = 0)
+	{
+		if (numThreads <= 0)
+			numThreads = std::max(1, (int)thread::hardware_concurrency());
+		numWorkers = numThreads;
+		nextExternal = numThreads;
+		for (int i = 0; i < numThreads + externalThreads; ++i)
+			threads.push_back(make_unique<ThreadData>());
+		registerThread(0);
+		for (int i = 1; i < numThreads; ++i)
+			workers.push_back(thread(&JobSystem::workLoop, this, i));
+	}
+
+	~JobSystem()
+	{
+		stopping = true;
+		wakeCondition.notify_all();
+		for (auto& worker : workers)
+			worker.join();
+		if (registration.owner == this)
+			registration = { nullptr, 0 };
+		if (current == this)
+			current = nullptr;
+	}
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Threads do sistema (a principal e as de apoio); as externas de attachThread no entram na conta,
+	// mas tambm executam tarefas de qualquer fila enquanto esperam em wait()
+	int getNumThreads() const {
+		return numWorkers;
+	}
+
+	// D  thread que chama uma das filas reservadas no construtor, para que ela possa criar tarefas
+	bool attachThread()
+	{
+		int index = nextExternal++;
+		if (index >= (int)threads.size()) {
+			std::cerr << "JobSystem: nenhuma fila reservada para outra thread" << std::endl;
+			return false;
+		}
+		registerThread(index);
+		return true;
+	}
+
+	Job* createJob(function<void()> task)
+	{
+		return createChild(nullptr, std::move(task));
+	}
+
+	// Filha de parent: parent s termina depois dela (chamar antes de run(parent))
+	Job* createChild(Job* parent, function<void()> task)
+	{
+		ThreadData& data = getThreadData();
+		Job* job = &data.jobs[data.nextJob++ & (maxJobs - 1)];
+		job->task = std::move(task);
+		job->parent = parent;
+		job->unfinished.store(1, memory_order_relaxed);
+		if (parent != nullptr)
+			parent->unfinished.fetch_add(1, memory_order_relaxed);
+		return job;
+	}
+
+	void run(Job* job)
+	{
+		getThreadData().queue.push(job);
+		if (sleeping.load(memory_order_relaxed) > 0)
+			wakeCondition.notify_one();
+	}
+
+	// Executa outras tarefas enquanto a esperada no termina
+	void wait(const Job* job)
+	{
+		while (job->unfinished.load(memory_order_acquire) > 0) {
+			Job* next = findJob(getThreadIndex());
+			if (next != nullptr)
+				execute(next);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	// Chama task(begin, end) para trechos de no mximo grain ndices de [0, count) e espera todos; grain 0
+	// divide o intervalo em quatro trechos por thread
+	// Modelo sobre a funo (e no std::function) para que uma lambda com muitas capturas no v para o heap a cada chamada
+	template <typename Task>
+	void parallelFor(int count, int grain, const Task& task)
+	{
+		if (count <= 0)
+			return;
+		if (grain <= 0)
+			grain = std::max(1, count / (getNumThreads() * 4));
+		grain = std::max(grain, (count + maxJobs / 2 - 1) / (maxJobs / 2));
+		if (count <= grain || getNumThreads() == 1) {
+			task(0, count);
+			return;
+		}
+
+		Job* root = createJob(nullptr);
+		for (int begin = 0; begin < count; begin += grain) {
+			int end = std::min(count, begin + grain);
+			run(createChild(root, [&task, begin, end]() { task(begin, end); }));
+		}
+		// A raiz no tem trabalho prprio: termina assim que as filhas terminarem
+		finish(root);
+		wait(root);
+	}
+
+private:
+	struct ThreadData {
+		JobDeque queue{ maxJobs };
+		vector<Job> jobs = vector<Job>(maxJobs);
+		unsigned nextJob = 0;
+		unsigned random = 0x9E3779B9;
+	};
+
+	vector<unique_ptr<ThreadData>> threads;
+	vector<thread> workers;
+	int numWorkers = 1;
+	atomic<int> nextExternal{ 1 };
+	atomic<bool> stopping{ false };
+	atomic<int> sleeping{ 0 };
+	mutex wakeMutex;
+	condition_variable wakeCondition;
+
+	// Fila da thread e o sistema em que ela foi registrada: a mesma thread pode usar mais de um JobSystem
+	struct ThreadRegistration {
+		const JobSystem* owner;
+		int index;
+	};
+
+	inline static thread_local ThreadRegistration registration = { nullptr, 0 };
+
+	void registerThread(int index)
+	{
+		registration = { this, index };
+		threads[index]->random += index * 7919;
+	}
+
+	// S a dona empilha na fila (a outra ponta  dos ladres): uma thread no registrada neste sistema encerra o programa
+	int getThreadIndex() const
+	{
+		if (registration.owner != this) {
+			std::cerr << "JobSystem: thread sem fila neste sistema (chame attachThread antes de criar tarefas)" << std::endl;
+			std::abort();
+		}
+		return registration.index;
+	}
+
+	ThreadData& getThreadData()
+	{
+		return *threads[getThreadIndex()];
+	}
+
+	// A prpria fila primeiro (tarefas mais recentes, ainda no cache); depois rouba a mais antiga de outra thread
+	Job* findJob(int index)
+	{
+		Job* job = threads[index]->queue.pop();
+		if (job != nullptr)
+			return job;
+
+		unsigned& random = threads[index]->random;
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+		int numThreads = (int)threads.size();
+		for (int i = 0; i < numThreads; ++i) {
+			int victim = (int)((random + i) % numThreads);
+			if (victim == index)
+				continue;
+			job = threads[victim]->queue.steal();
+			if (job != nullptr)
+				return job;
+		}
+		return nullptr;
+	}
+
+	void execute(Job* job)
+	{
+		if (job->task)
+			job->task();
+		finish(job);
+	}
+
+	void finish(Job* job)
+	{
+		while (job != nullptr) {
+			Job* parent = job->parent;
+			if (job->unfinished.fetch_sub(1, memory_order_acq_rel) != 1)
+				return;
+			job = parent;
+		}
+	}
+
+	void workLoop(int index)
+	{
+		registerThread(index);
+		AllocationTracker::markFrameThread();
+		Profiler::setThreadName("JobSystem " + to_string(index));
+		int idle = 0;
+		while (!stopping) {
+			Job* job = findJob(index);
+			if (job != nullptr) {
+				execute(job);
+				idle = 0;
+				continue;
+			}
+			// Sem trabalho: cede a vez algumas vezes e depois dorme at uma tarefa nova (ou 1 ms, caso o aviso se perca)
+			if (++idle < 64) {
+				std::this_thread::yield();
+				continue;
+			}
+			unique_lock<mutex> lock(wakeMutex);
+			sleeping++;
+			wakeCondition.wait_for(lock, std::chrono::milliseconds(1));
+			sleeping--;
+		}
+	}
+};
\ No newline at end of file
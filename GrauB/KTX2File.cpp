@@ -0,0 +1,151 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include "VirtualFileSystem.cpp"
+
+using namespace std;
+
+// Imagem com todos os nveis de mipmap j comprimidos (nvel 0  o maior)
+struct CompressedImage {
+	uint32_t vkFormat = 0;
+	int width = 0, height = 0;
+	vector<vector<unsigned char>> levels;
+};
+
+// Leitura e escrita de arquivos KTX2 (Khronos) com texturas 2D em formatos de bloco, sem supercompresso
+class KTX2File
+{
+public:
+	// Valores de VkFormat usados pelo KTX2
+	static const uint32_t formatBC1 = 131;	// VK_FORMAT_BC1_RGB_UNORM_BLOCK
+	static const uint32_t formatBC3 = 137;	// VK_FORMAT_BC3_UNORM_BLOCK
+	static const uint32_t formatBC7 = 145;	// VK_FORMAT_BC7_UNORM_BLOCK
+
+	static int getBlockSize(uint32_t vkFormat) {
+		return vkFormat == formatBC1 ? 8 : 16;
+	}
+
+	static bool write(const string& filepath, const CompressedImage& image) {
+		uint32_t levelCount = (uint32_t)image.levels.size();
+		vector<unsigned char> dfd = buildDFD(image.vkFormat);
+
+		size_t levelIndexOffset = 80;
+		size_t dfdOffset = levelIndexOffset + levelCount * 24;
+		size_t dataOffset = dfdOffset + dfd.size();
+
+		// Os nveis ficam do menor para o maior, cada um alinhado ao tamanho do bloco
+		vector<uint64_t> levelOffsets(levelCount);
+		size_t offset = dataOffset;
+		for (int level = (int)levelCount - 1; level >= 0; --level) {
+			offset = align(offset, getBlockSize(image.vkFormat));
+			levelOffsets[level] = offset;
+			offset += image.levels[level].size();
+		}
+
+		vector<unsigned char> file(offset, 0);
+		memcpy(file.data(), identifier, sizeof(identifier));
+		uint32_t header[9] = { image.vkFormat, 1, (uint32_t)image.width, (uint32_t)image.height, 0, 0, 1, levelCount, 0 };
+		memcpy(file.data() + 12, header, sizeof(header));
+
+		uint32_t index[4] = { (uint32_t)dfdOffset, (uint32_t)dfd.size(), 0, 0 };
+		memcpy(file.data() + 48, index, sizeof(index));
+
+		for (uint32_t level = 0; level < levelCount; ++level) {
+			uint64_t entry[3] = { levelOffsets[level], image.levels[level].size(), image.levels[level].size() };
+			memcpy(file.data() + levelIndexOffset + level * 24, entry, sizeof(entry));
+			memcpy(file.data() + levelOffsets[level], image.levels[level].data(), image.levels[level].size());
+		}
+		memcpy(file.data() + dfdOffset, dfd.data(), dfd.size());
+
+		std::ofstream outputFile(filepath, std::ios::binary);
+		if (!outputFile.is_open()) {
+			std::cerr << "Erro ao criar o arquivo KTX2: " << filepath << std::endl;
+			return false;
+		}
+		outputFile.write((const char*)file.data(), file.size());
+		return outputFile.good();
+	}
+
+	static bool read(const string& filepath, CompressedImage& image) {
+		VirtualFile file(filepath);
+		if (!file.isOpen() || file.size() < 80)
+			return false;
+
+		const unsigned char* data = file.data();
+		if (memcmp(data, identifier, sizeof(identifier)) != 0) {
+			std::cerr << "Arquivo KTX2 invlido: " << filepath << std::endl;
+			return false;
+		}
+
+		uint32_t header[9];
+		memcpy(header, data + 12, sizeof(header));
+		uint32_t levelCount = header[7];
+		if (header[0] != formatBC1 && header[0] != formatBC3 && header[0] != formatBC7) {
+			std::cerr << "Formato KTX2 no suportado (" << header[0] << "): " << filepath << std::endl;
+			return false;
+		}
+		if (header[4] != 0 || header[5] != 0 || header[6] != 1 || header[8] != 0 || levelCount == 0 || 80 + (size_t)levelCount * 24 > file.size()) {
+			std::cerr << "Arquivo KTX2 com layout no suportado: " << filepath << std::endl;
+			return false;
+		}
+
+		image.vkFormat = header[0];
+		image.width = (int)header[2];
+		image.height = (int)header[3];
+		image.levels.assign(levelCount, {});
+		for (uint32_t level = 0; level < levelCount; ++level) {
+			uint64_t entry[3];
+			memcpy(entry, data + 80 + level * 24, sizeof(entry));
+			if (entry[0] > file.size() || entry[1] > file.size() - entry[0]) {
+				std::cerr << "Arquivo KTX2 truncado: " << filepath << std::endl;
+				return false;
+			}
+			image.levels[level].assign(data + entry[0], data + entry[0] + entry[1]);
+		}
+		return true;
+	}
+
+private:
+	static constexpr unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	static size_t align(size_t offset, size_t alignment) {
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+	// Descritor de formato (Data Format Descriptor) bsico exigido pelo KTX2
+	static vector<unsigned char> buildDFD(uint32_t vkFormat) {
+		// Modelo de cor do bloco e amostras (deslocamento em bits, canal)
+		unsigned char colorModel = vkFormat == formatBC1 ? 128 : vkFormat == formatBC3 ? 130 : 134;
+		vector<pair<uint32_t, uint32_t>> samples;
+		if (vkFormat == formatBC3)
+			samples = { { 0, 15 }, { 64, 0 } };
+		else
+			samples = { { 0, 0 } };
+		uint32_t sampleBits = vkFormat == formatBC7 ? 128 : 64;
+
+		uint32_t blockSize = 24 + 16 * (uint32_t)samples.size();
+		vector<uint32_t> words = {
+			4 + blockSize,
+			0,
+			2u | (blockSize << 16),
+			colorModel | (1u << 8) | (1u << 16),
+			3u | (3u << 8),
+			(uint32_t)getBlockSize(vkFormat),
+			0
+		};
+		for (const auto& sample : samples) {
+			words.push_back(sample.first | ((sampleBits - 1) << 16) | (sample.second << 24));
+			words.push_back(0);
+			words.push_back(0);
+			words.push_back(0xFFFFFFFFu);
+		}
+
+		vector<unsigned char> dfd(words.size() * 4);
+		memcpy(dfd.data(), words.data(), dfd.size());
+		return dfd;
+	}
+};
\ No newline at end of file
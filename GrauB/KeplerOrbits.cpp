@@ -0,0 +1,237 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "JobSystem.cpp"
+#include "Profiler.cpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GRAUB_SSE
+#endif
+
+using namespace std;
+
+// rbitas keplerianas fixas, avaliadas direto pelo tempo em vez de integradas: a posio de cada uma sai da equao de
+// Kepler (M = E - e sen E), resolvida com um nmero fixo de iteraes de Newton para que quatro rbitas andem juntas
+// nas instrues SSE (as iteraes param quando as quatro convergiram). Os elementos ficam em SoA, com os eixos do plano
+// da rbita j multiplicados pelos semi-eixos; a anomalia mdia  calculada em double, para que a preciso no caia
+// com o tempo. O plano de referncia  o x-z da cena e o sentido  o mesmo das rbitas circulares do NBody.
+class KeplerOrbits
+{
+public:
+	static constexpr float eccentricityLimit = 0.95f;
+
+	// Semi-eixo maior, excentricidade (at eccentricityLimit), inclinao, longitude do nodo ascendente, argumento do
+	// periapsis e anomalia mdia em t = 0, em graus, e o perodo em segundos (0: parada). Retorna o ndice da rbita.
+	int add(float semiMajorAxis, float eccentricity, float inclination, float ascendingNode, float periapsis, float phase, float period) {
+		const float degrees = 0.01745329252f;
+		eccentricity = std::min(std::max(eccentricity, 0.0f), eccentricityLimit);
+		float a = std::max(semiMajorAxis, 0.0f), b = a * std::sqrt(1.0f - eccentricity * eccentricity);
+		float cosNode = std::cos(ascendingNode * degrees), sinNode = std::sin(ascendingNode * degrees);
+		float cosPeriapsis = std::cos(periapsis * degrees), sinPeriapsis = std::sin(periapsis * degrees);
+		float cosInclination = std::cos(inclination * degrees), sinInclination = std::sin(inclination * degrees);
+		// Eixos P (para o periapsis) e Q no referencial com z para cima, levados para o da cena (x, z, -y)
+		glm::vec3 p(cosNode * cosPeriapsis - sinNode * sinPeriapsis * cosInclination,
+			sinNode * cosPeriapsis + cosNode * sinPeriapsis * cosInclination, sinPeriapsis * sinInclination);
+		glm::vec3 q(-cosNode * sinPeriapsis - sinNode * cosPeriapsis * cosInclination,
+			-sinNode * sinPeriapsis + cosNode * cosPeriapsis * cosInclination, cosPeriapsis * sinInclination);
+		px.push_back(a * p.x);
+		py.push_back(a * p.z);
+		pz.push_back(-a * p.y);
+		qx.push_back(b * q.x);
+		qy.push_back(b * q.z);
+		qz.push_back(-b * q.y);
+		e.push_back(eccentricity);
+		meanMotion.push_back(period > 0.0f ? twoPi / period : 0.0);
+		meanAnomaly.push_back(reduceAngle(phase * (double)degrees));
+		return (int)e.size() - 1;
+	}
+
+	// Perodo da rbita de semi-eixo maior a em torno de um corpo com mu = G * massa (terceira lei de Kepler)
+	static float getPeriod(float semiMajorAxis, float mu) {
+		return mu > 0.0f ? 6.28318530718f * std::sqrt(semiMajorAxis * semiMajorAxis * semiMajorAxis / mu) : 0.0f;
+	}
+
+	// Cinturo de count rbitas com semi-eixo entre inner e outer (densidade uniforme na rea), excentricidade e
+	// inclinao (em graus) sorteadas at os mximos e o perodo pela terceira lei. Retorna o ndice da primeira.
+	int addBelt(int count, float inner, float outer, float maxEccentricity, float maxInclination, float mu, uint32_t seed) {
+		int first = (int)size();
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		reserve(size() + count);
+		for (int i = 0; i < count; ++i) {
+			float semiMajorAxis = std::sqrt(inner * inner + unit(random) * (outer * outer - inner * inner));
+			float eccentricity = unit(random) * maxEccentricity, inclination = unit(random) * maxInclination;
+			float ascendingNode = unit(random) * 360.0f, periapsis = unit(random) * 360.0f, phase = unit(random) * 360.0f;
+			add(semiMajorAxis, eccentricity, inclination, ascendingNode, periapsis, phase, getPeriod(semiMajorAxis, mu));
+		}
+		return first;
+	}
+
+	void reserve(size_t count) {
+		for (auto* values : { &px, &py, &pz, &qx, &qy, &qz, &e })
+			values->reserve(count);
+		meanMotion.reserve(count);
+		meanAnomaly.reserve(count);
+	}
+
+	void clear() {
+		for (auto* values : { &px, &py, &pz, &qx, &qy, &qz, &e })
+			values->clear();
+		meanMotion.clear();
+		meanAnomaly.clear();
+	}
+
+	size_t size() const {
+		return e.size();
+	}
+
+	// Posies de todas as rbitas no tempo time, somadas a center, em positions (size() elementos)
+	void evaluate(double time, glm::vec3 center, glm::vec3* positions, JobSystem& jobs) const {
+		PROFILE_ZONE("KeplerOrbits::evaluate");
+		jobs.parallelFor((int)size(), 4096, [&](int begin, int end) {
+			evaluate(time, center, positions, begin, end);
+		});
+	}
+
+	// S as rbitas [begin, end)
+	void evaluate(double time, glm::vec3 center, glm::vec3* positions, int begin, int end) const {
+		int i = begin;
+#ifdef GRAUB_SSE
+		__m128d t = _mm_set1_pd(time);
+		alignas(16) float x[4], y[4], z[4];
+		for (; i + 4 <= end; i += 4) {
+			__m128 eccentricity = _mm_loadu_ps(&e[i]);
+			__m128d low = reduceAngle(_mm_add_pd(_mm_loadu_pd(&meanAnomaly[i]), _mm_mul_pd(_mm_loadu_pd(&meanMotion[i]), t)));
+			__m128d high = reduceAngle(_mm_add_pd(_mm_loadu_pd(&meanAnomaly[i + 2]), _mm_mul_pd(_mm_loadu_pd(&meanMotion[i + 2]), t)));
+			__m128 mean = _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+			__m128 sine, cosine;
+			solveKepler(mean, eccentricity, sine, cosine);
+			__m128 along = _mm_sub_ps(cosine, eccentricity);
+			_mm_store_ps(x, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&px[i]), along), _mm_mul_ps(_mm_loadu_ps(&qx[i]), sine)));
+			_mm_store_ps(y, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&py[i]), along), _mm_mul_ps(_mm_loadu_ps(&qy[i]), sine)));
+			_mm_store_ps(z, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&pz[i]), along), _mm_mul_ps(_mm_loadu_ps(&qz[i]), sine)));
+			for (int k = 0; k < 4; ++k)
+				positions[i + k] = center + glm::vec3(x[k], y[k], z[k]);
+		}
+#endif
+		for (; i < end; ++i) {
+			float sine, cosine;
+			solveKepler((float)reduceAngle(meanAnomaly[i] + meanMotion[i] * time), e[i], sine, cosine);
+			float along = cosine - e[i];
+			positions[i] = center + glm::vec3(px[i] * along + qx[i] * sine, py[i] * along + qy[i] * sine, pz[i] * along + qz[i] * sine);
+		}
+	}
+
+	// A mesma posio calculada em double com std::sin e Newton at convergir (referncia para conferir o resultado)
+	glm::dvec3 getReferencePosition(int orbit, double time) const {
+		double mean = reduceAngle(meanAnomaly[orbit] + meanMotion[orbit] * time);
+		double anomaly = mean + 0.85 * e[orbit] * (mean < 0.0 ? -1.0 : 1.0);
+		for (int iteration = 0; iteration < 50; ++iteration) {
+			double delta = (anomaly - e[orbit] * std::sin(anomaly) - mean) / (1.0 - e[orbit] * std::cos(anomaly));
+			anomaly -= delta;
+			if (std::abs(delta) < 1e-14)
+				break;
+		}
+		double along = std::cos(anomaly) - e[orbit], sine = std::sin(anomaly);
+		return glm::dvec3(px[orbit] * along + qx[orbit] * sine, py[orbit] * along + qy[orbit] * sine, pz[orbit] * along + qz[orbit] * sine);
+	}
+
+	// Newton em solveKepler para quando a correo fica abaixo de tolerance (o erro que sobra  da ordem do seu
+	// quadrado); partindo de M + 0.85 e sinal(M), maxIterations basta at e = 0.95
+	static constexpr float tolerance = 1e-4f;
+	static const int maxIterations = 8;
+
+	// Seno e cosseno com a reduo de Cody-Waite para [-pi/4, pi/4] e os polinmios do Cephes (erro de ~1e-7)
+	static void sinCos(float angle, float& sine, float& cosine) {
+		int quadrant = (int)std::nearbyint(angle * 0.636619772f);
+		float x = reduceQuadrant(angle, (float)quadrant), x2 = x * x;
+		float s = x + x * x2 * (-1.6666654611e-1f + x2 * (8.3321608736e-3f + x2 * -1.9515295891e-4f));
+		float c = 1.0f - 0.5f * x2 + x2 * x2 * (4.166664568298827e-2f + x2 * (-1.388731625493765e-3f + x2 * 2.443315711809948e-5f));
+		if (quadrant & 1)
+			std::swap(s, c);
+		sine = (quadrant & 2) ? -s : s;
+		cosine = ((quadrant + 1) & 2) ? -c : c;
+	}
+
+private:
+	static constexpr double twoPi = 6.283185307179586;
+	vector<float> px, py, pz, qx, qy, qz, e;
+	// Em rad/s e rad
+	vector<double> meanMotion, meanAnomaly;
+
+	// ngulo em [-pi, pi]
+	static double reduceAngle(double angle) {
+		return angle - twoPi * std::nearbyint(angle / twoPi);
+	}
+
+	static float reduceQuadrant(float angle, float quadrant) {
+		return ((angle - quadrant * 1.5703125f) - quadrant * 4.837512969970703125e-4f) - quadrant * 7.54978995489188216e-8f;
+	}
+
+	// Seno e cosseno da anomalia excntrica E de M (em [-pi, pi]); os da ltima correo d saem da expanso de
+	// primeira ordem (sen(E - d) ~ sen E - d cos E), sem calcular outro seno
+	static void solveKepler(float mean, float eccentricity, float& sine, float& cosine) {
+		float anomaly = mean + 0.85f * eccentricity * (mean < 0.0f ? -1.0f : 1.0f);
+		for (int iteration = 0; iteration < maxIterations; ++iteration) {
+			sinCos(anomaly, sine, cosine);
+			float delta = (anomaly - eccentricity * sine - mean) / (1.0f - eccentricity * cosine);
+			anomaly -= delta;
+			float correctedSine = sine - delta * cosine;
+			cosine += delta * sine;
+			sine = correctedSine;
+			if (std::abs(delta) < tolerance)
+				break;
+		}
+	}
+
+#ifdef GRAUB_SSE
+	static __m128d reduceAngle(__m128d angle) {
+		__m128d turns = _mm_cvtepi32_pd(_mm_cvtpd_epi32(_mm_div_pd(angle, _mm_set1_pd(twoPi))));
+		return _mm_sub_pd(angle, _mm_mul_pd(turns, _mm_set1_pd(twoPi)));
+	}
+
+	static void sinCos(__m128 angle, __m128& sine, __m128& cosine) {
+		__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(0.636619772f)));
+		__m128 q = _mm_cvtepi32_ps(quadrant);
+		__m128 x = _mm_sub_ps(angle, _mm_mul_ps(q, _mm_set1_ps(1.5703125f)));
+		x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(4.837512969970703125e-4f)));
+		x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(7.54978995489188216e-8f)));
+		__m128 x2 = _mm_mul_ps(x, x);
+		__m128 s = _mm_add_ps(_mm_mul_ps(x2, _mm_set1_ps(-1.9515295891e-4f)), _mm_set1_ps(8.3321608736e-3f));
+		s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.6666654611e-1f));
+		s = _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(x, x2), s));
+		__m128 c = _mm_add_ps(_mm_mul_ps(x2, _mm_set1_ps(2.443315711809948e-5f)), _mm_set1_ps(-1.388731625493765e-3f));
+		c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(4.166664568298827e-2f));
+		c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x2, _mm_set1_ps(0.5f))), _mm_mul_ps(_mm_mul_ps(x2, x2), c));
+		// Quadrante mpar troca seno e cosseno; o bit 2 do quadrante (e do seguinte, no cosseno) inverte o sinal
+		__m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+		__m128 swappedSine = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+		__m128 swappedCosine = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+		sine = _mm_xor_ps(swappedSine, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30)));
+		cosine = _mm_xor_ps(swappedCosine, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30)));
+	}
+
+	static void solveKepler(__m128 mean, __m128 eccentricity, __m128& sine, __m128& cosine) {
+		__m128 signBit = _mm_set1_ps(-0.0f), one = _mm_set1_ps(1.0f), limit = _mm_set1_ps(tolerance);
+		__m128 start = _mm_or_ps(_mm_mul_ps(_mm_set1_ps(0.85f), eccentricity), _mm_and_ps(mean, signBit));
+		__m128 anomaly = _mm_add_ps(mean, start);
+		for (int iteration = 0; iteration < maxIterations; ++iteration) {
+			sinCos(anomaly, sine, cosine);
+			__m128 error = _mm_sub_ps(_mm_sub_ps(anomaly, _mm_mul_ps(eccentricity, sine)), mean);
+			__m128 delta = _mm_div_ps(error, _mm_sub_ps(one, _mm_mul_ps(eccentricity, cosine)));
+			anomaly = _mm_sub_ps(anomaly, delta);
+			__m128 correctedSine = _mm_sub_ps(sine, _mm_mul_ps(delta, cosine));
+			cosine = _mm_add_ps(cosine, _mm_mul_ps(delta, sine));
+			sine = correctedSine;
+			if (_mm_movemask_ps(_mm_cmpge_ps(_mm_andnot_ps(signBit, delta), limit)) == 0)
+				break;
+		}
+	}
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,163 @@
+#pragma once
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+using namespace std;
+
+// Compresso no formato de bloco do LZ4 (sem o cabealho de frame): sequncias de literais seguidas de uma
+// cpia (deslocamento de at 64 KB, tamanho mnimo 4). A descompresso  s cpia de memria, rpida o
+// suficiente para ser feita na carga; a compresso  gulosa, com uma tabela de hash de 4 bytes.
+class LZ4
+{
+public:
+	// Pior caso do tamanho comprimido (dados incompressveis viram uma nica sequncia de literais)
+	static size_t getMaxCompressedSize(size_t size) {
+		return size + size / 255 + 16;
+	}
+
+	static vector<unsigned char> compress(const unsigned char* source, size_t size) {
+		vector<unsigned char> output;
+		output.reserve(getMaxCompressedSize(size));
+
+		vector<uint32_t> table(hashSize, 0);
+		size_t anchor = 0, position = 0;
+		// O ltimo trecho precisa ser s de literais: a ltima cpia comea pelo menos 12 bytes antes do fim
+		// e termina pelo menos 5 bytes antes dele (regras do formato)
+		size_t matchLimit = size > lastLiterals ? size - lastLiterals : 0;
+		size_t searchLimit = size > minEndDistance ? size - minEndDistance : 0;
+
+		while (position < searchLimit) {
+			uint32_t sequence = read32(source + position);
+			uint32_t& slot = table[hash(sequence)];
+			size_t candidate = slot;
+			slot = (uint32_t)position;
+
+			if (candidate >= position || position - candidate > maxOffset || read32(source + candidate) != sequence) {
+				++position;
+				continue;
+			}
+
+			// Estende a cpia para trs (sobre literais ainda no emitidos) e para frente
+			while (position > anchor && candidate > 0 && source[position - 1] == source[candidate - 1]) {
+				--position;
+				--candidate;
+			}
+			size_t length = minMatch;
+			while (position + length < matchLimit && source[position + length] == source[candidate + length])
+				++length;
+
+			writeSequence(output, source + anchor, position - anchor, position - candidate, length);
+			position += length;
+			anchor = position;
+
+			if (position >= 2 && position - 2 < searchLimit)
+				table[hash(read32(source + position - 2))] = (uint32_t)(position - 2);
+		}
+
+		writeSequence(output, source + anchor, size - anchor, 0, 0);
+		return output;
+	}
+
+	// Descomprime exatamente "size" bytes em "target"; falha (sem escrever fora dos limites) com dados invlidos
+	static bool decompress(const unsigned char* source, size_t sourceSize, unsigned char* target, size_t size) {
+		const unsigned char* input = source;
+		const unsigned char* inputEnd = source + sourceSize;
+		unsigned char* output = target;
+		unsigned char* outputEnd = target + size;
+
+		while (input < inputEnd) {
+			unsigned token = *input++;
+
+			size_t literals = token >> 4;
+			if (literals == 15 && !readLength(input, inputEnd, literals))
+				return false;
+			if (literals > (size_t)(inputEnd - input) || literals > (size_t)(outputEnd - output))
+				return false;
+			memcpy(output, input, literals);
+			input += literals;
+			output += literals;
+
+			// A ltima sequncia no tem cpia
+			if (input == inputEnd)
+				break;
+
+			if (inputEnd - input < 2)
+				return false;
+			size_t offset = input[0] | (input[1] << 8);
+			input += 2;
+			if (offset == 0 || offset > (size_t)(output - target))
+				return false;
+
+			size_t length = token & 15;
+			if (length == 15 && !readLength(input, inputEnd, length))
+				return false;
+			length += minMatch;
+			if (length > (size_t)(outputEnd - output))
+				return false;
+
+			// A cpia pode se sobrepor ao que est sendo escrito (repetio de padres curtos)
+			const unsigned char* match = output - offset;
+			if (offset >= length) {
+				memcpy(output, match, length);
+				output += length;
+			}
+			else {
+				for (size_t i = 0; i < length; ++i)
+					*output++ = *match++;
+			}
+		}
+		return output == outputEnd;
+	}
+
+private:
+	static const size_t minMatch = 4, lastLiterals = 5, minEndDistance = 12, maxOffset = 65535;
+	static const int hashBits = 16;
+	static const size_t hashSize = (size_t)1 << hashBits;
+
+	static uint32_t read32(const unsigned char* bytes) {
+		uint32_t value;
+		memcpy(&value, bytes, 4);
+		return value;
+	}
+
+	static uint32_t hash(uint32_t sequence) {
+		return (sequence * 2654435761u) >> (32 - hashBits);
+	}
+
+	// Tamanhos de 15 ou mais continuam em bytes extras, somados at um byte menor que 255
+	static bool readLength(const unsigned char*& input, const unsigned char* inputEnd, size_t& length) {
+		unsigned char value;
+		do {
+			if (input >= inputEnd)
+				return false;
+			value = *input++;
+			length += value;
+		} while (value == 255);
+		return true;
+	}
+
+	static void writeLength(vector<unsigned char>& output, size_t length) {
+		for (; length >= 255; length -= 255)
+			output.push_back(255);
+		output.push_back((unsigned char)length);
+	}
+
+	// Sequncia: token (literais << 4 | cpia - 4), literais, deslocamento de 16 bits e tamanho extra da cpia.
+	// Com matchLength 0  a sequncia final, s com literais.
+	static void writeSequence(vector<unsigned char>& output, const unsigned char* literals, size_t numLiterals, size_t offset, size_t matchLength) {
+		size_t matchCode = matchLength > 0 ? matchLength - minMatch : 0;
+		output.push_back((unsigned char)((std::min<size_t>(numLiterals, 15) << 4) | std::min<size_t>(matchCode, 15)));
+		if (numLiterals >= 15)
+			writeLength(output, numLiterals - 15);
+		output.insert(output.end(), literals, literals + numLiterals);
+
+		if (matchLength == 0)
+			return;
+		output.push_back((unsigned char)(offset & 0xFF));
+		output.push_back((unsigned char)(offset >> 8));
+		if (matchCode >= 15)
+			writeLength(output, matchCode - 15);
+	}
+};
\ No newline at end of file
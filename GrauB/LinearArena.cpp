@@ -0,0 +1,159 @@
+#pragma once
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+using namespace std;
+
+// Memria linear para dados temporrios, usada pelos contineres std::pmr: cada alocao s avana um ponteiro
+// no bloco atual e nada  liberado sozinho; rewind (ou o fim de um ArenaScope) e reset devolvem tudo de uma vez.
+// Os blocos pedidos ao upstream ficam para os prximos ciclos, ento depois do primeiro ela no aloca mais.
+// No  thread-safe: cada thread tem a sua (scratch) e a thread principal tem tambm a do quadro (frame).
+class LinearArena : public std::pmr::memory_resource
+{
+public:
+	// Posio da arena, para voltar a ela com rewind
+	struct Marker {
+		size_t block, offset, used;
+	};
+
+	LinearArena(size_t blockSize = 64 * 1024, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+		: blockSize(blockSize), upstream(upstream) {}
+
+	~LinearArena() {
+		release();
+	}
+
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator=(const LinearArena&) = delete;
+
+	Marker getMarker() const {
+		return { current, offset, used };
+	}
+
+	// Descarta o que foi alocado depois do marcador (os blocos continuam reservados)
+	void rewind(const Marker& marker) {
+		current = marker.block;
+		offset = marker.offset;
+		used = marker.used;
+	}
+
+	// Descarta tudo; se o ltimo ciclo precisou de mais de um bloco, troca todos por um s do tamanho somado
+	void reset() {
+		rewind({ 0, 0, 0 });
+		if (blocks.size() <= 1)
+			return;
+		size_t total = 0;
+		for (const auto& block : blocks)
+			total += block.size;
+		release();
+		addBlock(total);
+	}
+
+	// Devolve os blocos ao upstream
+	void release() {
+		for (const auto& block : blocks)
+			upstream->deallocate(block.data, block.size, alignof(std::max_align_t));
+		blocks.clear();
+		rewind({ 0, 0, 0 });
+	}
+
+	// Bytes em uso agora, maior uso desde a criao, bytes reservados e blocos pedidos ao upstream
+	size_t getUsed() const {
+		return used;
+	}
+
+	size_t getPeak() const {
+		return peak;
+	}
+
+	size_t getCapacity() const {
+		size_t total = 0;
+		for (const auto& block : blocks)
+			total += block.size;
+		return total;
+	}
+
+	size_t getUpstreamAllocations() const {
+		return upstreamAllocations;
+	}
+
+	// Arena da thread que chama, para os temporrios da carga (leitura das malhas, compilao da cena)
+	static LinearArena& scratch() {
+		thread_local LinearArena arena;
+		return arena;
+	}
+
+	// Arena dos dados que s valem durante um quadro; a thread principal chama reset no fim de cada um
+	static LinearArena& frame() {
+		static LinearArena arena;
+		return arena;
+	}
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		while (true) {
+			if (current == blocks.size())
+				addBlock(std::max(blockSize, bytes + alignment));
+			Block& block = blocks[current];
+			uintptr_t address = (uintptr_t)block.data + offset;
+			size_t start = (size_t)(((address + alignment - 1) & ~(uintptr_t)(alignment - 1)) - (uintptr_t)block.data);
+			if (start + bytes <= block.size) {
+				used += start + bytes - offset;
+				peak = std::max(peak, used);
+				offset = start + bytes;
+				return block.data + start;
+			}
+			// No cabe no resto do bloco: passa para o prximo (um j reservado ou um novo)
+			++current;
+			offset = 0;
+		}
+	}
+
+	void do_deallocate(void*, size_t, size_t) override {}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+
+private:
+	struct Block {
+		char* data;
+		size_t size;
+	};
+
+	size_t blockSize;
+	std::pmr::memory_resource* upstream;
+	vector<Block> blocks;
+	size_t current = 0, offset = 0, used = 0, peak = 0, upstreamAllocations = 0;
+
+	void addBlock(size_t size) {
+		blocks.push_back({ (char*)upstream->allocate(size, alignof(std::max_align_t)), size });
+		++upstreamAllocations;
+	}
+};
+
+// Trecho que usa a arena como pilha: o que for alocado nela a partir daqui  descartado no destrutor. Os contineres
+// que usam resource() precisam ser declarados depois do ArenaScope, para serem destrudos antes dele.
+class ArenaScope
+{
+public:
+	ArenaScope(LinearArena& arena = LinearArena::scratch()) : arena(arena), marker(arena.getMarker()) {}
+
+	~ArenaScope() {
+		arena.rewind(marker);
+	}
+
+	ArenaScope(const ArenaScope&) = delete;
+	ArenaScope& operator=(const ArenaScope&) = delete;
+
+	std::pmr::memory_resource* resource() {
+		return &arena;
+	}
+
+private:
+	LinearArena& arena;
+	LinearArena::Marker marker;
+};
\ No newline at end of file
@@ -0,0 +1,165 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <cstddef>
+#include <atomic>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Mapeia um arquivo inteiro em memria (somente leitura), evitando cpias para buffers intermedirios
+class MappedFile
+{
+public:
+	// Quantos arquivos j foram abertos por aqui (para comparar o pacote de assets com os arquivos soltos)
+	inline static atomic<int> filesOpened{ 0 };
+
+	MappedFile() {}
+
+	MappedFile(const string& filepath)
+	{
+		open(filepath);
+	}
+
+	~MappedFile()
+	{
+		close();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const string& filepath)
+	{
+		close();
+
+#ifdef _WIN32
+		fileHandle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE) {
+			std::cerr << "Erro ao abrir o arquivo: " << filepath << std::endl;
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(fileHandle, &fileSize);
+		length = (size_t)fileSize.QuadPart;
+
+		if (length > 0) {
+			mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mappingHandle != nullptr)
+				bytes = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		}
+#else
+		fileDescriptor = ::open(filepath.c_str(), O_RDONLY);
+		if (fileDescriptor < 0) {
+			std::cerr << "Erro ao abrir o arquivo: " << filepath << std::endl;
+			return false;
+		}
+
+		struct stat fileStat;
+		fstat(fileDescriptor, &fileStat);
+		length = (size_t)fileStat.st_size;
+
+		if (length > 0) {
+			void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+			if (address != MAP_FAILED) {
+				bytes = (const unsigned char*)address;
+				madvise(address, length, MADV_SEQUENTIAL);
+			}
+		}
+#endif
+
+		++filesOpened;
+		if (length > 0 && bytes == nullptr) {
+			std::cerr << "Erro ao mapear o arquivo em memria: " << filepath << std::endl;
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void close()
+	{
+#ifdef _WIN32
+		if (bytes != nullptr)
+			UnmapViewOfFile(bytes);
+		if (mappingHandle != nullptr)
+			CloseHandle(mappingHandle);
+		if (fileHandle != INVALID_HANDLE_VALUE)
+			CloseHandle(fileHandle);
+		mappingHandle = nullptr;
+		fileHandle = INVALID_HANDLE_VALUE;
+#else
+		if (bytes != nullptr)
+			munmap((void*)bytes, length);
+		if (fileDescriptor >= 0)
+			::close(fileDescriptor);
+		fileDescriptor = -1;
+#endif
+		bytes = nullptr;
+		length = 0;
+	}
+
+	// Tira o arquivo do cache de pginas do sistema, para medir uma leitura "a frio" (s em sistemas POSIX)
+	static bool dropFromCache(const string& filepath)
+	{
+#ifdef _WIN32
+		return false;
+#else
+		int descriptor = ::open(filepath.c_str(), O_RDONLY);
+		if (descriptor < 0)
+			return false;
+		fdatasync(descriptor);
+		bool dropped = posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED) == 0;
+		::close(descriptor);
+		return dropped;
+#endif
+	}
+
+	bool isOpen() const {
+		return bytes != nullptr || (length == 0 && isHandleValid());
+	}
+
+	const unsigned char* data() const {
+		return bytes;
+	}
+
+	size_t size() const {
+		return length;
+	}
+
+private:
+	const unsigned char* bytes = nullptr;
+	size_t length = 0;
+
+#ifdef _WIN32
+	HANDLE fileHandle = INVALID_HANDLE_VALUE;
+	HANDLE mappingHandle = nullptr;
+
+	bool isHandleValid() const {
+		return fileHandle != INVALID_HANDLE_VALUE;
+	}
+#else
+	int fileDescriptor = -1;
+
+	bool isHandleValid() const {
+		return fileDescriptor >= 0;
+	}
+#endif
+};
@@ -0,0 +1,208 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <unordered_map>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "../Common/include/Shader.h"
+#include "TextureLoader.cpp"
+#include "VirtualFileSystem.cpp"
+
+using namespace std;
+
+// Trecho contguo de vrtices (ou ndices) de uma malha desenhado com um nico material
+struct SubMesh {
+	int material;
+	int first;
+	int count;
+};
+
+// Tabela de materiais de um arquivo MTL, guardada como estrutura de arrays (um vetor por propriedade).
+// Cada arquivo MTL  lido uma nica vez e compartilhado por todas as malhas que o referenciam.
+class MaterialLibrary
+{
+public:
+	vector<string> names;
+	vector<glm::vec3> ambient, diffuse, specular;
+	vector<float> shininess;
+	vector<string> diffuseMaps;
+	vector<GLuint> textureIds;
+	// Escala (xy) e deslocamento (zw) das coordenadas de textura quando a textura est num atlas
+	vector<glm::vec4> uvTransforms;
+	// Materiais usados por malhas com coordenadas de textura fora de [0, 1] (textura repetida) no entram em atlas
+	vector<unsigned char> repeatsUV;
+	// Camada da textura quando textureIds guarda uma textura de array (-1 para texturas 2D comuns)
+	vector<int> textureLayers;
+
+	// Retorna a biblioteca j carregada para este MTL ou l o arquivo na primeira vez
+	static shared_ptr<MaterialLibrary> load(const string& filepath) {
+		auto cached = cache.find(filepath);
+		if (cached != cache.end())
+			return cached->second;
+
+		auto library = make_shared<MaterialLibrary>();
+		library->readMTLFile(filepath);
+		cache[filepath] = library;
+		return library;
+	}
+
+	// L o MTL sem passar pelo cache (recarga do arquivo em outra thread; depois usar replace)
+	static shared_ptr<MaterialLibrary> read(const string& filepath) {
+		auto library = make_shared<MaterialLibrary>();
+		library->readMTLFile(filepath);
+		return library;
+	}
+
+	// Guarda no cache uma biblioteca lida com read (em outra thread, na carga da cena)
+	static void insert(const string& filepath, shared_ptr<MaterialLibrary> library) {
+		cache.insert({ filepath, library });
+	}
+
+	// Troca a biblioteca em cache pela recarregada. Materiais cuja textura no mudou continuam com a textura
+	// j criada (inclusive a posio num atlas ou a camada num array), para que ela no seja lida de novo.
+	static void replace(const string& filepath, shared_ptr<MaterialLibrary> library) {
+		auto cached = cache.find(filepath);
+		if (cached != cache.end()) {
+			const MaterialLibrary& old = *cached->second;
+			for (int i = 0; i < library->size(); ++i) {
+				for (int j = 0; j < old.size(); ++j) {
+					if (old.diffuseMaps[j] == library->diffuseMaps[i] && old.textureIds[j] != 0) {
+						library->textureIds[i] = old.textureIds[j];
+						library->uvTransforms[i] = old.uvTransforms[j];
+						library->textureLayers[i] = old.textureLayers[j];
+						break;
+					}
+				}
+			}
+		}
+		cache[filepath] = library;
+	}
+
+	// Material padro para faces sem "usemtl" ou com material inexistente
+	static int defaultMaterial() {
+		return -1;
+	}
+
+	int size() const {
+		return (int)names.size();
+	}
+
+	int find(const string& name) const {
+		for (int i = 0; i < size(); ++i)
+			if (names[i] == name)
+				return i;
+		return defaultMaterial();
+	}
+
+	int addMaterial(const string& name, glm::vec3 ka, glm::vec3 kd, glm::vec3 ks, float ns, const string& diffuseMap = "", GLuint textureId = 0) {
+		names.push_back(name);
+		ambient.push_back(ka);
+		diffuse.push_back(kd);
+		specular.push_back(ks);
+		shininess.push_back(ns);
+		diffuseMaps.push_back(diffuseMap);
+		textureIds.push_back(textureId);
+		uvTransforms.push_back(glm::vec4(1.0f, 1.0f, 0.0f, 0.0f));
+		repeatsUV.push_back(0);
+		textureLayers.push_back(-1);
+		return size() - 1;
+	}
+
+	// Cria as texturas map_Kd; texturas repetidas (mesmo arquivo) so carregadas uma vez s
+	void loadTextures() {
+		for (int i = 0; i < size(); ++i)
+			if (textureIds[i] == 0 && !diffuseMaps[i].empty())
+				textureIds[i] = TextureLoader::loadTexture(diffuseMaps[i]);
+	}
+
+	void markRepeatsUV(int material) {
+		if (material >= 0 && material < size())
+			repeatsUV[material] = 1;
+	}
+
+	GLuint getTextureId(int material) const {
+		return material >= 0 && material < size() ? textureIds[material] : 0;
+	}
+
+	int getTextureLayer(int material) const {
+		return material >= 0 && material < size() ? textureLayers[material] : -1;
+	}
+
+	// Envia os coeficientes de iluminao do material para o shader
+	void applyMaterial(const Shader* shader, int material) const {
+		bool valid = material >= 0 && material < size();
+		glm::vec3 ka = valid ? ambient[material] : glm::vec3(0.2f);
+		glm::vec3 kd = valid ? diffuse[material] : glm::vec3(0.8f);
+		glm::vec3 ks = valid ? specular[material] : glm::vec3(0.5f);
+		float ns = valid ? shininess[material] : 32.0f;
+		glm::vec4 uvTransform = valid ? uvTransforms[material] : glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+
+		shader->setVec3("ka", ka.r, ka.g, ka.b);
+		shader->setVec3("kd", kd.r, kd.g, kd.b);
+		shader->setVec3("ks", ks.r, ks.g, ks.b);
+		shader->setFloat("q", ns);
+		shader->setVec4("uv_transform", uvTransform.x, uvTransform.y, uvTransform.z, uvTransform.w);
+		shader->setInt("texture_layer", getTextureLayer(material));
+	}
+
+private:
+	inline static unordered_map<string, shared_ptr<MaterialLibrary>> cache;
+
+	// Funo para ler todos os materiais de um arquivo MTL
+	void readMTLFile(const string& filepath) {
+		VirtualFile file(filepath);
+		if (!file.isOpen()) {
+			std::cerr << "Erro ao abrir o arquivo MTL: " << filepath << std::endl;
+			return;
+		}
+		istringstream inputFile(file.toString());
+
+		string line;
+		while (getline(inputFile, line))
+		{
+			istringstream ssline(line);
+			string word;
+			ssline >> word;
+
+			if (word == "newmtl") {
+				string name;
+				ssline >> name;
+				addMaterial(name, glm::vec3(0.2f), glm::vec3(0.8f), glm::vec3(0.5f), 32.0f);
+			}
+			else if (names.empty()) {
+				continue;
+			}
+			else if (word == "Ka") {
+				ambient.back() = readColor(ssline);
+			}
+			else if (word == "Kd") {
+				diffuse.back() = readColor(ssline);
+			}
+			else if (word == "Ks") {
+				specular.back() = readColor(ssline);
+			}
+			else if (word == "Ns") {
+				ssline >> shininess.back();
+			}
+			else if (word == "map_Kd") {
+				// O nome do arquivo  o ltimo termo (opes como -s e -o vm antes)
+				string token;
+				while (ssline >> token)
+					diffuseMaps.back() = token;
+			}
+		}
+	}
+
+	// L "r g b"; com um nico valor, repete-o nos trs canais
+	static glm::vec3 readColor(istringstream& ssline) {
+		float r = 0.0f, g, b;
+		ssline >> r;
+		if (!(ssline >> g >> b))
+			g = b = r;
+		return glm::vec3(r, g, b);
+	}
+};
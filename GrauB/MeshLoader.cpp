@@ -0,0 +1,573 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <charconv>
+#include <algorithm>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "VirtualFileSystem.cpp"
+#include "LinearArena.cpp"
+
+using namespace std;
+
+// Incio de um trecho da malha que usa o material indicado por "usemtl"
+struct MaterialRange {
+	string materialName;
+	int firstVertex;
+};
+
+// L arquivos de malha (OBJ, PLY e STL) direto para o layout de vrtices da engine:
+// posio (3), cor (3), coordenada de textura (2) e normal (3). Os vetores intermedirios ficam na arena
+// da thread (LinearArena::scratch), descartados juntos no fim da leitura.
+class MeshLoader
+{
+public:
+	static const int stride = 11;
+
+	// Escolhe o leitor pela extenso do arquivo
+	static bool readMeshFile(const std::string& filepath, std::vector<GLfloat>& vbuffer,
+		string& materialFileName, vector<MaterialRange>& materialRanges) {
+		string extension = getExtension(filepath);
+
+		if (extension == "ply" || extension == "stl") {
+			bool success = extension == "ply" ? readPLYFile(filepath, vbuffer) : readSTLFile(filepath, vbuffer);
+			// PLY e STL no referenciam materiais: usa o primeiro material do MTL de mesmo nome, se existir
+			materialFileName = filepath.substr(0, filepath.find_last_of('.')) + ".mtl";
+			materialRanges.push_back({ "", 0 });
+			return success;
+		}
+
+		ArenaScope scratch;
+		std::pmr::vector<GLuint> indices(scratch.resource());
+		return readOBJFile(filepath, indices, vbuffer, materialFileName, materialRanges);
+	}
+
+	static string getExtension(const std::string& filepath) {
+		size_t pos = filepath.find_last_of('.');
+		if (pos == string::npos)
+			return "";
+		string extension = filepath.substr(pos + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+		return extension;
+	}
+
+	// Funo para ler o arquivo OBJ e extrair os dados de vrtices e ndices
+	static bool readOBJFile(const std::string& filepath, std::pmr::vector<GLuint>& indices, std::vector<GLfloat>& vbuffer,
+		string& materialFileName, vector<MaterialRange>& materialRanges) {
+
+		glm::vec3 color = glm::vec3(1.0, 0.0, 1.0);
+
+		// Os temporrios usam a mesma memria dos ndices (a arena de readMeshFile)
+		std::pmr::memory_resource* scratch = indices.get_allocator().resource();
+		std::pmr::vector<glm::vec2> textureCoordinates(scratch);
+		std::pmr::vector<glm::vec3> vertices(scratch);
+		std::pmr::vector<glm::vec3> normals(scratch);
+
+		VirtualFile file(filepath);
+		if (!file.isOpen()) {
+			std::cerr << "Erro ao abrir o arquivo OBJ: " << filepath << std::endl;
+			return false;
+		}
+		std::istringstream inputFile(file.toString());
+
+		std::string line;
+		while (std::getline(inputFile, line)) {
+			std::istringstream ssline(line);
+			std::string word;
+			ssline >> word;
+
+			if (word == "mtllib") {
+				std::getline(ssline >> std::ws, materialFileName);
+			}
+			else if (word == "usemtl") {
+				string materialName;
+				ssline >> materialName;
+				materialRanges.push_back({ materialName, (int)(vbuffer.size() / stride) });
+			}
+			else if (word == "v") {
+				glm::vec3 v;
+				ssline >> v.x >> v.y >> v.z;
+				vertices.push_back(v);
+			}
+			else if (word == "vt")
+			{
+				glm::vec2 vt;
+				ssline >> vt.s >> vt.t;
+				textureCoordinates.push_back(vt);
+			}
+			else if (word == "vn")
+			{
+				glm::vec3 vn;
+				ssline >> vn.x >> vn.y >> vn.z;
+				normals.push_back(vn);
+			}
+			else if (word == "f") {
+				std::string tokens[3];
+				ssline >> tokens[0] >> tokens[1] >> tokens[2];
+
+				for (int i = 0; i < 3; ++i) {
+					int pos = tokens[i].find("/");
+					std::string token = tokens[i].substr(0, pos);
+					int index = std::atoi(token.c_str()) - 1;
+					indices.push_back(index);
+
+					vbuffer.push_back(vertices[index].x);
+					vbuffer.push_back(vertices[index].y);
+					vbuffer.push_back(vertices[index].z);
+
+					vbuffer.push_back(color.r);
+					vbuffer.push_back(color.g);
+					vbuffer.push_back(color.b);
+
+					tokens[i] = tokens[i].substr(pos + 1);
+					pos = tokens[i].find("/");
+					token = tokens[i].substr(0, pos);
+					index = atoi(token.c_str()) - 1;
+
+					vbuffer.push_back(textureCoordinates[index].s);
+					vbuffer.push_back(textureCoordinates[index].t);
+
+					tokens[i] = tokens[i].substr(pos + 1);
+					index = atoi(tokens[i].c_str()) - 1;
+
+					vbuffer.push_back(normals[index].x);
+					vbuffer.push_back(normals[index].y);
+					vbuffer.push_back(normals[index].z);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// Funo para ler arquivos PLY (binrio little/big endian ou ASCII) a partir do arquivo mapeado em memria
+	static bool readPLYFile(const std::string& filepath, std::vector<GLfloat>& vbuffer) {
+		VirtualFile file(filepath);
+		if (!file.isOpen() || file.size() == 0) {
+			std::cerr << "Erro ao abrir o arquivo PLY: " << filepath << std::endl;
+			return false;
+		}
+
+		const char* begin = (const char*)file.data();
+		const char* end = begin + file.size();
+
+		PLYHeader header;
+		const char* body = parsePLYHeader(begin, end, header);
+		if (body == nullptr) {
+			std::cerr << "Cabealho PLY invlido: " << filepath << std::endl;
+			return false;
+		}
+
+		const PLYElement* vertexElement = nullptr;
+		const PLYElement* faceElement = nullptr;
+		for (const auto& element : header.elements) {
+			if (element.name == "vertex")
+				vertexElement = &element;
+			else if (element.name == "face")
+				faceElement = &element;
+		}
+
+		if (vertexElement == nullptr || faceElement == nullptr) {
+			std::cerr << "Arquivo PLY sem vrtices ou faces: " << filepath << std::endl;
+			return false;
+		}
+
+		// Descobre qual propriedade do vrtice alimenta cada atributo da engine
+		int attributeProperty[stride];
+		for (int i = 0; i < stride; ++i)
+			attributeProperty[i] = -1;
+		for (int p = 0; p < (int)vertexElement->properties.size(); ++p) {
+			int attribute = getPLYAttribute(vertexElement->properties[p].name);
+			if (attribute >= 0)
+				attributeProperty[attribute] = p;
+		}
+
+		ArenaScope scratch;
+		std::pmr::vector<GLfloat> vertices(scratch.resource());
+		// As contagens do cabealho so limitadas ao que cabe no corpo, para que um cabealho corrompido no pea gigabytes
+		size_t bodySize = end - body;
+		vertices.reserve(std::min(vertexElement->count, bodySize / getMinRowSize(*vertexElement, header.format)) * stride);
+		vbuffer.reserve(vbuffer.size() + std::min(faceElement->count, bodySize / getMinRowSize(*faceElement, header.format)) * 3 * stride);
+
+		PLYCursor cursor = { body, end, header.format };
+		std::pmr::vector<double> values(scratch.resource());
+		std::pmr::vector<uint32_t> faceIndices(scratch.resource());
+
+		for (const auto& element : header.elements) {
+			for (size_t row = 0; row < element.count; ++row) {
+				if (&element == vertexElement) {
+					values.resize(element.properties.size());
+					for (size_t p = 0; p < element.properties.size(); ++p)
+						if (!cursor.readProperty(element.properties[p], values[p], nullptr))
+							return reportTruncated(filepath);
+
+					GLfloat vertex[stride] = { 0.0, 0.0, 0.0, 1.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+					for (int a = 0; a < stride; ++a) {
+						if (attributeProperty[a] < 0)
+							continue;
+						double value = values[attributeProperty[a]];
+						// Cores inteiras (uchar) vo de 0 a 255
+						if (a >= 3 && a <= 5 && isIntegerType(element.properties[attributeProperty[a]].type))
+							value /= 255.0;
+						vertex[a] = (GLfloat)value;
+					}
+					vertices.insert(vertices.end(), vertex, vertex + stride);
+				}
+				else if (&element == faceElement) {
+					faceIndices.clear();
+					for (const auto& property : element.properties) {
+						double value;
+						std::pmr::vector<uint32_t>* list = property.isList && isFaceIndexList(property.name) ? &faceIndices : nullptr;
+						if (!cursor.readProperty(property, value, list))
+							return reportTruncated(filepath);
+					}
+
+					// Triangula polgonos em leque
+					for (size_t k = 1; k + 1 < faceIndices.size(); ++k) {
+						uint32_t triangle[3] = { faceIndices[0], faceIndices[k], faceIndices[k + 1] };
+						for (uint32_t index : triangle) {
+							// Compara com os vrtices j lidos: o PLY pode declarar as faces antes dos vrtices
+							if (((size_t)index + 1) * stride > vertices.size())
+								return reportTruncated(filepath);
+							vbuffer.insert(vbuffer.end(), vertices.begin() + (size_t)index * stride, vertices.begin() + ((size_t)index + 1) * stride);
+						}
+					}
+				}
+				else {
+					for (const auto& property : element.properties) {
+						double value;
+						if (!cursor.readProperty(property, value, nullptr))
+							return reportTruncated(filepath);
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// Funo para ler arquivos STL (binrio ou ASCII) a partir do arquivo mapeado em memria
+	static bool readSTLFile(const std::string& filepath, std::vector<GLfloat>& vbuffer) {
+		VirtualFile file(filepath);
+		if (!file.isOpen()) {
+			std::cerr << "Erro ao abrir o arquivo STL: " << filepath << std::endl;
+			return false;
+		}
+
+		const unsigned char* data = file.data();
+		size_t size = file.size();
+		const GLfloat color[3] = { 1.0, 0.0, 1.0 };
+
+		// STL binrio: cabealho de 80 bytes, nmero de tringulos e 50 bytes por tringulo
+		uint32_t numTriangles = 0;
+		if (size >= 84)
+			memcpy(&numTriangles, data + 80, sizeof(uint32_t));
+
+		if (size >= 84 && size == 84 + (size_t)numTriangles * 50) {
+			vbuffer.reserve(vbuffer.size() + (size_t)numTriangles * 3 * stride);
+			const unsigned char* triangle = data + 84;
+
+			for (uint32_t t = 0; t < numTriangles; ++t, triangle += 50) {
+				float values[12];
+				memcpy(values, triangle, sizeof(values));
+
+				for (int v = 0; v < 3; ++v) {
+					const float* position = values + 3 + v * 3;
+					GLfloat vertex[stride] = { position[0], position[1], position[2], color[0], color[1], color[2],
+						0.0, 0.0, values[0], values[1], values[2] };
+					vbuffer.insert(vbuffer.end(), vertex, vertex + stride);
+				}
+			}
+			return true;
+		}
+
+		// STL ASCII: "facet normal nx ny nz" seguido de trs "vertex x y z"
+		// (sem o "solid" inicial  um STL binrio com o tamanho errado, ou seja, truncado)
+		const char* cursor = (const char*)data;
+		const char* end = cursor + size;
+		float normal[3] = { 0.0, 0.0, 0.0 };
+		string_view word;
+		const char* start = cursor;
+		if (!nextToken(start, end, word) || word != "solid")
+			return reportTruncated(filepath);
+
+		while (nextToken(cursor, end, word)) {
+			if (word == "normal") {
+				for (int i = 0; i < 3; ++i)
+					if (!nextFloat(cursor, end, normal[i]))
+						return reportTruncated(filepath);
+			}
+			else if (word == "vertex") {
+				float position[3];
+				for (int i = 0; i < 3; ++i)
+					if (!nextFloat(cursor, end, position[i]))
+						return reportTruncated(filepath);
+
+				GLfloat vertex[stride] = { position[0], position[1], position[2], color[0], color[1], color[2],
+					0.0, 0.0, normal[0], normal[1], normal[2] };
+				vbuffer.insert(vbuffer.end(), vertex, vertex + stride);
+			}
+		}
+
+		return true;
+	}
+
+private:
+	enum PLYFormat { PLY_ASCII, PLY_BINARY_LITTLE_ENDIAN, PLY_BINARY_BIG_ENDIAN };
+	enum PLYType { PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64, PLY_INVALID };
+
+	struct PLYProperty {
+		string name;
+		PLYType type = PLY_INVALID;
+		PLYType countType = PLY_INVALID;
+		bool isList = false;
+	};
+
+	struct PLYElement {
+		string name;
+		size_t count = 0;
+		vector<PLYProperty> properties;
+	};
+
+	struct PLYHeader {
+		PLYFormat format = PLY_ASCII;
+		vector<PLYElement> elements;
+	};
+
+	// Percorre o corpo do PLY lendo um valor por vez, no formato indicado pelo cabealho
+	struct PLYCursor {
+		const char* position;
+		const char* end;
+		PLYFormat format;
+
+		bool readProperty(const PLYProperty& property, double& value, std::pmr::vector<uint32_t>* list) {
+			if (!property.isList)
+				return readValue(property.type, value);
+
+			double count;
+			if (!readValue(property.countType, count))
+				return false;
+			// Cada item ocupa ao menos o tamanho do tipo (no ASCII, um caractere): um tamanho que no cabe no que resta
+			// do corpo (ou negativo, NaN, infinito) invalida o arquivo antes do lao
+			size_t itemSize = format == PLY_ASCII ? 1 : std::max<size_t>(getTypeSize(property.type), 1);
+			if (!std::isfinite(count) || count < 0.0 || count > (double)((size_t)(end - position) / itemSize))
+				return false;
+
+			size_t items = (size_t)count;
+			for (size_t i = 0; i < items; ++i) {
+				if (!readValue(property.type, value))
+					return false;
+				// ndices fora do intervalo viram UINT32_MAX e so rejeitados na leitura das faces
+				if (list != nullptr)
+					list->push_back(value >= 0.0 && value <= (double)UINT32_MAX ? (uint32_t)value : UINT32_MAX);
+			}
+			return true;
+		}
+
+		bool readValue(PLYType type, double& value) {
+			if (format == PLY_ASCII) {
+				// Inteiros so lidos como inteiros: ndices acima de 2^24 no cabem exatos num float
+				if (isIntegerType(type)) {
+					int64_t integer;
+					if (!nextInteger(position, end, integer))
+						return false;
+					value = (double)integer;
+					return true;
+				}
+				float number;
+				if (!nextFloat(position, end, number))
+					return false;
+				value = number;
+				return true;
+			}
+
+			size_t size = getTypeSize(type);
+			if (size == 0 || (size_t)(end - position) < size)
+				return false;
+
+			unsigned char bytes[8];
+			memcpy(bytes, position, size);
+			position += size;
+			if (format == PLY_BINARY_BIG_ENDIAN)
+				std::reverse(bytes, bytes + size);
+
+			switch (type) {
+			case PLY_INT8: { int8_t v; memcpy(&v, bytes, size); value = v; break; }
+			case PLY_UINT8: { uint8_t v; memcpy(&v, bytes, size); value = v; break; }
+			case PLY_INT16: { int16_t v; memcpy(&v, bytes, size); value = v; break; }
+			case PLY_UINT16: { uint16_t v; memcpy(&v, bytes, size); value = v; break; }
+			case PLY_INT32: { int32_t v; memcpy(&v, bytes, size); value = v; break; }
+			case PLY_UINT32: { uint32_t v; memcpy(&v, bytes, size); value = v; break; }
+			case PLY_FLOAT32: { float v; memcpy(&v, bytes, size); value = v; break; }
+			case PLY_FLOAT64: { double v; memcpy(&v, bytes, size); value = v; break; }
+			default: return false;
+			}
+			return true;
+		}
+	};
+
+	// L o cabealho textual do PLY e retorna o incio do corpo (ou nullptr se invlido)
+	static const char* parsePLYHeader(const char* begin, const char* end, PLYHeader& header) {
+		const char* cursor = begin;
+		string line;
+
+		if (!nextLine(cursor, end, line) || line != "ply")
+			return nullptr;
+
+		while (nextLine(cursor, end, line)) {
+			std::istringstream ssline(line);
+			string word;
+			ssline >> word;
+
+			if (word == "format") {
+				string format;
+				ssline >> format;
+				if (format == "ascii")
+					header.format = PLY_ASCII;
+				else if (format == "binary_little_endian")
+					header.format = PLY_BINARY_LITTLE_ENDIAN;
+				else if (format == "binary_big_endian")
+					header.format = PLY_BINARY_BIG_ENDIAN;
+				else
+					return nullptr;
+			}
+			else if (word == "element") {
+				PLYElement element;
+				ssline >> element.name >> element.count;
+				header.elements.push_back(element);
+			}
+			else if (word == "property" && !header.elements.empty()) {
+				PLYProperty property;
+				string type;
+				ssline >> type;
+				if (type == "list") {
+					string countType;
+					ssline >> countType >> type;
+					property.isList = true;
+					property.countType = getType(countType);
+				}
+				property.type = getType(type);
+				ssline >> property.name;
+				if (property.type == PLY_INVALID || (property.isList && property.countType == PLY_INVALID))
+					return nullptr;
+				header.elements.back().properties.push_back(property);
+			}
+			else if (word == "end_header") {
+				return cursor;
+			}
+		}
+
+		return nullptr;
+	}
+
+	static PLYType getType(const string& name) {
+		if (name == "char" || name == "int8") return PLY_INT8;
+		if (name == "uchar" || name == "uint8") return PLY_UINT8;
+		if (name == "short" || name == "int16") return PLY_INT16;
+		if (name == "ushort" || name == "uint16") return PLY_UINT16;
+		if (name == "int" || name == "int32") return PLY_INT32;
+		if (name == "uint" || name == "uint32") return PLY_UINT32;
+		if (name == "float" || name == "float32") return PLY_FLOAT32;
+		if (name == "double" || name == "float64") return PLY_FLOAT64;
+		return PLY_INVALID;
+	}
+
+	// Menor nmero de bytes de uma linha do elemento no corpo, contando as listas com 3 itens (tringulos)
+	static size_t getMinRowSize(const PLYElement& element, PLYFormat format) {
+		size_t size = 0;
+		for (const auto& property : element.properties) {
+			if (format == PLY_ASCII)
+				size += property.isList ? 8 : 2;
+			else
+				size += property.isList ? getTypeSize(property.countType) + 3 * getTypeSize(property.type) : getTypeSize(property.type);
+		}
+		return std::max<size_t>(size, 1);
+	}
+
+	static size_t getTypeSize(PLYType type) {
+		switch (type) {
+		case PLY_INT8: case PLY_UINT8: return 1;
+		case PLY_INT16: case PLY_UINT16: return 2;
+		case PLY_INT32: case PLY_UINT32: case PLY_FLOAT32: return 4;
+		case PLY_FLOAT64: return 8;
+		default: return 0;
+		}
+	}
+
+	static bool isIntegerType(PLYType type) {
+		return type != PLY_FLOAT32 && type != PLY_FLOAT64;
+	}
+
+	static bool isFaceIndexList(const string& name) {
+		return name == "vertex_indices" || name == "vertex_index";
+	}
+
+	// Posio no layout da engine de cada propriedade de vrtice do PLY
+	static int getPLYAttribute(const string& name) {
+		if (name == "x") return 0;
+		if (name == "y") return 1;
+		if (name == "z") return 2;
+		if (name == "red") return 3;
+		if (name == "green") return 4;
+		if (name == "blue") return 5;
+		if (name == "s" || name == "u" || name == "texture_u") return 6;
+		if (name == "t" || name == "v" || name == "texture_v") return 7;
+		if (name == "nx") return 8;
+		if (name == "ny") return 9;
+		if (name == "nz") return 10;
+		return -1;
+	}
+
+	static bool nextLine(const char*& cursor, const char* end, string& line) {
+		if (cursor >= end)
+			return false;
+		const char* lineEnd = (const char*)memchr(cursor, '\n', end - cursor);
+		if (lineEnd == nullptr)
+			lineEnd = end;
+		line.assign(cursor, lineEnd);
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		cursor = lineEnd < end ? lineEnd + 1 : end;
+		return true;
+	}
+
+	static bool nextToken(const char*& cursor, const char* end, string_view& token) {
+		while (cursor < end && isspace((unsigned char)*cursor))
+			++cursor;
+		const char* start = cursor;
+		while (cursor < end && !isspace((unsigned char)*cursor))
+			++cursor;
+		token = string_view(start, cursor - start);
+		return cursor > start;
+	}
+
+	static bool nextFloat(const char*& cursor, const char* end, float& value) {
+		string_view token;
+		if (!nextToken(cursor, end, token))
+			return false;
+		if (token.front() == '+')
+			token.remove_prefix(1);
+		return std::from_chars(token.data(), token.data() + token.size(), value).ec == std::errc();
+	}
+
+	static bool nextInteger(const char*& cursor, const char* end, int64_t& value) {
+		string_view token;
+		if (!nextToken(cursor, end, token))
+			return false;
+		if (token.front() == '+')
+			token.remove_prefix(1);
+		return std::from_chars(token.data(), token.data() + token.size(), value).ec == std::errc();
+	}
+
+	static bool reportTruncated(const std::string& filepath) {
+		std::cerr << "Arquivo de malha truncado ou invlido: " << filepath << std::endl;
+		return false;
+	}
+};
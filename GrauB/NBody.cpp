@@ -0,0 +1,396 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <atomic>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "JobSystem.cpp"
+#include "Profiler.cpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GRAUB_SSE
+#endif
+
+using namespace std;
+
+// Simulao gravitacional de N corpos: posies, velocidades e aceleraes em SoA (um vetor por componente), integradas
+// com leapfrog (kick-drift-kick), que  simpltico e no acumula erro de energia como Euler. S os corpos com massa
+// atraem os outros; os de massa zero (ex.: um cinturo de asteroides) so partculas de teste, atradas mas sem custo
+// como fontes. Com at directLimit fontes a soma  direta, quatro fontes por vez com SSE; acima disso as fontes
+// vo para uma octree de Barnes-Hut (clulas distantes contam como um corpo s no centro de massa). A acelerao
+// de cada corpo  calculada por uma nica tarefa na mesma ordem, ento o resultado no depende do nmero de threads.
+class NBody
+{
+public:
+	NBody(float G = 1.0f, float softening = 0.05f, float theta = 0.5f, int directLimit = 2048)
+		: G(G), softening2(softening * softening), theta(theta), directLimit(directLimit) {}
+
+	// Retorna o ndice do corpo
+	int addBody(glm::vec3 position, glm::vec3 velocity, float mass) {
+		x.push_back(position.x);
+		y.push_back(position.y);
+		z.push_back(position.z);
+		vx.push_back(velocity.x);
+		vy.push_back(velocity.y);
+		vz.push_back(velocity.z);
+		ax.push_back(0.0f);
+		ay.push_back(0.0f);
+		az.push_back(0.0f);
+		m.push_back(std::max(mass, 0.0f));
+		accelerationsValid = false;
+		return (int)x.size() - 1;
+	}
+
+	// Velocidade da rbita circular de raio |position - center| em torno de uma massa centralMass, no plano
+	// perpendicular a y (sentido anti-horrio visto de cima)
+	glm::vec3 getCircularVelocity(glm::vec3 position, glm::vec3 center, float centralMass) const {
+		glm::vec3 offset = position - center;
+		offset.y = 0.0f;
+		float radius = glm::length(offset);
+		if (radius <= 0.0f || centralMass <= 0.0f)
+			return glm::vec3(0.0f);
+		glm::vec3 direction = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), offset / radius));
+		return direction * std::sqrt(G * centralMass / radius);
+	}
+
+	// Cinturo de count corpos entre os raios inner e outer em torno do corpo central, com espessura thickness em y e
+	// rbitas circulares; a semente torna o cinturo igual em toda execuo. Retorna o ndice do primeiro corpo.
+	int addBelt(int central, int count, float inner, float outer, float thickness, float mass, uint32_t seed) {
+		int first = (int)x.size();
+		glm::vec3 center = getPosition(central), centerVelocity = getVelocity(central);
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		reserve(x.size() + count);
+		for (int i = 0; i < count; ++i) {
+			// Raio com densidade uniforme na rea do anel
+			float radius = std::sqrt(inner * inner + unit(random) * (outer * outer - inner * inner));
+			float angle = unit(random) * 6.28318530718f;
+			glm::vec3 position = center + glm::vec3(radius * std::cos(angle), (unit(random) - 0.5f) * thickness, radius * std::sin(angle));
+			addBody(position, centerVelocity + getCircularVelocity(position, center, m[central]), mass);
+		}
+		return first;
+	}
+
+	void reserve(size_t count) {
+		for (auto* values : { &x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az, &m })
+			values->reserve(count);
+	}
+
+	size_t size() const {
+		return x.size();
+	}
+
+	glm::vec3 getPosition(int body) const {
+		return glm::vec3(x[body], y[body], z[body]);
+	}
+
+	void setPosition(int body, glm::vec3 position) {
+		x[body] = position.x;
+		y[body] = position.y;
+		z[body] = position.z;
+		accelerationsValid = false;
+	}
+
+	glm::vec3 getVelocity(int body) const {
+		return glm::vec3(vx[body], vy[body], vz[body]);
+	}
+
+	float getMass(int body) const {
+		return m[body];
+	}
+
+	// Um passo de dt segundos: meio impulso, deslocamento, novas aceleraes e o outro meio impulso
+	void step(float dt, JobSystem& jobs) {
+		PROFILE_ZONE("NBody::step");
+		if (!accelerationsValid)
+			computeAccelerations(jobs);
+		int count = (int)size();
+		float half = 0.5f * dt;
+		jobs.parallelFor(count, 4096, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i) {
+				vx[i] += ax[i] * half;
+				vy[i] += ay[i] * half;
+				vz[i] += az[i] * half;
+				x[i] += vx[i] * dt;
+				y[i] += vy[i] * dt;
+				z[i] += vz[i] * dt;
+			}
+		});
+		computeAccelerations(jobs);
+		jobs.parallelFor(count, 4096, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i) {
+				vx[i] += ax[i] * half;
+				vy[i] += ay[i] * half;
+				vz[i] += az[i] * half;
+			}
+		});
+	}
+
+	// Aceleraes de todos os corpos pelas posies atuais (soma direta ou Barnes-Hut, conforme o nmero de fontes)
+	void computeAccelerations(JobSystem& jobs) {
+		gatherSources();
+		bool direct = sourceCount <= directLimit;
+		if (!direct)
+			buildTree(jobs);
+		std::atomic<uint64_t> total{ 0 };
+		jobs.parallelFor((int)size(), 256, [&](int begin, int end) {
+			uint64_t count = 0;
+			for (int i = begin; i < end; ++i) {
+				float accX = 0.0f, accY = 0.0f, accZ = 0.0f;
+				if (direct) {
+					accumulate(0, sourceCount, x[i], y[i], z[i], accX, accY, accZ);
+					count += sourceCount;
+				}
+				else {
+					count += traverse(x[i], y[i], z[i], accX, accY, accZ);
+				}
+				ax[i] = G * accX;
+				ay[i] = G * accY;
+				az[i] = G * accZ;
+			}
+			total.fetch_add(count, memory_order_relaxed);
+		});
+		interactions = total.load();
+		usedTree = !direct;
+		accelerationsValid = true;
+	}
+
+	// Energia cintica mais potencial (com o mesmo amortecimento das foras), somada em double; a potencial  O(M)
+	// nos corpos com massa, ento serve para conferir a conservao em cenas de teste, no a cada quadro
+	double getEnergy(JobSystem& jobs) const {
+		int count = (int)size();
+		vector<double> kinetic(count, 0.0), potential(count, 0.0);
+		jobs.parallelFor(count, 64, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i) {
+				if (m[i] <= 0.0f)
+					continue;
+				kinetic[i] = 0.5 * m[i] * ((double)vx[i] * vx[i] + (double)vy[i] * vy[i] + (double)vz[i] * vz[i]);
+				double sum = 0.0;
+				for (int j = i + 1; j < count; ++j) {
+					if (m[j] <= 0.0f)
+						continue;
+					double dx = (double)x[j] - x[i], dy = (double)y[j] - y[i], dz = (double)z[j] - z[i];
+					sum -= (double)m[j] / std::sqrt(dx * dx + dy * dy + dz * dz + softening2);
+				}
+				potential[i] = G * m[i] * sum;
+			}
+		});
+		double energy = 0.0;
+		for (int i = 0; i < count; ++i)
+			energy += kinetic[i] + potential[i];
+		return energy;
+	}
+
+	// Interaes corpo-fonte (ou corpo-clula) do ltimo clculo das aceleraes e se ele usou a octree
+	uint64_t getInteractions() const {
+		return interactions;
+	}
+
+	bool isUsingTree() const {
+		return usedTree;
+	}
+
+	int getNumNodes() const {
+		return (int)nodes.size();
+	}
+
+private:
+	// Clula da octree: centro de massa e massa das fontes [begin, end) (contguas na ordem de Morton), lado da
+	// clula e os filhos, contguos a partir de firstChild (nenhum numa folha)
+	struct Node {
+		float x, y, z, mass, size;
+		int begin, end, firstChild, numChildren;
+	};
+
+	static const int leafSize = 16;
+	static const int maxLevel = 21;
+
+	float G, softening2, theta;
+	int directLimit;
+	vector<float> x, y, z, vx, vy, vz, ax, ay, az, m;
+	bool accelerationsValid = false, usedTree = false;
+	uint64_t interactions = 0;
+
+	// Cpia das fontes (corpos com massa) usada no clculo, ordenada pelo cdigo de Morton quando h octree
+	int sourceCount = 0;
+	vector<float> sx, sy, sz, sm, sortedScratch;
+	vector<pair<uint64_t, int>> codes;
+	vector<Node> nodes;
+
+	void gatherSources() {
+		sourceCount = 0;
+		sx.clear();
+		sy.clear();
+		sz.clear();
+		sm.clear();
+		for (size_t i = 0; i < size(); ++i)
+			if (m[i] > 0.0f) {
+				sx.push_back(x[i]);
+				sy.push_back(y[i]);
+				sz.push_back(z[i]);
+				sm.push_back(m[i]);
+				++sourceCount;
+			}
+	}
+
+	// Ordena as fontes pelo cdigo de Morton (clulas vizinhas ficam contguas) e monta a octree sobre elas
+	void buildTree(JobSystem& jobs) {
+		PROFILE_ZONE("NBody::buildTree");
+		glm::vec3 low(sx[0], sy[0], sz[0]), high = low;
+		for (int i = 1; i < sourceCount; ++i) {
+			low = glm::min(low, glm::vec3(sx[i], sy[i], sz[i]));
+			high = glm::max(high, glm::vec3(sx[i], sy[i], sz[i]));
+		}
+		float size = std::max(std::max(high.x - low.x, high.y - low.y), std::max(high.z - low.z, 1e-6f));
+		float scale = (float)((1 << maxLevel) - 1) / size;
+
+		codes.resize(sourceCount);
+		jobs.parallelFor(sourceCount, 4096, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i)
+				codes[i] = { interleave((uint32_t)((sx[i] - low.x) * scale)) | interleave((uint32_t)((sy[i] - low.y) * scale)) << 1 |
+					interleave((uint32_t)((sz[i] - low.z) * scale)) << 2, i };
+		});
+		std::sort(codes.begin(), codes.end());
+
+		sortedScratch.resize(sourceCount);
+		for (vector<float>* values : { &sx, &sy, &sz, &sm }) {
+			for (int i = 0; i < sourceCount; ++i)
+				sortedScratch[i] = (*values)[codes[i].second];
+			values->swap(sortedScratch);
+		}
+
+		nodes.clear();
+		nodes.push_back({});
+		buildNode(0, 0, sourceCount, 0, size);
+	}
+
+	void buildNode(int index, int begin, int end, int level, float size) {
+		Node node = { 0.0f, 0.0f, 0.0f, 0.0f, size, begin, end, -1, 0 };
+		if (end - begin <= leafSize || level == maxLevel) {
+			for (int i = begin; i < end; ++i) {
+				node.x += sx[i] * sm[i];
+				node.y += sy[i] * sm[i];
+				node.z += sz[i] * sm[i];
+				node.mass += sm[i];
+			}
+		}
+		else {
+			// Os 3 bits do nvel escolhem o octante; como os cdigos esto ordenados, cada octante  um trecho contguo
+			int shift = 3 * (maxLevel - 1 - level);
+			int ranges[9], numChildren = 0;
+			int first = begin;
+			for (int octant = 0; octant < 8; ++octant) {
+				int last = first;
+				while (last < end && (int)((codes[last].first >> shift) & 7) == octant)
+					++last;
+				if (last > first)
+					ranges[numChildren++] = first;
+				first = last;
+			}
+			ranges[numChildren] = end;
+			node.firstChild = (int)nodes.size();
+			node.numChildren = numChildren;
+			nodes.resize(nodes.size() + numChildren);
+			for (int c = 0; c < numChildren; ++c) {
+				buildNode(node.firstChild + c, ranges[c], ranges[c + 1], level + 1, size * 0.5f);
+				const Node& child = nodes[node.firstChild + c];
+				node.x += child.x * child.mass;
+				node.y += child.y * child.mass;
+				node.z += child.z * child.mass;
+				node.mass += child.mass;
+			}
+		}
+		if (node.mass > 0.0f) {
+			node.x /= node.mass;
+			node.y /= node.mass;
+			node.z /= node.mass;
+		}
+		nodes[index] = node;
+	}
+
+	// Percorre a octree a partir da raiz com uma pilha fixa; retorna quantas interaes foram somadas
+	uint64_t traverse(float px, float py, float pz, float& accX, float& accY, float& accZ) const {
+		int stack[8 * maxLevel + 8];
+		int top = 0;
+		stack[top++] = 0;
+		uint64_t count = 0;
+		float theta2 = theta * theta;
+		while (top > 0) {
+			const Node& node = nodes[stack[--top]];
+			float dx = node.x - px, dy = node.y - py, dz = node.z - pz;
+			float distance2 = dx * dx + dy * dy + dz * dz;
+			if (node.numChildren == 0) {
+				accumulate(node.begin, node.end, px, py, pz, accX, accY, accZ);
+				count += node.end - node.begin;
+			}
+			else if (node.size * node.size < theta2 * distance2) {
+				// Longe o bastante: a clula inteira conta como um corpo no centro de massa
+				float inverse = 1.0f / std::sqrt(distance2 + softening2);
+				float factor = node.mass * inverse * inverse * inverse;
+				accX += dx * factor;
+				accY += dy * factor;
+				accZ += dz * factor;
+				++count;
+			}
+			else {
+				for (int c = node.numChildren - 1; c >= 0; --c)
+					stack[top++] = node.firstChild + c;
+			}
+		}
+		return count;
+	}
+
+	// Soma a atrao das fontes [begin, end) sobre o ponto (sem G); uma fonte na mesma posio (o prprio corpo)  ignorada
+	void accumulate(int begin, int end, float px, float py, float pz, float& accX, float& accY, float& accZ) const {
+		int i = begin;
+#ifdef GRAUB_SSE
+		__m128 positionX = _mm_set1_ps(px), positionY = _mm_set1_ps(py), positionZ = _mm_set1_ps(pz);
+		__m128 epsilon = _mm_set1_ps(softening2), zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+		__m128 sumX = zero, sumY = zero, sumZ = zero;
+		for (; i + 4 <= end; i += 4) {
+			__m128 dx = _mm_sub_ps(_mm_loadu_ps(&sx[i]), positionX);
+			__m128 dy = _mm_sub_ps(_mm_loadu_ps(&sy[i]), positionY);
+			__m128 dz = _mm_sub_ps(_mm_loadu_ps(&sz[i]), positionZ);
+			__m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			__m128 inverse = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(distance2, epsilon)));
+			__m128 factor = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(&sm[i]), inverse), _mm_mul_ps(inverse, inverse));
+			factor = _mm_and_ps(factor, _mm_cmpgt_ps(distance2, zero));
+			sumX = _mm_add_ps(sumX, _mm_mul_ps(dx, factor));
+			sumY = _mm_add_ps(sumY, _mm_mul_ps(dy, factor));
+			sumZ = _mm_add_ps(sumZ, _mm_mul_ps(dz, factor));
+		}
+		float lanes[4];
+		_mm_storeu_ps(lanes, sumX);
+		accX += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+		_mm_storeu_ps(lanes, sumY);
+		accY += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+		_mm_storeu_ps(lanes, sumZ);
+		accZ += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+		for (; i < end; ++i) {
+			float dx = sx[i] - px, dy = sy[i] - py, dz = sz[i] - pz;
+			float distance2 = dx * dx + dy * dy + dz * dz;
+			if (distance2 <= 0.0f)
+				continue;
+			float inverse = 1.0f / std::sqrt(distance2 + softening2);
+			float factor = sm[i] * inverse * inverse * inverse;
+			accX += dx * factor;
+			accY += dy * factor;
+			accZ += dz * factor;
+		}
+	}
+
+	// Espalha os 21 bits de v a cada 3 bits (um eixo do cdigo de Morton)
+	static uint64_t interleave(uint32_t v) {
+		uint64_t bits = v & 0x1FFFFF;
+		bits = (bits | bits << 32) & 0x1F00000000FFFFull;
+		bits = (bits | bits << 16) & 0x1F0000FF0000FFull;
+		bits = (bits | bits << 8) & 0x100F00F00F00F00Full;
+		bits = (bits | bits << 4) & 0x10C30C30C30C30C3ull;
+		bits = (bits | bits << 2) & 0x1249249249249249ull;
+		return bits;
+	}
+};
\ No newline at end of file
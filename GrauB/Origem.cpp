@@ -3,6 +3,14 @@
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <chrono>
+#include <filesystem>
+#include <new>
+#include <cstdlib>
+#include <cstdio>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -15,9 +23,129 @@
 #include "Scene.cpp"
 #include "SceneObj.cpp"
 #include "Bezier.cpp"
+#include "Benchmark.cpp"
+#include "AssetPacker.cpp"
+#include "SceneCompiler.cpp"
+#include "VirtualFileSystem.cpp"
+#include "HotReload.cpp"
+#include "JobSystem.cpp"
+#include "Simulation.cpp"
+#include "Profiler.cpp"
+#include "InputRecording.cpp"
+#include "CameraPath.cpp"
+#include "FrameBenchmark.cpp"
+#include "AllocationTracker.cpp"
+#include "LinearArena.cpp"
 
 using namespace std;
 
+// Operadores globais de alocao: contam cada chamada no AllocationTracker (por thread, sem alocar) e repassam
+// para malloc/free. S podem ser definidos uma vez no programa, ento ficam aqui e no no AllocationTracker.
+void* operator new(size_t size) {
+    AllocationTracker::onAllocate(size);
+    if (void* pointer = std::malloc(size > 0 ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    AllocationTracker::onAllocate(size);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+// Verses com alinhamento acima do padro (usadas, por exemplo, pelo new_delete_resource dos contineres std::pmr)
+static void* allocateAligned(size_t size, std::align_val_t alignment) noexcept {
+    AllocationTracker::onAllocate(size);
+#ifdef _WIN32
+    return _aligned_malloc(size > 0 ? size : 1, (size_t)alignment);
+#else
+    void* pointer = nullptr;
+    return posix_memalign(&pointer, std::max((size_t)alignment, sizeof(void*)), size > 0 ? size : 1) == 0 ? pointer : nullptr;
+#endif
+}
+
+static void freeAligned(void* pointer) noexcept {
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (void* pointer = allocateAligned(size, alignment))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    freeAligned(pointer);
+}
+
 // Dimenses da janela
 const GLuint WIDTH = 1000, HEIGHT = 1000;
 
@@ -28,9 +156,17 @@ int translateDirection = 0;
 // Varivel de controle de escala
 float scale = 0.0;
 
-// ID do objeto selecionado
-SceneObj* selectedObject = nullptr;
+// Identificador estvel do objeto selecionado (SceneObj::handle; -1 sem seleo)
+int selectedHandle = -1;
 Scene* gScene = nullptr;
+// Os callbacks s repassam a entrada: as variveis acima so usadas pelos passos da simulao
+Simulation* gSimulation = nullptr;
+
+// Objeto selecionado, procurado pelo identificador: ponteiros para os objetos da cena deixam de valer
+// quando a lista muda (ex.: recarga do Scene.json)
+SceneObj* getSelectedObject() {
+    return gScene != nullptr && selectedHandle >= 0 ? gScene->findObject(selectedHandle) : nullptr;
+}
 
 // Reseta variveis de controle de escala
 void resetScaleVariable() {
@@ -58,16 +194,17 @@ void adjustScale(int key) {
 
 // Ajusta a rotao com base na tecla pressionada
 void adjustRotation(int key) {
+    SceneObj* selectedObject = getSelectedObject();
     if (selectedObject != nullptr) {
         switch (key) {
         case GLFW_KEY_X:
-            selectedObject->rotate = "x";
+            selectedObject->rotate = 'x';
             break;
         case GLFW_KEY_Y:
-            selectedObject->rotate = "y";
+            selectedObject->rotate = 'y';
             break;
         case GLFW_KEY_Z:
-            selectedObject->rotate = "z";
+            selectedObject->rotate = 'z';
             break;
         default:
             break;
@@ -77,6 +214,7 @@ void adjustRotation(int key) {
 
 // Alterna a reproduo da curva com base na tecla pressionada
 void adjustPlayCurve(int key) {
+    SceneObj* selectedObject = getSelectedObject();
     if (key == GLFW_KEY_P && selectedObject != nullptr) {
         selectedObject->playCurve = !selectedObject->playCurve;
     }
@@ -116,16 +254,17 @@ void adjustTranslation(int key) {
 
 // Seleciona o objeto com base no ID
 void setSelectedObject(int id) {
+    SceneObj* selectedObject = getSelectedObject();
     if (selectedObject != nullptr) {
-        selectedObject->rotate = "";
+        selectedObject->rotate = 0;
     }
     if (id < 0) {
-        selectedObject = nullptr;
+        selectedHandle = -1;
     }
     else {
         for (auto& obj : gScene->sceneObject) {
             if (obj.transfObjectId == id) {
-                selectedObject = &obj;
+                selectedHandle = obj.handle;
                 break;
             }
         }
@@ -152,11 +291,8 @@ void selectObjectByKey(int key) {
     }
 }
 
-// Funo callback acionada quando h interao com o teclado
-void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mode) {
-    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, GL_TRUE);
-    }
+// Aplica uma tecla (no passo da simulao)
+void handleKey(int key, int action) {
     if (action == GLFW_PRESS) {
         adjustScale(key);
         adjustRotation(key);
@@ -164,31 +300,196 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mode
         selectObjectByKey(key);
     }
     adjustTranslation(key);
-    if (gScene != nullptr) {
-        gScene->camera.moveCamera(key);
+    gScene->camera.moveCamera(key);
+}
+
+// Aplica um evento de entrada (no passo da simulao)
+void handleInput(const InputEvent& event) {
+    switch (event.type) {
+    case InputEvent::keyEvent:
+        handleKey(event.key, event.action);
+        break;
+    case InputEvent::cursorEvent:
+        gScene->camera.updateCameraDirection(event.x, event.y);
+        break;
+    case InputEvent::scrollEvent:
+        gScene->camera.scrollCamera(event.y);
+        break;
+    }
+}
+
+// Um passo da simulao: entrada, gravitao, rbitas, animao, curvas, matrizes de modelo e partculas
+void simulateStep(Scene& scene, const vector<InputEvent>& input, double time) {
+    resetTranslationVariables();
+    for (const auto& event : input) {
+        handleInput(event);
+    }
+
+    scene.stepGravity(1.0f / scene.getSimulationSettings().stepsPerSecond);
+    scene.updateOrbits(time);
+
+    // Cada tarefa s mexe nos seus objetos
+    SceneObj* selectedObject = getSelectedObject();
+    int selectedId = selectedObject != nullptr ? selectedObject->transfObjectId : -1;
+    JobSystem::current->parallelFor((int)scene.sceneObject.size(), 256, [&](int begin, int end) {
+        PROFILE_ZONE("simulateStep (objetos)");
+        for (int i = begin; i < end; ++i)
+        {
+            switch (scene.sceneObject[i].rotate) {
+            case 'x':
+                scene.sceneObject[i].rotateX(time);
+                break;
+            case 'y':
+                scene.sceneObject[i].rotateY(time);
+                break;
+            case 'z':
+                scene.sceneObject[i].rotateZ(time);
+                break;
+            }
+
+            if (selectedId >= 0 && selectedId == scene.sceneObject[i].transfObjectId) {
+
+                if (!scene.sceneObject[i].playCurve || scene.sceneObject[i].nbCurve <= 0) {
+                    if (translateX)
+                        scene.sceneObject[i].translateX(translateDirection);
+                    else if (translateY)
+                        scene.sceneObject[i].translateY(translateDirection);
+                    else if (translateZ)
+                        scene.sceneObject[i].translateZ(translateDirection);
+                }
+
+                scene.sceneObject[i].updateScale(scale);
+            }
+
+            if (scene.sceneObject[i].playCurve && scene.sceneObject[i].nbCurve > 0) {
+                glm::vec3 curvePosition = scene.sceneObject[i].curveBezier.getPointOnCurve(scene.sceneObject[i].iPoint);
+                scene.sceneObject[i].updatePosition(curvePosition);
+                scene.sceneObject[i].iPoint = (scene.sceneObject[i].iPoint + 1) % scene.sceneObject[i].nbCurve;
+            }
+
+            scene.sceneObject[i].updateModelMatrix();
+        }
+    });
+
+    scene.updateParticles(1.0f / scene.getSimulationSettings().stepsPerSecond);
+    resetScaleVariable();
+}
+
+// Funo callback acionada quando h interao com o teclado
+void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mode) {
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
+        glfwSetWindowShouldClose(window, GL_TRUE);
+    }
+    // F9 liga e desliga o perfil dos quadros
+    if (key == GLFW_KEY_F9 && action == GLFW_PRESS) {
+        Profiler::setEnabled(!Profiler::isEnabled());
+        cout << "Perfil " << (Profiler::isEnabled() ? "ligado" : "desligado") << endl;
+    }
+    if (gSimulation != nullptr) {
+        gSimulation->pushInput({ InputEvent::keyEvent, key, action });
     }
 }
 
 // Funo callback acionada quando h interao com o mouse
 void mouseCallback(GLFWwindow* window, double xpos, double ypos) {
-    if (gScene != nullptr) {
-        gScene->camera.updateCameraDirection(xpos, ypos);
+    if (gSimulation != nullptr) {
+        gSimulation->pushInput({ InputEvent::cursorEvent, 0, 0, xpos, ypos });
     }
 }
 
 // Funo callback acionada quando h interao com a rolagem do mouse
 void scrollCallback(GLFWwindow* window, double xpos, double ypos) {
-    if (gScene != nullptr) {
-        gScene->camera.scrollCamera(ypos);
+    if (gSimulation != nullptr) {
+        gSimulation->pushInput({ InputEvent::scrollEvent, 0, 0, xpos, ypos });
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // Modo de benchmark pela linha de comando (no abre janela)
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        return Benchmark::run(argc - 2, argv + 2);
+    }
+    // Empacotador de assets pela linha de comando
+    if (argc > 1 && string(argv[1]) == "--pack") {
+        return AssetPacker::run(argc - 2, argv + 2);
+    }
+    // Compilao do Scene.json para o formato binrio lido pela Scene
+    if (argc > 1 && string(argv[1]) == "--compile-scene") {
+        return SceneCompiler::run(argc - 2, argv + 2);
+    }
+
+    // Opes da execuo com janela (podem ser combinadas):
+    //   --scene cena.json: outra cena no lugar do Scene.json (ex.: SceneStress.json, com os cintures, as luzes e as
+    //     partculas em quantidades de teste de carga)
+    //   --profile [trao.json] [quadros]: perfil desde a carga da cena; o trao cobre a carga e os primeiros quadros
+    //   --record [entrada.txt]: grava a entrada de cada passo da simulao
+    //   --replay entrada.txt: usa a entrada gravada em vez do teclado e do mouse
+    //   --benchmark [quadros] [quadros.csv]: sem vsync, um passo por quadro e a cmera dando uma volta pela cena;
+    //     mede os quadros e fecha no fim
+    //   --zero-alloc: o benchmark (com as opes padro, se --benchmark no foi dado) termina com cdigo 1 se
+    //     algum quadro depois do aquecimento alocou memria do heap
+    string scenePath = "Scene.json", tracePath, recordPath, replayPath, benchmarkPath;
+    int traceFrames = 0, benchmarkFrames = 0;
+    bool zeroAlloc = false;
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        auto next = [&](const string& fallback) {
+            return i + 1 < argc && string(argv[i + 1]).rfind("--", 0) != 0 ? string(argv[++i]) : fallback;
+        };
+        if (option == "--scene") {
+            scenePath = next(scenePath);
+        }
+        else if (option == "--profile") {
+            tracePath = next("GrauB_trace.json");
+            traceFrames = std::max(1, atoi(next("300").c_str()));
+            Profiler::setEnabled(true);
+            Profiler::startCapture();
+        }
+        else if (option == "--record") {
+            recordPath = next("GrauB_input.txt");
+        }
+        else if (option == "--replay") {
+            replayPath = next("GrauB_input.txt");
+        }
+        else if (option == "--benchmark") {
+            benchmarkFrames = std::max(1, atoi(next("1200").c_str()));
+            benchmarkPath = next("benchmark_frames.csv");
+        }
+        else if (option == "--zero-alloc") {
+            zeroAlloc = true;
+        }
+        else {
+            std::cerr << "Opo desconhecida: " << option << std::endl;
+            return -1;
+        }
+    }
+    if (zeroAlloc && benchmarkFrames == 0) {
+        benchmarkFrames = 1200;
+        benchmarkPath = "benchmark_frames.csv";
+    }
+    InputRecording recording, replay;
+    if (!replayPath.empty() && !replay.load(replayPath)) {
+        return -1;
+    }
+    Profiler::setThreadName("Main");
+    AllocationTracker::markFrameThread();
+
+    // Com um pacote de assets na pasta, a cena, os shaders, as malhas e as texturas so lidos dele
+    if (std::filesystem::exists("Assets.pak") && VirtualFileSystem::mount("Assets.pak")) {
+        cout << "Pacote de assets montado: Assets.pak (" << VirtualFileSystem::getNumPackedFiles() << " arquivos)" << endl;
+    }
+
+    // Tarefas em paralelo (carga da cena e atualizao dos objetos a cada passo), com uma thread por ncleo
+    // e uma fila a mais para a thread da simulao
+    JobSystem jobSystem(0, 1);
+    JobSystem::current = &jobSystem;
+
     // Inicializao da GLFW
     glfwInit();
 
     // Criao da janela GLFW
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Grau B - Gustavo, Arthur e Rafael", nullptr, nullptr);
+    const string windowTitle = "Grau B - Gustavo, Arthur e Rafael";
+    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, windowTitle.c_str(), nullptr, nullptr);
     glfwMakeContextCurrent(window);
 
     // Registro das funes de callback para a janela GLFW
@@ -215,27 +516,123 @@ int main() {
     glViewport(0, 0, width, height);
 
     // Compilando e buildando o programa de shader
-    Shader shader("VShader.vs", "FShader.fs");
+    VirtualFile vertexFile("VShader.vs"), fragmentFile("FShader.fs");
+    Shader shader = Shader::fromSource(vertexFile.toString(), fragmentFile.toString());
     glUseProgram(shader.ID);
+    // Texturas 2D na unidade 0 e texturas de array na unidade 1
+    shader.setInt("tex_buffer", 0);
+    shader.setInt("tex_array", 1);
 
-    Scene scene("Scene.json", &shader, width, height);
+    auto loadStart = std::chrono::steady_clock::now();
+    Scene scene(scenePath, &shader, width, height);
     gScene = &scene;
+    glFinish();
+    cout << "Cena carregada em " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count()
+        << " ms (" << MappedFile::filesOpened << " arquivos abertos); texturas ocupam " << TextureLoader::textureMemory / (1024.0 * 1024.0) << " MB de VRAM" << endl;
+    if (TextureResidency::current != nullptr)
+        cout << "Residncia de texturas: " << TextureResidency::current->getResidentBytes() / (1024.0 * 1024.0) << " de "
+            << TextureResidency::current->getBudget() / (1024.0 * 1024.0) << " MB carregados" << endl;
 
     // Configurao da iluminao
-    shader.setVec3("light_pos", scene.lightPositionX, scene.lightPositionY, scene.lightPositionZ);
-    shader.setVec3("light_color", scene.lightColorR, scene.lightColorG, scene.lightColorB);
+    scene.applyLight();
+
+    // Recarga automtica dos arquivos da cena e dos shaders; com um pacote montado os arquivos soltos no so usados
+    // (nem no benchmark, que precisa da mesma cena do incio ao fim)
+    unique_ptr<HotReload> hotReload;
+    if (scene.getHotReloadSettings().enabled && benchmarkFrames > 0) {
+        cout << "Recarga automtica desligada durante o benchmark" << endl;
+    }
+    else if (scene.getHotReloadSettings().enabled && VirtualFileSystem::getNumPackedFiles() > 0) {
+        cout << "Recarga automtica desligada: os arquivos vm do pacote de assets" << endl;
+    }
+    else if (scene.getHotReloadSettings().enabled) {
+        // Um programa de shader novo no tem os uniforms do anterior
+        hotReload = make_unique<HotReload>(scene, shader, scenePath, "VShader.vs", "FShader.fs", [&]() {
+            shader.setInt("tex_buffer", 0);
+            shader.setInt("tex_array", 1);
+            scene.applyLight();
+            scene.camera.updateProjection();
+        });
+        cout << "Recarga automtica ligada" << endl;
+    }
 
     glEnable(GL_DEPTH_TEST);
 
+    // Simulao em passos fixos; o lao abaixo s desenha a ltima cpia completa da cena. No benchmark ela anda
+    // um passo por quadro na thread principal, ento a sequncia de estados desenhados  sempre a mesma.
+    SceneSimulationAux simulationSettings = scene.getSimulationSettings();
+    unique_ptr<FrameBenchmark> benchmark;
+    unique_ptr<CameraPath> cameraPath;
+    if (benchmarkFrames > 0) {
+        simulationSettings.enabled = false;
+        benchmark = make_unique<FrameBenchmark>(benchmarkFrames);
+        glfwSwapInterval(0);
+    }
+    Simulation simulation(scene, simulationSettings, [&](const vector<InputEvent>& input, double time) {
+        simulateStep(scene, input, time);
+        if (cameraPath)
+            cameraPath->apply(scene.camera, time);
+    });
+    gSimulation = &simulation;
+    if (!recordPath.empty())
+        simulation.setRecording(&recording);
+    if (!replayPath.empty()) {
+        simulation.setReplay(&replay);
+        cout << "Reproduzindo " << replay.size() << " eventos de " << replayPath << " (at o passo " << replay.getLastStep() << ")" << endl;
+    }
+    else if (benchmarkFrames > 0) {
+        // Sem gravao, o benchmark ignora o teclado e o mouse (a reproduo de uma entrada vazia)
+        simulation.setReplay(&replay);
+    }
+    simulation.start();
+    if (benchmark) {
+        // Uma volta completa da cmera nos quadros medidos, em torno das posies iniciais dos objetos
+        cameraPath = make_unique<CameraPath>(simulation.acquire(), benchmark->getTotalFrames() / simulationSettings.stepsPerSecond);
+        cout << "Benchmark: " << benchmarkFrames << " quadros" << endl;
+    }
+    cout << "Simulao a " << simulationSettings.stepsPerSecond << " passos/s "
+        << (simulation.isThreaded() ? "numa thread prpria" : "na thread principal") << endl;
+    bool replayReported = false;
+
+    // Tempos das duas threads, mostrados no ttulo da janela a cada meio segundo e no fim
+    auto reportStart = std::chrono::steady_clock::now();
+    uint64_t reportSteps = 0, totalFrames = 0, reportFrames = 0;
+    double reportStepMs = 0, totalFrameMs = 0, reportFrameMs = 0;
+    // Alocaes do heap das threads do quadro (principal, simulao e JobSystem) at o fim do quadro anterior
+    uint64_t allocations = 0, allocatedBytes = 0, reportAllocations = 0;
+    AllocationTracker::getFrameTotals(allocations, allocatedBytes);
+    int exitCode = 0;
+
+    // Resumo do perfil a cada 5 s enquanto ele estiver ligado
+    auto profileStart = std::chrono::steady_clock::now();
+    int frameNumber = 0;
 
     // Loop da aplicao
     while (!glfwWindowShouldClose(window))
     {
-        resetTranslationVariables();
+        auto frameStart = std::chrono::steady_clock::now();
+        uint64_t profileFrameStart = Profiler::isEnabled() ? Profiler::now() : 0;
 
-        // Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funes de callback correspondentes
+        // Checa se houveram eventos de input (key pressed, mouse moved etc.) e repassa  simulao
         glfwPollEvents();
 
+        // Aplica os arquivos alterados com a simulao parada; se a lista de objetos mudou, a cpia antiga no serve mais
+        if (hotReload) {
+            auto lock = simulation.lockScene();
+            if (hotReload->update())
+                simulation.publish();
+        }
+
+        if (benchmark)
+            simulation.stepOnce();
+        else
+            simulation.update();
+        const SceneSnapshot& snapshot = simulation.acquire();
+        if (!replayPath.empty() && simulation.isReplayFinished() && !replayReported) {
+            cout << "Reproduo da entrada terminada no passo " << snapshot.step << endl;
+            replayReported = true;
+        }
+
         // Limpa o buffer de cor
         glClearColor(0.1f, 0.1f, 0.1f, 0.1f); //cor de fundo
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -243,64 +640,129 @@ int main() {
         glLineWidth(10);
         glPointSize(20);
 
-        if (gScene != nullptr)
-            gScene->camera.updateCamera();
-
-        for (int i = 0; i < scene.sceneObject.size(); ++i)
-        {
-            // Iluminao: Coeficiente de material para a luz ambiente
-            shader.setFloat("ka", scene.sceneObject[i].sceneObjInfo.ka);
-            // Iluminao: Coeficiente de material para a luz difusa
-            shader.setFloat("kd", scene.sceneObject[i].sceneObjInfo.kd);
-            // Iluminao: Coeficiente de material para a luz especular
-            shader.setFloat("ks", scene.sceneObject[i].sceneObjInfo.ks);
-            // Iluminao: Expoente de brilho do material
-            shader.setFloat("q", scene.sceneObject[i].sceneObjInfo.ns);
-
-            if (scene.sceneObject[i].rotate == "x")
-                scene.sceneObject[i].rotateX();
-            else if (scene.sceneObject[i].rotate == "y")
-                scene.sceneObject[i].rotateY();
-            else if (scene.sceneObject[i].rotate == "z")
-                scene.sceneObject[i].rotateZ();
-
-            if (selectedObject != nullptr && selectedObject->transfObjectId >= 0 && selectedObject->transfObjectId == scene.sceneObject[i].transfObjectId) {
+        // Envia a parte da vez das texturas e vrtices que ainda esto chegando
+        if (UploadManager::current != nullptr) {
+            PROFILE_ZONE("UploadManager::update");
+            PROFILE_GPU_ZONE("UploadManager::update");
+            UploadManager::current->update();
+        }
+        scene.updateTextureResidency(snapshot);
 
-                if (!scene.sceneObject[i].playCurve || scene.sceneObject[i].nbCurve <= 0) {
-                    if (translateX)
-                        scene.sceneObject[i].translateX(translateDirection);
-                    else if (translateY)
-                        scene.sceneObject[i].translateY(translateDirection);
-                    else if (translateZ)
-                        scene.sceneObject[i].translateZ(translateDirection);
-                }
+        // Os coeficientes de material (ka, kd, ks, q) e a textura so enviados por sub-malha em renderObject
+        SceneObj::beginFrame();
 
-                scene.sceneObject[i].updateScale(scale);
-            }
+        // Sombra da luz principal antes da cena (o ShadowMap mede as suas partes nas prprias zonas de GPU)
+        scene.renderShadows(snapshot);
 
-            if (scene.sceneObject[i].playCurve && scene.sceneObject[i].nbCurve > 0) {
-                glm::vec3 curvePosition = scene.sceneObject[i].curveBezier.getPointOnCurve(scene.sceneObject[i].iPoint);
-                scene.sceneObject[i].updatePosition(curvePosition);
-                scene.sceneObject[i].iPoint = (scene.sceneObject[i].iPoint + 1) % scene.sceneObject[i].nbCurve;
-            }
+        // Cmera e objetos como estavam no ltimo passo completo da simulao
+        {
+            PROFILE_GPU_ZONE("Scene::render");
+            scene.render(snapshot);
+        }
 
-            scene.sceneObject[i].updateModelMatrix();
-            scene.sceneObject[i].renderObject();
+        double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        totalFrameMs += frameMs;
+        totalFrames++;
+        double reportSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - reportStart).count();
+        if (reportSeconds >= 0.5) {
+            uint64_t steps = simulation.getNumSteps() - reportSteps;
+            double stepMs = simulation.getStepMs() - reportStepMs;
+            uint64_t frames = totalFrames - reportFrames;
+            double framesMs = totalFrameMs - reportFrameMs;
+            // Num buffer fixo: o ttulo  montado em todo meio segundo e no deve alocar
+            char title[256];
+            std::snprintf(title, sizeof(title), "%s | simulacao: %.2f passos/s, %.2f ms/passo | desenho: %.2f quadros/s, %.2f ms/quadro | %.1f alocacoes/quadro",
+                windowTitle.c_str(), steps / reportSeconds, steps > 0 ? stepMs / steps : 0.0, frames / reportSeconds, frames > 0 ? framesMs / frames : 0.0,
+                frames > 0 ? (double)(allocations - reportAllocations) / frames : 0.0);
+            glfwSetWindowTitle(window, title);
+            reportStart = std::chrono::steady_clock::now();
+            reportSteps += steps;
+            reportStepMs += stepMs;
+            reportFrames = totalFrames;
+            reportFrameMs = totalFrameMs;
+            reportAllocations = allocations;
         }
 
-        resetScaleVariable();
+        // Os dados temporrios do quadro so descartados de uma vez
+        LinearArena::frame().reset();
+
+        if (profileFrameStart != 0)
+            Profiler::record("frame", profileFrameStart, Profiler::now());
+        Profiler::endFrame();
+        Profiler::collect();
+        if (Profiler::isCapturing() && ++frameNumber >= traceFrames)
+            Profiler::writeTrace(tracePath);
+        if (std::chrono::steady_clock::now() - profileStart >= std::chrono::seconds(5)) {
+            if (Profiler::isEnabled())
+                Profiler::printSummary(cout);
+            profileStart = std::chrono::steady_clock::now();
+        }
 
         // Troca os buffers da tela
         glfwSwapBuffers(window);
+
+        uint64_t frameAllocations = allocations, frameBytes = allocatedBytes;
+        AllocationTracker::getFrameTotals(allocations, allocatedBytes);
+        frameAllocations = allocations - frameAllocations;
+        frameBytes = allocatedBytes - frameBytes;
+
+        if (benchmark) {
+            benchmark->endFrame(SceneObj::drawCalls, SceneObj::triangles, frameAllocations, frameBytes);
+            if (benchmark->isFinished()) {
+                benchmark->report(cout, benchmarkPath, simulation.getStepMs() / std::max<uint64_t>(1, simulation.getNumSteps()),
+                    FrameBenchmark::checksum(snapshot));
+                if (zeroAlloc && benchmark->getAllocatingFrames() > 0) {
+                    std::cerr << "Falha: " << benchmark->getAllocatingFrames() << " quadros alocaram depois do aquecimento"
+                        << " (--profile mostra as alocaes por zona)" << std::endl;
+                    exitCode = 1;
+                }
+                auto lock = simulation.lockScene();
+                cout << "  cmera: fov " << glm::degrees(scene.camera.getFov()) << " graus, planos de " << scene.camera.getNearPlane()
+                    << " a " << scene.camera.getFarPlane() << endl;
+                if (!scene.cameraMatchesSettings()) {
+                    std::cerr << "Falha: a cmera no usa o fov e os planos de " << scenePath << std::endl;
+                    exitCode = 1;
+                }
+                glfwSetWindowShouldClose(window, GL_TRUE);
+            }
+        }
     }
-    // Pede pra OpenGL desalocar os buffers
-    for (int i = 0; i < scene.sceneObject.size(); ++i) {
-        glDeleteVertexArrays(1, &scene.sceneObject[i].sceneObjInfo.VAO);
+    simulation.stop();
+    gSimulation = nullptr;
+    if (!recordPath.empty() && recording.save(recordPath)) {
+        cout << "Entrada gravada em " << recordPath << " (" << recording.size() << " eventos)" << endl;
     }
+    cout << "Simulao: " << simulation.getNumSteps() << " passos, " << (simulation.getNumSteps() > 0 ? simulation.getStepMs() / simulation.getNumSteps() : 0.0)
+        << " ms por passo; desenho: " << totalFrames << " quadros, " << (totalFrames > 0 ? totalFrameMs / totalFrames : 0.0)
+        << " ms por quadro (sem esperar a troca dos buffers)" << endl;
+    cout << "Memria: pico residente de " << AllocationTracker::getPeakResidentBytes() / (1024.0 * 1024.0) << " MB; arena do quadro: pico de "
+        << LinearArena::frame().getPeak() << " bytes em " << LinearArena::frame().getCapacity() << " reservados" << endl;
+    hotReload.reset();
+    Profiler::collect();
+    if (Profiler::isCapturing())
+        Profiler::writeTrace(tracePath);
+    if (Profiler::isEnabled())
+        Profiler::printSummary(cout);
+    Profiler::releaseGpu();
+
+    // Pede pra OpenGL desalocar os buffers (cada malha  apagada junto com o ltimo objeto que a usa)
+    scene.sceneObject.clear();
+    for (auto& batch : scene.instancedBatches) {
+        batch.release();
+    }
+    scene.textureResidency.reset();
+    scene.uploadManager.reset();
+    scene.bodyRenderer.reset();
+    scene.particleRenderer.reset();
+    scene.impostorRenderer.reset();
+    scene.pointLights.reset();
+    scene.shadowMap.reset();
+
+    VirtualFileSystem::unmount();
 
     // Finaliza a execuo da GLFW, limpando os recursos alocados por ela
     glfwTerminate();
-    return 0;
+    return exitCode;
 }
 
 
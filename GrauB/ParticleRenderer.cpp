@@ -0,0 +1,161 @@
+#pragma once
+#include <vector>
+#include <cstring>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "../Common/include/Shader.h"
+#include "SceneSnapshot.cpp"
+#include "SceneObj.cpp"
+#include "Profiler.cpp"
+
+using namespace std;
+
+// Desenha as partculas da cpia como quadrados voltados para a cmera, uma chamada instanciada por emissor, com
+// mistura aditiva e sem escrever profundidade. Os dados das instncias vo para um buffer dividido em trs trechos,
+// usados em rodzio: cada quadro mapeia o seu trecho sem sincronizar (a OpenGL 3.3 no tem mapeamento persistente)
+// e s espera a fence dele, posta trs quadros antes, se a GPU ainda no terminou de desenh-lo.
+class ParticleRenderer
+{
+public:
+	static const int numRegions = 3;
+
+	ParticleRenderer() : shader(Shader::fromSource(vertexSource, fragmentSource))
+	{
+		const GLfloat corners[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &cornerVBO);
+		glGenBuffers(1, &instanceVBO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, cornerVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)0);
+		glEnableVertexAttribArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		glEnableVertexAttribArray(1);
+		glVertexAttribDivisor(1, 1);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	~ParticleRenderer()
+	{
+		for (GLsync fence : fences)
+			if (fence != 0)
+				glDeleteSync(fence);
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &cornerVBO);
+		glDeleteBuffers(1, &instanceVBO);
+		glDeleteProgram(shader.ID);
+	}
+
+	ParticleRenderer(const ParticleRenderer&) = delete;
+	ParticleRenderer& operator=(const ParticleRenderer&) = delete;
+
+	// Usa a cmera da cpia; o programa de shader da cena precisa ser religado depois (o chamador faz isso)
+	void render(const SceneSnapshot& snapshot)
+	{
+		PROFILE_ZONE("ParticleRenderer::render");
+		if (snapshot.particles.empty())
+			return;
+		size_t bytes = snapshot.particles.size() * sizeof(glm::vec4);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		if (bytes > regionSize)
+			resize(bytes);
+
+		// O trecho deste quadro foi desenhado trs quadros atrs; quase sempre a fence j passou
+		if (fences[region] != 0) {
+			glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			glDeleteSync(fences[region]);
+			fences[region] = 0;
+		}
+		size_t offset = region * regionSize;
+		void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+		if (mapped == nullptr) {
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			return;
+		}
+		memcpy(mapped, snapshot.particles.data(), bytes);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+
+		shader.Use();
+		glm::mat4 view = snapshot.view, projection = snapshot.projection;
+		shader.setMat4("view", glm::value_ptr(view));
+		shader.setMat4("projection", glm::value_ptr(projection));
+		glBindVertexArray(VAO);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+		glDepthMask(GL_FALSE);
+		for (const auto& batch : snapshot.particleBatches) {
+			if (batch.count == 0)
+				continue;
+			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (GLvoid*)(offset + batch.first * sizeof(glm::vec4)));
+			shader.setVec3("particle_color", batch.color.r, batch.color.g, batch.color.b);
+			shader.setFloat("particle_size", batch.size);
+			SceneObj::countDraw(GL_TRIANGLE_STRIP, 4, batch.count);
+			glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, batch.count);
+		}
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		region = (region + 1) % numRegions;
+	}
+
+private:
+	Shader shader;
+	GLuint VAO = 0, cornerVBO = 0, instanceVBO = 0;
+	size_t regionSize = 0;
+	int region = 0;
+	GLsync fences[numRegions] = {};
+
+	// Recria o buffer (com o buffer ligado) com trechos de pelo menos bytes, dobrando o tamanho para no repetir isso
+	// a cada quadro em que as partculas aumentam; o buffer antigo s  liberado pela OpenGL depois dos desenhos dele
+	void resize(size_t bytes)
+	{
+		for (GLsync& fence : fences)
+			if (fence != 0) {
+				glDeleteSync(fence);
+				fence = 0;
+			}
+		regionSize = std::max(bytes, regionSize * 2);
+		glBufferData(GL_ARRAY_BUFFER, regionSize * numRegions, nullptr, GL_STREAM_DRAW);
+		region = 0;
+	}
+
+	inline static const char* vertexSource = R"(#version 330 core
+layout (location = 0) in vec2 corner;
+layout (location = 1) in vec4 particle;
+uniform mat4 view;
+uniform mat4 projection;
+uniform float particle_size;
+out vec2 offset;
+out float fade;
+void main()
+{
+	// O quadrado fica no plano da cmera: o deslocamento  somado j no espao da viso
+	vec4 eye = view * vec4(particle.xyz, 1.0);
+	eye.xy += corner * particle.w;
+	gl_Position = projection * eye;
+	offset = corner;
+	fade = particle_size > 0.0 ? particle.w / particle_size : 0.0;
+}
+)";
+
+	inline static const char* fragmentSource = R"(#version 330 core
+in vec2 offset;
+in float fade;
+out vec4 color;
+uniform vec3 particle_color;
+void main()
+{
+	// Mancha suave: some na borda e com a idade
+	float distance2 = dot(offset, offset);
+	if (distance2 > 1.0)
+		discard;
+	color = vec4(particle_color, (1.0 - distance2) * fade);
+}
+)";
+};
\ No newline at end of file
@@ -0,0 +1,245 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "JobSystem.cpp"
+#include "Profiler.cpp"
+#include "SceneSnapshot.cpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GRAUB_SSE
+#endif
+
+using namespace std;
+
+// Um emissor e as suas partculas, em SoA com capacidade fixa (nenhuma alocao depois de criado). As partculas
+// nascem na superfcie de uma esfera de raio radius em torno da posio e saem na direo dada (ou para fora da
+// esfera, se ela  zero), espalhadas por spread, com velocidade speed; duram cerca de life segundos e perdem
+// velocidade com drag (frao por segundo).
+class ParticleEmitter
+{
+public:
+	int maxParticles;
+	float rate, life, speed, spread, radius, size, drag;
+	glm::vec3 color;
+	// Atualizados pela cena a cada passo
+	glm::vec3 position = glm::vec3(0), direction = glm::vec3(0);
+
+	ParticleEmitter(int maxParticles, float rate, float life, float speed, float spread, float radius, float size, float drag,
+		glm::vec3 color, uint32_t seed)
+		: maxParticles(std::max(maxParticles, 0)), rate(std::max(rate, 0.0f)), life(std::max(life, 0.001f)), speed(speed),
+		spread(spread), radius(radius), size(size), drag(std::max(drag, 0.0f)), color(color), random(seed)
+	{
+		for (auto* values : { &x, &y, &z, &vx, &vy, &vz, &age, &lifetime })
+			values->resize(this->maxParticles);
+	}
+
+	int getCount() const {
+		return count;
+	}
+
+	// Cria as partculas de dt segundos (a frao que sobra passa para o prximo passo); para quando o emissor enche
+	void emit(float dt) {
+		pending += rate * dt;
+		int spawn = std::min((int)pending, maxParticles - count);
+		pending -= (float)(int)pending;
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f), variation(0.75f, 1.25f);
+		glm::vec3 axis = glm::length(direction) > 0.0f ? glm::normalize(direction) : glm::vec3(0.0f);
+		for (int k = 0; k < spawn; ++k) {
+			glm::vec3 normal = randomDirection(unit);
+			glm::vec3 velocity = (axis == glm::vec3(0.0f) ? normal : axis) + spread * randomDirection(unit);
+			velocity = glm::length(velocity) > 0.0f ? glm::normalize(velocity) * speed * variation(random) : glm::vec3(0.0f);
+			int i = count++;
+			x[i] = position.x + normal.x * radius;
+			y[i] = position.y + normal.y * radius;
+			z[i] = position.z + normal.z * radius;
+			vx[i] = velocity.x;
+			vy[i] = velocity.y;
+			vz[i] = velocity.z;
+			age[i] = 0.0f;
+			lifetime[i] = life * variation(random);
+		}
+	}
+
+	// Integra, envelhece e remove as mortas de [begin, end), juntando as vivas no incio do trecho (na mesma
+	// ordem); retorna quantas ficaram. Trechos diferentes podem ser atualizados ao mesmo tempo.
+	int update(float dt, int begin, int end) {
+		float damping = std::max(0.0f, 1.0f - drag * dt);
+		int alive = begin, i = begin;
+#ifdef GRAUB_SSE
+		__m128 step = _mm_set1_ps(dt), factor = _mm_set1_ps(damping);
+		alignas(16) float lanes[8][4];
+		for (; i + 4 <= end; i += 4) {
+			__m128 velocityX = _mm_mul_ps(_mm_loadu_ps(&vx[i]), factor);
+			__m128 velocityY = _mm_mul_ps(_mm_loadu_ps(&vy[i]), factor);
+			__m128 velocityZ = _mm_mul_ps(_mm_loadu_ps(&vz[i]), factor);
+			__m128 positionX = _mm_add_ps(_mm_loadu_ps(&x[i]), _mm_mul_ps(velocityX, step));
+			__m128 positionY = _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(velocityY, step));
+			__m128 positionZ = _mm_add_ps(_mm_loadu_ps(&z[i]), _mm_mul_ps(velocityZ, step));
+			__m128 older = _mm_add_ps(_mm_loadu_ps(&age[i]), step), lifetimes = _mm_loadu_ps(&lifetime[i]);
+			int mask = _mm_movemask_ps(_mm_cmplt_ps(older, lifetimes));
+			// Quatro vivas sem buraco antes delas: gravadas no lugar; seno s as vivas vo para alive, uma a uma
+			if (mask == 15 && alive == i) {
+				_mm_storeu_ps(&x[i], positionX);
+				_mm_storeu_ps(&y[i], positionY);
+				_mm_storeu_ps(&z[i], positionZ);
+				_mm_storeu_ps(&vx[i], velocityX);
+				_mm_storeu_ps(&vy[i], velocityY);
+				_mm_storeu_ps(&vz[i], velocityZ);
+				_mm_storeu_ps(&age[i], older);
+				alive += 4;
+				continue;
+			}
+			if (mask == 0)
+				continue;
+			_mm_store_ps(lanes[0], positionX);
+			_mm_store_ps(lanes[1], positionY);
+			_mm_store_ps(lanes[2], positionZ);
+			_mm_store_ps(lanes[3], velocityX);
+			_mm_store_ps(lanes[4], velocityY);
+			_mm_store_ps(lanes[5], velocityZ);
+			_mm_store_ps(lanes[6], older);
+			_mm_store_ps(lanes[7], lifetimes);
+			for (int k = 0; k < 4; ++k)
+				if (mask & (1 << k))
+					store(alive++, lanes[0][k], lanes[1][k], lanes[2][k], lanes[3][k], lanes[4][k], lanes[5][k], lanes[6][k], lanes[7][k]);
+		}
+#endif
+		for (; i < end; ++i) {
+			float older = age[i] + dt;
+			if (older >= lifetime[i])
+				continue;
+			float velocityX = vx[i] * damping, velocityY = vy[i] * damping, velocityZ = vz[i] * damping;
+			store(alive++, x[i] + velocityX * dt, y[i] + velocityY * dt, z[i] + velocityZ * dt, velocityX, velocityY, velocityZ, older, lifetime[i]);
+		}
+		return alive - begin;
+	}
+
+	// Junta os trechos [starts[c], starts[c] + alive[c]) no incio dos vetores, em ordem
+	void compact(const vector<int>& starts, const vector<int>& alive) {
+		int total = 0;
+		for (size_t c = 0; c < starts.size(); ++c) {
+			if (total != starts[c] && alive[c] > 0)
+				for (auto* values : { &x, &y, &z, &vx, &vy, &vz, &age, &lifetime })
+					memmove(values->data() + total, values->data() + starts[c], alive[c] * sizeof(float));
+			total += alive[c];
+		}
+		count = total;
+	}
+
+	// Posio e tamanho (reduzido conforme a idade) de [begin, end) em out
+	void write(glm::vec4* out, int begin, int end) const {
+		for (int i = begin; i < end; ++i)
+			out[i] = glm::vec4(x[i], y[i], z[i], size * (1.0f - age[i] / lifetime[i]));
+	}
+
+private:
+	vector<float> x, y, z, vx, vy, vz, age, lifetime;
+	int count = 0;
+	float pending = 0.0f;
+	std::mt19937 random;
+
+	void store(int i, float px, float py, float pz, float velocityX, float velocityY, float velocityZ, float older, float lifetimeValue) {
+		x[i] = px;
+		y[i] = py;
+		z[i] = pz;
+		vx[i] = velocityX;
+		vy[i] = velocityY;
+		vz[i] = velocityZ;
+		age[i] = older;
+		lifetime[i] = lifetimeValue;
+	}
+
+	// Direo uniforme na esfera (rejeio no cubo)
+	glm::vec3 randomDirection(std::uniform_real_distribution<float>& unit) {
+		for (;;) {
+			glm::vec3 candidate(unit(random), unit(random), unit(random));
+			float length2 = glm::dot(candidate, candidate);
+			if (length2 > 1e-6f && length2 <= 1.0f)
+				return candidate / std::sqrt(length2);
+		}
+	}
+};
+
+// Todos os emissores da cena. Um passo atualiza os trechos de chunkSize partculas de todos os emissores em paralelo
+// (cada trecho compacta as suas vivas), junta os trechos de cada emissor e s ento cria as novas partculas, em
+// srie, com o gerador de cada emissor: o resultado no depende do nmero de threads e se repete na reproduo.
+class ParticleSystem
+{
+public:
+	static const int chunkSize = 16384;
+
+	vector<ParticleEmitter> emitters;
+
+	void update(float dt, JobSystem& jobs) {
+		PROFILE_ZONE("ParticleSystem::update");
+		chunks.clear();
+		for (int e = 0; e < (int)emitters.size(); ++e)
+			for (int begin = 0; begin < emitters[e].getCount(); begin += chunkSize)
+				chunks.push_back({ e, begin, std::min(begin + chunkSize, emitters[e].getCount()), 0 });
+		jobs.parallelFor((int)chunks.size(), 1, [&](int begin, int end) {
+			for (int c = begin; c < end; ++c)
+				chunks[c].alive = emitters[chunks[c].emitter].update(dt, chunks[c].begin, chunks[c].end);
+		});
+
+		size_t c = 0;
+		for (int e = 0; e < (int)emitters.size(); ++e) {
+			starts.clear();
+			alive.clear();
+			for (; c < chunks.size() && chunks[c].emitter == e; ++c) {
+				starts.push_back(chunks[c].begin);
+				alive.push_back(chunks[c].alive);
+			}
+			emitters[e].compact(starts, alive);
+			emitters[e].emit(dt);
+		}
+	}
+
+	// Partculas de todos os emissores no formato do desenho, um lote por emissor
+	void write(vector<glm::vec4>& particles, vector<ParticleBatch>& batches, JobSystem& jobs) const {
+		PROFILE_ZONE("ParticleSystem::write");
+		// Reserva para o mximo dos emissores: cada snapshot aloca uma vez e no cresce com as partculas vivas
+		batches.clear();
+		batches.reserve(emitters.size());
+		particles.reserve(getMaxParticles());
+		int total = 0;
+		for (const auto& emitter : emitters) {
+			batches.push_back({ total, emitter.getCount(), emitter.color, emitter.size });
+			total += emitter.getCount();
+		}
+		particles.resize(total);
+		for (size_t e = 0; e < emitters.size(); ++e) {
+			glm::vec4* out = particles.data() + batches[e].first;
+			jobs.parallelFor(emitters[e].getCount(), chunkSize, [&](int begin, int end) {
+				emitters[e].write(out, begin, end);
+			});
+		}
+	}
+
+	size_t getMaxParticles() const {
+		size_t total = 0;
+		for (const auto& emitter : emitters)
+			total += emitter.maxParticles;
+		return total;
+	}
+
+	size_t getNumParticles() const {
+		size_t total = 0;
+		for (const auto& emitter : emitters)
+			total += emitter.getCount();
+		return total;
+	}
+
+private:
+	struct Chunk {
+		int emitter, begin, end, alive;
+	};
+
+	vector<Chunk> chunks;
+	vector<int> starts, alive;
+};
\ No newline at end of file
@@ -0,0 +1,274 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include "MeshLoader.cpp"
+#include "JobSystem.cpp"
+#include "Profiler.cpp"
+
+using namespace std;
+
+// Malhas geradas por frmula (esfera UV, icosfera, cubo, cilindro, toro e pirmide), indexadas e j no layout de
+// vrtices da engine, com qualquer tesselagem: um objeto do Scene.json usa uma delas pelo nome, sem ler arquivo.
+// Dentro da engine a primitiva  o caminho "primitive:tipo:tesselagem:arquivo.mtl", que ocupa o lugar do arquivo de
+// malha (o mesmo caminho  a mesma malha). Todas cabem na esfera de raio 1 (o cubo e a pirmide vo de -1 a 1).
+class Primitives
+{
+public:
+	inline static const string prefix = "primitive:";
+	// A partir de quantos vrtices a gerao  dividida em tarefas
+	static const int parallelVertices = 65536;
+
+	static bool isPrimitive(const string& path) {
+		return path.compare(0, prefix.size(), prefix) == 0;
+	}
+
+	// Esferas (as nicas que podem ser desenhadas como impostores)
+	static bool isSphere(const string& path) {
+		return path.compare(0, prefix.size() + 9, prefix + "uvsphere:") == 0 || path.compare(0, prefix.size() + 10, prefix + "icosphere:") == 0;
+	}
+
+	static string makePath(const string& type, int tessellation, const string& materialFileName) {
+		return prefix + type + ":" + std::to_string(std::max(tessellation, 1)) + ":" + materialFileName;
+	}
+
+	// Gera a primitiva do caminho; com jobs, as grandes so divididas entre as threads (a thread que chama precisa
+	// poder criar tarefas)
+	static bool generate(const string& path, vector<GLfloat>& vbuffer, vector<GLuint>& indices, string& materialFileName,
+		JobSystem* jobs = nullptr) {
+		PROFILE_ZONE("Primitives::generate");
+		size_t typeEnd = path.find(':', prefix.size());
+		size_t tessellationEnd = typeEnd == string::npos ? string::npos : path.find(':', typeEnd + 1);
+		if (!isPrimitive(path) || tessellationEnd == string::npos) {
+			std::cerr << "Caminho de primitiva invlido: " << path << std::endl;
+			return false;
+		}
+		string type = path.substr(prefix.size(), typeEnd - prefix.size());
+		int tessellation = std::max(1, atoi(path.substr(typeEnd + 1, tessellationEnd - typeEnd - 1).c_str()));
+		materialFileName = path.substr(tessellationEnd + 1);
+
+		vbuffer.clear();
+		indices.clear();
+		if (type == "uvsphere")
+			generateUVSphere(std::max(tessellation, 3), std::max(tessellation / 2, 2), vbuffer, indices, jobs);
+		else if (type == "icosphere")
+			generateIcosphere(tessellation, vbuffer, indices, jobs);
+		else if (type == "cube")
+			generateCube(tessellation, vbuffer, indices, jobs);
+		else if (type == "cylinder")
+			generateCylinder(std::max(tessellation, 3), vbuffer, indices, jobs);
+		else if (type == "torus")
+			generateTorus(std::max(tessellation, 3), std::max(tessellation / 2, 3), vbuffer, indices, jobs);
+		else if (type == "pyramid")
+			generatePyramid(vbuffer, indices);
+		else {
+			std::cerr << "Primitiva desconhecida: " << type << " (tipos: uvsphere, icosphere, cube, cylinder, torus, pyramid)" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+private:
+	static const int stride = MeshLoader::stride;
+
+	// Posio, cor (a mesma dos arquivos OBJ), coordenada de textura e normal
+	static void setVertex(GLfloat* out, const glm::vec3& position, const glm::vec2& uv, const glm::vec3& normal) {
+		const GLfloat vertex[stride] = { position.x, position.y, position.z, 1.0f, 0.0f, 1.0f, uv.s, uv.t, normal.x, normal.y, normal.z };
+		std::copy(vertex, vertex + stride, out);
+	}
+
+	// Chama task(begin, end) para [0, count) em tarefas se a malha tem vrtices suficientes, seno direto
+	template <typename Task>
+	static void forRange(JobSystem* jobs, int count, size_t vertices, const Task& task) {
+		if (jobs != nullptr && vertices >= (size_t)parallelVertices)
+			jobs->parallelFor(count, 0, task);
+		else
+			task(0, count);
+	}
+
+	static void resize(vector<GLfloat>& vbuffer, vector<GLuint>& indices, size_t vertices, size_t numIndices) {
+		vbuffer.resize(vertices * stride);
+		indices.resize(numIndices);
+	}
+
+	// Grade de (columns + 1) x (rows + 1) vrtices a partir do vrtice first e do ndice firstIndex, com
+	// point(u, v, position, normal) para u e v em [0, 1]; u cresce para a direita e v para cima de quem olha a face
+	// de fora. Cada tarefa faz linhas inteiras (os vrtices e os tringulos acima deles).
+	template <typename PointFunction>
+	static void fillGrid(vector<GLfloat>& vbuffer, vector<GLuint>& indices, size_t first, size_t firstIndex, int columns, int rows,
+		const PointFunction& point, JobSystem* jobs) {
+		forRange(jobs, rows + 1, (size_t)(columns + 1) * (rows + 1), [&](int begin, int end) {
+			for (int row = begin; row < end; ++row) {
+				float v = (float)row / rows;
+				for (int column = 0; column <= columns; ++column) {
+					float u = (float)column / columns;
+					glm::vec3 position, normal;
+					point(u, v, position, normal);
+					setVertex(&vbuffer[(first + (size_t)row * (columns + 1) + column) * stride], position, glm::vec2(u, v), normal);
+				}
+				if (row == rows)
+					continue;
+				GLuint* out = &indices[firstIndex + (size_t)row * columns * 6];
+				for (int column = 0; column < columns; ++column) {
+					GLuint a = (GLuint)(first + (size_t)row * (columns + 1) + column), b = a + 1, c = a + columns + 1, d = c + 1;
+					*out++ = a; *out++ = b; *out++ = d;
+					*out++ = a; *out++ = d; *out++ = c;
+				}
+			}
+		});
+	}
+
+	// ngulo em torno do eixo y da coluna u: u = 0.5 fica em +x, como nos planetas exportados do Wings 3D
+	static float getLongitude(float u) {
+		return glm::two_pi<float>() * (u - 0.25f);
+	}
+
+	static void generateUVSphere(int segments, int rings, vector<GLfloat>& vbuffer, vector<GLuint>& indices, JobSystem* jobs) {
+		resize(vbuffer, indices, (size_t)(segments + 1) * (rings + 1), (size_t)segments * rings * 6);
+		fillGrid(vbuffer, indices, 0, 0, segments, rings, [](float u, float v, glm::vec3& position, glm::vec3& normal) {
+			float longitude = getLongitude(u), polar = glm::pi<float>() * v;
+			normal = glm::vec3(std::sin(polar) * std::sin(longitude), -std::cos(polar), std::sin(polar) * std::cos(longitude));
+			position = normal;
+		}, jobs);
+	}
+
+	static void generateTorus(int segments, int sides, vector<GLfloat>& vbuffer, vector<GLuint>& indices, JobSystem* jobs) {
+		const float ringRadius = 0.7f, tubeRadius = 0.3f;
+		resize(vbuffer, indices, (size_t)(segments + 1) * (sides + 1), (size_t)segments * sides * 6);
+		fillGrid(vbuffer, indices, 0, 0, segments, sides, [&](float u, float v, glm::vec3& position, glm::vec3& normal) {
+			float longitude = getLongitude(u), tube = glm::two_pi<float>() * v;
+			normal = glm::vec3(std::cos(tube) * std::sin(longitude), std::sin(tube), std::cos(tube) * std::cos(longitude));
+			position = glm::vec3(std::sin(longitude), 0.0f, std::cos(longitude)) * ringRadius + normal * tubeRadius;
+		}, jobs);
+	}
+
+	// Lateral em uma grade de uma linha; as tampas so leques em torno do centro
+	static void generateCylinder(int segments, vector<GLfloat>& vbuffer, vector<GLuint>& indices, JobSystem* jobs) {
+		size_t sideVertices = (size_t)(segments + 1) * 2, sideIndices = (size_t)segments * 6;
+		resize(vbuffer, indices, sideVertices + 2 * (size_t)(segments + 1), sideIndices + 2 * (size_t)segments * 3);
+		fillGrid(vbuffer, indices, 0, 0, segments, 1, [](float u, float v, glm::vec3& position, glm::vec3& normal) {
+			float longitude = getLongitude(u);
+			normal = glm::vec3(std::sin(longitude), 0.0f, std::cos(longitude));
+			position = glm::vec3(normal.x, 2.0f * v - 1.0f, normal.z);
+		}, jobs);
+
+		for (int cap = 0; cap < 2; ++cap) {
+			float y = cap == 0 ? 1.0f : -1.0f;
+			size_t center = sideVertices + (size_t)cap * (segments + 1);
+			size_t index = sideIndices + (size_t)cap * segments * 3;
+			setVertex(&vbuffer[center * stride], glm::vec3(0.0f, y, 0.0f), glm::vec2(0.5f), glm::vec3(0.0f, y, 0.0f));
+			for (int segment = 0; segment < segments; ++segment) {
+				float longitude = getLongitude((float)segment / segments);
+				glm::vec3 position(std::sin(longitude), y, std::cos(longitude));
+				setVertex(&vbuffer[(center + 1 + segment) * stride], position, glm::vec2(0.5f + 0.5f * position.x, 0.5f - 0.5f * position.z * y),
+					glm::vec3(0.0f, y, 0.0f));
+				// Anti-horrio visto de fora: de cima, na ordem das colunas; de baixo, ao contrrio
+				GLuint current = (GLuint)(center + 1 + segment), next = (GLuint)(center + 1 + (segment + 1) % segments);
+				indices[index++] = (GLuint)center;
+				indices[index++] = cap == 0 ? current : next;
+				indices[index++] = cap == 0 ? next : current;
+			}
+		}
+	}
+
+	// Cada face  uma grade de divisions x divisions quadrados; as faces so feitas em paralelo s linhas
+	static void generateCube(int divisions, vector<GLfloat>& vbuffer, vector<GLuint>& indices, JobSystem* jobs) {
+		// Normal, direo de u e direo de v de cada face, com u x v = normal
+		const glm::vec3 faces[6][3] = {
+			{ { 1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 } }, { { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+			{ { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, -1 } }, { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+			{ { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } }, { { 0, 0, -1 }, { -1, 0, 0 }, { 0, 1, 0 } }
+		};
+		size_t faceVertices = (size_t)(divisions + 1) * (divisions + 1), faceIndices = (size_t)divisions * divisions * 6;
+		resize(vbuffer, indices, faceVertices * 6, faceIndices * 6);
+		for (int face = 0; face < 6; ++face) {
+			const glm::vec3* axes = faces[face];
+			fillGrid(vbuffer, indices, faceVertices * face, faceIndices * face, divisions, divisions,
+				[axes](float u, float v, glm::vec3& position, glm::vec3& normal) {
+					normal = axes[0];
+					position = axes[0] + (2.0f * u - 1.0f) * axes[1] + (2.0f * v - 1.0f) * axes[2];
+				}, jobs);
+		}
+	}
+
+	// Cada face do icosaedro dividida em frequency tringulos projetados na esfera. As faces no dividem vrtices,
+	// ento a coordenada de textura de cada uma  desenrolada em torno do centro dela, sem a costura cruzar a face.
+	static void generateIcosphere(int frequency, vector<GLfloat>& vbuffer, vector<GLuint>& indices, JobSystem* jobs) {
+		const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+		const glm::vec3 corners[12] = {
+			{ -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 }, { 0, -1, t }, { 0, 1, t },
+			{ 0, -1, -t }, { 0, 1, -t }, { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+		};
+		const int triangles[20][3] = {
+			{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 }, { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+			{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 }, { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+		};
+		size_t faceVertices = (size_t)(frequency + 1) * (frequency + 2) / 2, faceIndices = (size_t)frequency * frequency * 3;
+		resize(vbuffer, indices, faceVertices * 20, faceIndices * 20);
+
+		forRange(jobs, 20, faceVertices * 20, [&](int begin, int end) {
+			for (int face = begin; face < end; ++face) {
+				glm::vec3 a = corners[triangles[face][0]], b = corners[triangles[face][1]], c = corners[triangles[face][2]];
+				if (glm::dot(glm::cross(b - a, c - a), a + b + c) < 0.0f)
+					std::swap(b, c);
+				float centerU = getSphereU(glm::normalize(a + b + c), 0.5f);
+				// Vrtice (i, j): i passos de a para b e j de a para c
+				size_t first = faceVertices * face;
+				auto vertexIndex = [&](int i, int j) {
+					return (GLuint)(first + (size_t)i * (frequency + 1) - (size_t)i * (i - 1) / 2 + j);
+				};
+				for (int i = 0; i <= frequency; ++i)
+					for (int j = 0; i + j <= frequency; ++j) {
+						glm::vec3 normal = glm::normalize(a + (b - a) * ((float)i / frequency) + (c - a) * ((float)j / frequency));
+						float u = getSphereU(normal, centerU);
+						u += u - centerU > 0.5f ? -1.0f : u - centerU < -0.5f ? 1.0f : 0.0f;
+						setVertex(&vbuffer[vertexIndex(i, j) * stride], normal, glm::vec2(u, 0.5f + std::asin(std::clamp(normal.y, -1.0f, 1.0f)) / glm::pi<float>()), normal);
+					}
+				GLuint* out = &indices[faceIndices * face];
+				for (int i = 0; i < frequency; ++i)
+					for (int j = 0; i + j < frequency; ++j) {
+						*out++ = vertexIndex(i, j); *out++ = vertexIndex(i + 1, j); *out++ = vertexIndex(i, j + 1);
+						if (i + j + 2 <= frequency) {
+							*out++ = vertexIndex(i + 1, j); *out++ = vertexIndex(i + 1, j + 1); *out++ = vertexIndex(i, j + 1);
+						}
+					}
+			}
+		});
+	}
+
+	// Coordenada u de uma direo na esfera, com a mesma longitude da esfera UV; nos polos usa fallback
+	static float getSphereU(const glm::vec3& direction, float fallback) {
+		if (direction.x * direction.x + direction.z * direction.z < 1e-10f)
+			return fallback;
+		float u = 0.25f + std::atan2(direction.x, direction.z) / glm::two_pi<float>();
+		return u - std::floor(u);
+	}
+
+	// Base quadrada em y = -1 e vrtice em y = 1, com normais planas (a tesselagem no se aplica)
+	static void generatePyramid(vector<GLfloat>& vbuffer, vector<GLuint>& indices) {
+		const glm::vec3 base[4] = { { -1, -1, 1 }, { 1, -1, 1 }, { 1, -1, -1 }, { -1, -1, -1 } };
+		const glm::vec3 apex(0.0f, 1.0f, 0.0f);
+		resize(vbuffer, indices, 16, 18);
+		for (int side = 0; side < 4; ++side) {
+			const glm::vec3& left = base[side];
+			const glm::vec3& right = base[(side + 1) % 4];
+			glm::vec3 normal = glm::normalize(glm::cross(right - left, apex - left));
+			setVertex(&vbuffer[(side * 3 + 0) * stride], left, glm::vec2(0.0f, 0.0f), normal);
+			setVertex(&vbuffer[(side * 3 + 1) * stride], right, glm::vec2(1.0f, 0.0f), normal);
+			setVertex(&vbuffer[(side * 3 + 2) * stride], apex, glm::vec2(0.5f, 1.0f), normal);
+			for (int k = 0; k < 3; ++k)
+				indices[side * 3 + k] = side * 3 + k;
+		}
+		for (int corner = 0; corner < 4; ++corner)
+			setVertex(&vbuffer[(12 + corner) * stride], base[corner], glm::vec2(0.5f + 0.5f * base[corner].x, 0.5f + 0.5f * base[corner].z),
+				glm::vec3(0.0f, -1.0f, 0.0f));
+		const GLuint baseIndices[6] = { 12, 14, 13, 12, 15, 14 };
+		std::copy(baseIndices, baseIndices + 6, indices.begin() + 12);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,499 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
+#include <unordered_map>
+#include <cstdint>
+#include <glad/glad.h>
+#include "AllocationTracker.cpp"
+
+using namespace std;
+
+// Com GRAUB_PROFILER 0 as macros de zona somem na compilao
+#ifndef GRAUB_PROFILER
+#define GRAUB_PROFILER 1
+#endif
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#if GRAUB_PROFILER
+// Mede o tempo de CPU do escopo; name precisa ser uma string literal (s o ponteiro  guardado)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+// Mede o tempo de GPU dos comandos enviados no escopo (zonas de GPU no podem ser aninhadas)
+#define PROFILE_GPU_ZONE(name) GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(name)
+// Guarda um valor do quadro (ex.: objetos desenhados); name tambm precisa ser uma string literal
+#define PROFILE_COUNTER(name, value) Profiler::count(name, (double)(value))
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_GPU_ZONE(name)
+#define PROFILE_COUNTER(name, value)
+#endif
+
+// Trecho medido: nome (string literal), incio e fim em ns desde o incio do programa e as alocaes feitas nele
+struct ProfileEvent {
+	const char* name;
+	uint64_t begin, end;
+	uint32_t allocations = 0, bytes = 0;
+};
+
+// Fila circular de eventos de uma thread: s ela escreve e s o Profiler::collect l, sem travas.
+// Com a fila cheia os eventos novos so descartados (e contados).
+class ProfileRing
+{
+public:
+	static const uint64_t capacity = 1 << 16;
+
+	bool push(const ProfileEvent& event) {
+		uint64_t head = this->head.load(memory_order_relaxed);
+		if (head - tail.load(memory_order_acquire) >= capacity) {
+			dropped.fetch_add(1, memory_order_relaxed);
+			return false;
+		}
+		events[head & (capacity - 1)] = event;
+		this->head.store(head + 1, memory_order_release);
+		return true;
+	}
+
+	template <typename Function>
+	void drain(Function&& function) {
+		uint64_t head = this->head.load(memory_order_acquire);
+		uint64_t tail = this->tail.load(memory_order_relaxed);
+		for (; tail != head; ++tail)
+			function(events[tail & (capacity - 1)]);
+		this->tail.store(tail, memory_order_release);
+	}
+
+	uint64_t getDropped() const {
+		return dropped.load(memory_order_relaxed);
+	}
+
+private:
+	vector<ProfileEvent> events = vector<ProfileEvent>(capacity);
+	alignas(64) atomic<uint64_t> head{ 0 };
+	alignas(64) atomic<uint64_t> tail{ 0 };
+	atomic<uint64_t> dropped{ 0 };
+};
+
+// Consulta de GPU enviada e ainda no lida, com o nome e o incio (na CPU) da zona
+struct ProfileGpuQuery {
+	GLuint query;
+	const char* name;
+	uint64_t begin;
+};
+
+// Perfil dos quadros: zonas de CPU gravadas por thread em filas sem travas, zonas de GPU medidas com consultas
+// GL_TIME_ELAPSED lidas nos quadros seguintes, quando a GPU termina (sem esperar por ela), estatsticas por zona (p50/p95/p99 das
+// ltimas medidas), contadores por quadro e exportao no formato trace_event do Chrome (chrome://tracing ou ui.perfetto.dev).
+// Desligado, cada zona custa a leitura de um bool.
+class Profiler
+{
+public:
+	// Medidas guardadas por zona para as estatsticas
+	static const int statsWindow = 1024;
+
+	static bool isEnabled() {
+		return enabled.load(memory_order_relaxed);
+	}
+
+	static void setEnabled(bool value) {
+		enabled.store(value, memory_order_relaxed);
+	}
+
+	// Tempo em ns desde o incio do programa
+	static uint64_t now() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	// Nome da thread que chama, usado no trao
+	static void setThreadName(const string& name) {
+		ProfileThread& thread = getThread();
+		lock_guard<mutex> lock(threadsMutex);
+		thread.name = name;
+	}
+
+	static void record(const char* name, uint64_t begin, uint64_t end, uint64_t allocations = 0, uint64_t bytes = 0) {
+		getThread().ring.push({ name, begin, end, (uint32_t)allocations, (uint32_t)std::min<uint64_t>(bytes, UINT32_MAX) });
+	}
+
+	// Passa a guardar os eventos para o trao (at maxCaptureEvents); writeTrace grava e termina a captura
+	static void startCapture() {
+		lock_guard<mutex> lock(collectMutex);
+		captured.clear();
+		capturedCounters.clear();
+		capturing = true;
+	}
+
+	static bool isCapturing() {
+		return capturing;
+	}
+
+	// Esvazia as filas das threads nas estatsticas (e no trao, durante a captura); chamado uma vez por quadro
+	static void collect() {
+		lock_guard<mutex> lock(collectMutex);
+		lock_guard<mutex> threadsLock(threadsMutex);
+		for (auto& thread : threads) {
+			uint32_t id = thread->id;
+			thread->ring.drain([id](const ProfileEvent& event) { addEvent(id, event); });
+		}
+	}
+
+	// Valor de um contador neste momento (com o perfil ligado): entra nas estatsticas e, durante a captura, no trao
+	static void count(const char* name, double value) {
+		if (!isEnabled())
+			return;
+		uint64_t time = now();
+		lock_guard<mutex> lock(collectMutex);
+		CounterStats& stats = counters[name];
+		if (stats.samples.size() < statsWindow)
+			stats.samples.push_back(value);
+		else
+			stats.samples[stats.next] = value;
+		stats.next = (stats.next + 1) % statsWindow;
+		stats.count++;
+		stats.sum += value;
+		if (capturing && capturedCounters.size() < maxCaptureEvents)
+			capturedCounters.push_back({ name, time, value });
+	}
+
+	// Fim do quadro na thread da OpenGL: l, na ordem de envio, as consultas de GPU que j tm resultado; a primeira
+	// que a GPU ainda no terminou (e as seguintes) fica para o prximo quadro
+	static void endFrame() {
+		while (!gpuPending.empty()) {
+			const ProfileGpuQuery& pending = gpuPending.front();
+			GLint available = 0;
+			glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				break;
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &elapsed);
+			ProfileEvent event = { pending.name, pending.begin, pending.begin + elapsed };
+			{
+				lock_guard<mutex> lock(collectMutex);
+				addEvent(gpuThreadId, event);
+			}
+			gpuFreeQueries.push_back(pending.query);
+			gpuPending.pop_front();
+		}
+	}
+
+	// Retorna false (e no mede) com o perfil desligado ou outra zona de GPU aberta
+	static bool beginGpuZone(const char* name) {
+		if (!isEnabled() || gpuActive)
+			return false;
+		GLuint query;
+		if (gpuFreeQueries.empty()) {
+			glGenQueries(1, &query);
+		}
+		else {
+			query = gpuFreeQueries.back();
+			gpuFreeQueries.pop_back();
+		}
+		gpuPending.push_back({ query, name, now() });
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		gpuActive = true;
+		return true;
+	}
+
+	static void endGpuZone() {
+		if (!gpuActive)
+			return;
+		glEndQuery(GL_TIME_ELAPSED);
+		gpuActive = false;
+	}
+
+	// Libera as consultas de GPU (antes de destruir o contexto)
+	static void releaseGpu() {
+		for (const auto& pending : gpuPending)
+			gpuFreeQueries.push_back(pending.query);
+		if (!gpuFreeQueries.empty())
+			glDeleteQueries((GLsizei)gpuFreeQueries.size(), gpuFreeQueries.data());
+		gpuPending.clear();
+		gpuFreeQueries.clear();
+		gpuActive = false;
+	}
+
+	// Tabela com quantas vezes cada zona rodou e os percentis das ltimas statsWindow medidas, em ms
+	static void printSummary(ostream& out) {
+		lock_guard<mutex> lock(collectMutex);
+		// A mesma zona pode vir de literais diferentes (um por unidade de compilao): agrupa pelo texto
+		unordered_map<string, vector<double>> samples;
+		unordered_map<string, uint64_t> counts, allocations, bytes;
+		vector<string> order;
+		for (const auto& zone : zones) {
+			string name = zone.first.name + (zone.first.thread == gpuThreadId ? string(" (GPU)") : string());
+			if (!samples.count(name))
+				order.push_back(name);
+			const ZoneStats& stats = zone.second;
+			samples[name].insert(samples[name].end(), stats.samples.begin(), stats.samples.end());
+			counts[name] += stats.count;
+			allocations[name] += stats.allocations;
+			bytes[name] += stats.bytes;
+		}
+		std::sort(order.begin(), order.end());
+
+		out << "Perfil (ltimas " << statsWindow << " medidas de cada zona em cada thread, em ms):" << endl;
+		out << "  zona" << string(32, ' ') << std::setw(10) << "vezes" << std::setw(10) << "p50" << std::setw(10) << "p95"
+			<< std::setw(10) << "p99" << std::setw(12) << "aloc./vez" << std::setw(12) << "bytes/vez" << endl;
+		auto flags = out.flags();
+		auto precision = out.precision();
+		out.setf(std::ios::fixed);
+		out.precision(3);
+		for (const auto& name : order) {
+			vector<double>& values = samples[name];
+			std::sort(values.begin(), values.end());
+			out << "  " << name << string(name.size() < 36 ? 36 - name.size() : 1, ' ') << std::setw(10) << counts[name]
+				<< std::setw(10) << percentile(values, 0.50) << std::setw(10) << percentile(values, 0.95)
+				<< std::setw(10) << percentile(values, 0.99) << std::setw(12) << (double)allocations[name] / counts[name]
+				<< std::setw(12) << (double)bytes[name] / counts[name] << endl;
+		}
+		printCounters(out);
+		out.flags(flags);
+		out.precision(precision);
+
+		uint64_t dropped = 0;
+		lock_guard<mutex> threadsLock(threadsMutex);
+		for (const auto& thread : threads)
+			dropped += thread->ring.getDropped();
+		if (dropped > 0)
+			out << "  " << dropped << " eventos descartados (fila de uma thread cheia)" << endl;
+	}
+
+	// Grava os eventos capturados como JSON trace_event ("X" com incio e durao em microssegundos, "C" para os
+	// contadores) e termina a captura
+	static bool writeTrace(const string& path) {
+		lock_guard<mutex> lock(collectMutex);
+		capturing = false;
+		ofstream out(path);
+		if (!out) {
+			std::cerr << "Erro ao gravar o trao: " << path << std::endl;
+			return false;
+		}
+
+		out << "{\"traceEvents\":[\n";
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << gpuThreadId << ",\"args\":{\"name\":\"GPU\"}}";
+		{
+			lock_guard<mutex> threadsLock(threadsMutex);
+			for (const auto& thread : threads)
+				out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id << ",\"args\":{\"name\":\""
+					<< escape(thread->name) << "\"}}";
+		}
+		out.setf(std::ios::fixed);
+		out.precision(3);
+		for (const auto& event : captured)
+			out << ",\n{\"name\":\"" << escape(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+				<< ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0
+				<< ",\"args\":{\"alocacoes\":" << event.allocations << ",\"bytes\":" << event.bytes << "}}";
+		for (const auto& counter : capturedCounters)
+			out << ",\n{\"name\":\"" << escape(counter.name) << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << counter.time / 1000.0
+				<< ",\"args\":{\"valor\":" << counter.value << "}}";
+		out << "\n]}\n";
+		cout << "Trao gravado em " << path << " (" << captured.size() + capturedCounters.size() << " eventos)" << endl;
+		captured.clear();
+		captured.shrink_to_fit();
+		capturedCounters.clear();
+		capturedCounters.shrink_to_fit();
+		return (bool)out;
+	}
+
+private:
+	static const uint32_t gpuThreadId = 0;
+	static const size_t maxCaptureEvents = 4 * 1024 * 1024;
+
+	struct ProfileThread {
+		ProfileRing ring;
+		uint32_t id;
+		string name;
+	};
+
+	struct CapturedEvent {
+		const char* name;
+		uint32_t thread;
+		uint64_t begin, end;
+		uint32_t allocations, bytes;
+	};
+
+	struct CapturedCounter {
+		const char* name;
+		uint64_t time;
+		double value;
+	};
+
+	struct ZoneKey {
+		const char* name;
+		uint32_t thread;
+
+		bool operator==(const ZoneKey& other) const {
+			return name == other.name && thread == other.thread;
+		}
+	};
+
+	struct ZoneKeyHash {
+		size_t operator()(const ZoneKey& key) const {
+			return std::hash<const void*>()(key.name) ^ ((size_t)key.thread * 0x9E3779B97F4A7C15ull);
+		}
+	};
+
+	// ltimas medidas da zona (em ms), num anel de statsWindow posies
+	struct ZoneStats {
+		vector<double> samples;
+		size_t next = 0;
+		uint64_t count = 0;
+		uint64_t allocations = 0, bytes = 0;
+	};
+
+	// ltimos valores do contador, num anel de statsWindow posies, e a soma de todos
+	struct CounterStats {
+		vector<double> samples;
+		size_t next = 0;
+		uint64_t count = 0;
+		double sum = 0.0;
+	};
+
+	inline static atomic<bool> enabled{ false };
+	inline static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	inline static mutex threadsMutex;
+	inline static vector<unique_ptr<ProfileThread>> threads;
+	inline static thread_local ProfileThread* localThread = nullptr;
+
+	inline static mutex collectMutex;
+	inline static unordered_map<ZoneKey, ZoneStats, ZoneKeyHash> zones;
+	inline static bool capturing = false;
+	inline static vector<CapturedEvent> captured;
+	inline static unordered_map<const char*, CounterStats> counters;
+	inline static vector<CapturedCounter> capturedCounters;
+
+	// Consultas enviadas, na ordem, e as j lidas que podem ser reaproveitadas
+	inline static deque<ProfileGpuQuery> gpuPending;
+	inline static vector<GLuint> gpuFreeQueries;
+	inline static bool gpuActive = false;
+
+	// Fila da thread que chama, criada no primeiro uso (as filas ficam at o fim do programa)
+	static ProfileThread& getThread() {
+		if (localThread == nullptr) {
+			auto thread = make_unique<ProfileThread>();
+			lock_guard<mutex> lock(threadsMutex);
+			thread->id = (uint32_t)threads.size() + 1;
+			thread->name = "Thread " + to_string(thread->id);
+			localThread = thread.get();
+			threads.push_back(std::move(thread));
+		}
+		return *localThread;
+	}
+
+	// Chamado com collectMutex travado
+	static void addEvent(uint32_t thread, const ProfileEvent& event) {
+		ZoneStats& stats = zones[{ event.name, thread }];
+		double ms = (event.end - event.begin) / 1e6;
+		if (stats.samples.size() < statsWindow)
+			stats.samples.push_back(ms);
+		else
+			stats.samples[stats.next] = ms;
+		stats.next = (stats.next + 1) % statsWindow;
+		stats.count++;
+		stats.allocations += event.allocations;
+		stats.bytes += event.bytes;
+		if (capturing && captured.size() < maxCaptureEvents)
+			captured.push_back({ event.name, thread, event.begin, event.end, event.allocations, event.bytes });
+	}
+
+	// Tabela dos contadores: quantos valores, a mdia de todos e os percentis dos ltimos statsWindow (chamado com
+	// collectMutex travado, no formato de printSummary)
+	static void printCounters(ostream& out) {
+		if (counters.empty())
+			return;
+		unordered_map<string, vector<double>> samples;
+		unordered_map<string, uint64_t> counts;
+		unordered_map<string, double> sums;
+		vector<string> order;
+		for (const auto& counter : counters) {
+			string name = counter.first;
+			if (!samples.count(name))
+				order.push_back(name);
+			samples[name].insert(samples[name].end(), counter.second.samples.begin(), counter.second.samples.end());
+			counts[name] += counter.second.count;
+			sums[name] += counter.second.sum;
+		}
+		std::sort(order.begin(), order.end());
+
+		out << "Contadores (ltimos " << statsWindow << " valores de cada um):" << endl;
+		out << "  contador" << string(28, ' ') << std::setw(10) << "vezes" << std::setw(12) << "mdia" << std::setw(12) << "p50"
+			<< std::setw(12) << "p95" << std::setw(12) << "p99" << endl;
+		for (const auto& name : order) {
+			vector<double>& values = samples[name];
+			std::sort(values.begin(), values.end());
+			out << "  " << name << string(name.size() < 36 ? 36 - name.size() : 1, ' ') << std::setw(10) << counts[name]
+				<< std::setw(12) << sums[name] / counts[name] << std::setw(12) << percentile(values, 0.50)
+				<< std::setw(12) << percentile(values, 0.95) << std::setw(12) << percentile(values, 0.99) << endl;
+		}
+	}
+
+	static double percentile(const vector<double>& sorted, double fraction) {
+		if (sorted.empty())
+			return 0.0;
+		return sorted[std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()))];
+	}
+
+	static string escape(const string& text) {
+		string result;
+		for (char c : text) {
+			if (c == '"' || c == '\\')
+				result += '\\';
+			result += c;
+		}
+		return result;
+	}
+};
+
+// Zona de CPU: mede o tempo e as alocaes da thread do construtor ao destrutor, se o perfil estava ligado no incio
+class ProfileZone
+{
+public:
+	ProfileZone(const char* name) : name(name), active(Profiler::isEnabled()) {
+		if (active) {
+			allocations = AllocationTracker::getThreadAllocations();
+			bytes = AllocationTracker::getThreadBytes();
+			begin = Profiler::now();
+		}
+	}
+
+	~ProfileZone() {
+		if (active)
+			Profiler::record(name, begin, Profiler::now(), AllocationTracker::getThreadAllocations() - allocations,
+				AllocationTracker::getThreadBytes() - bytes);
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	const char* name;
+	bool active;
+	uint64_t begin = 0, allocations = 0, bytes = 0;
+};
+
+// Zona de GPU: uma consulta GL_TIME_ELAPSED em volta dos comandos do escopo (s na thread da OpenGL)
+class GpuProfileZone
+{
+public:
+	GpuProfileZone(const char* name) : active(Profiler::beginGpuZone(name)) {}
+
+	~GpuProfileZone() {
+		if (active)
+			Profiler::endGpuZone();
+	}
+
+	GpuProfileZone(const GpuProfileZone&) = delete;
+	GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+
+private:
+	bool active;
+};
\ No newline at end of file
@@ -4,38 +4,67 @@
 #include <string>
 #include <assert.h>
 #include <vector>
+#include <memory>
+#include <unordered_map>
+#include <memory_resource>
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <sstream>
+#include <random>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/constants.hpp>
 #include "../Common/include/stb_image.h"
 #include "SceneObj.cpp"
 #include "Camera.cpp"
+#include "TextureAtlas.cpp"
+#include "TextureArray.cpp"
+#include "InstancedBatch.cpp"
+#include "SceneCompiler.cpp"
+#include "TextureResidency.cpp"
+#include "SceneLoader.cpp"
+#include "SceneSnapshot.cpp"
+#include "NBody.cpp"
+#include "KeplerOrbits.cpp"
+#include "BodyRenderer.cpp"
+#include "ParticleSystem.cpp"
+#include "ParticleRenderer.cpp"
+#include "ImpostorRenderer.cpp"
+#include "ClusteredLights.cpp"
+#include "ShadowMap.cpp"
 
 using namespace std;
 using json = nlohmann::json;
 
-struct SceneObjAux {
-	int transfObjectId = -1;
-	float x, y, z, scale, rotateSpeed = 10.0;
-	bool curveEnable = false;
-	string objFilePath, rotate;
-	vector <glm::vec3> curvePoints;
-};
-
-struct SceneCameraAux {
-	float fov, nearPlane, farPlane, positionX, positionY, positionZ, 
-		frontDirectionX, frontDirectionY, frontDirectionZ, 
-		upDirectionX, upDirectionY, upDirectionZ;
-};
-
 class Scene
 {
 public:
 	Camera camera;
 	vector<SceneObj> sceneObject;
+	vector<InstancedBatch> instancedBatches;
+	unique_ptr<UploadManager> uploadManager;
+	unique_ptr<TextureResidency> textureResidency;
+	// Mantido depois da carga para que a recarga de uma textura possa reescrever a sua camada
+	unique_ptr<TextureArray> textureArray;
+	// Gravitao entre os objetos com massa, mais os asteroides (corpos a partir de firstAsteroid, sem SceneObj)
+	unique_ptr<NBody> gravity;
+	unique_ptr<BodyRenderer> bodyRenderer;
+	int firstAsteroid = 0;
+	// rbitas fixas dos objetos com "orbit" (a k-sima move sceneObject[orbitObjects[k]]) e do cinturo "orbitBelt"
+	KeplerOrbits orbits, orbitBelt;
+	// Um emissor por objeto da lista com "particles" (o k-simo segue sceneObject[emitterObjects[k]])
+	ParticleSystem particles;
+	unique_ptr<ParticleRenderer> particleRenderer;
+	// Esferas pequenas na tela desenhadas como impostores (impostors[i] marca sceneObject[i] no quadro atual)
+	unique_ptr<ImpostorRenderer> impostorRenderer;
+	vector<unsigned char> impostors;
+	// Luzes pontuais dos objetos com "light" e do anel de "pointLights", distribudas em aglomerados a cada quadro
+	unique_ptr<ClusteredLights> pointLights;
+	// Sombra da luz principal, com os objetos parados num mapa guardado (sem o bloco "shadows", nullptr)
+	unique_ptr<ShadowMap> shadowMap;
 	int width, height;
 	float lightPositionX, lightPositionY, lightPositionZ, lightColorR, lightColorG, lightColorB;
 
@@ -43,133 +72,888 @@ public:
 		: jsonFilePath(jsonFilePath), shader(shader), width(width), height(height), camera(shader, width, height)
     {
 		loadSceneFromJSON(jsonFilePath);
+		if (uploadAux.enabled)
+			createUploadManager();
+		if (residencyAux.enabled)
+			createTextureResidency();
 		loadObjects();
+		if (atlasAux.enabled && !residencyAux.enabled)
+			buildTextureAtlas();
+		if (textureArrayAux.enabled && !residencyAux.enabled)
+			buildTextureArrays();
+		setupOrbits();
+		setupParticles();
+		setupLights();
+		setupShadows();
     }
 
-private:
-	Shader* shader;
-	string jsonFilePath;
-	std::vector<SceneObjAux> sceneObjectsAux;
+	// Pede ao gerenciador de residncia a resoluo de cada textura conforme o tamanho do objeto na tela
+	// e deixa ele carregar ou descartar os mipmaps (uma vez por quadro, com as posies da cpia que vai ser desenhada)
+	void updateTextureResidency(const SceneSnapshot& snapshot) {
+		if (!textureResidency || snapshot.models.size() != sceneObject.size())
+			return;
 
-	void loadSceneFromJSON(const std::string& jsonFilePath) {
-		std::ifstream file(jsonFilePath);
-		if (!file.is_open()) {
-			std::cerr << "No foi possvel abrir o arquivo JSON: " << jsonFilePath << std::endl;
-			return;
-		}
-
-		json j;
-		file >> j;
-
-		if (j.contains("objects")) {
-			for (const auto& obj : j["objects"]) {
-				SceneObjAux objAux;
-				objAux.objFilePath = obj["objFilePath"];
-				objAux.x = obj["positionX"];
-				objAux.y = obj["positionY"];
-				objAux.z = obj["positionZ"];
-				if (obj.contains("curvePoints")) {
-					for (const auto& point : obj["curvePoints"]) {
-						float x = std::stof(point[0].get<std::string>());
-						float y = std::stof(point[1].get<std::string>());
-						float z = std::stof(point[2].get<std::string>());
-						objAux.curvePoints.push_back(glm::vec3(x, y, z));
-					}
-				}
-				if (obj.contains("transfObjectId"))
-					objAux.transfObjectId = obj["transfObjectId"];
-				if(obj.contains("curveEnable"))
-						objAux.curveEnable = obj["curveEnable"];
-				if (obj.contains("scale"))
-					objAux.scale = obj["scale"];
-				if (obj.contains("rotate"))
-					objAux.rotate = obj["rotate"];
-				if (obj.contains("rotateSpeed"))
-					objAux.rotateSpeed = obj["rotateSpeed"];
-				sceneObjectsAux.push_back(objAux);
-			}
+		for (size_t i = 0; i < sceneObject.size(); ++i) {
+			const SceneObj& obj = sceneObject[i];
+			const glm::mat4& model = snapshot.models[i];
+			float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+			float pixels = Camera::getProjectedSize(glm::vec3(model[3]), obj.sceneObjInfo.boundingRadius * scale,
+				snapshot.cameraPosition, snapshot.fov, snapshot.height);
+
+			const MaterialLibrary* library = obj.sceneObjInfo.materialLibrary.get();
+			for (const auto& subMesh : obj.sceneObjInfo.subMeshes)
+				if (library->getTextureLayer(subMesh.material) < 0)
+					textureResidency->requestSize(library->getTextureId(subMesh.material), pixels);
 		}
-		else {
-			std::cerr << "Estrutura JSON invlida: 'objects' no encontrado." << std::endl;
+		textureResidency->update();
+	}
+
+	// Objeto pelo identificador estvel (nullptr se ele no existe mais)
+	SceneObj* findObject(int handle) {
+		for (auto& obj : sceneObject)
+			if (obj.handle == handle)
+				return &obj;
+		return nullptr;
+	}
+
+	// Guarda as matrizes de modelo e a cmera atuais numa cpia para o desenho (chamado pela simulao)
+	void writeSnapshot(SceneSnapshot& snapshot) const {
+		snapshot.models.resize(sceneObject.size());
+		for (size_t i = 0; i < sceneObject.size(); ++i)
+			snapshot.models[i] = sceneObject[i].getModelMatrix();
+		snapshot.view = camera.getViewMatrix();
+		snapshot.projection = camera.getProjectionMatrix();
+		snapshot.cameraPosition = camera.getPosition();
+		snapshot.fov = camera.getFov();
+		snapshot.height = camera.getHeight();
+		size_t asteroids = gravity ? gravity->size() - firstAsteroid : 0;
+		snapshot.bodies.resize(asteroids + orbitBelt.size());
+		for (size_t i = 0; i < asteroids; ++i)
+			snapshot.bodies[i] = gravity->getPosition(firstAsteroid + (int)i);
+		// O cinturo no tem estado alm do tempo: as posies so calculadas direto na cpia
+		if (orbitBelt.size() > 0)
+			orbitBelt.evaluate(orbitTime, beltFocus >= 0 ? sceneObject[beltFocus].getPosition() : glm::vec3(0),
+				snapshot.bodies.data() + asteroids, getJobs());
+		particles.write(snapshot.particles, snapshot.particleBatches, getJobs());
+	}
+
+	// Desenha a cena como ela estava na cpia: s l a malha e o material dos objetos, ento a simulao pode
+	// continuar mexendo nas posies enquanto isso. Uma cpia de antes da lista de objetos mudar  ignorada.
+	void render(const SceneSnapshot& snapshot) {
+		PROFILE_ZONE("Scene::render");
+		if (snapshot.models.size() != sceneObject.size())
+			return;
+
+		glm::mat4 view = snapshot.view, projection = snapshot.projection;
+		shader->setMat4("view", glm::value_ptr(view));
+		shader->setMat4("projection", glm::value_ptr(projection));
+		shader->setVec3("camera_pos", snapshot.cameraPosition.x, snapshot.cameraPosition.y, snapshot.cameraPosition.z);
+		updatePointLights(snapshot);
+		selectImpostors(snapshot);
+		for (size_t i = 0; i < sceneObject.size(); ++i)
+			if (!sceneObject[i].instanced && !impostors[i])
+				sceneObject[i].renderObject(snapshot.models[i]);
+		renderInstancedBatches(snapshot);
+		if (impostorRenderer && impostorRenderer->size() > 0) {
+			impostorRenderer->render(view, projection, snapshot.cameraPosition, glm::vec3(lightPositionX, lightPositionY, lightPositionZ),
+				glm::vec3(lightColorR, lightColorG, lightColorB), pointLights.get(), width, height, pointLightAux.clustered,
+				shadowMap.get());
+			shader->Use();
+		}
+		if (!snapshot.bodies.empty()) {
+			if (!bodyRenderer)
+				bodyRenderer = make_unique<BodyRenderer>();
+			bodyRenderer->render(snapshot);
+			shader->Use();
+		}
+		// Por ltimo: as partculas so transparentes e no escrevem profundidade
+		if (!snapshot.particles.empty()) {
+			if (!particleRenderer)
+				particleRenderer = make_unique<ParticleRenderer>();
+			particleRenderer->render(snapshot);
+			shader->Use();
 		}
+	}
 
-		loadLightFromJSON(j);
-		loadCameraFromJSON(j);	
+	// Desenha o mapa de sombra da luz principal com as matrizes da cpia e liga ele no shader da cena. Chamado antes
+	// de render e fora da zona de GPU dele (as zonas de GPU do ShadowMap no podem ficar dentro de outra).
+	void renderShadows(const SceneSnapshot& snapshot) {
+		if (!shadowMap || snapshot.models.size() != sceneObject.size())
+			return;
+		shadowMap->render(glm::vec3(lightPositionX, lightPositionY, lightPositionZ), sceneObject, snapshot.models);
+		glViewport(0, 0, width, height);
+		shader->Use();
+		shadowMap->bind(shader);
 	}
 
-	void loadLightFromJSON(json j) {
-		if (j.contains("light")) {
-			const auto& light = j["light"];
-			if (light.contains("lightPositionX")) {
-				lightPositionX = light["lightPositionX"];
-			}
-			if (light.contains("lightPositionY")) {
-				lightPositionY = light["lightPositionY"];
-			}
-			if (light.contains("lightPositionZ")) {
-				lightPositionZ = light["lightPositionZ"];
+	// Desenha os lotes instanciados (os objetos deles so pulados pelo lao de renderObject)
+	void renderInstancedBatches(const SceneSnapshot& snapshot) {
+		for (auto& batch : instancedBatches)
+			batch.render(shader, sceneObject, snapshot.models, impostors);
+	}
+
+	// Coloca as luzes pontuais nas posies da cpia, distribui nos aglomerados da cmera dela e liga os buffers no shader
+	void updatePointLights(const SceneSnapshot& snapshot) {
+		if (!pointLights)
+			return;
+		pointLights->clear();
+		for (size_t k = 0; k < lightObjects.size(); ++k) {
+			const SceneLightAux& aux = lightSettings[k];
+			pointLights->add(glm::vec3(snapshot.models[lightObjects[k]][3]), aux.radius,
+				glm::vec3(aux.color[0], aux.color[1], aux.color[2]) * aux.intensity);
+		}
+		for (size_t k = 0; k < ringLights.size(); k += 2)
+			pointLights->add(glm::vec3(ringLights[k]), ringLights[k].w, glm::vec3(ringLights[k + 1]));
+		pointLights->build(snapshot.view, snapshot.projection, getJobs());
+		pointLights->upload();
+		pointLights->bind(shader, width, height, pointLightAux.clustered);
+	}
+
+	// Marca as esferas com menos de impostorAux.maxPixels de dimetro na tela e as passa para o desenho de impostores
+	void selectImpostors(const SceneSnapshot& snapshot) {
+		impostors.assign(sceneObject.size(), 0);
+		if (impostorRenderer)
+			impostorRenderer->clear();
+		if (!impostorAux.enabled)
+			return;
+
+		for (size_t i = 0; i < sceneObject.size(); ++i) {
+			const SceneObj& obj = sceneObject[i];
+			if (!obj.sceneObjInfo.sphere || !obj.isUploaded())
+				continue;
+			const glm::mat4& model = snapshot.models[i];
+			float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+			float pixels = Camera::getProjectedSize(glm::vec3(model[3]), obj.sceneObjInfo.boundingRadius * scale,
+				snapshot.cameraPosition, snapshot.fov, snapshot.height);
+			if (pixels >= impostorAux.maxPixels)
+				continue;
+			if (!impostorRenderer)
+				impostorRenderer = make_unique<ImpostorRenderer>();
+			impostors[i] = 1;
+			impostorRenderer->add(model, obj.sceneObjInfo.boundingRadius, obj.sceneObjInfo.materialLibrary.get(),
+				obj.sceneObjInfo.subMeshes.front().material);
+		}
+	}
+
+	const SceneHotReloadAux& getHotReloadSettings() const {
+		return hotReloadAux;
+	}
+
+	const SceneSimulationAux& getSimulationSettings() const {
+		return simulationAux;
+	}
+
+	// Se a cmera usa o fov e os planos dados na cena (os que faltam no JSON ficam com os padres da Camera)
+	bool cameraMatchesSettings() const {
+		const SceneImageSettings& settings = sceneImage.getSettings();
+		if (!(settings.flags & SceneImageSettings::hasCamera))
+			return true;
+		const SceneCameraAux& cameraAux = settings.camera;
+		return (cameraAux.fov <= 0.0f || camera.getFov() == glm::radians(cameraAux.fov)) &&
+			(cameraAux.nearPlane <= 0.0f || camera.getNearPlane() == cameraAux.nearPlane) &&
+			(cameraAux.farPlane <= 0.0f || camera.getFarPlane() == cameraAux.farPlane);
+	}
+
+	const SceneGravityAux& getGravitySettings() const {
+		return gravityAux;
+	}
+
+	// Pe os objetos com rbita fixa na posio do tempo time, os focos antes dos objetos que giram em torno deles
+	// (chamado pela simulao depois da gravitao, para a qual esses objetos so corpos movidos de fora)
+	void updateOrbits(double time) {
+		orbitTime = time;
+		if (orbits.size() == 0)
+			return;
+		orbitPositions.resize(orbits.size());
+		orbits.evaluate(time, glm::vec3(0), orbitPositions.data(), getJobs());
+		for (size_t k = 0; k < orbitObjects.size(); ++k) {
+			SceneObj& obj = sceneObject[orbitObjects[k]];
+			glm::vec3 focus = orbitFocus[k] >= 0 ? sceneObject[orbitFocus[k]].getPosition() : obj.getScenePosition();
+			obj.updatePosition(focus + orbitPositions[k]);
+		}
+	}
+
+	// Leva cada emissor para o seu objeto (apontando para longe do objeto awayFrom, se houver) e avana as partculas
+	// dt segundos (chamado pela simulao depois de mover os objetos)
+	void updateParticles(float dt) {
+		if (particles.emitters.empty())
+			return;
+		for (size_t k = 0; k < emitterObjects.size(); ++k) {
+			ParticleEmitter& emitter = particles.emitters[k];
+			emitter.position = sceneObject[emitterObjects[k]].getPosition();
+			if (emitterAway[k] >= 0)
+				emitter.direction = emitter.position - sceneObject[emitterAway[k]].getPosition();
+		}
+		particles.update(dt, getJobs());
+	}
+
+	// Avana a gravitao dt segundos e move os objetos com massa (chamado pela simulao antes de atualizar as
+	// matrizes). Um objeto movido pelo teclado ou por uma curva desde o passo anterior leva o seu corpo junto.
+	void stepGravity(float dt) {
+		if (!gravity)
+			return;
+		for (const auto& obj : sceneObject)
+			if (obj.body >= 0 && obj.getPosition() != gravity->getPosition(obj.body))
+				gravity->setPosition(obj.body, obj.getPosition());
+		for (int i = 0; i < gravityAux.substeps; ++i)
+			gravity->step(dt / gravityAux.substeps, getJobs());
+		for (auto& obj : sceneObject)
+			if (obj.body >= 0)
+				obj.updatePosition(gravity->getPosition(obj.body));
+	}
+
+	// Aplica os objetos alterados de uma nova verso da cena compilada (ndices da lista "objects"; ndices alm
+	// do fim foram removidos). Objetos com o mesmo arquivo de malha s trocam as propriedades; os demais so
+	// recriados, usando as malhas j lidas em meshes quando houver (com recreate, todos so recriados: o arquivo
+	// glTF deles foi regravado). Retorna true se a lista de objetos mudou (ponteiros para sceneObject deixam de valer).
+	bool reloadObjects(const SceneImage& image, const vector<int>& changed, const unordered_map<string, MeshData>& meshes, bool recreate = false) {
+		bool structural = false;
+		objectOrbits.resize(std::max(objectOrbits.size(), (size_t)image.getNumObjects()));
+		objectParticles.resize(objectOrbits.size());
+		objectLights.resize(objectOrbits.size());
+		for (int index : changed) {
+			bool removed = index >= image.getNumObjects();
+			SceneObjAux obj = removed ? SceneObjAux() : image.getObjectAux(index);
+			if (!removed) {
+				objectOrbits[index] = obj.orbit;
+				objectParticles[index] = obj.particles;
+				objectLights[index] = obj.light;
 			}
-			if (light.contains("lightColorR")) {
-				lightColorR = light["lightColorR"];
+			float scaleObj = obj.scale > 0 ? obj.scale : 1.0;
+
+			bool samePath = !removed;
+			bool found = false;
+			for (const auto& sceneObj : sceneObject) {
+				if (sceneObj.sceneIndex != index)
+					continue;
+				found = true;
+				samePath = samePath && sceneObj.sceneObjInfo.getObjFilePath() == obj.objFilePath;
 			}
-			if (light.contains("lightColorG")) {
-				lightColorG = light["lightColorG"];
+			if (found && samePath && !recreate) {
+				string extension = MeshLoader::getExtension(obj.objFilePath);
+				bool gltf = extension == "glb" || extension == "gltf";
+				for (auto& sceneObj : sceneObject)
+					if (sceneObj.sceneIndex == index) {
+						sceneObj.setSceneProperties(obj.x, obj.y, obj.z, obj.transfObjectId, obj.curvePoints, obj.curveEnable,
+							glm::vec3(scaleObj, scaleObj, scaleObj), obj.rotate, obj.rotateSpeed);
+						sceneObj.mass = gltf ? 0.0f : obj.mass;
+						sceneObj.velocity = obj.velocity;
+						sceneObj.castShadows = obj.castShadows;
+					}
+				continue;
 			}
-			if (light.contains("lightColorB")) {
-				lightColorB = light["lightColorB"];
+
+			sceneObject.erase(std::remove_if(sceneObject.begin(), sceneObject.end(),
+				[index](const SceneObj& sceneObj) { return sceneObj.sceneIndex == index; }), sceneObject.end());
+			if (!removed) {
+				auto mesh = meshes.find(obj.objFilePath);
+				if (mesh != meshes.end()) {
+					SceneObjInfo info(obj.objFilePath, mesh->second);
+					addObject(obj, index, &info);
+				}
+				else {
+					addObject(obj, index);
+				}
 			}
+			structural = true;
+		}
+		objectOrbits.resize(image.getNumObjects());
+		objectParticles.resize(image.getNumObjects());
+		objectLights.resize(image.getNumObjects());
+		if (structural)
+			buildInstancedBatches();
+		if (!changed.empty()) {
+			setupGravity();
+			setupOrbits();
+			setupParticles();
+			setupLights();
+			if (shadowMap)
+				shadowMap->invalidate();
+		}
+		return structural;
+	}
+
+	// Troca a malha de todos os objetos que usam o arquivo (OBJ, PLY ou STL; um glTF  recarregado por reloadObjects)
+	void reloadMesh(const string& objFilePath, const MeshData& data) {
+		SceneObjInfo info(objFilePath, data);
+		for (auto& obj : sceneObject)
+			if (obj.sceneObjInfo.getObjFilePath() == objFilePath)
+				obj.sceneObjInfo = info;
+		buildInstancedBatches();
+		if (shadowMap)
+			shadowMap->invalidate();
+	}
+
+	// Arquivos de malha cujo MTL  este
+	vector<string> getMeshesUsingMaterial(const string& mtlFilePath) const {
+		vector<string> meshes;
+		for (const auto& obj : sceneObject) {
+			const string& path = obj.sceneObjInfo.getObjFilePath();
+			if (AssetPack::normalizePath(obj.sceneObjInfo.getMaterialFilePath()) == AssetPack::normalizePath(mtlFilePath) &&
+				std::find(meshes.begin(), meshes.end(), path) == meshes.end())
+				meshes.push_back(path);
+		}
+		return meshes;
+	}
+
+	// Luz e cmera de uma nova verso da cena compilada
+	void reloadSettings(const SceneImageSettings& settings, bool light, bool camera) {
+		if (light) {
+			loadLight(settings);
+			applyLight();
+		}
+		if (camera)
+			loadCamera(settings);
+		impostorAux = settings.impostors;
+		pointLightAux = settings.pointLights;
+		shadowAux = settings.shadows;
+		setupLights();
+		setupShadows();
+	}
+
+	void applyLight() {
+		shader->setVec3("light_pos", lightPositionX, lightPositionY, lightPositionZ);
+		shader->setVec3("light_color", lightColorR, lightColorG, lightColorB);
+	}
+
+private:
+	Shader* shader;
+	string jsonFilePath;
+	SceneImage sceneImage;
+	SceneAtlasAux atlasAux;
+	SceneTextureArrayAux textureArrayAux;
+	SceneUploadAux uploadAux;
+	SceneResidencyAux residencyAux;
+	SceneHotReloadAux hotReloadAux;
+	SceneSimulationAux simulationAux;
+	SceneGravityAux gravityAux;
+	SceneOrbitBeltAux orbitBeltAux;
+	SceneImpostorAux impostorAux;
+	ScenePointLightAux pointLightAux;
+	SceneShadowAux shadowAux;
+	// rbita de cada objeto da lista "objects" e, para cada rbita dos objetos, o ndice em sceneObject do foco
+	// (-1: a posio do objeto no Scene.json); beltFocus  o do cinturo (-1: a origem)
+	vector<SceneOrbitAux> objectOrbits;
+	vector<int> orbitObjects, orbitFocus;
+	vector<glm::vec3> orbitPositions;
+	int beltFocus = -1;
+	double orbitTime = 0;
+	// Emissor de cada objeto da lista "objects" e, para cada emissor, os ndices em sceneObject do objeto e do
+	// awayFrom (-1: a direo do Scene.json)
+	vector<SceneParticleAux> objectParticles;
+	vector<int> emitterObjects, emitterAway;
+	// Luz de cada objeto da lista "objects"; para cada luz dos objetos, o ndice em sceneObject e a luz; e as luzes do
+	// anel (posio e raio, cor)
+	vector<SceneLightAux> objectLights, lightSettings;
+	vector<int> lightObjects;
+	vector<glm::vec4> ringLights;
+
+	// A cena vem da verso compilada do JSON (recompilada s quando o JSON muda), usada direto da memria mapeada
+	void loadSceneFromJSON(const std::string& jsonFilePath) {
+		if (!SceneCompiler::loadOrCompile(jsonFilePath, sceneImage))
+			return;
+
+		const SceneImageSettings& settings = sceneImage.getSettings();
+		loadLight(settings);
+		loadCamera(settings);
+		if (settings.flags & SceneImageSettings::hasCompression)
+			TextureLoader::compression = sceneImage.getString(settings.compressionFormat);
+		atlasAux = settings.atlas;
+		textureArrayAux = settings.textureArrays;
+		uploadAux = settings.upload;
+		residencyAux = settings.residency;
+		hotReloadAux = settings.hotReload;
+		simulationAux = settings.simulation;
+		gravityAux = settings.gravity;
+		orbitBeltAux = settings.orbitBelt;
+		impostorAux = settings.impostors;
+		pointLightAux = settings.pointLights;
+		shadowAux = settings.shadows;
+	}
+
+	void loadLight(const SceneImageSettings& settings) {
+		if (!(settings.flags & SceneImageSettings::hasLight))
+			return;
+		lightPositionX = settings.lightPosition[0];
+		lightPositionY = settings.lightPosition[1];
+		lightPositionZ = settings.lightPosition[2];
+		lightColorR = settings.lightColor[0];
+		lightColorG = settings.lightColor[1];
+		lightColorB = settings.lightColor[2];
+	}
+
+	void loadCamera(const SceneImageSettings& settings) {
+		if (!(settings.flags & SceneImageSettings::hasCamera))
+			return;
+		const SceneCameraAux& cameraAux = settings.camera;
+		if (settings.flags & SceneImageSettings::hasCameraPosition)
+			camera.setPosition(glm::vec3(cameraAux.positionX, cameraAux.positionY, cameraAux.positionZ));
+		if (settings.flags & SceneImageSettings::hasCameraFront)
+			camera.setFrontDirection(glm::vec3(cameraAux.frontDirectionX, cameraAux.frontDirectionY, cameraAux.frontDirectionZ));
+		if (settings.flags & SceneImageSettings::hasCameraUp)
+			camera.setUpDirection(glm::vec3(cameraAux.upDirectionX, cameraAux.upDirectionY, cameraAux.upDirectionZ));
+		// O fov do JSON  em graus
+		camera.setProjection(cameraAux.fov > 0.0f ? glm::radians(cameraAux.fov) : 0.0f, cameraAux.nearPlane, cameraAux.farPlane);
+		camera.updateProjection();
+		camera.updateCamera();
+	}
+
+	// Texturas e vrtices carregados daqui em diante passam pelo anel de staging em vez de serem enviados na hora
+	void createUploadManager() {
+		uploadManager = make_unique<UploadManager>((size_t)(uploadAux.ringSizeMB * 1024 * 1024), (size_t)(uploadAux.frameBudgetMB * 1024 * 1024));
+		uploadManager->initialize();
+		UploadManager::current = uploadManager.get();
+	}
+
+	void createTextureResidency() {
+		textureResidency = make_unique<TextureResidency>((size_t)(residencyAux.budgetMB * 1024 * 1024), residencyAux.tailSize);
+		textureResidency->initialize();
+		TextureResidency::current = textureResidency.get();
+	}
+
+	// Sistema de tarefas do passo da simulao e do quadro: criado em main antes da cena (s a carga tem um local,
+	// pois o passo e o quadro rodam em threads diferentes e um sistema local seria de uma s delas)
+	static JobSystem& getJobs() {
+		assert(JobSystem::current != nullptr);
+		return *JobSystem::current;
+	}
+
+	// Carga em duas fases: o SceneLoader l as malhas, os MTL e as texturas e gera as curvas em paralelo; depois,
+	// na thread principal, os buffers e as texturas so criados e os objetos so montados direto no vetor
+	void loadObjects() {
+		PROFILE_ZONE("Scene::loadObjects");
+		// Sem o sistema de tarefas do programa (ex.: cena criada fora de main) usa um s para a carga
+		unique_ptr<JobSystem> localJobs;
+		if (JobSystem::current == nullptr)
+			localJobs = make_unique<JobSystem>();
+		JobSystem& jobs = JobSystem::current != nullptr ? *JobSystem::current : *localJobs;
+		SceneLoader loader;
+		loader.load(sceneImage, jobs, UploadManager::current == nullptr && TextureResidency::current == nullptr);
+
+		PROFILE_ZONE("Scene::loadObjects (OpenGL)");
+		auto start = std::chrono::steady_clock::now();
+		for (auto& material : loader.materials)
+			MaterialLibrary::insert(material.first, material.second);
+		for (const auto& texture : loader.textures)
+			TextureLoader::loadTextureFromSource(texture.first, texture.second);
+		// Uma malha por arquivo, compartilhada por todos os objetos que a usam (ns tirados de um pool, liberados juntos)
+		std::pmr::unsynchronized_pool_resource pool;
+		std::pmr::unordered_map<string, SceneObjInfo> infos(&pool);
+		for (auto& mesh : loader.meshes)
+			infos.insert({ mesh.first, SceneObjInfo(mesh.first, std::move(mesh.second)) });
+		loader.meshes.clear();
+		loader.textures.clear();
+
+		sceneObject.reserve(sceneImage.getNumObjects());
+		objectOrbits.resize(sceneImage.getNumObjects());
+		objectParticles.resize(sceneImage.getNumObjects());
+		objectLights.resize(sceneImage.getNumObjects());
+		for (int i = 0; i < sceneImage.getNumObjects(); ++i) {
+			SceneObjAux obj = sceneImage.getObjectAux(i);
+			objectOrbits[i] = obj.orbit;
+			objectParticles[i] = obj.particles;
+			objectLights[i] = obj.light;
+			auto info = infos.find(obj.objFilePath);
+			addObject(obj, i, info != infos.end() ? &info->second : nullptr, loader.findCurve(i));
+		}
+		sceneImage.close();
+		setupGravity();
+
+		std::cout << "Objetos: leitura em " << loader.getTotalMs() << " ms com " << jobs.getNumThreads() << " thread(s) (malhas "
+			<< loader.meshMs << " ms, MTL " << loader.materialMs << " ms, texturas " << loader.textureMs << " ms, curvas "
+			<< loader.curveMs << " ms); criao na GPU em " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+			<< " ms; pico residente de " << AllocationTracker::getPeakResidentBytes() / (1024.0 * 1024.0) << " MB" << std::endl;
+	}
+
+	// Cria o(s) SceneObj de um objeto do Scene.json; info  a malha j criada e curve a curva j gerada, se houver
+	void addObject(const SceneObjAux& obj, int index, const SceneObjInfo* info = nullptr, Bezier* curve = nullptr) {
+		float scaleObj = obj.scale > 0 ? obj.scale : 1.0;
+		string extension = MeshLoader::getExtension(obj.objFilePath);
+		size_t first = sceneObject.size();
+		if (extension == "glb" || extension == "gltf") {
+			loadGLTFObject(obj, scaleObj);
 		}
 		else {
-			std::cerr << "Estrutura JSON invlida: 'lights' no encontrado." << std::endl;
+			bool hasCurve = curve != nullptr && !obj.curvePoints.empty();
+			sceneObject.emplace_back(obj.x, obj.y, obj.z, info != nullptr ? *info : SceneObjInfo(obj.objFilePath), glm::mat4(1), shader,
+				obj.transfObjectId, hasCurve ? vector<glm::vec3>() : obj.curvePoints, obj.curveEnable, glm::vec3(scaleObj, scaleObj, scaleObj),
+				obj.rotate, obj.rotateSpeed);
+			if (hasCurve)
+				sceneObject.back().setBezierCurve(obj.curvePoints, std::move(*curve));
+			// S objetos de uma malha s entram na gravitao (as primitivas de um glTF se moveriam separadas)
+			sceneObject.back().mass = obj.mass;
+			sceneObject.back().velocity = obj.velocity;
+		}
+		for (size_t i = first; i < sceneObject.size(); ++i) {
+			sceneObject[i].sceneIndex = index;
+			sceneObject[i].castShadows = obj.castShadows;
 		}
 	}
 
-	void loadCameraFromJSON(json j) {
-		if (j.contains("camera")) {
-			const auto& cam = j["camera"];
-			SceneCameraAux cameraAux;
+	// Objeto movido por uma rbita de Kepler (updateOrbits)
+	bool hasOrbit(const SceneObj& obj) const {
+		return obj.sceneIndex >= 0 && obj.sceneIndex < (int)objectOrbits.size() && objectOrbits[obj.sceneIndex].semiMajorAxis > 0;
+	}
 
-			if (cam.contains("fov")) {
-				cameraAux.fov = cam["fov"];
-			}
-			if (cam.contains("nearPlane")) {
-				cameraAux.nearPlane = cam["nearPlane"];
+	// Recria a gravitao com as posies atuais dos objetos com massa (as velocidades voltam s do Scene.json).
+	// Objetos parados ganham a velocidade da rbita circular em torno do mais pesado, se circularVelocities.
+	void setupGravity() {
+		gravity.reset();
+		for (auto& obj : sceneObject)
+			obj.body = -1;
+		if (!gravityAux.enabled)
+			return;
+
+		gravity = make_unique<NBody>(gravityAux.G, gravityAux.softening, gravityAux.theta, gravityAux.directLimit);
+		gravity->reserve(sceneObject.size() + gravityAux.asteroids);
+		// Um objeto com rbita  movido por updateOrbits: como corpo ele seria puxado tambm pela gravitao
+		SceneObj* central = nullptr;
+		for (auto& obj : sceneObject)
+			if (obj.mass > 0 && !hasOrbit(obj) && (central == nullptr || obj.mass > central->mass))
+				central = &obj;
+		for (auto& obj : sceneObject) {
+			if (obj.mass <= 0 || hasOrbit(obj))
+				continue;
+			glm::vec3 velocity = obj.velocity;
+			if (gravityAux.circularVelocities && velocity == glm::vec3(0) && &obj != central)
+				velocity = central->velocity + gravity->getCircularVelocity(obj.getPosition(), central->getPosition(), central->mass);
+			obj.body = gravity->addBody(obj.getPosition(), velocity, obj.mass);
+		}
+		firstAsteroid = (int)gravity->size();
+		if (central != nullptr && gravityAux.asteroids > 0) {
+			gravity->addBelt(central->body, gravityAux.asteroids, gravityAux.asteroidInnerRadius, gravityAux.asteroidOuterRadius,
+				gravityAux.asteroidThickness, gravityAux.asteroidMass, gravityAux.asteroidSeed);
+		}
+		std::cout << "Gravitao: " << firstAsteroid << " objeto(s) e " << gravity->size() - firstAsteroid << " asteroide(s)" << std::endl;
+	}
+
+	// Monta as rbitas dos objetos (de novo a cada mudana na lista, j que os ndices em sceneObject mudam) e, na
+	// primeira vez, o cinturo. As rbitas ficam na ordem da profundidade do objeto na cadeia de focos (lua, planeta,
+	// estrela), para que updateOrbits mova cada foco antes dos objetos em torno dele.
+	void setupOrbits() {
+		unordered_map<int, int> byId;
+		for (int i = (int)sceneObject.size() - 1; i >= 0; --i)
+			if (sceneObject[i].transfObjectId >= 0)
+				byId[sceneObject[i].transfObjectId] = i;
+		auto findFocus = [&](int around) {
+			auto found = byId.find(around);
+			return around >= 0 && found != byId.end() ? found->second : -1;
+		};
+		auto getOrbit = [&](int object) -> const SceneOrbitAux* {
+			int index = sceneObject[object].sceneIndex;
+			return index >= 0 && index < (int)objectOrbits.size() && objectOrbits[index].semiMajorAxis > 0 ? &objectOrbits[index] : nullptr;
+		};
+
+		vector<pair<int, int>> order;
+		for (int i = 0; i < (int)sceneObject.size(); ++i) {
+			if (getOrbit(i) == nullptr)
+				continue;
+			// Um ciclo de focos  cortado depois de passar por todos os objetos
+			int depth = 0;
+			for (int focus = findFocus(getOrbit(i)->around); focus >= 0 && getOrbit(focus) != nullptr && depth < (int)sceneObject.size();
+				focus = findFocus(getOrbit(focus)->around))
+				++depth;
+			order.push_back({ depth, i });
+		}
+		std::stable_sort(order.begin(), order.end());
+
+		orbits.clear();
+		orbitObjects.clear();
+		orbitFocus.clear();
+		for (const auto& entry : order) {
+			const SceneOrbitAux& orbit = *getOrbit(entry.second);
+			orbits.add(orbit.semiMajorAxis, orbit.eccentricity, orbit.inclination, orbit.ascendingNode, orbit.periapsis, orbit.phase, orbit.period);
+			orbitObjects.push_back(entry.second);
+			int focus = findFocus(orbit.around);
+			orbitFocus.push_back(focus != entry.second ? focus : -1);
+		}
+
+		beltFocus = findFocus(orbitBeltAux.around);
+		if (orbitBelt.size() == 0 && orbitBeltAux.count > 0) {
+			auto start = std::chrono::steady_clock::now();
+			orbitBelt.addBelt(orbitBeltAux.count, orbitBeltAux.innerRadius, orbitBeltAux.outerRadius, orbitBeltAux.maxEccentricity,
+				orbitBeltAux.maxInclination, orbitBeltAux.mu, orbitBeltAux.seed);
+			std::cout << "rbitas: " << orbits.size() << " objeto(s) e cinturo de " << orbitBelt.size() << " em "
+				<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+		}
+	}
+
+	// Recria os emissores (a cada mudana na lista de objetos): um por objeto da lista com "particles", preso ao
+	// primeiro SceneObj dele. As partculas vivas se perdem, o que s acontece na recarga.
+	void setupParticles() {
+		unordered_map<int, int> byId;
+		for (int i = (int)sceneObject.size() - 1; i >= 0; --i)
+			if (sceneObject[i].transfObjectId >= 0)
+				byId[sceneObject[i].transfObjectId] = i;
+
+		particles.emitters.clear();
+		emitterObjects.clear();
+		emitterAway.clear();
+		vector<bool> done(objectParticles.size(), false);
+		for (int i = 0; i < (int)sceneObject.size(); ++i) {
+			int index = sceneObject[i].sceneIndex;
+			if (index < 0 || index >= (int)objectParticles.size() || done[index] || objectParticles[index].maxParticles <= 0)
+				continue;
+			done[index] = true;
+			const SceneParticleAux& aux = objectParticles[index];
+			particles.emitters.emplace_back(aux.maxParticles, aux.rate, aux.life, aux.speed, aux.spread, aux.radius, aux.size, aux.drag,
+				glm::vec3(aux.color[0], aux.color[1], aux.color[2]), aux.seed);
+			particles.emitters.back().direction = glm::vec3(aux.direction[0], aux.direction[1], aux.direction[2]);
+			emitterObjects.push_back(i);
+			auto away = byId.find(aux.awayFrom);
+			emitterAway.push_back(aux.awayFrom >= 0 && away != byId.end() && away->second != i ? away->second : -1);
+		}
+		if (!particles.emitters.empty())
+			std::cout << "Partculas: " << particles.emitters.size() << " emissor(es)" << std::endl;
+	}
+
+	// Refaz a lista das luzes pontuais (a cada mudana na lista de objetos ou no bloco "pointLights"): uma por objeto da
+	// lista com "light", presa ao primeiro SceneObj dele, mais as do anel. Sem nenhuma luz os aglomerados so desligados.
+	void setupLights() {
+		lightObjects.clear();
+		lightSettings.clear();
+		vector<bool> done(objectLights.size(), false);
+		for (int i = 0; i < (int)sceneObject.size(); ++i) {
+			int index = sceneObject[i].sceneIndex;
+			if (index < 0 || index >= (int)objectLights.size() || done[index] || objectLights[index].radius <= 0)
+				continue;
+			done[index] = true;
+			lightObjects.push_back(i);
+			lightSettings.push_back(objectLights[index]);
+		}
+
+		// Cores sorteadas com o maior componente em 1
+		ringLights.clear();
+		std::mt19937 random(pointLightAux.ringSeed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		for (int k = 0; k < pointLightAux.ringCount; ++k) {
+			float angle = unit(random) * glm::two_pi<float>();
+			float distance = pointLightAux.ringInnerRadius + (pointLightAux.ringOuterRadius - pointLightAux.ringInnerRadius) * unit(random);
+			float height = (unit(random) - 0.5f) * pointLightAux.ringThickness;
+			glm::vec3 color(unit(random), unit(random), unit(random));
+			color /= std::max(std::max(color.r, color.g), std::max(color.b, 1e-3f));
+			ringLights.push_back(glm::vec4(std::cos(angle) * distance, height, std::sin(angle) * distance, pointLightAux.ringRadius));
+			ringLights.push_back(glm::vec4(color * pointLightAux.ringIntensity, 0.0f));
+		}
+
+		int count = (int)lightObjects.size() + pointLightAux.ringCount;
+		if (count == 0) {
+			if (pointLights)
+				ClusteredLights::unbind(shader);
+			pointLights.reset();
+			return;
+		}
+		if (!pointLights || pointLights->tilesX != pointLightAux.tilesX || pointLights->tilesY != pointLightAux.tilesY ||
+			pointLights->slices != pointLightAux.slices)
+			pointLights = make_unique<ClusteredLights>(pointLightAux.tilesX, pointLightAux.tilesY, pointLightAux.slices);
+		pointLights->reserve(count);
+		std::cout << "Luzes pontuais: " << lightObjects.size() << " de objetos e " << pointLightAux.ringCount << " do anel, "
+			<< (pointLightAux.clustered ? "em aglomerados" : "todas em cada fragmento") << std::endl;
+	}
+
+	// Cria, troca ou remove o mapa de sombra conforme o bloco "shadows" (na carga e a cada recarga dele); o mapa
+	// guardado  sempre refeito
+	void setupShadows() {
+		if (!shadowAux.enabled) {
+			if (shadowMap)
+				ShadowMap::unbind(shader);
+			shadowMap.reset();
+			return;
+		}
+		if (!shadowMap || shadowMap->size != shadowAux.size || shadowMap->staticFrames != shadowAux.staticFrames ||
+			shadowMap->nearPlane != shadowAux.nearPlane || shadowMap->farPlane != shadowAux.farPlane)
+			shadowMap = make_unique<ShadowMap>(shadowAux.size, shadowAux.nearPlane, shadowAux.farPlane, shadowAux.staticFrames);
+		shadowMap->bias = shadowAux.bias;
+		shadowMap->caching = shadowAux.cacheStatic;
+		shadowMap->invalidate();
+	}
+
+	// Um GLB vira um SceneObj por primitiva de cada n com mesh; todos compartilham o transfObjectId
+	// do JSON, ento so selecionados e transformados juntos
+	void loadGLTFObject(const SceneObjAux& obj, float scaleObj) {
+		GLTFModel model;
+		if (!model.load(obj.objFilePath))
+			return;
+		shared_ptr<SceneObjInfo::MeshBuffers> buffers = SceneObjInfo::adoptModel(model);
+
+		for (const auto& instance : model.instances) {
+			if (instance.mesh < 0 || instance.mesh >= (int)model.meshes.size())
+				continue;
+			for (int primitiveIndex : model.meshes[instance.mesh]) {
+				const GLTFPrimitive& primitive = model.primitives[primitiveIndex];
+				SceneObjInfo info(obj.objFilePath, primitive, model.materials, buffers);
+				sceneObject.emplace_back(obj.x, obj.y, obj.z, info, instance.transform, shader, obj.transfObjectId, obj.curvePoints,
+					obj.curveEnable, glm::vec3(scaleObj, scaleObj, scaleObj), obj.rotate, obj.rotateSpeed);
 			}
-			if (cam.contains("farPlane")) {
-				cameraAux.farPlane = cam["farPlane"];
+		}
+	}
+
+	// Troca as texturas pequenas dos materiais usados na cena por pginas de atlas e ordena os objetos
+	// por textura, para que objetos que compartilham uma pgina sejam desenhados em sequncia sem religar a textura
+	void buildTextureAtlas() {
+		vector<MaterialLibrary*> libraries = getMaterialLibraries();
+		int bindsBefore = countTextureBinds();
+		TextureAtlas atlas(atlasAux.pageSize, atlasAux.padding);
+
+		for (MaterialLibrary* library : libraries) {
+			for (int m = 0; m < library->size(); ++m) {
+				int width, height, channels;
+				const string& path = library->diffuseMaps[m];
+				if (path.empty() || library->repeatsUV[m] || !TextureBaker::getImageInfo(path, width, height, channels))
+					continue;
+				if (width <= atlasAux.maxTextureSize && height <= atlasAux.maxTextureSize)
+					atlas.add(path);
 			}
-			if (cam.contains("positionX") && cam.contains("positionY") && cam.contains("positionZ")) {
-				cameraAux.positionX = cam["positionX"];
-				cameraAux.positionY = cam["positionY"];
-				cameraAux.positionZ = cam["positionZ"];
-				camera.setPosition(glm::vec3(cameraAux.positionX, cameraAux.positionY, cameraAux.positionZ));
+		}
+		atlas.pack();
+
+		vector<GLuint> replaced;
+		for (MaterialLibrary* library : libraries) {
+			for (int m = 0; m < library->size(); ++m) {
+				const string& path = library->diffuseMaps[m];
+				if (path.empty() || library->repeatsUV[m] || !atlas.contains(path))
+					continue;
+				replaced.push_back(library->textureIds[m]);
+				library->textureIds[m] = atlas.getTexture(path);
+				library->uvTransforms[m] = atlas.getUVTransform(path);
 			}
-			if (cam.contains("frontDirectionX") && cam.contains("frontDirectionY") && cam.contains("frontDirectionZ")) {
-				cameraAux.frontDirectionX = cam["frontDirectionX"];
-				cameraAux.frontDirectionY = cam["frontDirectionY"];
-				cameraAux.frontDirectionZ = cam["frontDirectionZ"];
-				camera.setFrontDirection(glm::vec3(cameraAux.frontDirectionX, cameraAux.frontDirectionY, cameraAux.frontDirectionZ));
+		}
+
+		releaseUnusedTextures(libraries, replaced);
+
+		std::stable_sort(sceneObject.begin(), sceneObject.end(), [](const SceneObj& a, const SceneObj& b) {
+			return getFirstTexture(a) < getFirstTexture(b);
+		});
+
+		std::cout << "Atlas: " << atlas.getNumTextures() << " texturas em " << atlas.pages.size() << " pgina(s)";
+		for (size_t p = 0; p < atlas.pages.size(); ++p)
+			std::cout << (p == 0 ? " - ocupao " : ", ") << (int)(atlas.getOccupancy((int)p) * 100.0f) << "%";
+		std::cout << std::endl;
+		std::cout << "Trocas de textura por quadro: " << bindsBefore << " -> " << countTextureBinds()
+			<< " (" << bindsBefore - countTextureBinds() << " eliminadas)" << std::endl;
+	}
+
+	// Coloca as texturas de mesmo tamanho e formato em texturas de array e junta em lotes instanciados os objetos
+	// que compartilham malha, array e material; cada lote  desenhado com uma chamada e sem trocar de textura
+	void buildTextureArrays() {
+		vector<MaterialLibrary*> libraries = getMaterialLibraries();
+		int drawsBefore = countDrawCalls();
+		textureArray = make_unique<TextureArray>(textureArrayAux.width, textureArrayAux.height);
+
+		// Materiais j colocados no atlas ficam de fora
+		for (MaterialLibrary* library : libraries)
+			for (int m = 0; m < library->size(); ++m)
+				if (!library->diffuseMaps[m].empty() && library->uvTransforms[m] == glm::vec4(1.0f, 1.0f, 0.0f, 0.0f))
+					textureArray->add(library->diffuseMaps[m]);
+		textureArray->build();
+
+		vector<GLuint> replaced;
+		for (MaterialLibrary* library : libraries) {
+			for (int m = 0; m < library->size(); ++m) {
+				const string& path = library->diffuseMaps[m];
+				if (path.empty() || library->uvTransforms[m] != glm::vec4(1.0f, 1.0f, 0.0f, 0.0f) || !textureArray->contains(path))
+					continue;
+				replaced.push_back(library->textureIds[m]);
+				library->textureIds[m] = textureArray->getTexture(path);
+				library->textureLayers[m] = textureArray->getLayer(path);
 			}
-			if (cam.contains("upDirectionX") && cam.contains("upDirectionY") && cam.contains("upDirectionZ")) {
-				cameraAux.upDirectionX = cam["upDirectionX"];
-				cameraAux.upDirectionY = cam["upDirectionY"];
-				cameraAux.upDirectionZ = cam["upDirectionZ"];
-				camera.setUpDirection(glm::vec3(cameraAux.upDirectionX, cameraAux.upDirectionY, cameraAux.upDirectionZ));
+		}
+		releaseUnusedTextures(libraries, replaced);
+		buildInstancedBatches();
+
+		int instances = 0;
+		for (const auto& batch : instancedBatches)
+			instances += (int)batch.objects.size();
+		int layers = 0;
+		for (size_t a = 0; a < textureArray->arrays.size(); ++a)
+			layers += textureArray->getNumLayers((int)a);
+		std::cout << "Texturas de array: " << textureArray->arrays.size() << " array(s) com " << layers << " camada(s); "
+			<< instancedBatches.size() << " lote(s) instanciado(s) com " << instances << " objeto(s)" << std::endl;
+		std::cout << "Chamadas de desenho por quadro: " << drawsBefore << " -> " << countDrawCalls() << std::endl;
+	}
+
+	// Refaz os lotes instanciados a partir da lista de objetos atual (na carga e quando a recarga muda os objetos)
+	void buildInstancedBatches() {
+		for (auto& batch : instancedBatches)
+			batch.release();
+		instancedBatches.clear();
+		for (auto& obj : sceneObject)
+			obj.instanced = false;
+		if (!textureArray)
+			return;
+
+		for (int i = 0; i < (int)sceneObject.size(); ++i) {
+			if (!InstancedBatch::canInstance(sceneObject[i]))
+				continue;
+			bool added = false;
+			for (auto& batch : instancedBatches) {
+				if (batch.accepts(sceneObject[i], sceneObject)) {
+					batch.objects.push_back(i);
+					added = true;
+					break;
+				}
 			}
-			camera.updateCamera();
+			if (!added)
+				instancedBatches.push_back(InstancedBatch(sceneObject[i], i));
 		}
-		else {
-			std::cerr << "Estrutura JSON invlida: 'camera' no encontrado." << std::endl;
+
+		// Lotes de um objeto s no ganham nada com instanciamento
+		instancedBatches.erase(std::remove_if(instancedBatches.begin(), instancedBatches.end(),
+			[](const InstancedBatch& batch) { return batch.objects.size() < 2; }), instancedBatches.end());
+		for (auto& batch : instancedBatches) {
+			batch.initializeBuffers();
+			for (int i : batch.objects)
+				sceneObject[i].instanced = true;
 		}
 	}
 
-	void loadObjects() {
-		for (const auto& obj : sceneObjectsAux)
-		{
-			float scaleObj = obj.scale > 0 ? obj.scale : 1.0;
-			SceneObj sceneObj = SceneObj(obj.x, obj.y, obj.z, obj.objFilePath, shader, obj.transfObjectId, obj.curvePoints, obj.curveEnable,
-				glm::vec3(scaleObj, scaleObj, scaleObj), obj.rotate, obj.rotateSpeed);
-			sceneObject.push_back(sceneObj);
+	vector<MaterialLibrary*> getMaterialLibraries() const {
+		vector<MaterialLibrary*> libraries;
+		for (const auto& obj : sceneObject) {
+			MaterialLibrary* library = obj.sceneObjInfo.materialLibrary.get();
+			if (std::find(libraries.begin(), libraries.end(), library) == libraries.end())
+				libraries.push_back(library);
+		}
+		return libraries;
+	}
+
+	// Apaga as texturas originais que nenhum material usa mais
+	static void releaseUnusedTextures(const vector<MaterialLibrary*>& libraries, const vector<GLuint>& replaced) {
+		for (GLuint texture : replaced) {
+			bool stillUsed = texture == 0;
+			for (MaterialLibrary* library : libraries)
+				stillUsed = stillUsed || std::find(library->textureIds.begin(), library->textureIds.end(), texture) != library->textureIds.end();
+			if (!stillUsed)
+				TextureLoader::releaseTexture(texture);
+		}
+	}
+
+	int countDrawCalls() const {
+		int draws = (int)instancedBatches.size();
+		for (const auto& obj : sceneObject)
+			if (!obj.instanced)
+				draws += (int)obj.sceneObjInfo.subMeshes.size();
+		return draws;
+	}
+
+	static GLuint getFirstTexture(const SceneObj& obj) {
+		const SceneObjInfo& info = obj.sceneObjInfo;
+		return info.subMeshes.empty() ? 0 : info.materialLibrary->getTextureId(info.subMeshes.front().material);
+	}
+
+	// Quantas vezes a textura muda ao desenhar a cena na ordem atual
+	int countTextureBinds() const {
+		int binds = 0;
+		GLuint bound = 0;
+		for (const auto& obj : sceneObject) {
+			for (const auto& subMesh : obj.sceneObjInfo.subMeshes) {
+				GLuint texture = obj.sceneObjInfo.materialLibrary->getTextureId(subMesh.material);
+				if (texture != bound) {
+					++binds;
+					bound = texture;
+				}
+			}
 		}
+		return binds;
 	}
 };
\ No newline at end of file
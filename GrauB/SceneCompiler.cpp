@@ -0,0 +1,363 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory_resource>
+#include <algorithm>
+#include <filesystem>
+#include "SceneImage.cpp"
+#include "VirtualFileSystem.cpp"
+#include "LinearArena.cpp"
+#include "Primitives.cpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+// Converte o Scene.json (formato de edio) na cena compilada lida pela Scene. O JSON s  analisado quando
+// o cache "Scene.json.gbscene" no existe ou  mais antigo que ele; tambm pode ser chamado pela linha de
+// comando: GrauB --compile-scene [Scene.json] [sada]
+class SceneCompiler
+{
+public:
+	static int run(int argc, char** argv) {
+		string scenePath = argc > 0 ? argv[0] : "Scene.json";
+		string outputPath = argc > 1 ? argv[1] : getCachePath(scenePath);
+
+		vector<unsigned char> image;
+		if (!compileFile(scenePath, image) || !write(outputPath, image))
+			return -1;
+
+		SceneImage scene;
+		scene.load(std::move(image));
+		std::cout << outputPath << ": " << scene.getNumObjects() << " objetos, " << scene.size() / 1024.0 << " KB" << std::endl;
+		return 0;
+	}
+
+	static string getCachePath(const string& scenePath) {
+		return scenePath + ".gbscene";
+	}
+
+	// Abre o cache compilado da cena ou, se ele estiver desatualizado, compila o JSON e grava o cache
+	static bool loadOrCompile(const string& scenePath, SceneImage& scene) {
+		string cachePath = getCachePath(scenePath);
+		if (isCacheValid(scenePath, cachePath) && scene.open(cachePath))
+			return true;
+
+		vector<unsigned char> image;
+		if (!compileFile(scenePath, image))
+			return false;
+		if (!write(cachePath, image))
+			std::cerr << "No foi possvel gravar o cache da cena: " << cachePath << std::endl;
+		return scene.load(std::move(image));
+	}
+
+	static bool compileFile(const string& scenePath, vector<unsigned char>& image) {
+		VirtualFile file(scenePath);
+		if (!file.isOpen()) {
+			std::cerr << "No foi possvel abrir o arquivo JSON: " << scenePath << std::endl;
+			return false;
+		}
+
+		try {
+			json j = json::parse(file.data(), file.data() + file.size());
+			image = compile(j);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Erro ao ler a cena " << scenePath << ": " << e.what() << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// As listas intermedirias ficam na arena da thread e so descartadas juntas depois de montar a imagem
+	static vector<unsigned char> compile(const json& j) {
+		SceneImageSettings settings;
+		ArenaScope scratch;
+		std::pmr::vector<SceneImageObject> objects(scratch.resource());
+		std::pmr::vector<glm::vec3> curvePoints(scratch.resource());
+		std::pmr::vector<string> names(scratch.resource());
+		std::pmr::unordered_map<string, uint32_t> nameIndices(scratch.resource());
+
+		// Nomes repetidos (a mesma malha em milhares de objetos) ficam uma vez s na tabela
+		auto addName = [&](const string& name) {
+			auto inserted = nameIndices.insert({ name, (uint32_t)names.size() });
+			if (inserted.second)
+				names.push_back(name);
+			return inserted.first->second;
+		};
+
+		if (j.contains("objects")) {
+			const auto& sceneObjects = j["objects"];
+			objects.reserve(sceneObjects.size());
+			for (const auto& obj : sceneObjects) {
+				SceneImageObject object = {};
+				// Uma primitiva gerada ocupa o lugar do arquivo de malha
+				if (obj.contains("primitive")) {
+					const auto& primitive = obj["primitive"];
+					object.objFilePath = addName(Primitives::makePath(primitive.value("type", string("uvsphere")), primitive.value("tessellation", 32),
+						primitive.value("material", string())));
+				}
+				else {
+					object.objFilePath = addName(obj["objFilePath"].get<string>());
+				}
+				object.x = obj["positionX"];
+				object.y = obj["positionY"];
+				object.z = obj["positionZ"];
+				object.transfObjectId = obj.value("transfObjectId", -1);
+				object.scale = obj.value("scale", 0.0f);
+				object.rotateSpeed = obj.value("rotateSpeed", 10.0f);
+				object.rotate = obj.contains("rotate") ? addName(obj["rotate"].get<string>()) : SceneImageObject::noString;
+				if (obj.value("curveEnable", false))
+					object.flags |= SceneImageObject::curveEnable;
+				if (!obj.value("castShadows", true))
+					object.flags |= SceneImageObject::noShadows;
+
+				object.firstCurvePoint = (uint32_t)curvePoints.size();
+				if (obj.contains("curvePoints")) {
+					for (const auto& point : obj["curvePoints"])
+						curvePoints.push_back(glm::vec3(getNumber(point[0]), getNumber(point[1]), getNumber(point[2])));
+				}
+				object.numCurvePoints = (uint32_t)curvePoints.size() - object.firstCurvePoint;
+				object.mass = obj.value("mass", 0.0f);
+				object.velocity[0] = obj.value("velocityX", 0.0f);
+				object.velocity[1] = obj.value("velocityY", 0.0f);
+				object.velocity[2] = obj.value("velocityZ", 0.0f);
+				if (obj.contains("orbit")) {
+					const auto& orbit = obj["orbit"];
+					object.orbit.around = orbit.value("around", -1);
+					object.orbit.semiMajorAxis = std::max(0.0f, orbit.value("semiMajorAxis", 0.0f));
+					object.orbit.eccentricity = orbit.value("eccentricity", 0.0f);
+					object.orbit.inclination = orbit.value("inclination", 0.0f);
+					object.orbit.ascendingNode = orbit.value("ascendingNode", 0.0f);
+					object.orbit.periapsis = orbit.value("periapsis", 0.0f);
+					object.orbit.phase = orbit.value("phase", 0.0f);
+					object.orbit.period = orbit.value("period", 0.0f);
+				}
+				if (obj.contains("particles")) {
+					const auto& particles = obj["particles"];
+					SceneParticleAux& aux = object.particles;
+					aux.maxParticles = particles.value("enabled", true) ? std::max(0, particles.value("maxParticles", 0)) : 0;
+					aux.awayFrom = particles.value("awayFrom", aux.awayFrom);
+					aux.rate = particles.value("rate", aux.rate);
+					aux.life = particles.value("life", aux.life);
+					aux.speed = particles.value("speed", aux.speed);
+					aux.spread = particles.value("spread", aux.spread);
+					aux.radius = particles.value("radius", aux.radius);
+					aux.size = particles.value("size", aux.size);
+					aux.drag = particles.value("drag", aux.drag);
+					aux.direction[0] = particles.value("directionX", 0.0f);
+					aux.direction[1] = particles.value("directionY", 0.0f);
+					aux.direction[2] = particles.value("directionZ", 0.0f);
+					aux.color[0] = particles.value("colorR", aux.color[0]);
+					aux.color[1] = particles.value("colorG", aux.color[1]);
+					aux.color[2] = particles.value("colorB", aux.color[2]);
+					aux.seed = particles.value("seed", aux.seed);
+				}
+				if (obj.contains("light")) {
+					const auto& light = obj["light"];
+					SceneLightAux& aux = object.light;
+					aux.radius = light.value("enabled", true) ? std::max(0.0f, light.value("radius", 0.0f)) : 0.0f;
+					aux.intensity = std::max(0.0f, light.value("intensity", aux.intensity));
+					aux.color[0] = light.value("colorR", aux.color[0]);
+					aux.color[1] = light.value("colorG", aux.color[1]);
+					aux.color[2] = light.value("colorB", aux.color[2]);
+				}
+				objects.push_back(object);
+			}
+		}
+		else {
+			std::cerr << "Estrutura JSON invlida: 'objects' no encontrado." << std::endl;
+		}
+
+		compileLight(j, settings);
+		compileCamera(j, settings);
+		if (j.contains("textureCompression")) {
+			const auto& compression = j["textureCompression"];
+			settings.flags |= SceneImageSettings::hasCompression;
+			settings.compressionFormat = addName(compression.value("enabled", true) ? compression.value("format", string("auto")) : "");
+		}
+		compileOptions(j, settings);
+
+		return SceneImage::build(settings, objects, curvePoints, names);
+	}
+
+	static bool write(const string& filepath, const vector<unsigned char>& image) {
+		std::ofstream outputFile(filepath, std::ios::binary);
+		if (!outputFile.is_open()) {
+			std::cerr << "Erro ao criar o arquivo da cena compilada: " << filepath << std::endl;
+			return false;
+		}
+		outputFile.write((const char*)image.data(), image.size());
+		return outputFile.good();
+	}
+
+private:
+	static bool isCacheValid(const string& scenePath, const string& cachePath) {
+		if (VirtualFileSystem::isPacked(cachePath))
+			return true;
+		std::error_code error;
+		if (!std::filesystem::exists(cachePath, error))
+			return false;
+		return std::filesystem::last_write_time(cachePath, error) >= std::filesystem::last_write_time(scenePath, error) && !error;
+	}
+
+	// Os pontos das curvas no Scene.json so strings ("-14.0"); nmeros tambm so aceitos
+	static float getNumber(const json& value) {
+		return value.is_string() ? std::stof(value.get<string>()) : value.get<float>();
+	}
+
+	static void compileLight(const json& j, SceneImageSettings& settings) {
+		if (!j.contains("light")) {
+			std::cerr << "Estrutura JSON invlida: 'lights' no encontrado." << std::endl;
+			return;
+		}
+		const auto& light = j["light"];
+		settings.flags |= SceneImageSettings::hasLight;
+		settings.lightPosition[0] = light.value("lightPositionX", 0.0f);
+		settings.lightPosition[1] = light.value("lightPositionY", 0.0f);
+		settings.lightPosition[2] = light.value("lightPositionZ", 0.0f);
+		settings.lightColor[0] = light.value("lightColorR", 1.0f);
+		settings.lightColor[1] = light.value("lightColorG", 1.0f);
+		settings.lightColor[2] = light.value("lightColorB", 1.0f);
+	}
+
+	static void compileCamera(const json& j, SceneImageSettings& settings) {
+		if (!j.contains("camera")) {
+			std::cerr << "Estrutura JSON invlida: 'camera' no encontrado." << std::endl;
+			return;
+		}
+		const auto& cam = j["camera"];
+		SceneCameraAux& camera = settings.camera;
+		settings.flags |= SceneImageSettings::hasCamera;
+		camera.fov = cam.value("fov", 0.0f);
+		camera.nearPlane = cam.value("nearPlane", 0.0f);
+		camera.farPlane = cam.value("farPlane", 0.0f);
+		if (cam.contains("positionX") && cam.contains("positionY") && cam.contains("positionZ")) {
+			settings.flags |= SceneImageSettings::hasCameraPosition;
+			camera.positionX = cam["positionX"];
+			camera.positionY = cam["positionY"];
+			camera.positionZ = cam["positionZ"];
+		}
+		if (cam.contains("frontDirectionX") && cam.contains("frontDirectionY") && cam.contains("frontDirectionZ")) {
+			settings.flags |= SceneImageSettings::hasCameraFront;
+			camera.frontDirectionX = cam["frontDirectionX"];
+			camera.frontDirectionY = cam["frontDirectionY"];
+			camera.frontDirectionZ = cam["frontDirectionZ"];
+		}
+		if (cam.contains("upDirectionX") && cam.contains("upDirectionY") && cam.contains("upDirectionZ")) {
+			settings.flags |= SceneImageSettings::hasCameraUp;
+			camera.upDirectionX = cam["upDirectionX"];
+			camera.upDirectionY = cam["upDirectionY"];
+			camera.upDirectionZ = cam["upDirectionZ"];
+		}
+	}
+
+	// Blocos opcionais: "textureAtlas", "textureArrays", "upload", "textureResidency", "hotReload" e "simulation"
+	static void compileOptions(const json& j, SceneImageSettings& settings) {
+		if (j.contains("textureAtlas")) {
+			const auto& atlas = j["textureAtlas"];
+			settings.atlas.enabled = atlas.value("enabled", true);
+			settings.atlas.pageSize = atlas.value("pageSize", settings.atlas.pageSize);
+			settings.atlas.padding = atlas.value("padding", settings.atlas.padding);
+			settings.atlas.maxTextureSize = atlas.value("maxTextureSize", settings.atlas.maxTextureSize);
+		}
+		if (j.contains("textureArrays")) {
+			const auto& arrays = j["textureArrays"];
+			settings.textureArrays.enabled = arrays.value("enabled", true);
+			settings.textureArrays.width = arrays.value("width", settings.textureArrays.width);
+			settings.textureArrays.height = arrays.value("height", settings.textureArrays.height);
+		}
+		if (j.contains("upload")) {
+			const auto& upload = j["upload"];
+			settings.upload.enabled = upload.value("enabled", true);
+			settings.upload.ringSizeMB = upload.value("ringSizeMB", settings.upload.ringSizeMB);
+			settings.upload.frameBudgetMB = upload.value("frameBudgetMB", settings.upload.frameBudgetMB);
+		}
+		if (j.contains("textureResidency")) {
+			const auto& residency = j["textureResidency"];
+			settings.residency.enabled = residency.value("enabled", true);
+			settings.residency.budgetMB = residency.value("budgetMB", settings.residency.budgetMB);
+			settings.residency.tailSize = residency.value("tailSize", settings.residency.tailSize);
+		}
+		if (j.contains("hotReload")) {
+			const auto& hotReload = j["hotReload"];
+			settings.hotReload.enabled = hotReload.value("enabled", true);
+			settings.hotReload.pollIntervalMs = hotReload.value("pollIntervalMs", settings.hotReload.pollIntervalMs);
+		}
+		if (j.contains("simulation")) {
+			const auto& simulation = j["simulation"];
+			settings.simulation.enabled = simulation.value("enabled", true);
+			settings.simulation.stepsPerSecond = std::max(1.0f, simulation.value("stepsPerSecond", settings.simulation.stepsPerSecond));
+			settings.simulation.maxStepsPerFrame = std::max(1, simulation.value("maxStepsPerFrame", settings.simulation.maxStepsPerFrame));
+		}
+		if (j.contains("gravity")) {
+			const auto& gravity = j["gravity"];
+			SceneGravityAux& aux = settings.gravity;
+			aux.enabled = gravity.value("enabled", true);
+			aux.circularVelocities = gravity.value("circularVelocities", aux.circularVelocities);
+			aux.G = gravity.value("G", aux.G);
+			aux.softening = std::max(0.0f, gravity.value("softening", aux.softening));
+			aux.theta = std::max(0.0f, gravity.value("theta", aux.theta));
+			aux.directLimit = std::max(0, gravity.value("directLimit", aux.directLimit));
+			aux.substeps = std::max(1, gravity.value("substeps", aux.substeps));
+			if (gravity.contains("asteroids")) {
+				const auto& asteroids = gravity["asteroids"];
+				aux.asteroids = std::max(0, asteroids.value("count", 0));
+				aux.asteroidInnerRadius = asteroids.value("innerRadius", aux.asteroidInnerRadius);
+				aux.asteroidOuterRadius = asteroids.value("outerRadius", aux.asteroidOuterRadius);
+				aux.asteroidThickness = asteroids.value("thickness", aux.asteroidThickness);
+				aux.asteroidMass = std::max(0.0f, asteroids.value("mass", aux.asteroidMass));
+				aux.asteroidSeed = asteroids.value("seed", aux.asteroidSeed);
+			}
+		}
+		if (j.contains("orbitBelt")) {
+			const auto& belt = j["orbitBelt"];
+			SceneOrbitBeltAux& aux = settings.orbitBelt;
+			aux.count = belt.value("enabled", true) ? std::max(0, belt.value("count", 0)) : 0;
+			aux.around = belt.value("around", aux.around);
+			aux.innerRadius = belt.value("innerRadius", aux.innerRadius);
+			aux.outerRadius = belt.value("outerRadius", aux.outerRadius);
+			aux.maxEccentricity = belt.value("maxEccentricity", aux.maxEccentricity);
+			aux.maxInclination = belt.value("maxInclination", aux.maxInclination);
+			aux.mu = belt.value("mu", aux.mu);
+			aux.seed = belt.value("seed", aux.seed);
+		}
+		if (j.contains("impostors")) {
+			const auto& impostors = j["impostors"];
+			settings.impostors.enabled = impostors.value("enabled", true);
+			settings.impostors.maxPixels = std::max(0.0f, impostors.value("maxPixels", settings.impostors.maxPixels));
+		}
+		if (j.contains("pointLights")) {
+			const auto& lights = j["pointLights"];
+			ScenePointLightAux& aux = settings.pointLights;
+			aux.clustered = lights.value("clustered", aux.clustered);
+			aux.tilesX = std::max(1, lights.value("tilesX", aux.tilesX));
+			aux.tilesY = std::max(1, lights.value("tilesY", aux.tilesY));
+			aux.slices = std::max(1, lights.value("slices", aux.slices));
+			if (lights.contains("ring")) {
+				const auto& ring = lights["ring"];
+				aux.ringCount = ring.value("enabled", true) ? std::max(0, ring.value("count", 0)) : 0;
+				aux.ringInnerRadius = ring.value("innerRadius", aux.ringInnerRadius);
+				aux.ringOuterRadius = ring.value("outerRadius", aux.ringOuterRadius);
+				aux.ringThickness = ring.value("thickness", aux.ringThickness);
+				aux.ringRadius = std::max(0.0f, ring.value("radius", aux.ringRadius));
+				aux.ringIntensity = std::max(0.0f, ring.value("intensity", aux.ringIntensity));
+				aux.ringSeed = ring.value("seed", aux.ringSeed);
+			}
+		}
+		if (j.contains("shadows")) {
+			const auto& shadows = j["shadows"];
+			SceneShadowAux& aux = settings.shadows;
+			aux.enabled = shadows.value("enabled", true);
+			aux.cacheStatic = shadows.value("cacheStatic", aux.cacheStatic);
+			aux.size = std::max(16, shadows.value("size", aux.size));
+			aux.staticFrames = std::max(1, shadows.value("staticFrames", aux.staticFrames));
+			aux.nearPlane = std::max(1e-3f, shadows.value("nearPlane", aux.nearPlane));
+			aux.farPlane = std::max(aux.nearPlane * 2.0f, shadows.value("farPlane", aux.farPlane));
+			aux.bias = shadows.value("bias", aux.bias);
+		}
+	}
+};
\ No newline at end of file
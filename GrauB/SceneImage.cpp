@@ -0,0 +1,400 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory_resource>
+#include <cstring>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "VirtualFileSystem.cpp"
+
+using namespace std;
+
+// rbita kepleriana fixa de um objeto ("orbit" no Scene.json), em torno do objeto com transfObjectId around (-1: em
+// torno da posio do prprio objeto no Scene.json). ngulos em graus e perodo em segundos; sem semiMajorAxis no h rbita.
+struct SceneOrbitAux {
+	int32_t around = -1;
+	float semiMajorAxis = 0.0f, eccentricity = 0.0f, inclination = 0.0f, ascendingNode = 0.0f, periapsis = 0.0f, phase = 0.0f,
+		period = 0.0f;
+};
+
+// Emissor de partculas preso a um objeto ("particles" no Scene.json): at maxParticles vivas, rate novas por segundo,
+// durando cerca de life segundos. Nascem a radius do centro do objeto e saem com velocidade speed na direo direction
+// (zero: para fora do objeto) ou, com awayFrom, para longe do objeto com esse transfObjectId (a cauda de um cometa),
+// espalhadas por spread; drag  a frao da velocidade perdida por segundo. Sem maxParticles no h emissor.
+struct SceneParticleAux {
+	int32_t maxParticles = 0, awayFrom = -1;
+	float rate = 0.0f, life = 1.0f, speed = 1.0f, spread = 0.2f, radius = 0.0f, size = 0.5f, drag = 0.0f;
+	float direction[3] = {}, color[3] = { 1.0f, 1.0f, 1.0f };
+	uint32_t seed = 1;
+};
+
+// Luz pontual presa a um objeto ("light" no Scene.json): ilumina at radius do centro do objeto, com a cor
+// multiplicada por intensity. Sem radius no h luz.
+struct SceneLightAux {
+	float radius = 0.0f, intensity = 1.0f;
+	float color[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+struct SceneObjAux {
+	int transfObjectId = -1;
+	float x, y, z, scale, rotateSpeed = 10.0;
+	bool curveEnable = false;
+	string objFilePath, rotate;
+	vector <glm::vec3> curvePoints;
+	// Massa e velocidade inicial na simulao gravitacional (sem massa o objeto no participa dela)
+	float mass = 0.0f;
+	glm::vec3 velocity = glm::vec3(0.0f);
+	SceneOrbitAux orbit;
+	SceneParticleAux particles;
+	SceneLightAux light;
+	// Entra no mapa de sombra da luz principal
+	bool castShadows = true;
+};
+
+// Configurao opcional do atlas de texturas ("textureAtlas" no Scene.json)
+struct SceneAtlasAux {
+	bool enabled = false;
+	int pageSize = 2048, padding = 4, maxTextureSize = 512;
+};
+
+// Configurao opcional das texturas de array ("textureArrays" no Scene.json); width e height
+// definem o tamanho comum para o qual as imagens so reamostradas (0 agrupa s imagens de mesmo tamanho)
+struct SceneTextureArrayAux {
+	bool enabled = false;
+	int width = 0, height = 0;
+};
+
+// Configurao opcional do envio em segundo plano ("upload" no Scene.json): tamanho do anel de staging
+// e quantos bytes podem ser enviados por quadro, em MB
+struct SceneUploadAux {
+	bool enabled = false;
+	float ringSizeMB = 32.0f, frameBudgetMB = 4.0f;
+};
+
+// Configurao opcional do gerenciador de residncia de texturas ("textureResidency" no Scene.json): oramento
+// de memria de vdeo em MB e o tamanho, em pixels, a partir do qual os mipmaps ficam sempre carregados.
+// Com ele ligado o atlas e as texturas de array no so montados, j que os nveis so controlados por textura.
+struct SceneResidencyAux {
+	bool enabled = false;
+	float budgetMB = 64.0f;
+	int tailSize = 128;
+};
+
+// Configurao opcional da recarga automtica ("hotReload" no Scene.json): com ela ligada, mudanas no Scene.json,
+// nas malhas, nos MTL, nas texturas e nos shaders so aplicadas com o programa aberto. pollIntervalMs  o
+// intervalo de verificao dos arquivos nos sistemas sem inotify.
+struct SceneHotReloadAux {
+	bool enabled = false;
+	int pollIntervalMs = 250;
+};
+
+// Configurao opcional da simulao ("simulation" no Scene.json): a animao, as curvas e a cmera andam em passos
+// fixos de 1/stepsPerSecond s; com ela ligada os passos rodam numa thread prpria, em paralelo ao desenho, e sem ela
+// na thread principal antes de cada quadro. maxStepsPerFrame limita os passos atrasados feitos de uma vez.
+struct SceneSimulationAux {
+	bool enabled = false;
+	float stepsPerSecond = 60.0f;
+	int maxStepsPerFrame = 5;
+};
+
+// Configurao opcional da gravitao ("gravity" no Scene.json): os objetos com "mass" se atraem com constante G;
+// softening amortece a fora a curta distncia, theta  o critrio de abertura das clulas do Barnes-Hut e
+// directLimit o nmero de corpos com massa at o qual a soma  direta. Com circularVelocities os objetos com massa e
+// sem velocidade comeam em rbita circular em torno do mais pesado. asteroids cria um cinturo em torno dele entre
+// asteroidInnerRadius e asteroidOuterRadius (massa asteroidMass cada, 0 para partculas de teste), desenhado como pontos.
+struct SceneGravityAux {
+	bool enabled = false, circularVelocities = true;
+	float G = 1.0f, softening = 0.05f, theta = 0.5f;
+	int directLimit = 2048, substeps = 1;
+	int asteroids = 0;
+	float asteroidInnerRadius = 0.0f, asteroidOuterRadius = 0.0f, asteroidThickness = 1.0f, asteroidMass = 0.0f;
+	uint32_t asteroidSeed = 1;
+};
+
+// Configurao opcional do cinturo de rbitas fixas ("orbitBelt" no Scene.json): count rbitas em torno do objeto
+// com transfObjectId around (-1: a origem), com semi-eixo entre innerRadius e outerRadius, excentricidade e inclinao
+// (graus) sorteadas at maxEccentricity e maxInclination e perodo pela terceira lei de Kepler com mu = G * massa.
+// As posies so calculadas a cada passo pelo tempo, sem simulao, e desenhadas como pontos.
+struct SceneOrbitBeltAux {
+	int count = 0, around = -1;
+	float innerRadius = 0.0f, outerRadius = 0.0f, maxEccentricity = 0.1f, maxInclination = 2.0f, mu = 1000.0f;
+	uint32_t seed = 1;
+};
+
+// Configurao opcional dos impostores ("impostors" no Scene.json): as esferas geradas (Primitives) com menos de
+// maxPixels de dimetro na tela so desenhadas como um quadrado, com a esfera calculada no fragment shader.
+// Vale tambm na recarga, sem reiniciar.
+struct SceneImpostorAux {
+	bool enabled = false;
+	float maxPixels = 16.0f;
+};
+
+// Configurao opcional das luzes pontuais ("pointLights" no Scene.json), alm das dos objetos com "light": ring cria
+// ringCount luzes sorteadas num anel em torno da origem, entre ringInnerRadius e ringOuterRadius, com raio ringRadius.
+// Com clustered as luzes so distribudas a cada quadro em tilesX x tilesY x slices aglomerados sobre o frustum da
+// cmera e cada fragmento s calcula as do seu aglomerado; sem ele, todas. Vale tambm na recarga, sem reiniciar.
+struct ScenePointLightAux {
+	bool clustered = true;
+	int tilesX = 16, tilesY = 9, slices = 24;
+	int ringCount = 0;
+	float ringInnerRadius = 0.0f, ringOuterRadius = 0.0f, ringThickness = 1.0f, ringRadius = 5.0f, ringIntensity = 1.0f;
+	uint32_t ringSeed = 1;
+};
+
+// Configurao opcional da sombra da luz principal ("shadows" no Scene.json): mapa cbico de size x size por face,
+// com a projeo entre nearPlane e farPlane, e bias somado na comparao. Com cacheStatic os objetos parados h
+// staticFrames quadros ficam num mapa guardado e s os que se movem so desenhados a cada quadro. Vale tambm na
+// recarga, sem reiniciar.
+struct SceneShadowAux {
+	bool enabled = false, cacheStatic = true;
+	int size = 1024, staticFrames = 30;
+	float nearPlane = 0.5f, farPlane = 200.0f, bias = 0.0005f;
+};
+
+struct SceneCameraAux {
+	float fov, nearPlane, farPlane, positionX, positionY, positionZ,
+		frontDirectionX, frontDirectionY, frontDirectionZ,
+		upDirectionX, upDirectionY, upDirectionZ;
+};
+
+// Tudo o que a cena compilada guarda alm dos objetos: cmera, luz e os blocos opcionais do Scene.json
+struct SceneImageSettings {
+	static const uint32_t hasCamera = 1, hasCameraPosition = 2, hasCameraFront = 4, hasCameraUp = 8, hasLight = 16, hasCompression = 32;
+
+	uint32_t flags = 0;
+	SceneCameraAux camera = {};
+	float lightPosition[3] = {}, lightColor[3] = {};
+	uint32_t compressionFormat = 0xFFFFFFFF;	// ndice do formato na tabela de nomes
+	SceneAtlasAux atlas;
+	SceneTextureArrayAux textureArrays;
+	SceneUploadAux upload;
+	SceneResidencyAux residency;
+	SceneHotReloadAux hotReload;
+	SceneSimulationAux simulation;
+	SceneGravityAux gravity;
+	SceneOrbitBeltAux orbitBelt;
+	SceneImpostorAux impostors;
+	ScenePointLightAux pointLights;
+	SceneShadowAux shadows;
+};
+
+// Registro de um objeto na cena compilada; os nomes so ndices na tabela de nomes e os pontos da curva
+// ficam numa lista nica, referenciada por incio e quantidade
+struct SceneImageObject {
+	static const uint32_t curveEnable = 1, noShadows = 2, noString = 0xFFFFFFFF;
+
+	int32_t transfObjectId;
+	float x, y, z, scale, rotateSpeed;
+	uint32_t flags;
+	uint32_t objFilePath, rotate;
+	uint32_t firstCurvePoint, numCurvePoints;
+	float mass, velocity[3];
+	SceneOrbitAux orbit;
+	SceneParticleAux particles;
+	SceneLightAux light;
+};
+
+// Cena compilada a partir do Scene.json ("Scene.json.gbscene"), usada direto da memria mapeada:
+//   cabealho (32 bytes): "GBSC", verso, nmero de objetos, de pontos de curva e de nomes, tamanho dos nomes
+//     e os tamanhos das estruturas de configurao e de objeto (um cache gravado com outro layout  recompilado)
+//   configurao, registros dos objetos, pontos das curvas (vec3) e tabela de nomes (deslocamento e tamanho),
+//   cada seo alinhada em 16 bytes, e por fim os caracteres dos nomes
+class SceneImage
+{
+public:
+	static const uint32_t version = 7;
+
+	SceneImage() {}
+
+	SceneImage(const SceneImage&) = delete;
+	SceneImage& operator=(const SceneImage&) = delete;
+
+	// Mapeia um arquivo j compilado (do pacote de assets ou do disco)
+	bool open(const string& filepath) {
+		close();
+		if (!file.open(filepath))
+			return false;
+		if (!setData(file.data(), file.size())) {
+			std::cerr << "Cena compilada invlida ou de outra verso: " << filepath << std::endl;
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	// Usa uma cena compilada em memria (quando o cache ainda no existia)
+	bool load(vector<unsigned char>&& image) {
+		close();
+		buffer = std::move(image);
+		if (!setData(buffer.data(), buffer.size())) {
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void close() {
+		file.close();
+		buffer.clear();
+		buffer.shrink_to_fit();
+		bytes = nullptr;
+		length = 0;
+		numObjects = numCurvePoints = numStrings = 0;
+	}
+
+	bool isOpen() const {
+		return bytes != nullptr;
+	}
+
+	size_t size() const {
+		return length;
+	}
+
+	const SceneImageSettings& getSettings() const {
+		return *settings;
+	}
+
+	int getNumObjects() const {
+		return (int)numObjects;
+	}
+
+	const SceneImageObject& getObject(int index) const {
+		return objects[index];
+	}
+
+	const glm::vec3* getCurvePoints(const SceneImageObject& object) const {
+		return curvePoints + object.firstCurvePoint;
+	}
+
+	string getString(uint32_t index) const {
+		if (index == SceneImageObject::noString)
+			return "";
+		return string(strings + stringTable[index * 2], stringTable[index * 2 + 1]);
+	}
+
+	// Objeto no formato usado pela Scene para criar o SceneObj
+	SceneObjAux getObjectAux(int index) const {
+		const SceneImageObject& object = objects[index];
+		SceneObjAux objAux;
+		objAux.transfObjectId = object.transfObjectId;
+		objAux.x = object.x;
+		objAux.y = object.y;
+		objAux.z = object.z;
+		objAux.scale = object.scale;
+		objAux.rotateSpeed = object.rotateSpeed;
+		objAux.curveEnable = (object.flags & SceneImageObject::curveEnable) != 0;
+		objAux.castShadows = (object.flags & SceneImageObject::noShadows) == 0;
+		objAux.objFilePath = getString(object.objFilePath);
+		objAux.rotate = getString(object.rotate);
+		objAux.curvePoints.assign(getCurvePoints(object), getCurvePoints(object) + object.numCurvePoints);
+		objAux.mass = object.mass;
+		objAux.velocity = glm::vec3(object.velocity[0], object.velocity[1], object.velocity[2]);
+		objAux.orbit = object.orbit;
+		objAux.particles = object.particles;
+		objAux.light = object.light;
+		return objAux;
+	}
+
+	// Monta a imagem a partir das partes j convertidas (usado pelo compilador da cena); os temporrios usam
+	// a mesma memria que objects
+	static vector<unsigned char> build(const SceneImageSettings& settings, const std::pmr::vector<SceneImageObject>& objects,
+		const std::pmr::vector<glm::vec3>& curvePoints, const std::pmr::vector<string>& names) {
+		std::pmr::string characters(objects.get_allocator().resource());
+		std::pmr::vector<uint32_t> table(objects.get_allocator().resource());
+		for (const auto& name : names) {
+			table.push_back((uint32_t)characters.size());
+			table.push_back((uint32_t)name.size());
+			characters += name;
+		}
+
+		uint32_t header[8] = { 0, version, (uint32_t)objects.size(), (uint32_t)curvePoints.size(), (uint32_t)names.size(),
+			(uint32_t)characters.size(), (uint32_t)sizeof(SceneImageSettings), (uint32_t)sizeof(SceneImageObject) };
+		memcpy(header, magic, 4);
+		Layout layout = getLayout(header);
+
+		vector<unsigned char> image(layout.total, 0);
+		memcpy(image.data(), header, sizeof(header));
+		memcpy(image.data() + layout.settings, &settings, sizeof(settings));
+		if (!objects.empty())
+			memcpy(image.data() + layout.objects, objects.data(), objects.size() * sizeof(SceneImageObject));
+		if (!curvePoints.empty())
+			memcpy(image.data() + layout.curvePoints, curvePoints.data(), curvePoints.size() * sizeof(glm::vec3));
+		if (!table.empty())
+			memcpy(image.data() + layout.stringTable, table.data(), table.size() * sizeof(uint32_t));
+		memcpy(image.data() + layout.strings, characters.data(), characters.size());
+		return image;
+	}
+
+private:
+	static constexpr char magic[4] = { 'G', 'B', 'S', 'C' };
+	static const size_t headerSize = 32;
+
+	struct Layout {
+		size_t settings, objects, curvePoints, stringTable, strings, total;
+	};
+
+	VirtualFile file;
+	vector<unsigned char> buffer;
+	const unsigned char* bytes = nullptr;
+	size_t length = 0;
+	uint32_t numObjects = 0, numCurvePoints = 0, numStrings = 0;
+	const SceneImageSettings* settings = nullptr;
+	const SceneImageObject* objects = nullptr;
+	const glm::vec3* curvePoints = nullptr;
+	const uint32_t* stringTable = nullptr;
+	const char* strings = nullptr;
+
+	static size_t align(size_t offset) {
+		return (offset + 15) & ~(size_t)15;
+	}
+
+	static Layout getLayout(const uint32_t header[8]) {
+		Layout layout;
+		layout.settings = headerSize;
+		layout.objects = align(layout.settings + sizeof(SceneImageSettings));
+		layout.curvePoints = align(layout.objects + (size_t)header[2] * sizeof(SceneImageObject));
+		layout.stringTable = align(layout.curvePoints + (size_t)header[3] * sizeof(glm::vec3));
+		layout.strings = layout.stringTable + (size_t)header[4] * 2 * sizeof(uint32_t);
+		layout.total = layout.strings + header[5];
+		return layout;
+	}
+
+	// Confere o cabealho e todos os ndices uma vez; depois disso os registros so lidos sem verificao
+	bool setData(const unsigned char* data, size_t size) {
+		uint32_t header[8];
+		if (size < headerSize || memcmp(data, magic, 4) != 0)
+			return false;
+		memcpy(header, data, sizeof(header));
+		if (header[1] != version || header[6] != sizeof(SceneImageSettings) || header[7] != sizeof(SceneImageObject))
+			return false;
+		Layout layout = getLayout(header);
+		if (layout.total > size)
+			return false;
+
+		numObjects = header[2];
+		numCurvePoints = header[3];
+		numStrings = header[4];
+		settings = (const SceneImageSettings*)(data + layout.settings);
+		objects = (const SceneImageObject*)(data + layout.objects);
+		curvePoints = (const glm::vec3*)(data + layout.curvePoints);
+		stringTable = (const uint32_t*)(data + layout.stringTable);
+		strings = (const char*)(data + layout.strings);
+
+		for (uint32_t i = 0; i < numStrings; ++i)
+			if (stringTable[i * 2] > header[5] || stringTable[i * 2 + 1] > header[5] - stringTable[i * 2])
+				return false;
+		if (settings->compressionFormat != SceneImageObject::noString && settings->compressionFormat >= numStrings)
+			return false;
+		for (uint32_t i = 0; i < numObjects; ++i) {
+			const SceneImageObject& object = objects[i];
+			if (object.objFilePath >= numStrings || (object.rotate != SceneImageObject::noString && object.rotate >= numStrings) ||
+				object.firstCurvePoint > numCurvePoints || object.numCurvePoints > numCurvePoints - object.firstCurvePoint)
+				return false;
+		}
+
+		bytes = data;
+		length = size;
+		return true;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include <memory_resource>
+#include <chrono>
+#include "SceneImage.cpp"
+#include "SceneObjInfo.cpp"
+#include "MaterialLibrary.cpp"
+#include "TextureLoader.cpp"
+#include "Bezier.cpp"
+#include "JobSystem.cpp"
+
+using namespace std;
+
+// Parte da carga da cena que no usa a OpenGL, feita em paralelo antes de criar os objetos: leitura (ou gerao,
+// para as primitivas) das malhas e dos MTL, decodificao das texturas e gerao das curvas. Cada arquivo  lido uma nica vez, mesmo que
+// vrios objetos o usem; depois a Scene cria os buffers e as texturas de uma vez na thread principal.
+class SceneLoader
+{
+private:
+	// Os ns das tabelas abaixo (um por arquivo) vm de blocos de tamanho fixo, devolvidos juntos com o SceneLoader
+	std::pmr::unsynchronized_pool_resource pool;
+
+public:
+	std::pmr::unordered_map<string, MeshData> meshes{ &pool };
+	std::pmr::unordered_map<string, shared_ptr<MaterialLibrary>> materials{ &pool };
+	std::pmr::unordered_map<string, TextureLoader::TextureSource> textures{ &pool };
+	// Tempo de cada etapa, em ms
+	double meshMs = 0, materialMs = 0, textureMs = 0, curveMs = 0;
+
+	// Com decodeTextures falso as texturas ficam para o UploadManager ou o TextureResidency, que j as leem
+	// em segundo plano. prepareSource (chamado aqui na thread que chama load) consulta a OpenGL quando h compresso.
+	void load(const SceneImage& image, JobSystem& jobs, bool decodeTextures)
+	{
+		PROFILE_ZONE("SceneLoader::load");
+		auto start = std::chrono::steady_clock::now();
+		vector<string> meshPaths;
+		for (int i = 0; i < image.getNumObjects(); ++i) {
+			string path = image.getString(image.getObject(i).objFilePath);
+			string extension = MeshLoader::getExtension(path);
+			if (extension != "glb" && extension != "gltf" && meshes.insert({ path, MeshData() }).second)
+				meshPaths.push_back(path);
+		}
+		vector<unsigned char> meshLoaded(meshPaths.size(), 0);
+		jobs.parallelFor((int)meshPaths.size(), 1, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i)
+				meshLoaded[i] = SceneObjInfo::readMesh(meshPaths[i], meshes.at(meshPaths[i]), &jobs);
+		});
+		// Malhas que no puderam ser lidas ficam para o construtor do SceneObjInfo, que avisa do erro
+		for (size_t i = 0; i < meshPaths.size(); ++i)
+			if (!meshLoaded[i])
+				meshes.erase(meshPaths[i]);
+		meshMs = elapsedMs(start);
+
+		start = std::chrono::steady_clock::now();
+		vector<string> materialPaths;
+		for (const auto& mesh : meshes)
+			if (!materials.count(mesh.second.materialFileName)) {
+				materials[mesh.second.materialFileName] = nullptr;
+				materialPaths.push_back(mesh.second.materialFileName);
+			}
+		jobs.parallelFor((int)materialPaths.size(), 1, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i)
+				materials.at(materialPaths[i]) = MaterialLibrary::read(materialPaths[i]);
+		});
+		materialMs = elapsedMs(start);
+
+		start = std::chrono::steady_clock::now();
+		if (decodeTextures)
+			loadTextures(jobs);
+		textureMs = elapsedMs(start);
+
+		start = std::chrono::steady_clock::now();
+		loadCurves(image, jobs);
+		curveMs = elapsedMs(start);
+	}
+
+	// Curva j gerada do objeto (nullptr se ele no tem curva)
+	Bezier* findCurve(int object)
+	{
+		auto found = std::lower_bound(curveObjects.begin(), curveObjects.end(), object);
+		return found != curveObjects.end() && *found == object ? &curves[found - curveObjects.begin()] : nullptr;
+	}
+
+	double getTotalMs() const {
+		return meshMs + materialMs + textureMs + curveMs;
+	}
+
+private:
+	vector<int> curveObjects;
+	vector<Bezier> curves;
+
+	void loadTextures(JobSystem& jobs)
+	{
+		vector<string> texturePaths;
+		for (const auto& material : materials)
+			for (const auto& path : material.second->diffuseMaps)
+				if (!path.empty() && textures.insert({ path, TextureLoader::TextureSource() }).second)
+					texturePaths.push_back(path);
+
+		for (const auto& path : texturePaths)
+			if (!TextureLoader::prepareSource(path, textures.at(path)))
+				textures.erase(path);
+		texturePaths.erase(std::remove_if(texturePaths.begin(), texturePaths.end(),
+			[this](const string& path) { return !textures.count(path); }), texturePaths.end());
+
+		vector<unsigned char> decoded(texturePaths.size(), 0);
+		jobs.parallelFor((int)texturePaths.size(), 1, [&](int begin, int end) {
+			for (int i = begin; i < end; ++i)
+				decoded[i] = TextureLoader::readSource(texturePaths[i], textures.at(texturePaths[i]));
+		});
+		// Texturas que falharam so tentadas de novo por loadTexture, que avisa do erro
+		for (size_t i = 0; i < texturePaths.size(); ++i)
+			if (!decoded[i])
+				textures.erase(texturePaths[i]);
+	}
+
+	void loadCurves(const SceneImage& image, JobSystem& jobs)
+	{
+		for (int i = 0; i < image.getNumObjects(); ++i)
+			if (image.getObject(i).numCurvePoints > 0)
+				curveObjects.push_back(i);
+		curves.resize(curveObjects.size());
+		jobs.parallelFor((int)curveObjects.size(), 0, [&](int begin, int end) {
+			for (int c = begin; c < end; ++c) {
+				const SceneImageObject& object = image.getObject(curveObjects[c]);
+				const glm::vec3* points = image.getCurvePoints(object);
+				curves[c].setControlPoints(vector<glm::vec3>(points, points + object.numCurvePoints));
+				curves[c].generateCurvePoints(400);
+			}
+		});
+	}
+
+	static double elapsedMs(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+};
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 #include "../Common/include/Shader.h"
 #include "Bezier.cpp"
+#include "Profiler.cpp"
 
 using namespace std; 
 
@@ -12,15 +13,42 @@ public:
 	vector <glm::vec3> curvePoints;
 	SceneObjInfo sceneObjInfo;
 	Bezier curveBezier = Bezier();
-	int transfObjectId, nbCurve, iPoint;
+	int transfObjectId, nbCurve = 0, iPoint = 0;
 	bool playCurve;
-	string rotate;
+	// Eixo da rotao contnua: 'x', 'y', 'z' ou 0 (sem rotao); um char evita comparar strings a cada passo
+	char rotate = 0;
+	// Desenhado por um InstancedBatch da cena em vez de renderObject
+	bool instanced = false;
+	// Posio do objeto na lista "objects" do Scene.json (um GLB gera vrios SceneObj com o mesmo ndice)
+	int sceneIndex = -1;
+	// Massa e velocidade inicial do Scene.json; body  o corpo do objeto na gravitao da cena (-1 se no tem)
+	float mass = 0;
+	glm::vec3 velocity = glm::vec3(0);
+	int body = -1;
+	// Entra no mapa de sombra da luz principal ("castShadows" no Scene.json)
+	bool castShadows = true;
+	// Identificador que no muda quando a lista de objetos cresce ou  reordenada (ao contrrio de ponteiros
+	// e ndices); um objeto recriado pela recarga ganha outro
+	int handle = nextHandle++;
+	// Chamadas de desenho e tringulos do quadro atual, de todos os objetos (zerados em beginFrame)
+	inline static int drawCalls = 0;
+	inline static size_t triangles = 0;
 
 	SceneObj(float x, float y, float z, string objFilePath, Shader* shader, int transfObjectId = -1, vector <glm::vec3> curvePoints = {}, bool curveEnable = false,
 		glm::vec3 scale = glm::vec3(1.0, 1.0, 1.0), string rotate = "", float rotateSpeed = 10, float rotationAngle = 0.0, glm::vec3 rotationAxis = glm::vec3(0.0, 0.0, 1.0),
 		float translationSpeed = 0.05)
-		: x(x), y(y), z(z), objFilePath(objFilePath), sceneObjInfo(objFilePath), shader(shader), transfObjectId(transfObjectId), curvePoints(curvePoints), playCurve(curveEnable),
-		scale(scale), rotate(rotate), rotateSpeed(rotateSpeed), rotationAngle(rotationAngle), rotationAxis(rotationAxis), translationSpeed(translationSpeed)
+		: SceneObj(x, y, z, SceneObjInfo(objFilePath), glm::mat4(1), shader, transfObjectId, curvePoints, curveEnable, scale, rotate, rotateSpeed,
+			rotationAngle, rotationAxis, translationSpeed)
+	{
+	}
+
+	// Objeto com a malha j carregada (ex.: primitiva de um GLB), posicionado pela transformao do seu n
+	SceneObj(float x, float y, float z, const SceneObjInfo& sceneObjInfo, glm::mat4 nodeTransform, Shader* shader, int transfObjectId = -1,
+		vector <glm::vec3> curvePoints = {}, bool curveEnable = false, glm::vec3 scale = glm::vec3(1.0, 1.0, 1.0), string rotate = "",
+		float rotateSpeed = 10, float rotationAngle = 0.0, glm::vec3 rotationAxis = glm::vec3(0.0, 0.0, 1.0), float translationSpeed = 0.05)
+		: x(x), y(y), z(z), objFilePath(sceneObjInfo.getObjFilePath()), sceneObjInfo(sceneObjInfo), nodeTransform(nodeTransform), shader(shader),
+		transfObjectId(transfObjectId), curvePoints(curvePoints), playCurve(curveEnable), scale(scale), rotate(parseRotate(rotate)), rotateSpeed(rotateSpeed),
+		rotationAngle(rotationAngle), rotationAxis(rotationAxis), translationSpeed(translationSpeed)
 	{
 		this->position = glm::vec3(x, y, z);
 
@@ -28,13 +56,57 @@ public:
 			setBezierCurve();
 	}
 
+	// "x", "y" ou "z" do Scene.json; qualquer outro valor desliga a rotao
+	static char parseRotate(const string& rotate) {
+		return rotate == "x" || rotate == "y" || rotate == "z" ? rotate[0] : 0;
+	}
+
+	// S pode ser movido: a cpia duplicaria a curva e os pontos de controle sem necessidade
+	SceneObj(SceneObj&&) = default;
+	SceneObj& operator=(SceneObj&&) = default;
+	SceneObj(const SceneObj&) = delete;
+	SceneObj& operator=(const SceneObj&) = delete;
+
 	void setBezierCurve() {
+		Bezier curve;
+		curve.setControlPoints(curvePoints);
+		curve.generateCurvePoints(400);
+		setBezierCurve(curvePoints, std::move(curve));
+	}
+
+	// Usa uma curva cujos pontos j foram gerados (em outra thread, na carga da cena); s cria os buffers dela
+	void setBezierCurve(const vector<glm::vec3>& controlPoints, Bezier&& curve) {
+		curvePoints = controlPoints;
+		curveBezier = std::move(curve);
 		curveBezier.setShader(shader);
-		curveBezier.setControlPoints(curvePoints);
-		curveBezier.generateCurve(400);
+		curveBezier.createBuffers();
 		nbCurve = curveBezier.getNbCurvePoints();
 	}
 
+	// Troca o que veio do Scene.json mantendo a malha j carregada (recarga da cena)
+	void setSceneProperties(float x, float y, float z, int transfObjectId, const vector<glm::vec3>& curvePoints, bool curveEnable,
+		glm::vec3 scale, const string& rotate, float rotateSpeed)
+	{
+		this->x = x;
+		this->y = y;
+		this->z = z;
+		this->position = glm::vec3(x, y, z);
+		this->transfObjectId = transfObjectId;
+		this->playCurve = curveEnable;
+		this->scale = scale;
+		this->rotate = parseRotate(rotate);
+		this->rotateSpeed = rotateSpeed;
+		if (this->rotate == 0)
+			this->rotationAngle = 0.0f;
+		if (curvePoints != this->curvePoints) {
+			this->curvePoints = curvePoints;
+			this->iPoint = 0;
+			this->nbCurve = 0;
+			if (!curvePoints.empty())
+				setBezierCurve();
+		}
+	}
+
 	void updateScale(const float scaleFactor)
 	{
 		this->scale.x += scaleFactor;
@@ -48,7 +120,12 @@ public:
 		model = glm::translate(model, position);
 		model = glm::rotate(model, glm::radians(rotationAngle), rotationAxis);
 		model = glm::scale(model, scale);
-		shader->setMat4("model", glm::value_ptr(model));
+		modelMatrix = model * nodeTransform;
+	}
+
+	const glm::mat4& getModelMatrix() const
+	{
+		return modelMatrix;
 	}
 
 	void updatePosition(glm::vec3 newPosition)
@@ -56,31 +133,140 @@ public:
 		this->position = newPosition;
 	}
 
+	const glm::vec3& getPosition() const
+	{
+		return position;
+	}
+
+	// Posio dada no Scene.json (a atual pode ter sido mudada pela simulao)
+	glm::vec3 getScenePosition() const
+	{
+		return glm::vec3(x, y, z);
+	}
+
+	// Desenha uma sub-malha por material; texturas e materiais iguais aos do desenho anterior no so religados
 	void renderObject() const
 	{
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, sceneObjInfo.textureId);
+		renderObject(modelMatrix);
+	}
+
+	// Desenha com a matriz de modelo de uma cpia da simulao (a do objeto pode estar sendo alterada por ela)
+	void renderObject(glm::mat4 model) const
+	{
+		PROFILE_ZONE("SceneObj::renderObject");
+		if (!isUploaded())
+			return;
+		shader->setMat4("model", glm::value_ptr(model));
 		glBindVertexArray(sceneObjInfo.VAO);
-		glDrawArrays(GL_TRIANGLES, 0, sceneObjInfo.numVertices);
+		for (const auto& subMesh : sceneObjInfo.subMeshes) {
+			useMaterial(shader, sceneObjInfo.materialLibrary.get(), subMesh.material);
+			countDraw(sceneObjInfo.drawMode, subMesh.count);
+			if (sceneObjInfo.indexType != 0)
+				glDrawElements(sceneObjInfo.drawMode, subMesh.count, sceneObjInfo.indexType,
+					(GLvoid*)(sceneObjInfo.indexOffset + subMesh.first * getIndexSize(sceneObjInfo.indexType)));
+			else
+				glDrawArrays(sceneObjInfo.drawMode, subMesh.first, subMesh.count);
+		}
 		glBindVertexArray(0);
+	}
+
+	// S a geometria, para o mapa de sombra: shader  o do ShadowMap e nenhum material  aplicado. Fica fora de
+	// drawCalls e triangles (que so os da cena); retorna os tringulos desenhados, para os contadores do ShadowMap.
+	size_t renderDepth(const Shader* shader, glm::mat4 model) const
+	{
+		if (!isUploaded())
+			return 0;
+		size_t drawn = 0;
+		shader->setMat4("model", glm::value_ptr(model));
+		glBindVertexArray(sceneObjInfo.VAO);
+		for (const auto& subMesh : sceneObjInfo.subMeshes) {
+			drawn += countTriangles(sceneObjInfo.drawMode, subMesh.count);
+			if (sceneObjInfo.indexType != 0)
+				glDrawElements(sceneObjInfo.drawMode, subMesh.count, sceneObjInfo.indexType,
+					(GLvoid*)(sceneObjInfo.indexOffset + subMesh.first * getIndexSize(sceneObjInfo.indexType)));
+			else
+				glDrawArrays(sceneObjInfo.drawMode, subMesh.first, subMesh.count);
+		}
+		glBindVertexArray(0);
+		return drawn;
+	}
+
+	bool isUploaded() const
+	{
+		return sceneObjInfo.uploaded == nullptr || *sceneObjInfo.uploaded;
+	}
+
+	// Esquece o estado de material e textura do quadro anterior (chamado no incio de cada quadro)
+	static void beginFrame()
+	{
+		drawCalls = 0;
+		triangles = 0;
+		appliedLibrary = nullptr;
+		appliedMaterial = -1;
+		boundTextureId = 0;
+		boundArrayId = 0;
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, 0);
 	}
 
-	void rotateX()
+	static void countDraw(GLenum drawMode, GLsizei count, GLsizei instances = 1)
 	{
-		this->rotationAngle = (GLfloat)glfwGetTime() * rotateSpeed;
+		drawCalls++;
+		triangles += countTriangles(drawMode, count) * instances;
+	}
+
+	// Tringulos de uma chamada com count vrtices (ou ndices)
+	static size_t countTriangles(GLenum drawMode, GLsizei count)
+	{
+		if (drawMode == GL_TRIANGLES)
+			return (size_t)(count / 3);
+		if ((drawMode == GL_TRIANGLE_STRIP || drawMode == GL_TRIANGLE_FAN) && count > 2)
+			return (size_t)(count - 2);
+		return 0;
+	}
+
+	// Envia o material e liga a sua textura (2D na unidade 0, de array na unidade 1), pulando o que j est aplicado
+	static void useMaterial(const Shader* shader, const MaterialLibrary* library, int material)
+	{
+		if (library == appliedLibrary && material == appliedMaterial)
+			return;
+
+		library->applyMaterial(shader, material);
+		appliedLibrary = library;
+		appliedMaterial = material;
+
+		GLuint textureId = library->getTextureId(material);
+		if (library->getTextureLayer(material) >= 0) {
+			if (textureId != boundArrayId) {
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D_ARRAY, textureId);
+				glActiveTexture(GL_TEXTURE0);
+				boundArrayId = textureId;
+			}
+		}
+		else if (textureId != boundTextureId) {
+			glBindTexture(GL_TEXTURE_2D, textureId);
+			boundTextureId = textureId;
+		}
+	}
+
+	void rotateX(double time)
+	{
+		this->rotationAngle = (GLfloat)time * rotateSpeed;
 		this->rotationAxis = glm::vec3(1.0f, 0.0f, 0.0f);
 	}
 
-	void rotateY()
+	void rotateY(double time)
 	{
-		this->rotationAngle = (GLfloat)glfwGetTime() * rotateSpeed;
+		this->rotationAngle = (GLfloat)time * rotateSpeed;
 		this->rotationAxis = glm::vec3(0.0f, 1.0f, 0.0f);
 	}
 
-	void rotateZ()
+	void rotateZ(double time)
 	{
-		this->rotationAngle = (GLfloat)glfwGetTime() * rotateSpeed;
+		this->rotationAngle = (GLfloat)time * rotateSpeed;
 		this->rotationAxis = glm::vec3(0.0f, 0.0f, 1.0f);
 	}
 
@@ -105,8 +291,21 @@ private:
 
 	glm::vec3 position;
 	glm::vec3 scale;
+	glm::mat4 nodeTransform;
+	glm::mat4 modelMatrix = glm::mat4(1);
 	float rotationAngle;
 	glm::vec3 rotationAxis;
 	float translationSpeed, rotateSpeed;
 	Shader* shader;
+
+	inline static int nextHandle = 0;
+	inline static const MaterialLibrary* appliedLibrary = nullptr;
+	inline static int appliedMaterial = -1;
+	inline static GLuint boundTextureId = 0;
+	inline static GLuint boundArrayId = 0;
+
+	static size_t getIndexSize(GLenum indexType)
+	{
+		return indexType == GL_UNSIGNED_BYTE ? 1 : indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+	}
 };
\ No newline at end of file
@@ -4,6 +4,10 @@
 #include <string>
 #include <assert.h>
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <glad/glad.h>
@@ -11,123 +15,163 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "../Common/include/stb_image.h"
+#include "MeshLoader.cpp"
+#include "TextureLoader.cpp"
+#include "MaterialLibrary.cpp"
+#include "GLTFLoader.cpp"
+#include "Primitives.cpp"
+#include "Profiler.cpp"
 
 using namespace std;
 
+// Vrtices e materiais lidos do arquivo de malha, antes de irem para a GPU (a leitura pode ser feita em outra thread)
+struct MeshData {
+	vector<GLfloat> vbuffer;
+	// S as primitivas geradas so indexadas; os arquivos so lidos j com os vrtices repetidos por tringulo
+	vector<GLuint> indices;
+	string materialFileName;
+	vector<MaterialRange> materialRanges;
+};
+
 class SceneObjInfo {
 public:
+	// Identifica o contedo de uma malha: dois hashes de 64 bits independentes e os tamanhos dos vrtices e ndices
+	struct MeshKey {
+		uint64_t hash = 0, hash2 = 0;
+		size_t vertexBytes = 0, indexBytes = 0;
+
+		bool operator==(const MeshKey& other) const {
+			return hash == other.hash && hash2 == other.hash2 && vertexBytes == other.vertexBytes && indexBytes == other.indexBytes;
+		}
+	};
+
+	struct MeshKeyHash {
+		size_t operator()(const MeshKey& key) const {
+			return (size_t)key.hash;
+		}
+	};
+
+	// Objetos da OpenGL de uma malha, apagados quando o ltimo SceneObjInfo que os usa  destrudo
+	struct MeshBuffers {
+		vector<GLuint> vertexArrays, buffers;
+		shared_ptr<bool> uploaded;
+		MeshKey key;
+		bool shared = false;
+
+		MeshBuffers() {}
+
+		MeshBuffers(const MeshBuffers&) = delete;
+		MeshBuffers& operator=(const MeshBuffers&) = delete;
+
+		~MeshBuffers() {
+			if (shared)
+				sharedMeshes.erase(key);
+			for (GLuint buffer : buffers)
+				if (UploadManager::current != nullptr)
+					UploadManager::current->cancelBuffer(buffer);
+			if (!vertexArrays.empty())
+				glDeleteVertexArrays((GLsizei)vertexArrays.size(), vertexArrays.data());
+			if (!buffers.empty())
+				glDeleteBuffers((GLsizei)buffers.size(), buffers.data());
+		}
+	};
+
 	int numVertices;
-	float ka, kd, ks, ns;
-	GLuint VAO, textureId;
+	GLuint VAO;
+	GLenum drawMode = GL_TRIANGLES, indexType = 0;
+	size_t indexOffset = 0;
+	shared_ptr<MaterialLibrary> materialLibrary;
+	vector<SubMesh> subMeshes;
+	// Com o UploadManager ativo, os vrtices chegam em segundo plano: o objeto s  desenhado quando vira true
+	shared_ptr<bool> uploaded;
+	// Raio da esfera envolvente da malha em torno da origem do modelo (usado para estimar o tamanho na tela)
+	float boundingRadius = 1.0f;
+	// Esfera gerada (Primitives): pode ser trocada por um impostor quando fica pequena na tela
+	bool sphere = false;
 
 	SceneObjInfo(string objFilePath) : objFilePath(objFilePath)
 	{
-		this->VAO = loadSimpleOBJ(objFilePath, numVertices, materialFileName, materialName);
-		this->textureFileName = loadSimpleMTL(materialFileName, materialName);
-		this->textureId = loadTexture(textureFileName);
+		MeshData data;
+		this->VAO = readMesh(objFilePath, data) ? createMesh(data) : -1;
 	}
 
-private:
-	string objFilePath, materialFileName, materialName, textureFileName;
-
-	// Funo para ler o arquivo OBJ e extrair os dados de vrtices e ndices
-	bool readOBJFile(const std::string& filepath, std::vector<GLuint>& indices, std::vector<GLfloat>& vbuffer,
-		string& materialFileName, string& materialName) {
+	// Malha j lida por readMesh
+	SceneObjInfo(string objFilePath, MeshData data) : objFilePath(objFilePath)
+	{
+		this->VAO = createMesh(data);
+	}
 
-		glm::vec3 color = glm::vec3(1.0, 0.0, 1.0);
+	const string& getObjFilePath() const {
+		return objFilePath;
+	}
 
-		vector <glm::vec2> textureCoordinates;
-		vector <glm::vec3> vertices;
-		vector <glm::vec3> normals;
+	const string& getMaterialFilePath() const {
+		return materialFileName;
+	}
 
-		std::ifstream inputFile(filepath);
-		if (!inputFile.is_open()) {
-			std::cerr << "Erro ao abrir o arquivo OBJ: " << filepath << std::endl;
+	// Uma primitiva (Primitives)  gerada em vez de lida; jobs divide as grandes entre as threads
+	static bool readMesh(const std::string& filepath, MeshData& data, JobSystem* jobs = nullptr) {
+		PROFILE_ZONE("SceneObjInfo::readMesh");
+		if (Primitives::isPrimitive(filepath))
+			return Primitives::generate(filepath, data.vbuffer, data.indices, data.materialFileName, jobs);
+		if (!MeshLoader::readMeshFile(filepath, data.vbuffer, data.materialFileName, data.materialRanges)) {
+			std::cerr << "Erro ao ler o arquivo de malha: " << filepath << std::endl;
 			return false;
 		}
+		return true;
+	}
 
-		std::string line;
-		while (std::getline(inputFile, line)) {
-			std::istringstream ssline(line);
-			std::string word;
-			ssline >> word;
-
-			if (word == "mtllib") {
-				std::getline(ssline >> std::ws, materialFileName);
-			}
-			else if (word == "usemtl") {
-				ssline >> materialName;
-			}
-			else if (word == "v") {
-				glm::vec3 v;
-				ssline >> v.x >> v.y >> v.z;
-				vertices.push_back(v);
-			}
-			else if (word == "vt")
-			{
-				glm::vec2 vt;
-				ssline >> vt.s >> vt.t;
-				textureCoordinates.push_back(vt);
-			}
-			else if (word == "vn")
-			{
-				glm::vec3 vn;
-				ssline >> vn.x >> vn.y >> vn.z;
-				normals.push_back(vn);
-			}
-			else if (word == "f") {
-				std::string tokens[3];
-				ssline >> tokens[0] >> tokens[1] >> tokens[2];
-
-				for (int i = 0; i < 3; ++i) {
-					int posLastValue = tokens[i].find_last_of('/');
-					std::string lastValue = tokens[i].substr(posLastValue + 1);
-					int normal = std::stoi(lastValue);
-
-					int pos = tokens[i].find("/");
-					std::string token = tokens[i].substr(0, pos);
-					int index = std::atoi(token.c_str()) - 1;
-					indices.push_back(index);
-
-					vbuffer.push_back(vertices[index].x);
-					vbuffer.push_back(vertices[index].y);
-					vbuffer.push_back(vertices[index].z);
-
-					vbuffer.push_back(color.r);
-					vbuffer.push_back(color.g);
-					vbuffer.push_back(color.b);
-
-					tokens[i] = tokens[i].substr(pos + 1);
-					pos = tokens[i].find("/");
-					token = tokens[i].substr(0, pos);
-					index = atoi(token.c_str()) - 1; 
-
-					vbuffer.push_back(textureCoordinates[index].s);
-					vbuffer.push_back(textureCoordinates[index].t);
-
-					tokens[i] = tokens[i].substr(pos + 1);
-					index = atoi(tokens[i].c_str()) - 1;
-
-					vbuffer.push_back(normals[index].x);
-					vbuffer.push_back(normals[index].y);
-					vbuffer.push_back(normals[index].z);
-				}
-			}
-		}
+	// Primitiva de um arquivo glTF/GLB, j enviada para a GPU pelo GLTFModel; buffers vem de adoptModel
+	SceneObjInfo(string objFilePath, const GLTFPrimitive& primitive, shared_ptr<MaterialLibrary> materialLibrary, shared_ptr<MeshBuffers> buffers)
+		: numVertices(primitive.count), VAO(primitive.VAO), drawMode(primitive.mode), indexType(primitive.indexType),
+		indexOffset(primitive.indexOffset), materialLibrary(materialLibrary), buffers(buffers), objFilePath(objFilePath)
+	{
+		subMeshes.push_back({ primitive.material, 0, primitive.count });
+	}
 
-		inputFile.close();
-		return true;
+	// Passa a ser dono dos VAOs e buffers enviados pelo GLTFModel, compartilhados pelos objetos das suas primitivas
+	// (as texturas continuam com o TextureLoader, pois podem ter virado pginas de atlas)
+	static shared_ptr<MeshBuffers> adoptModel(const GLTFModel& model) {
+		auto buffers = make_shared<MeshBuffers>();
+		for (const auto& primitive : model.primitives)
+			buffers->vertexArrays.push_back(primitive.VAO);
+		buffers->buffers = model.getViewBuffers();
+		return buffers;
 	}
 
-	// Funo para inicializar os buffers de vrtices e arrays de vrtices (VAO e VBO)
-	bool initializeBuffers(GLuint& VBO, GLuint& VAO, const std::vector<GLfloat>& vbuffer, int stride) {
+private:
+	shared_ptr<MeshBuffers> buffers;
+	string objFilePath, materialFileName;
+
+	// Malhas j enviadas, pela chave do contedo dos vrtices (a entrada sai quando a malha  apagada)
+	inline static unordered_map<MeshKey, weak_ptr<MeshBuffers>, MeshKeyHash> sharedMeshes;
+
+	// Funo para inicializar os buffers de vrtices, de ndices e o array de vrtices (VBO, EBO e VAO)
+	bool initializeBuffers(GLuint& VBO, GLuint& EBO, GLuint& VAO, const std::vector<GLfloat>& vbuffer, const std::vector<GLuint>& indices, int stride) {
 		glGenBuffers(1, &VBO);
 		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, vbuffer.size() * sizeof(GLfloat), vbuffer.data(), GL_STATIC_DRAW);
+		if (UploadManager::current != nullptr) {
+			// S reserva o buffer; os dados so copiados pelo anel de staging nos prximos quadros
+			glBufferData(GL_ARRAY_BUFFER, vbuffer.size() * sizeof(GLfloat), nullptr, GL_STATIC_DRAW);
+			const unsigned char* bytes = (const unsigned char*)vbuffer.data();
+			uploaded = make_shared<bool>(false);
+			UploadManager::current->streamBuffer(VBO, vector<unsigned char>(bytes, bytes + vbuffer.size() * sizeof(GLfloat)), uploaded);
+		}
+		else {
+			glBufferData(GL_ARRAY_BUFFER, vbuffer.size() * sizeof(GLfloat), vbuffer.data(), GL_STATIC_DRAW);
+		}
 
 		glGenVertexArrays(1, &VAO);
 		glBindVertexArray(VAO);
 
+		// Os ndices so poucos perto dos vrtices: vo direto, sem o UploadManager (o buffer fica ligado ao VAO)
+		EBO = 0;
+		if (!indices.empty()) {
+			glGenBuffers(1, &EBO);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+		}
+
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride * sizeof(GLfloat), (GLvoid*)0);
 		glEnableVertexAttribArray(0);
 
@@ -146,130 +190,140 @@ private:
 		return true;
 	}
 
-	// Funo principal para carregar um arquivo OBJ e inicializar os buffers de vrtices e arrays de vrtices (VAO e VBO)
-	int loadSimpleOBJ(const std::string& filepath, int& numVertices, string& materialFileName, string& materialName) {
-		std::vector<GLuint> indices;
-		std::vector<GLfloat> vbuffer;
-		int stride = 11;
-
-		if (!readOBJFile(filepath, indices, vbuffer, materialFileName, materialName)) {
-			std::cerr << "Erro ao ler o arquivo OBJ: " << filepath << std::endl;
-			return -1;
-		}
+	// Funo principal para carregar uma malha lida de um arquivo (OBJ, PLY ou STL) e inicializar os buffers de vrtices e arrays de vrtices (VAO e VBO)
+	int createMesh(MeshData& data) {
+		PROFILE_ZONE("SceneObjInfo::createMesh");
+		std::vector<GLfloat>& vbuffer = data.vbuffer;
+		vector<MaterialRange>& materialRanges = data.materialRanges;
+		int stride = MeshLoader::stride;
+		materialFileName = data.materialFileName;
 
 		numVertices = vbuffer.size() / stride;
+		sphere = Primitives::isSphere(objFilePath);
+		boundingRadius = 0.0f;
+		for (size_t i = 0; i + 2 < vbuffer.size(); i += stride)
+			boundingRadius = std::max(boundingRadius, glm::length(glm::vec3(vbuffer[i], vbuffer[i + 1], vbuffer[i + 2])));
+
+		materialLibrary = MaterialLibrary::load(materialFileName);
+		materialLibrary->loadTextures();
+		if (data.indices.empty())
+			buildSubMeshes(vbuffer, materialRanges, stride);
+		else
+			buildIndexedSubMesh(vbuffer, data.indices, stride);
+
+		// Arquivos com a mesma geometria (ex.: os planetas, que s mudam o MTL) usam o mesmo VAO,
+		// o que permite desenh-los juntos com instanciamento
+		// (a chave tem 128 bits de hash e os tamanhos, ento no guardamos cpia dos vrtices para comparar)
+		MeshKey key = hashVertices(vbuffer, data.indices);
+		auto shared = sharedMeshes.find(key);
+		if (shared != sharedMeshes.end()) {
+			shared_ptr<MeshBuffers> mesh = shared->second.lock();
+			if (mesh) {
+				buffers = mesh;
+				uploaded = mesh->uploaded;
+				return mesh->vertexArrays.front();
+			}
+		}
 
-		GLuint VBO, VAO;
-		if (!initializeBuffers(VBO, VAO, vbuffer, stride)) {
+		GLuint VBO, EBO, VAO;
+		if (!initializeBuffers(VBO, EBO, VAO, vbuffer, data.indices, stride)) {
 			std::cerr << "Erro ao inicializar os buffers de vrtices e arrays de vrtices." << std::endl;
 			return -1;
 		}
 
+		buffers = make_shared<MeshBuffers>();
+		buffers->vertexArrays.push_back(VAO);
+		buffers->buffers.push_back(VBO);
+		if (EBO != 0)
+			buffers->buffers.push_back(EBO);
+		buffers->uploaded = uploaded;
+		buffers->key = key;
+		buffers->shared = true;
+		sharedMeshes[key] = buffers;
 		return VAO;
 	}
 
-	// Funo principal para carregar um arquivo MTL
-	string loadSimpleMTL(const std::string& filepath, string materialName)
-	{
-		string textureFileName;
-		std::ifstream inputFile(filepath);
-
-		if (!inputFile.is_open()) {
-			std::cerr << "Erro ao abrir o arquivo MTL: " << filepath << std::endl;
-			return "";
-		}
-
-		string line;
-		bool materialFound = false;
-
-		while (getline(inputFile, line))
-		{
-			istringstream ssline(line);
-			string word;
-			ssline >> word;
-
-			if (word == "newmtl")
-			{
-				string currentMaterialName;
-				ssline >> currentMaterialName;
-				materialFound = (currentMaterialName == materialName);
-			}
-			else if (word == "Ka" && materialFound) {
-				ssline >> ka;
-				ssline.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-			}
-			else if (word == "Ks" && materialFound) {
-				ssline >> ks;
-				ssline.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+	// FNV-1a sobre os bytes dos vrtices e dos ndices, mais um hash multiplicativo por palavra de 32 bits
+	// (com outras constantes, para que uma coliso de um no implique coliso do outro)
+	static MeshKey hashVertices(const std::vector<GLfloat>& vbuffer, const std::vector<GLuint>& indices) {
+		MeshKey key;
+		key.vertexBytes = vbuffer.size() * sizeof(GLfloat);
+		key.indexBytes = indices.size() * sizeof(GLuint);
+		uint64_t hash = 14695981039346656037ull, hash2 = 0x9E3779B97F4A7C15ull;
+		auto add = [&hash, &hash2](const void* data, size_t size) {
+			const unsigned char* bytes = (const unsigned char*)data;
+			for (size_t i = 0; i < size; ++i) {
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
 			}
-			else if (word == "Kd" && materialFound) {
-				ssline >> kd;
-				ssline.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+			for (size_t i = 0; i + 4 <= size; i += 4) {
+				uint32_t word;
+				memcpy(&word, bytes + i, 4);
+				hash2 = (hash2 ^ word) * 0xFF51AFD7ED558CCDull;
+				hash2 ^= hash2 >> 29;
 			}
-			else if (word == "Ns" && materialFound) {
-				ssline >> ns;
-				ssline.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-			}
-			else if (word == "map_Kd" && materialFound) {
-				ssline >> textureFileName;
-				break;
-			}
-		}
-
-		inputFile.close();
-		return textureFileName;
+		};
+		add(vbuffer.data(), key.vertexBytes);
+		add(indices.data(), key.indexBytes);
+		key.hash = hash;
+		key.hash2 = hash2;
+		return key;
 	}
 
-	int loadTexture(string filepath)
-	{
-		GLuint texID;
-
-		// Gera o identificador da textura na memria 
-		glGenTextures(1, &texID);
-		glBindTexture(GL_TEXTURE_2D, texID);
-
-		//Ajusta os parmetros de wrapping e filtering
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		//Carregamento da imagem
-		int width, height, nrChannels;
-		unsigned char* data = stbi_load(filepath.c_str(), &width, &height, &nrChannels, 0);
-
-		if (data)
-		{
-			GLenum format;
-			switch (nrChannels) {
-			case 1:
-				format = GL_RED;
-				break;
-			case 3:
-				format = GL_RGB;
-				break;
-			case 4:
-				format = GL_RGBA;
+	// Malha indexada (uma primitiva): um s material, o primeiro do MTL, desenhado pelos ndices
+	void buildIndexedSubMesh(const std::vector<GLfloat>& vbuffer, const std::vector<GLuint>& indices, int stride) {
+		numVertices = (int)indices.size();
+		indexType = GL_UNSIGNED_INT;
+		indexOffset = 0;
+		int material = materialLibrary->size() > 0 ? 0 : materialLibrary->find("");
+		subMeshes = { { material, 0, numVertices } };
+		for (size_t i = 6; i + 1 < vbuffer.size(); i += stride)
+			if (vbuffer[i] < -0.001f || vbuffer[i] > 1.001f || vbuffer[i + 1] < -0.001f || vbuffer[i + 1] > 1.001f) {
+				materialLibrary->markRepeatsUV(material);
 				break;
-			default:
-				std::cerr << "Nmero de canais no suportado: " << nrChannels << std::endl;
-				stbi_image_free(data);
-				return 0;
 			}
+	}
 
-			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-			glGenerateMipmap(GL_TEXTURE_2D);
-		}
-		else
-		{
-			std::cout << "Falha ao carregar a textura" << std::endl;
-			return 0;
+	// Converte os trechos "usemtl" em sub-malhas ordenadas por material, reordenando os vrtices
+	// para que cada material ocupe um nico intervalo contguo (uma chamada de desenho por material)
+	void buildSubMeshes(std::vector<GLfloat>& vbuffer, vector<MaterialRange> materialRanges, int stride) {
+		if (materialRanges.empty() || materialRanges.front().firstVertex > 0)
+			materialRanges.insert(materialRanges.begin(), { "", 0 });
+
+		vector<SubMesh> ranges;
+		for (size_t i = 0; i < materialRanges.size(); ++i) {
+			int first = materialRanges[i].firstVertex;
+			int last = i + 1 < materialRanges.size() ? materialRanges[i + 1].firstVertex : numVertices;
+			if (last <= first)
+				continue;
+			// Sem "usemtl" usa o primeiro material do arquivo
+			const string& name = materialRanges[i].materialName;
+			int material = name.empty() && materialLibrary->size() > 0 ? 0 : materialLibrary->find(name);
+			ranges.push_back({ material, first, last - first });
+
+			for (int v = first; v < last; ++v) {
+				GLfloat s = vbuffer[(size_t)v * stride + 6], t = vbuffer[(size_t)v * stride + 7];
+				if (s < -0.001f || s > 1.001f || t < -0.001f || t > 1.001f) {
+					materialLibrary->markRepeatsUV(material);
+					break;
+				}
+			}
 		}
 
-		stbi_image_free(data);
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		return texID;
+		std::stable_sort(ranges.begin(), ranges.end(), [](const SubMesh& a, const SubMesh& b) { return a.material < b.material; });
+
+		std::vector<GLfloat> sorted;
+		sorted.reserve(vbuffer.size());
+		subMeshes.clear();
+		for (const auto& range : ranges) {
+			int first = (int)(sorted.size() / stride);
+			sorted.insert(sorted.end(), vbuffer.begin() + (size_t)range.first * stride, vbuffer.begin() + (size_t)(range.first + range.count) * stride);
+			if (!subMeshes.empty() && subMeshes.back().material == range.material)
+				subMeshes.back().count += range.count;
+			else
+				subMeshes.push_back({ range.material, first, range.count });
+		}
+		vbuffer.swap(sorted);
 	}
 
 };
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Partculas de um emissor: as de [first, first + count) de SceneSnapshot::particles, com a cor e o tamanho inicial dele
+struct ParticleBatch {
+	int first, count;
+	glm::vec3 color;
+	float size;
+};
+
+// Estado da cena ao fim de um passo da simulao, tudo o que o desenho precisa: as matrizes de modelo (na ordem
+// de Scene::sceneObject) e a cmera. A simulao escreve uma cpia enquanto o desenho usa outra.
+struct SceneSnapshot {
+	vector<glm::mat4> models;
+	// Posies dos corpos da gravitao que no so objetos (asteroides) e do cinturo de rbitas
+	vector<glm::vec3> bodies;
+	// Partculas (posio e o tamanho, que diminui com a idade), um lote por emissor
+	vector<glm::vec4> particles;
+	vector<ParticleBatch> particleBatches;
+	glm::mat4 view = glm::mat4(1), projection = glm::mat4(1);
+	glm::vec3 cameraPosition = glm::vec3(0);
+	float fov = 0;
+	int height = 0;
+	// Passo da simulao que gerou a cpia e o tempo simulado, em segundos
+	uint64_t step = 0;
+	double time = 0;
+};
\ No newline at end of file
@@ -0,0 +1,271 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "../Common/include/Shader.h"
+#include "SceneObj.cpp"
+#include "Profiler.cpp"
+
+using namespace std;
+
+// Sombra da luz principal da cena (pontual): um mapa cbico de profundidade, com as seis faces desenhadas a partir da
+// luz. Os objetos que ficaram parados por staticFrames quadros so desenhados num mapa guardado, refeito s quando a luz
+// se move ou um objeto entra ou sai desse grupo; a cada quadro o mapa guardado  copiado para o do quadro e s os
+// objetos que se movem so desenhados por cima (sem nenhum, o FShader.fs l direto o guardado). O FShader.fs compara
+// a profundidade na unidade 5.
+class ShadowMap
+{
+public:
+	const int size, staticFrames;
+	const float nearPlane, farPlane;
+	// Vis da comparao no FShader.fs (em profundidade do mapa, de 0 a 1)
+	float bias = 0.0005f;
+	// Sem ele todos os objetos so desenhados a cada quadro (para comparar o custo)
+	bool caching = true;
+
+	ShadowMap(int size, float nearPlane, float farPlane, int staticFrames)
+		: size(std::max(size, 16)), staticFrames(std::max(staticFrames, 1)), nearPlane(std::max(nearPlane, 1e-3f)),
+		farPlane(std::max(farPlane, std::max(nearPlane, 1e-3f) * 2.0f)), shader(Shader::fromSource(vertexSource, fragmentSource))
+	{
+		glGenTextures(2, textures);
+		for (GLuint texture : textures) {
+			glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+			for (int face = 0; face < 6; ++face)
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT24, this->size, this->size, 0,
+					GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+		}
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+		// A filtragem entre faces evita a emenda nas bordas do cubo
+		glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+		// S profundidade: sem buffer de cor para desenhar ou ler
+		glGenFramebuffers(2, framebuffers);
+		for (GLuint framebuffer : framebuffers) {
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	~ShadowMap()
+	{
+		glDeleteFramebuffers(2, framebuffers);
+		glDeleteTextures(2, textures);
+		glDeleteProgram(shader.ID);
+	}
+
+	ShadowMap(const ShadowMap&) = delete;
+	ShadowMap& operator=(const ShadowMap&) = delete;
+
+	// Faz o mapa guardado ser redesenhado no prximo quadro (malhas trocadas pela recarga, por exemplo)
+	void invalidate() {
+		cacheValid = false;
+	}
+
+	// Desenha os mapas da luz em lightPosition com objects nas posies de models (os de castShadows). Usa o seu
+	// prprio programa de shader e framebuffer: o chamador religa o da cena e restaura a viewport. Chamar fora de
+	// outra zona de GPU do Profiler, para que as duas partes sejam medidas.
+	void render(const glm::vec3& lightPosition, const vector<SceneObj>& objects, const vector<glm::mat4>& models) {
+		PROFILE_ZONE("ShadowMap::render");
+		classify(lightPosition, objects, models);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[0]);
+		glViewport(0, 0, size, size);
+		glEnable(GL_DEPTH_TEST);
+		glDepthMask(GL_TRUE);
+		glEnable(GL_POLYGON_OFFSET_FILL);
+		glPolygonOffset(2.0f, 4.0f);
+		shader.Use();
+		for (int face = 0; face < 6; ++face)
+			faceMatrices[face] = getFaceMatrix(lightPosition, face);
+
+		size_t staticTriangles = 0, dynamicTriangles = 0;
+		if (rebuild) {
+			PROFILE_ZONE("ShadowMap::renderStatic");
+			PROFILE_GPU_ZONE("ShadowMap::renderStatic");
+			for (int face = 0; face < 6; ++face) {
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, textures[0], 0);
+				glClear(GL_DEPTH_BUFFER_BIT);
+				staticTriangles += drawFace(face, cached, objects, models);
+			}
+			cachedTriangles = staticTriangles;
+			cachedLight = lightPosition;
+			cacheValid = true;
+		}
+		if (numDynamic > 0) {
+			PROFILE_ZONE("ShadowMap::renderDynamic");
+			PROFILE_GPU_ZONE("ShadowMap::renderDynamic");
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[1]);
+			for (int face = 0; face < 6; ++face) {
+				glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, textures[0], 0);
+				glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, textures[1], 0);
+				glBlitFramebuffer(0, 0, size, size, 0, 0, size, size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+				dynamicTriangles += drawFace(face, dynamic, objects, models);
+			}
+		}
+		drawnTriangles = staticTriangles + dynamicTriangles;
+		sampled = numDynamic > 0 ? textures[1] : textures[0];
+
+		glDisable(GL_POLYGON_OFFSET_FILL);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// Poupados: os tringulos do mapa guardado, que no precisaram ser desenhados de novo neste quadro
+		PROFILE_COUNTER("ShadowMap: objetos guardados", numCached);
+		PROFILE_COUNTER("ShadowMap: objetos dinmicos", numDynamic);
+		PROFILE_COUNTER("ShadowMap: tringulos desenhados", drawnTriangles);
+		PROFILE_COUNTER("ShadowMap: tringulos poupados", rebuild ? 0 : cachedTriangles);
+		PROFILE_COUNTER("ShadowMap: mapa guardado refeito", rebuild ? 1 : 0);
+	}
+
+	// Liga o mapa do ltimo render na unidade 5 e passa para o shader da cena os planos e o vis da comparao
+	void bind(const Shader* shader) const {
+		glActiveTexture(GL_TEXTURE5);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, sampled);
+		glActiveTexture(GL_TEXTURE0);
+		shader->setBool("shadows", sampled != 0);
+		shader->setVec3("shadow_params", nearPlane, farPlane, bias);
+	}
+
+	// Desliga a sombra no shader da cena
+	static void unbind(const Shader* shader) {
+		shader->setBool("shadows", false);
+	}
+
+	// Objetos no mapa guardado e os desenhados a cada quadro no ltimo render
+	int getNumCached() const {
+		return numCached;
+	}
+
+	int getNumDynamic() const {
+		return numDynamic;
+	}
+
+	// Se o ltimo render redesenhou o mapa guardado
+	bool wasRebuilt() const {
+		return rebuild;
+	}
+
+	// Tringulos desenhados no ltimo render, nas seis faces (no entram em SceneObj::triangles)
+	size_t getTrianglesDrawn() const {
+		return drawnTriangles;
+	}
+
+private:
+	Shader shader;
+	// Mapa guardado (0) e o do quadro (1); o framebuffer 1 s  usado para ler na cpia de um para o outro
+	GLuint textures[2] = {}, framebuffers[2] = {};
+	GLuint sampled = 0;
+	glm::mat4 faceMatrices[6];
+
+	// Por objeto: a matriz do quadro anterior, h quantos quadros ela no muda, se est no mapa guardado e se 
+	// desenhado a cada quadro; e a esfera que o envolve (centro relativo  luz e raio)
+	vector<glm::mat4> previous;
+	vector<int> stillFrames;
+	vector<unsigned char> cached, dynamic;
+	vector<glm::vec4> spheres;
+	int numCached = 0, numDynamic = 0;
+	size_t cachedTriangles = 0, drawnTriangles = 0;
+	glm::vec3 cachedLight = glm::vec3(0.0f);
+	bool cacheValid = false, rebuild = false;
+
+	// Separa os objetos que projetam sombra em guardados e dinmicos e decide se o mapa guardado precisa ser refeito.
+	// Um objeto sem malha enviada ainda no projeta sombra.
+	void classify(const glm::vec3& lightPosition, const vector<SceneObj>& objects, const vector<glm::mat4>& models) {
+		if (previous.size() != objects.size()) {
+			previous.assign(models.begin(), models.end());
+			stillFrames.assign(objects.size(), 0);
+			cached.assign(objects.size(), 0);
+			dynamic.assign(objects.size(), 0);
+			spheres.resize(objects.size());
+			cacheValid = false;
+		}
+		rebuild = !cacheValid || lightPosition != cachedLight;
+		numDynamic = 0;
+		for (size_t i = 0; i < objects.size(); ++i) {
+			const SceneObj& obj = objects[i];
+			const glm::mat4& model = models[i];
+			bool caster = obj.castShadows && obj.isUploaded();
+			if (!caster || model != previous[i])
+				stillFrames[i] = 0;
+			else if (stillFrames[i] < staticFrames)
+				stillFrames[i]++;
+			previous[i] = model;
+
+			unsigned char isStatic = caching && caster && stillFrames[i] >= staticFrames;
+			if (isStatic != cached[i])
+				rebuild = true;
+			cached[i] = isStatic;
+			dynamic[i] = caster && !isStatic;
+			numDynamic += dynamic[i];
+			if (caster) {
+				float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+				spheres[i] = glm::vec4(glm::vec3(model[3]) - lightPosition, obj.sceneObjInfo.boundingRadius * scale);
+			}
+		}
+		if (rebuild) {
+			numCached = 0;
+			for (unsigned char isStatic : cached)
+				numCached += isStatic;
+		}
+	}
+
+	// Desenha numa face os objetos marcados em selection que ficam dentro do frustum dela; retorna os tringulos
+	size_t drawFace(int face, const vector<unsigned char>& selection, const vector<SceneObj>& objects, const vector<glm::mat4>& models) {
+		shader.setMat4("light_matrix", glm::value_ptr(faceMatrices[face]));
+		size_t drawn = 0;
+		for (size_t i = 0; i < objects.size(); ++i)
+			if (selection[i] && isInFace(face, spheres[i]))
+				drawn += objects[i].renderDepth(&shader, models[i]);
+		return drawn;
+	}
+
+	// Frustum de 90 graus da face (+X, -X, +Y, -Y, +Z, -Z, na ordem da OpenGL): a esfera precisa estar do lado de
+	// dentro dos quatro planos inclinados e entre near e far
+	bool isInFace(int face, const glm::vec4& sphere) const {
+		int axis = face / 2;
+		float major = face % 2 == 0 ? sphere[axis] : -sphere[axis];
+		float reach = sphere.w * 1.41421356f;
+		for (int other = 0; other < 3; ++other)
+			if (other != axis && major + reach < std::abs(sphere[other]))
+				return false;
+		return major + sphere.w >= nearPlane && major - sphere.w <= farPlane;
+	}
+
+	// Viso e projeo de uma face do cubo, com a orientao que a OpenGL usa para ler cada face
+	glm::mat4 getFaceMatrix(const glm::vec3& lightPosition, int face) const {
+		static const glm::vec3 directions[6] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+			glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+		static const glm::vec3 ups[6] = { glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+			glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) };
+		glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, nearPlane, farPlane);
+		return projection * glm::lookAt(lightPosition, lightPosition + directions[face], ups[face]);
+	}
+
+	inline static const char* vertexSource = R"(#version 330 core
+layout (location = 0) in vec3 position;
+uniform mat4 light_matrix;
+uniform mat4 model;
+void main()
+{
+	gl_Position = light_matrix * model * vec4(position, 1.0);
+}
+)";
+
+	inline static const char* fragmentSource = R"(#version 330 core
+void main()
+{
+}
+)";
+};
\ No newline at end of file
@@ -0,0 +1,202 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include "Scene.cpp"
+#include "SceneSnapshot.cpp"
+#include "TripleBuffer.cpp"
+#include "JobSystem.cpp"
+#include "InputRecording.cpp"
+
+using namespace std;
+
+// Anda com a cena em passos de tempo fixo (animao, curvas, cmera e entrada) e entrega ao desenho a ltima
+// cpia completa por um TripleBuffer, ento nenhum dos dois espera pelo outro. Com a thread prpria ligada os passos
+// rodam em paralelo ao desenho e no dependem do vsync; sem ela, update() faz na thread principal os passos atrasados.
+// Quem muda a lista de objetos (ex.: a recarga) trava a cena com lockScene() e publica uma cpia nova com publish().
+// A entrada pode ser gravada ou reproduzida pelo nmero do passo (InputRecording), o que torna as execues comparveis.
+class Simulation
+{
+public:
+	// Um passo: input traz os eventos chegados desde o passo anterior e time  o tempo simulado, em segundos
+	using StepFunction = function<void(const vector<InputEvent>& input, double time)>;
+
+	Simulation(Scene& scene, const SceneSimulationAux& settings, StepFunction step)
+		: scene(scene), settings(settings), step(std::move(step)), stepSeconds(1.0 / settings.stepsPerSecond)
+	{
+		publish();
+	}
+
+	~Simulation() {
+		stop();
+	}
+
+	Simulation(const Simulation&) = delete;
+	Simulation& operator=(const Simulation&) = delete;
+
+	// Faz o primeiro passo aqui, para o primeiro quadro j ter as matrizes de modelo, e inicia a thread
+	void start() {
+		startTime = std::chrono::steady_clock::now();
+		advance();
+		if (settings.enabled)
+			worker = thread(&Simulation::run, this);
+	}
+
+	void stop() {
+		stopping = true;
+		if (worker.joinable())
+			worker.join();
+	}
+
+	bool isThreaded() const {
+		return worker.joinable();
+	}
+
+	// Chamado pelos callbacks da GLFW, na thread principal
+	void pushInput(const InputEvent& event) {
+		lock_guard<mutex> lock(inputMutex);
+		pendingInput.push_back(event);
+	}
+
+	// Sem a thread prpria, faz os passos que j deviam ter acontecido (uma vez por quadro)
+	void update() {
+		if (!isThreaded())
+			advance();
+	}
+
+	// Sem a thread prpria, faz exatamente um passo, no importa quanto tempo passou (um por quadro no benchmark)
+	void stepOnce() {
+		if (isThreaded())
+			return;
+		auto lock = lockScene();
+		runStep();
+		publish();
+	}
+
+	// Guarda em recording a entrada de cada passo; chamar antes de start()
+	void setRecording(InputRecording* recording) {
+		this->recording = recording;
+		if (recording != nullptr)
+			recording->stepsPerSecond = settings.stepsPerSecond;
+	}
+
+	// Usa a entrada gravada em vez da recebida pelos callbacks; chamar antes de start()
+	void setReplay(const InputRecording* replay) {
+		this->replay = replay;
+		replayNext = 0;
+		if (replay != nullptr && replay->stepsPerSecond != settings.stepsPerSecond)
+			std::cerr << "A gravao de entrada foi feita a " << replay->stepsPerSecond << " passos/s e a simulao est a "
+				<< settings.stepsPerSecond << ": os eventos caem em outros tempos" << std::endl;
+	}
+
+	bool isReplayFinished() const {
+		return replayFinished;
+	}
+
+	// Impede a simulao de mexer na cena enquanto a trava existir
+	unique_lock<mutex> lockScene() {
+		return unique_lock<mutex>(sceneMutex);
+	}
+
+	// Publica o estado atual da cena; chamar com a cena travada (ou da prpria simulao)
+	void publish() {
+		SceneSnapshot& snapshot = snapshots.back();
+		scene.writeSnapshot(snapshot);
+		snapshot.step = numSteps;
+		snapshot.time = numSteps * stepSeconds;
+		snapshots.publish();
+	}
+
+	// ltima cpia publicada (s a thread que desenha)
+	const SceneSnapshot& acquire() {
+		return snapshots.acquire();
+	}
+
+	// Passos feitos at agora e o tempo gasto neles, em ms (para medir a taxa e o custo entre duas leituras)
+	uint64_t getNumSteps() const {
+		return stepCount.load(memory_order_relaxed);
+	}
+
+	double getStepMs() const {
+		return stepNanoseconds.load(memory_order_relaxed) / 1e6;
+	}
+
+private:
+	Scene& scene;
+	SceneSimulationAux settings;
+	StepFunction step;
+	double stepSeconds;
+
+	TripleBuffer<SceneSnapshot> snapshots;
+	mutex sceneMutex;
+	mutex inputMutex;
+	vector<InputEvent> pendingInput, input;
+
+	thread worker;
+	atomic<bool> stopping{ false };
+	std::chrono::steady_clock::time_point startTime;
+	// S a thread que faz os passos mexe nestes (ou quem travou a cena)
+	uint64_t numSteps = 0;
+	double nextStepTime = 0;
+	atomic<uint64_t> stepCount{ 0 }, stepNanoseconds{ 0 };
+	InputRecording* recording = nullptr;
+	const InputRecording* replay = nullptr;
+	size_t replayNext = 0;
+	atomic<bool> replayFinished{ false };
+
+	void run() {
+		// Os passos dividem a atualizao dos objetos em tarefas
+		if (JobSystem::current != nullptr)
+			JobSystem::current->attachThread();
+		Profiler::setThreadName("Simulation");
+		AllocationTracker::markFrameThread();
+		while (!stopping) {
+			advance();
+			std::this_thread::sleep_until(startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+				std::chrono::duration<double>(nextStepTime)));
+		}
+	}
+
+	// Faz os passos cujo horrio j chegou (no mximo maxStepsPerFrame; o atraso alm disso  descartado) e publica
+	void advance() {
+		double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		if (nextStepTime > now)
+			return;
+
+		auto lock = lockScene();
+		int steps = 0;
+		while (nextStepTime <= now && steps < settings.maxStepsPerFrame) {
+			runStep();
+			nextStepTime += stepSeconds;
+			++steps;
+		}
+		if (nextStepTime <= now)
+			nextStepTime = now + stepSeconds;
+		publish();
+	}
+
+	void runStep() {
+		{
+			lock_guard<mutex> lock(inputMutex);
+			input.swap(pendingInput);
+		}
+		if (replay != nullptr) {
+			input.clear();
+			replay->getEvents(numSteps, replayNext, input);
+			replayFinished = replay->isFinished(replayNext);
+		}
+		if (recording != nullptr)
+			recording->add(numSteps, input);
+		PROFILE_ZONE("Simulation::step");
+		auto begin = std::chrono::steady_clock::now();
+		step(input, numSteps * stepSeconds);
+		input.clear();
+		++numSteps;
+		stepNanoseconds += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+		stepCount++;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,278 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "../Common/include/stb_image.h"
+#include "TextureLoader.cpp"
+
+using namespace std;
+
+// Agrupa texturas de mesmas dimenses e nmero de canais em texturas de array (GL_TEXTURE_2D_ARRAY),
+// uma camada por imagem. Com um tamanho comum configurado, todas as imagens so reamostradas para ele
+// e imagens com o mesmo formato acabam no mesmo array. Com TextureLoader::compression definido, as camadas
+// vm do cache KTX2 j comprimidas e com os mipmaps gerados na CPU.
+class TextureArray
+{
+public:
+	vector<GLuint> arrays;
+
+	TextureArray(int width = 0, int height = 0, int minLayers = 2) : width(width), height(height), minLayers(minLayers) {}
+
+	// Registra a imagem para o agrupamento; s l o cabealho, os pixels so decodificados em build()
+	bool add(const string& filepath) {
+		if (entries.count(filepath))
+			return true;
+
+		Image image;
+		image.path = filepath;
+		if (!TextureBaker::getImageInfo(filepath, image.sourceWidth, image.sourceHeight, image.channels)) {
+			std::cerr << "Falha ao ler a textura para o array: " << filepath << std::endl;
+			return false;
+		}
+		// Imagens com paleta ou 2 canais so expandidas para RGBA
+		if (image.channels != 1 && image.channels != 3)
+			image.channels = 4;
+		image.width = width > 0 && height > 0 ? width : image.sourceWidth;
+		image.height = width > 0 && height > 0 ? height : image.sourceHeight;
+
+		entries[filepath] = { -1, -1, image };
+		images.push_back(image);
+		return true;
+	}
+
+	// Cria um array por grupo com pelo menos minLayers imagens; as demais continuam como texturas 2D comuns
+	void build() {
+		vector<vector<int>> groups;
+		for (int i = 0; i < (int)images.size(); ++i) {
+			bool grouped = false;
+			for (auto& group : groups) {
+				const Image& first = images[group.front()];
+				if (first.width == images[i].width && first.height == images[i].height && first.channels == images[i].channels) {
+					group.push_back(i);
+					grouped = true;
+					break;
+				}
+			}
+			if (!grouped)
+				groups.push_back({ i });
+		}
+
+		for (const auto& group : groups) {
+			if ((int)group.size() < minLayers)
+				continue;
+
+			const Image& first = images[group.front()];
+			bool compressed = !TextureLoader::compression.empty() &&
+				TextureLoader::isFormatSupported(TextureBaker::chooseFormat(TextureLoader::compression, first.channels));
+			GLuint texID = createArray(first.width, first.height, first.channels, (int)group.size(), compressed);
+
+			int layer = 0;
+			for (int i : group) {
+				LayerData data;
+				data.compressed = compressed;
+				if (!readLayer(images[i], data))
+					continue;
+				sendLayer(texID, images[i], layer, data);
+				entries[images[i].path] = { (int)arrays.size(), layer, images[i] };
+				++layer;
+			}
+
+			glBindTexture(GL_TEXTURE_2D_ARRAY, texID);
+			if (!compressed)
+				glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+			TextureLoader::trackMemory(texID, getArraySize(first, (int)group.size(), compressed));
+			arrays.push_back(texID);
+			layerCounts.push_back(layer);
+			compressedArrays.push_back(compressed);
+		}
+		images.clear();
+	}
+
+	bool contains(const string& filepath) const {
+		auto entry = entries.find(filepath);
+		return entry != entries.end() && entry->second.array >= 0;
+	}
+
+	GLuint getTexture(const string& filepath) const {
+		return arrays[entries.at(filepath).array];
+	}
+
+	int getLayer(const string& filepath) const {
+		return entries.at(filepath).layer;
+	}
+
+	int getNumLayers(int array) const {
+		return layerCounts[array];
+	}
+
+	// Pixels de uma camada (ou os nveis j comprimidos), lidos fora da thread da OpenGL
+	struct LayerData {
+		bool compressed = false;
+		vector<unsigned char> pixels;
+		CompressedImage image;
+	};
+
+	// Em qualquer thread: l de novo a imagem de uma camada (hot reload), no tamanho e formato do array
+	bool readLayer(const string& filepath, LayerData& data) const {
+		auto entry = entries.find(filepath);
+		if (entry == entries.end() || entry->second.array < 0)
+			return false;
+		// A imagem nova pode ter outro tamanho; a camada continua com o tamanho do array
+		Image image = entry->second.image;
+		int channels;
+		if (!TextureBaker::getImageInfo(filepath, image.sourceWidth, image.sourceHeight, channels))
+			return false;
+		data.compressed = compressedArrays[entry->second.array] != 0;
+		return readLayer(image, data);
+	}
+
+	// Na thread da OpenGL: troca a camada pela imagem lida em readLayer
+	void updateLayer(const string& filepath, const LayerData& data) {
+		const Entry& entry = entries.at(filepath);
+		GLuint texID = arrays[entry.array];
+		sendLayer(texID, entry.image, entry.layer, data);
+		if (!data.compressed) {
+			glBindTexture(GL_TEXTURE_2D_ARRAY, texID);
+			glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		}
+	}
+
+private:
+	struct Image {
+		string path;
+		int sourceWidth = 0, sourceHeight = 0;
+		int width = 0, height = 0, channels = 0;
+	};
+
+	struct Entry {
+		int array;
+		int layer;
+		Image image;
+	};
+
+	int width, height, minLayers;
+	vector<Image> images;
+	vector<int> layerCounts;
+	vector<unsigned char> compressedArrays;
+	unordered_map<string, Entry> entries;
+
+	static GLenum getFormat(int channels) {
+		return channels == 1 ? GL_RED : channels == 3 ? GL_RGB : GL_RGBA;
+	}
+
+	static GLenum getInternalFormat(int channels) {
+		return channels == 1 ? GL_R8 : channels == 3 ? GL_RGB8 : GL_RGBA8;
+	}
+
+	static int getNumLevels(int levelWidth, int levelHeight) {
+		int levels = 1;
+		while (levelWidth > 1 || levelHeight > 1) {
+			levelWidth = std::max(1, levelWidth / 2);
+			levelHeight = std::max(1, levelHeight / 2);
+			++levels;
+		}
+		return levels;
+	}
+
+	// Memria do array com todos os nveis de mipmap
+	static size_t getArraySize(const Image& image, int layers, bool compressed) {
+		if (!compressed)
+			return (size_t)image.width * image.height * image.channels * layers * 4 / 3;
+
+		TextureCompressor::Format format = TextureBaker::chooseFormat(TextureLoader::compression, image.channels);
+		size_t bytes = 0;
+		int levelWidth = image.width, levelHeight = image.height;
+		for (int level = 0; level < getNumLevels(image.width, image.height); ++level) {
+			bytes += TextureCompressor::getCompressedSize(levelWidth, levelHeight, format) * layers;
+			levelWidth = std::max(1, levelWidth / 2);
+			levelHeight = std::max(1, levelHeight / 2);
+		}
+		return bytes;
+	}
+
+	GLuint createArray(int arrayWidth, int arrayHeight, int channels, int layers, bool compressed) const {
+		GLuint texID;
+		glGenTextures(1, &texID);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texID);
+
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// Reserva todas as camadas de uma vez; os pixels so enviados camada por camada
+		if (compressed) {
+			TextureCompressor::Format format = TextureBaker::chooseFormat(TextureLoader::compression, channels);
+			GLenum glFormat = TextureBaker::getGLFormat(TextureBaker::getVkFormat(format));
+			int levels = getNumLevels(arrayWidth, arrayHeight);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+			for (int level = 0; level < levels; ++level) {
+				glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, glFormat, arrayWidth, arrayHeight, layers, 0,
+					(GLsizei)(TextureCompressor::getCompressedSize(arrayWidth, arrayHeight, format) * layers), nullptr);
+				arrayWidth = std::max(1, arrayWidth / 2);
+				arrayHeight = std::max(1, arrayHeight / 2);
+			}
+		}
+		else {
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, getInternalFormat(channels), arrayWidth, arrayHeight, layers, 0,
+				getFormat(channels), GL_UNSIGNED_BYTE, nullptr);
+		}
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		return texID;
+	}
+
+	// Decodifica a imagem (reamostrada para o tamanho do array) ou l os nveis comprimidos do cache KTX2;
+	// imagens de outro tamanho tm um cache prprio j reamostrado
+	static bool readLayer(const Image& image, LayerData& data) {
+		if (data.compressed) {
+			TextureCompressor::Format format = TextureBaker::chooseFormat(TextureLoader::compression, image.channels);
+			bool resized = image.width != image.sourceWidth || image.height != image.sourceHeight;
+			if (!TextureBaker::loadOrBake(image.path, format, data.image, resized ? image.width : 0, resized ? image.height : 0))
+				return false;
+			if ((int)data.image.levels.size() != getNumLevels(image.width, image.height)) {
+				std::cerr << "Nmero de mipmaps inesperado no cache da textura: " << image.path << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		int imageWidth, imageHeight, imageChannels;
+		unsigned char* pixels = TextureBaker::loadImage(image.path, imageWidth, imageHeight, imageChannels, image.channels);
+		if (pixels == nullptr) {
+			std::cerr << "Falha ao carregar a textura para o array: " << image.path << std::endl;
+			return false;
+		}
+		if (imageWidth != image.width || imageHeight != image.height)
+			data.pixels = TextureBaker::resample(pixels, imageWidth, imageHeight, image.channels, image.width, image.height);
+		else
+			data.pixels.assign(pixels, pixels + (size_t)imageWidth * imageHeight * image.channels);
+		stbi_image_free(pixels);
+		return true;
+	}
+
+	static void sendLayer(GLuint texID, const Image& image, int layer, const LayerData& data) {
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texID);
+		if (data.compressed) {
+			GLenum glFormat = TextureBaker::getGLFormat(data.image.vkFormat);
+			int levelWidth = image.width, levelHeight = image.height;
+			for (size_t level = 0; level < data.image.levels.size(); ++level) {
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, 0, 0, layer, levelWidth, levelHeight, 1, glFormat,
+					(GLsizei)data.image.levels[level].size(), data.image.levels[level].data());
+				levelWidth = std::max(1, levelWidth / 2);
+				levelHeight = std::max(1, levelHeight / 2);
+			}
+		}
+		else {
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, image.width, image.height, 1,
+				getFormat(image.channels), GL_UNSIGNED_BYTE, data.pixels.data());
+		}
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,209 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <climits>
+#include <cstring>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "../Common/include/stb_image.h"
+#include "TextureLoader.cpp"
+
+using namespace std;
+
+// Empacota vrias texturas pequenas em pginas de atlas (algoritmo skyline bottom-left).
+// Cada imagem ganha uma borda de "padding" pixels repetindo a borda original, para que os
+// nveis de mipmap no misturem texels de imagens vizinhas.
+class TextureAtlas
+{
+public:
+	vector<GLuint> pages;
+
+	TextureAtlas(int pageSize = 2048, int padding = 4) : pageSize(pageSize), padding(padding) {}
+
+	// Decodifica a imagem e a registra para o empacotamento (imagens repetidas so ignoradas)
+	bool add(const string& filepath) {
+		if (entries.count(filepath))
+			return true;
+
+		Image image;
+		image.path = filepath;
+		image.pixels = TextureBaker::loadImage(filepath, image.width, image.height, image.channels, 4);
+		if (image.pixels == nullptr) {
+			std::cerr << "Falha ao carregar a textura para o atlas: " << filepath << std::endl;
+			return false;
+		}
+		if (image.width + 2 * padding > pageSize || image.height + 2 * padding > pageSize) {
+			stbi_image_free(image.pixels);
+			return false;
+		}
+
+		entries[filepath] = { -1, glm::vec4(1.0f, 1.0f, 0.0f, 0.0f) };
+		images.push_back(image);
+		return true;
+	}
+
+	// Posiciona todas as imagens registradas e cria as pginas na OpenGL
+	void pack() {
+		// Mais altas primeiro: o skyline desperdia menos espao
+		std::sort(images.begin(), images.end(), [](const Image& a, const Image& b) {
+			return a.height != b.height ? a.height > b.height : a.width > b.width;
+		});
+
+		vector<vector<unsigned char>> pagePixels;
+		vector<vector<SkylineNode>> skylines;
+		usedArea.clear();
+
+		for (auto& image : images) {
+			int width = image.width + 2 * padding;
+			int height = image.height + 2 * padding;
+			int page = -1, x = 0, y = 0;
+
+			for (int p = 0; p < (int)skylines.size() && page < 0; ++p)
+				if (insert(skylines[p], width, height, x, y))
+					page = p;
+
+			if (page < 0) {
+				skylines.push_back({ { 0, 0, pageSize } });
+				pagePixels.push_back(vector<unsigned char>((size_t)pageSize * pageSize * 4, 0));
+				usedArea.push_back(0);
+				page = (int)skylines.size() - 1;
+				insert(skylines[page], width, height, x, y);
+			}
+
+			blit(pagePixels[page], image, x, y);
+			usedArea[page] += (double)image.width * image.height;
+
+			// Transformao aplicada s coordenadas de textura da malha: escala (xy) e deslocamento (zw)
+			entries[image.path] = { page, glm::vec4((float)image.width / pageSize, (float)image.height / pageSize,
+				(float)(x + padding) / pageSize, (float)(y + padding) / pageSize) };
+
+			stbi_image_free(image.pixels);
+			image.pixels = nullptr;
+		}
+		images.clear();
+
+		for (const auto& pixels : pagePixels)
+			pages.push_back(TextureLoader::createTexture(pixels.data(), pageSize, pageSize, 4));
+	}
+
+	bool contains(const string& filepath) const {
+		auto entry = entries.find(filepath);
+		return entry != entries.end() && entry->second.page >= 0;
+	}
+
+	GLuint getTexture(const string& filepath) const {
+		return pages[entries.at(filepath).page];
+	}
+
+	glm::vec4 getUVTransform(const string& filepath) const {
+		return entries.at(filepath).uvTransform;
+	}
+
+	int getNumTextures() const {
+		return (int)entries.size();
+	}
+
+	// Frao de cada pgina ocupada por texels teis (sem contar o padding)
+	float getOccupancy(int page) const {
+		return (float)(usedArea[page] / ((double)pageSize * pageSize));
+	}
+
+private:
+	struct Image {
+		string path;
+		int width = 0, height = 0, channels = 0;
+		unsigned char* pixels = nullptr;
+	};
+
+	struct Entry {
+		int page;
+		glm::vec4 uvTransform;
+	};
+
+	struct SkylineNode {
+		int x, y, width;
+	};
+
+	int pageSize, padding;
+	vector<Image> images;
+	unordered_map<string, Entry> entries;
+	vector<double> usedArea;
+
+	// Menor altura em que um retngulo de largura "width" cabe a partir do n "index" (-1 se no cabe)
+	int fit(const vector<SkylineNode>& skyline, int index, int width, int height) const {
+		if (skyline[index].x + width > pageSize)
+			return -1;
+
+		int y = 0, remaining = width;
+		for (int i = index; remaining > 0; ++i) {
+			if (i >= (int)skyline.size())
+				return -1;
+			y = std::max(y, skyline[i].y);
+			if (y + height > pageSize)
+				return -1;
+			remaining -= skyline[i].width;
+		}
+		return y;
+	}
+
+	bool insert(vector<SkylineNode>& skyline, int width, int height, int& x, int& y) {
+		int bestIndex = -1, bestY = INT_MAX, bestWidth = INT_MAX;
+
+		for (int i = 0; i < (int)skyline.size(); ++i) {
+			int candidateY = fit(skyline, i, width, height);
+			if (candidateY >= 0 && (candidateY < bestY || (candidateY == bestY && skyline[i].width < bestWidth))) {
+				bestIndex = i;
+				bestY = candidateY;
+				bestWidth = skyline[i].width;
+			}
+		}
+		if (bestIndex < 0)
+			return false;
+
+		x = skyline[bestIndex].x;
+		y = bestY;
+
+		// O novo n cobre os ns que ficaram por baixo do retngulo
+		skyline.insert(skyline.begin() + bestIndex, { x, y + height, width });
+		for (int i = bestIndex + 1; i < (int)skyline.size(); ++i) {
+			int shrink = skyline[i - 1].x + skyline[i - 1].width - skyline[i].x;
+			if (shrink <= 0)
+				break;
+			skyline[i].x += shrink;
+			skyline[i].width -= shrink;
+			if (skyline[i].width > 0)
+				break;
+			skyline.erase(skyline.begin() + i);
+			--i;
+		}
+
+		// Junta ns vizinhos de mesma altura
+		for (int i = 0; i + 1 < (int)skyline.size(); ++i) {
+			if (skyline[i].y == skyline[i + 1].y) {
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase(skyline.begin() + i + 1);
+				--i;
+			}
+		}
+		return true;
+	}
+
+	// Copia a imagem para a pgina repetindo os pixels da borda na rea de padding
+	void blit(vector<unsigned char>& page, const Image& image, int x, int y) const {
+		int width = image.width + 2 * padding;
+		int height = image.height + 2 * padding;
+
+		for (int row = 0; row < height; ++row) {
+			int sourceRow = glm::clamp(row - padding, 0, image.height - 1);
+			for (int column = 0; column < width; ++column) {
+				int sourceColumn = glm::clamp(column - padding, 0, image.width - 1);
+				const unsigned char* source = image.pixels + ((size_t)sourceRow * image.width + sourceColumn) * 4;
+				unsigned char* target = page.data() + ((size_t)(y + row) * pageSize + (x + column)) * 4;
+				memcpy(target, source, 4);
+			}
+		}
+	}
+};
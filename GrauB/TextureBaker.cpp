@@ -0,0 +1,203 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <filesystem>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "../Common/include/stb_image.h"
+#include "TextureCompressor.cpp"
+#include "KTX2File.cpp"
+#include "VirtualFileSystem.cpp"
+
+using namespace std;
+
+// Formatos de bloco que no fazem parte do GLAD 3.3 (S3TC  extenso, BPTC  do ncleo 4.2)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+// Prepara texturas comprimidas: gera os mipmaps na CPU, comprime cada nvel e guarda o resultado num
+// arquivo KTX2 ao lado da imagem. Nas prximas execues o KTX2  lido direto, sem decodificar nem comprimir.
+class TextureBaker
+{
+public:
+	// Formato de bloco para a configurao "bc1", "bc3", "bc7" ou "auto" (BC1 sem alfa, BC3 com alfa)
+	static TextureCompressor::Format chooseFormat(const string& compression, int channels) {
+		if (compression == "bc3")
+			return TextureCompressor::BC3;
+		if (compression == "bc7")
+			return TextureCompressor::BC7;
+		if (compression == "auto" && channels == 4)
+			return TextureCompressor::BC3;
+		return TextureCompressor::BC1;
+	}
+
+	static uint32_t getVkFormat(TextureCompressor::Format format) {
+		return format == TextureCompressor::BC1 ? KTX2File::formatBC1 : format == TextureCompressor::BC3 ? KTX2File::formatBC3 : KTX2File::formatBC7;
+	}
+
+	static GLenum getGLFormat(uint32_t vkFormat) {
+		return vkFormat == KTX2File::formatBC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT :
+			vkFormat == KTX2File::formatBC3 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+
+	static string getFormatName(TextureCompressor::Format format) {
+		return format == TextureCompressor::BC1 ? "bc1" : format == TextureCompressor::BC3 ? "bc3" : "bc7";
+	}
+
+	// Decodifica uma imagem lida pelo VirtualFileSystem (do pacote de assets ou do disco); liberar com stbi_image_free
+	static unsigned char* loadImage(const string& filepath, int& width, int& height, int& channels, int desiredChannels = 0) {
+		VirtualFile file(filepath);
+		if (!file.isOpen())
+			return nullptr;
+		return stbi_load_from_memory(file.data(), (int)file.size(), &width, &height, &channels, desiredChannels);
+	}
+
+	// S o cabealho da imagem: dimenses e nmero de canais
+	static bool getImageInfo(const string& filepath, int& width, int& height, int& channels) {
+		VirtualFile file(filepath);
+		return file.isOpen() && stbi_info_from_memory(file.data(), (int)file.size(), &width, &height, &channels);
+	}
+
+	// Caminho do cache: "Terra.jpg" vira "Terra.jpg.bc1.ktx2" (ou "Terra.jpg.2048x1024.bc1.ktx2" se reamostrada)
+	static string getCachePath(const string& filepath, TextureCompressor::Format format, int width = 0, int height = 0) {
+		string size = width > 0 && height > 0 ? "." + to_string(width) + "x" + to_string(height) : "";
+		return filepath + size + "." + getFormatName(format) + ".ktx2";
+	}
+
+	// L o KTX2 do cache se ele for mais novo que a imagem; seno comprime a imagem e grava o cache
+	static bool loadOrBake(const string& filepath, TextureCompressor::Format format, CompressedImage& image, int width = 0, int height = 0) {
+		string cachePath = getCachePath(filepath, format, width, height);
+		if (isCacheValid(filepath, cachePath) && KTX2File::read(cachePath, image) && image.vkFormat == getVkFormat(format) &&
+			(width <= 0 || (image.width == width && image.height == height)))
+			return true;
+
+		if (!bake(filepath, format, image, width, height))
+			return false;
+		if (!KTX2File::write(cachePath, image))
+			std::cerr << "No foi possvel gravar o cache da textura: " << cachePath << std::endl;
+		return true;
+	}
+
+	// Decodifica a imagem, reamostra para width x height (se informado), gera os mipmaps e comprime todos os nveis
+	static bool bake(const string& filepath, TextureCompressor::Format format, CompressedImage& image, int width = 0, int height = 0) {
+		int imageWidth, imageHeight, channels;
+		unsigned char* data = loadImage(filepath, imageWidth, imageHeight, channels, 4);
+		if (data == nullptr) {
+			std::cerr << "Falha ao carregar a textura: " << filepath << std::endl;
+			return false;
+		}
+
+		vector<unsigned char> pixels;
+		if (width > 0 && height > 0 && (width != imageWidth || height != imageHeight)) {
+			pixels = resample(data, imageWidth, imageHeight, 4, width, height);
+			imageWidth = width;
+			imageHeight = height;
+		}
+		else {
+			pixels.assign(data, data + (size_t)imageWidth * imageHeight * 4);
+		}
+		stbi_image_free(data);
+
+		image.vkFormat = getVkFormat(format);
+		image.width = imageWidth;
+		image.height = imageHeight;
+		image.levels.clear();
+
+		int levelWidth = imageWidth, levelHeight = imageHeight;
+		while (true) {
+			image.levels.push_back(TextureCompressor::compress(pixels.data(), levelWidth, levelHeight, format));
+			if (levelWidth == 1 && levelHeight == 1)
+				break;
+			pixels = downsample(pixels, levelWidth, levelHeight);
+			levelWidth = std::max(1, levelWidth / 2);
+			levelHeight = std::max(1, levelHeight / 2);
+		}
+		return true;
+	}
+
+	// Prximo nvel de mipmap: mdia de 2x2 pixels feita em luz linear (as imagens esto em sRGB),
+	// o que evita o escurecimento das bordas que a mdia direta dos valores causa
+	static vector<unsigned char> downsample(const vector<unsigned char>& rgba, int width, int height) {
+		static const vector<float> toLinear = buildLinearTable();
+
+		int targetWidth = std::max(1, width / 2), targetHeight = std::max(1, height / 2);
+		vector<unsigned char> target((size_t)targetWidth * targetHeight * 4);
+		for (int y = 0; y < targetHeight; ++y) {
+			int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+			for (int x = 0; x < targetWidth; ++x) {
+				int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+				const unsigned char* p[4] = {
+					&rgba[((size_t)y0 * width + x0) * 4], &rgba[((size_t)y0 * width + x1) * 4],
+					&rgba[((size_t)y1 * width + x0) * 4], &rgba[((size_t)y1 * width + x1) * 4]
+				};
+				unsigned char* output = &target[((size_t)y * targetWidth + x) * 4];
+				for (int c = 0; c < 3; ++c)
+					output[c] = toSRGB((toLinear[p[0][c]] + toLinear[p[1][c]] + toLinear[p[2][c]] + toLinear[p[3][c]]) * 0.25f);
+				output[3] = (unsigned char)((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) / 4);
+			}
+		}
+		return target;
+	}
+
+	// Reamostragem bilinear (centros de texel alinhados), suficiente para igualar tamanhos prximos
+	static vector<unsigned char> resample(const unsigned char* source, int sourceWidth, int sourceHeight, int channels,
+		int targetWidth, int targetHeight) {
+		vector<unsigned char> target((size_t)targetWidth * targetHeight * channels);
+		float scaleX = (float)sourceWidth / targetWidth;
+		float scaleY = (float)sourceHeight / targetHeight;
+
+		for (int y = 0; y < targetHeight; ++y) {
+			float sy = glm::clamp((y + 0.5f) * scaleY - 0.5f, 0.0f, (float)(sourceHeight - 1));
+			int y0 = (int)sy, y1 = glm::min(y0 + 1, sourceHeight - 1);
+			float fy = sy - y0;
+
+			for (int x = 0; x < targetWidth; ++x) {
+				float sx = glm::clamp((x + 0.5f) * scaleX - 0.5f, 0.0f, (float)(sourceWidth - 1));
+				int x0 = (int)sx, x1 = glm::min(x0 + 1, sourceWidth - 1);
+				float fx = sx - x0;
+
+				for (int c = 0; c < channels; ++c) {
+					float top = source[((size_t)y0 * sourceWidth + x0) * channels + c] * (1.0f - fx) + source[((size_t)y0 * sourceWidth + x1) * channels + c] * fx;
+					float bottom = source[((size_t)y1 * sourceWidth + x0) * channels + c] * (1.0f - fx) + source[((size_t)y1 * sourceWidth + x1) * channels + c] * fx;
+					target[((size_t)y * targetWidth + x) * channels + c] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+				}
+			}
+		}
+		return target;
+	}
+
+private:
+	// Um cache que veio no pacote de assets foi gravado pelo empacotador junto com a imagem e vale enquanto o pacote
+	// estiver montado; no disco, vale se for mais novo que a imagem
+	static bool isCacheValid(const string& filepath, const string& cachePath) {
+		if (VirtualFileSystem::isPacked(cachePath))
+			return true;
+		std::error_code error;
+		if (!std::filesystem::exists(cachePath, error))
+			return false;
+		return std::filesystem::last_write_time(cachePath, error) >= std::filesystem::last_write_time(filepath, error) && !error;
+	}
+
+	static vector<float> buildLinearTable() {
+		vector<float> table(256);
+		for (int i = 0; i < 256; ++i) {
+			float value = i / 255.0f;
+			table[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+		return table;
+	}
+
+	static unsigned char toSRGB(float linear) {
+		float value = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+		return (unsigned char)std::min(std::max(value * 255.0f + 0.5f, 0.0f), 255.0f);
+	}
+};
\ No newline at end of file
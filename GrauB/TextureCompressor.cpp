@@ -0,0 +1,363 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+using namespace std;
+
+// Codifica imagens RGBA em blocos 4x4 comprimidos: BC1 (RGB, 8 bytes por bloco), BC3 (RGBA, 16 bytes)
+// e BC7 modo 6 (RGBA, 16 bytes). Os eixos das cores de cada bloco so estimados por anlise de
+// componentes principais; as linhas de blocos so divididas entre vrias threads.
+class TextureCompressor
+{
+public:
+	enum Format { BC1, BC3, BC7 };
+
+	static int getBlockSize(Format format) {
+		return format == BC1 ? 8 : 16;
+	}
+
+	static size_t getCompressedSize(int width, int height, Format format) {
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+	}
+
+	static vector<unsigned char> compress(const unsigned char* rgba, int width, int height, Format format, int numThreads = 0) {
+		int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+		int blockSize = getBlockSize(format);
+		vector<unsigned char> output((size_t)blocksX * blocksY * blockSize);
+
+		if (numThreads <= 0)
+			numThreads = (int)std::max(1u, thread::hardware_concurrency());
+		numThreads = std::min(numThreads, blocksY);
+
+		auto encodeRows = [&](int firstRow, int lastRow) {
+			unsigned char block[64];
+			for (int by = firstRow; by < lastRow; ++by) {
+				for (int bx = 0; bx < blocksX; ++bx) {
+					fetchBlock(rgba, width, height, bx, by, block);
+					encodeBlock(block, format, output.data() + ((size_t)by * blocksX + bx) * blockSize);
+				}
+			}
+		};
+
+		if (numThreads <= 1) {
+			encodeRows(0, blocksY);
+			return output;
+		}
+
+		vector<thread> threads;
+		for (int t = 0; t < numThreads; ++t)
+			threads.emplace_back(encodeRows, blocksY * t / numThreads, blocksY * (t + 1) / numThreads);
+		for (auto& worker : threads)
+			worker.join();
+		return output;
+	}
+
+	// Codifica um bloco de 16 pixels RGBA (64 bytes, linha a linha)
+	static void encodeBlock(const unsigned char* block, Format format, unsigned char* output) {
+		switch (format) {
+		case BC1:
+			encodeColor(block, output);
+			break;
+		case BC3:
+			encodeAlpha(block, output);
+			encodeColor(block, output + 8);
+			break;
+		case BC7:
+			encodeBC7Mode6(block, output);
+			break;
+		}
+	}
+
+private:
+	// Copia o bloco (bx, by); nas bordas de imagens com tamanho no mltiplo de 4 repete o ltimo pixel
+	static void fetchBlock(const unsigned char* rgba, int width, int height, int bx, int by, unsigned char* block) {
+		for (int y = 0; y < 4; ++y) {
+			int sy = std::min(by * 4 + y, height - 1);
+			for (int x = 0; x < 4; ++x) {
+				int sx = std::min(bx * 4 + x, width - 1);
+				memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+			}
+		}
+	}
+
+	// Eixo principal dos pixels do bloco (nos "channels" primeiros canais), por iterao de potncia sobre a covarincia
+	static void principalAxis(const unsigned char* block, int channels, float* mean, float* axis) {
+		float covariance[4][4] = {};
+		for (int c = 0; c < channels; ++c) {
+			mean[c] = 0.0f;
+			for (int i = 0; i < 16; ++i)
+				mean[c] += block[i * 4 + c];
+			mean[c] /= 16.0f;
+		}
+		for (int i = 0; i < 16; ++i)
+			for (int a = 0; a < channels; ++a)
+				for (int b = a; b < channels; ++b)
+					covariance[a][b] += (block[i * 4 + a] - mean[a]) * (block[i * 4 + b] - mean[b]);
+		for (int a = 0; a < channels; ++a)
+			for (int b = 0; b < a; ++b)
+				covariance[a][b] = covariance[b][a];
+
+		for (int c = 0; c < channels; ++c)
+			axis[c] = 1.0f;
+		for (int iteration = 0; iteration < 8; ++iteration) {
+			float next[4] = {}, length = 0.0f;
+			for (int a = 0; a < channels; ++a) {
+				for (int b = 0; b < channels; ++b)
+					next[a] += covariance[a][b] * axis[b];
+				length = std::max(length, std::fabs(next[a]));
+			}
+			if (length < 1e-6f)
+				break;
+			for (int c = 0; c < channels; ++c)
+				axis[c] = next[c] / length;
+		}
+
+		float length = 0.0f;
+		for (int c = 0; c < channels; ++c)
+			length += axis[c] * axis[c];
+		length = std::sqrt(length);
+		for (int c = 0; c < channels; ++c)
+			axis[c] = length > 0.0f ? axis[c] / length : 0.0f;
+	}
+
+	// Extremos da projeo dos pixels sobre o eixo principal
+	static void axisEndpoints(const unsigned char* block, int channels, float* low, float* high) {
+		float mean[4], axis[4];
+		principalAxis(block, channels, mean, axis);
+
+		float minProjection = 0.0f, maxProjection = 0.0f;
+		for (int i = 0; i < 16; ++i) {
+			float projection = 0.0f;
+			for (int c = 0; c < channels; ++c)
+				projection += (block[i * 4 + c] - mean[c]) * axis[c];
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+		for (int c = 0; c < channels; ++c) {
+			low[c] = std::min(std::max(mean[c] + axis[c] * minProjection, 0.0f), 255.0f);
+			high[c] = std::min(std::max(mean[c] + axis[c] * maxProjection, 0.0f), 255.0f);
+		}
+	}
+
+	static uint16_t packRGB565(const float* color) {
+		int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+		int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+		int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	static void unpackRGB565(uint16_t packed, int* color) {
+		int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// Escolhe para cada pixel a cor mais prxima da paleta de 4 cores; retorna o erro quadrtico total
+	static int colorIndices(const unsigned char* block, uint16_t c0, uint16_t c1, unsigned char* indices) {
+		int palette[4][3];
+		unpackRGB565(c0, palette[0]);
+		unpackRGB565(c1, palette[1]);
+		for (int c = 0; c < 3; ++c) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		int totalError = 0;
+		for (int i = 0; i < 16; ++i) {
+			int bestError = INT32_MAX;
+			for (int p = 0; p < 4; ++p) {
+				int dr = block[i * 4] - palette[p][0], dg = block[i * 4 + 1] - palette[p][1], db = block[i * 4 + 2] - palette[p][2];
+				int error = dr * dr + dg * dg + db * db;
+				if (error < bestError) {
+					bestError = error;
+					indices[i] = (unsigned char)p;
+				}
+			}
+			totalError += bestError;
+		}
+		return totalError;
+	}
+
+	// Recalcula os extremos por mnimos quadrados a partir dos ndices escolhidos
+	static bool refineEndpoints(const unsigned char* block, const unsigned char* indices, float* c0, float* c1) {
+		static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f, ax[3] = {}, bx[3] = {};
+		for (int i = 0; i < 16; ++i) {
+			float a = weights[indices[i]], b = 1.0f - a;
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			for (int c = 0; c < 3; ++c) {
+				ax[c] += a * block[i * 4 + c];
+				bx[c] += b * block[i * 4 + c];
+			}
+		}
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f)
+			return false;
+		for (int c = 0; c < 3; ++c) {
+			c0[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / determinant, 0.0f), 255.0f);
+			c1[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / determinant, 0.0f), 255.0f);
+		}
+		return true;
+	}
+
+	// Parte de cor do BC1/BC3, sempre no modo de 4 cores (c0 > c1)
+	static void encodeColor(const unsigned char* block, unsigned char* output) {
+		float low[3], high[3];
+		axisEndpoints(block, 3, low, high);
+
+		uint16_t c0 = packRGB565(high), c1 = packRGB565(low);
+		unsigned char indices[16];
+		int error = colorIndices(block, c0, c1, indices);
+
+		float refined0[3], refined1[3];
+		unsigned char refinedIndices[16];
+		if (error > 0 && refineEndpoints(block, indices, refined0, refined1)) {
+			uint16_t r0 = packRGB565(refined0), r1 = packRGB565(refined1);
+			if (colorIndices(block, r0, r1, refinedIndices) < error) {
+				c0 = r0;
+				c1 = r1;
+				memcpy(indices, refinedIndices, 16);
+			}
+		}
+
+		// Com c0 <= c1 o decodificador usaria o modo de 3 cores: troca os extremos e remapeia os ndices
+		static const unsigned char swapped[4] = { 1, 0, 3, 2 };
+		if (c0 < c1) {
+			std::swap(c0, c1);
+			for (int i = 0; i < 16; ++i)
+				indices[i] = swapped[indices[i]];
+		}
+		else if (c0 == c1) {
+			memset(indices, 0, 16);
+		}
+
+		uint32_t bits = 0;
+		for (int i = 0; i < 16; ++i)
+			bits |= (uint32_t)indices[i] << (i * 2);
+
+		output[0] = c0 & 0xFF;
+		output[1] = c0 >> 8;
+		output[2] = c1 & 0xFF;
+		output[3] = c1 >> 8;
+		memcpy(output + 4, &bits, 4);
+	}
+
+	// Bloco de alfa do BC3 no modo de 8 valores (a0 > a1), ndices de 3 bits
+	static void encodeAlpha(const unsigned char* block, unsigned char* output) {
+		int a0 = 0, a1 = 255;
+		for (int i = 0; i < 16; ++i) {
+			a0 = std::max(a0, (int)block[i * 4 + 3]);
+			a1 = std::min(a1, (int)block[i * 4 + 3]);
+		}
+
+		output[0] = (unsigned char)a0;
+		output[1] = (unsigned char)a1;
+		uint64_t bits = 0;
+		if (a0 > a1) {
+			int palette[8] = { a0, a1 };
+			for (int p = 2; p < 8; ++p)
+				palette[p] = ((8 - p) * a0 + (p - 1) * a1) / 7;
+			for (int i = 0; i < 16; ++i) {
+				int alpha = block[i * 4 + 3], best = 0;
+				for (int p = 1; p < 8; ++p)
+					if (std::abs(alpha - palette[p]) < std::abs(alpha - palette[best]))
+						best = p;
+				bits |= (uint64_t)best << (i * 3);
+			}
+		}
+		for (int b = 0; b < 6; ++b)
+			output[2 + b] = (unsigned char)(bits >> (b * 8));
+	}
+
+	// Escreve "count" bits a partir do bit "position" (bloco de 128 bits, menos significativo primeiro)
+	static void writeBits(unsigned char* output, int& position, uint32_t value, int count) {
+		for (int b = 0; b < count; ++b, ++position)
+			if (value & (1u << b))
+				output[position >> 3] |= (unsigned char)(1u << (position & 7));
+	}
+
+	// Quantiza um extremo para 7 bits + bit p compartilhado pelos quatro canais, escolhendo o p de menor erro
+	static void quantizeBC7Endpoint(const float* endpoint, int* quantized, int& pBit) {
+		float bestError = 1e30f;
+		for (int p = 0; p < 2; ++p) {
+			int candidate[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; ++c) {
+				candidate[c] = std::min(std::max((int)std::lround((endpoint[c] - p) / 2.0f), 0), 127);
+				float value = (float)((candidate[c] << 1) | p);
+				error += (value - endpoint[c]) * (value - endpoint[c]);
+			}
+			if (error < bestError) {
+				bestError = error;
+				pBit = p;
+				memcpy(quantized, candidate, sizeof(candidate));
+			}
+		}
+	}
+
+	// BC7 modo 6: um subconjunto, extremos RGBA de 7 bits + bit p, ndices de 4 bits (16 nveis)
+	static void encodeBC7Mode6(const unsigned char* block, unsigned char* output) {
+		static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		float low[4], high[4];
+		axisEndpoints(block, 4, low, high);
+
+		int e0[4], e1[4], p0, p1;
+		quantizeBC7Endpoint(low, e0, p0);
+		quantizeBC7Endpoint(high, e1, p1);
+
+		int endpoint0[4], endpoint1[4];
+		for (int c = 0; c < 4; ++c) {
+			endpoint0[c] = (e0[c] << 1) | p0;
+			endpoint1[c] = (e1[c] << 1) | p1;
+		}
+
+		int palette[16][4];
+		for (int w = 0; w < 16; ++w)
+			for (int c = 0; c < 4; ++c)
+				palette[w][c] = ((64 - weights[w]) * endpoint0[c] + weights[w] * endpoint1[c] + 32) >> 6;
+
+		unsigned char indices[16];
+		for (int i = 0; i < 16; ++i) {
+			int bestError = INT32_MAX;
+			for (int w = 0; w < 16; ++w) {
+				int error = 0;
+				for (int c = 0; c < 4; ++c) {
+					int d = block[i * 4 + c] - palette[w][c];
+					error += d * d;
+				}
+				if (error < bestError) {
+					bestError = error;
+					indices[i] = (unsigned char)w;
+				}
+			}
+		}
+
+		// O ndice do primeiro pixel  gravado com 3 bits: o bit mais alto precisa ser 0
+		if (indices[0] >= 8) {
+			std::swap(e0, e1);
+			std::swap(p0, p1);
+			for (int i = 0; i < 16; ++i)
+				indices[i] = (unsigned char)(15 - indices[i]);
+		}
+
+		memset(output, 0, 16);
+		int position = 0;
+		writeBits(output, position, 1u << 6, 7);
+		for (int c = 0; c < 4; ++c) {
+			writeBits(output, position, (uint32_t)e0[c], 7);
+			writeBits(output, position, (uint32_t)e1[c], 7);
+		}
+		writeBits(output, position, (uint32_t)p0, 1);
+		writeBits(output, position, (uint32_t)p1, 1);
+		for (int i = 0; i < 16; ++i)
+			writeBits(output, position, indices[i], i == 0 ? 3 : 4);
+	}
+};
\ No newline at end of file
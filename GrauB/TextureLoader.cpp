@@ -0,0 +1,366 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <unordered_map>
+#include <glad/glad.h>
+#include "../Common/include/stb_image.h"
+#include "TextureBaker.cpp"
+#include "UploadManager.cpp"
+#include "TextureResidency.cpp"
+#include "Profiler.cpp"
+
+using namespace std;
+
+// Carrega imagens (de arquivo ou da memria) e cria as texturas na OpenGL
+class TextureLoader
+{
+public:
+	// Compresso das texturas de arquivo: "" (sem compresso), "bc1", "bc3", "bc7" ou "auto"
+	inline static string compression;
+	// Memria de vdeo estimada de todas as texturas criadas (com mipmaps), em bytes; as texturas do
+	// TextureResidency ficam de fora e so contadas por ele
+	inline static size_t textureMemory = 0;
+
+	// Texturas de arquivo ficam em cache pelo caminho: objetos que usam a mesma imagem compartilham a textura
+	static GLuint loadTexture(string filepath)
+	{
+		auto cached = loadedTextures.find(filepath);
+		if (cached != loadedTextures.end())
+			return cached->second;
+
+		if (TextureResidency::current != nullptr) {
+			int width, height, nrChannels;
+			if (TextureBaker::getImageInfo(filepath, width, height, nrChannels)) {
+				TextureCompressor::Format format = TextureBaker::chooseFormat(compression, nrChannels);
+				bool compressed = !compression.empty() && isFormatSupported(format);
+				GLuint texID = TextureResidency::current->registerTexture(filepath, compressed, format);
+				if (texID != 0) {
+					loadedTextures[filepath] = texID;
+					return texID;
+				}
+			}
+		}
+
+		if (UploadManager::current != nullptr) {
+			GLuint texID = streamTexture(filepath);
+			if (texID != 0) {
+				loadedTextures[filepath] = texID;
+				return texID;
+			}
+		}
+
+		if (!compression.empty()) {
+			GLuint texID = loadCompressedTexture(filepath);
+			if (texID != 0) {
+				loadedTextures[filepath] = texID;
+				return texID;
+			}
+		}
+
+		//Carregamento da imagem
+		int width, height, nrChannels;
+		unsigned char* data = TextureBaker::loadImage(filepath, width, height, nrChannels);
+
+		if (!data)
+		{
+			std::cout << "Falha ao carregar a textura" << std::endl;
+			return 0;
+		}
+
+		GLuint texID = createTexture(data, width, height, nrChannels);
+		stbi_image_free(data);
+		loadedTextures[filepath] = texID;
+		return texID;
+	}
+
+	// Textura enviada em segundo plano pelo UploadManager ativo (fica cinza at os dados chegarem)
+	static GLuint streamTexture(const string& filepath)
+	{
+		int width, height, nrChannels;
+		if (!TextureBaker::getImageInfo(filepath, width, height, nrChannels)) {
+			std::cout << "Falha ao carregar a textura" << std::endl;
+			return 0;
+		}
+
+		TextureCompressor::Format format = TextureBaker::chooseFormat(compression, nrChannels);
+		bool compressed = !compression.empty() && isFormatSupported(format);
+		GLuint texID = UploadManager::current->streamTexture(filepath, compressed, format);
+
+		size_t bytes = 0;
+		if (compressed) {
+			for (int levelWidth = width, levelHeight = height; ; levelWidth = std::max(1, levelWidth / 2), levelHeight = std::max(1, levelHeight / 2)) {
+				bytes += TextureCompressor::getCompressedSize(levelWidth, levelHeight, format);
+				if (levelWidth == 1 && levelHeight == 1)
+					break;
+			}
+		}
+		else {
+			bytes = (size_t)width * height * nrChannels * 4 / 3;
+		}
+		trackMemory(texID, bytes);
+		return texID;
+	}
+
+	// Textura com os mipmaps pr-comprimidos do cache KTX2 (gerado na primeira vez)
+	static GLuint loadCompressedTexture(const string& filepath)
+	{
+		int width, height, nrChannels;
+		if (!TextureBaker::getImageInfo(filepath, width, height, nrChannels))
+			return 0;
+
+		TextureCompressor::Format format = TextureBaker::chooseFormat(compression, nrChannels);
+		if (!isFormatSupported(format))
+			return 0;
+
+		CompressedImage image;
+		if (!TextureBaker::loadOrBake(filepath, format, image))
+			return 0;
+		return createCompressedTexture(image);
+	}
+
+	static GLuint createCompressedTexture(const CompressedImage& image)
+	{
+		GLenum format = TextureBaker::getGLFormat(image.vkFormat);
+		GLuint texID;
+		glGenTextures(1, &texID);
+		glBindTexture(GL_TEXTURE_2D, texID);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+
+		int width = image.width, height = image.height;
+		size_t bytes = 0;
+		for (size_t level = 0; level < image.levels.size(); ++level) {
+			glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, format, width, height, 0, (GLsizei)image.levels[level].size(), image.levels[level].data());
+			bytes += image.levels[level].size();
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+		}
+		trackMemory(texID, bytes);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return texID;
+	}
+
+	// Consulta a lista de formatos comprimidos do driver uma vez; sem suporte, a textura  enviada sem compresso
+	static bool isFormatSupported(TextureCompressor::Format format)
+	{
+		if (supportedFormats.empty()) {
+			GLint count = 0;
+			glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+			supportedFormats.resize(std::max(count, 1), 0);
+			if (count > 0)
+				glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, supportedFormats.data());
+		}
+
+		GLenum glFormat = TextureBaker::getGLFormat(TextureBaker::getVkFormat(format));
+		for (GLint supported : supportedFormats)
+			if ((GLenum)supported == glFormat)
+				return true;
+
+		std::cerr << "Formato comprimido no suportado pelo driver: " << TextureBaker::getFormatName(format) << std::endl;
+		return false;
+	}
+
+	// Apaga uma textura que deixou de ser usada (ex.: substituda por um atlas)
+	static void releaseTexture(GLuint texID)
+	{
+		for (auto it = loadedTextures.begin(); it != loadedTextures.end(); ++it) {
+			if (it->second == texID) {
+				loadedTextures.erase(it);
+				break;
+			}
+		}
+		trackMemory(texID, 0);
+		if (UploadManager::current != nullptr)
+			UploadManager::current->cancelTexture(texID);
+		if (TextureResidency::current != nullptr)
+			TextureResidency::current->releaseTexture(texID);
+		glDeleteTextures(1, &texID);
+	}
+
+	// Registra o tamanho de uma textura (0 quando ela  apagada) e atualiza textureMemory
+	static void trackMemory(GLuint texID, size_t bytes)
+	{
+		textureMemory -= textureSizes[texID];
+		textureMemory += bytes;
+		if (bytes > 0)
+			textureSizes[texID] = bytes;
+		else
+			textureSizes.erase(texID);
+	}
+
+	// Carrega uma imagem codificada (PNG, JPG...) que j est em memria, como as embutidas em arquivos GLB
+	static GLuint loadTextureFromMemory(const unsigned char* bytes, size_t size, bool flipVertically = false)
+	{
+		int width, height, nrChannels;
+		unsigned char* data = stbi_load_from_memory(bytes, (int)size, &width, &height, &nrChannels, 0);
+
+		if (!data)
+		{
+			std::cout << "Falha ao carregar a textura embutida" << std::endl;
+			return 0;
+		}
+
+		if (flipVertically)
+			flipRows(data, width, height, nrChannels);
+
+		GLuint texID = createTexture(data, width, height, nrChannels);
+		stbi_image_free(data);
+		return texID;
+	}
+
+	static GLuint createTexture(const unsigned char* data, int width, int height, int nrChannels)
+	{
+		GLenum format;
+		switch (nrChannels) {
+		case 1:
+			format = GL_RED;
+			break;
+		case 3:
+			format = GL_RGB;
+			break;
+		case 4:
+			format = GL_RGBA;
+			break;
+		default:
+			std::cerr << "Nmero de canais no suportado: " << nrChannels << std::endl;
+			return 0;
+		}
+
+		GLuint texID;
+
+		// Gera o identificador da textura na memria 
+		glGenTextures(1, &texID);
+		glBindTexture(GL_TEXTURE_2D, texID);
+
+		//Ajusta os parmetros de wrapping e filtering
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// Linhas de imagens RGB com largura mpar no so alinhadas em 4 bytes
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		trackMemory(texID, (size_t)width * height * nrChannels * 4 / 3);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return texID;
+	}
+
+	// Textura de arquivo j criada para este caminho (0 se no houver, ex.: imagem que foi para um atlas ou array)
+	static GLuint findTexture(const string& filepath)
+	{
+		auto cached = loadedTextures.find(filepath);
+		return cached != loadedTextures.end() ? cached->second : 0;
+	}
+
+	// Imagem nova de uma textura de arquivo, lida fora da thread da OpenGL para recarregar a textura (hot reload)
+	struct TextureSource {
+		bool compressed = false;
+		TextureCompressor::Format format = TextureCompressor::BC1;
+		int width = 0, height = 0, channels = 0;
+		vector<unsigned char> pixels;
+		CompressedImage image;
+	};
+
+	// Na thread da OpenGL: decide se a imagem recarregada vai comprimida, como em loadTexture
+	static bool prepareSource(const string& filepath, TextureSource& source)
+	{
+		if (!TextureBaker::getImageInfo(filepath, source.width, source.height, source.channels))
+			return false;
+		source.format = TextureBaker::chooseFormat(compression, source.channels);
+		source.compressed = !compression.empty() && isFormatSupported(source.format);
+		return true;
+	}
+
+	// Em qualquer thread: decodifica a imagem (ou refaz o cache KTX2 dela)
+	static bool readSource(const string& filepath, TextureSource& source)
+	{
+		PROFILE_ZONE("TextureLoader::readSource");
+		if (source.compressed)
+			return TextureBaker::loadOrBake(filepath, source.format, source.image);
+
+		// Imagens de 2 canais (cinza e alfa) viram RGBA, como no h formato 2D para elas aqui
+		int desiredChannels = source.channels == 2 ? 4 : 0;
+		unsigned char* data = TextureBaker::loadImage(filepath, source.width, source.height, source.channels, desiredChannels);
+		if (data == nullptr)
+			return false;
+		if (desiredChannels != 0)
+			source.channels = desiredChannels;
+		source.pixels.assign(data, data + (size_t)source.width * source.height * source.channels);
+		stbi_image_free(data);
+		return true;
+	}
+
+	// Troca o contedo da textura sem trocar o identificador, ento os materiais que a usam no mudam
+	static void updateTexture(GLuint texID, const TextureSource& source)
+	{
+		if (UploadManager::current != nullptr)
+			UploadManager::current->cancelTexture(texID);
+
+		glBindTexture(GL_TEXTURE_2D, texID);
+		if (source.compressed) {
+			GLenum format = TextureBaker::getGLFormat(source.image.vkFormat);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)source.image.levels.size() - 1);
+			int width = source.image.width, height = source.image.height;
+			size_t bytes = 0;
+			for (size_t level = 0; level < source.image.levels.size(); ++level) {
+				glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, format, width, height, 0, (GLsizei)source.image.levels[level].size(), source.image.levels[level].data());
+				bytes += source.image.levels[level].size();
+				width = std::max(1, width / 2);
+				height = std::max(1, height / 2);
+			}
+			trackMemory(texID, bytes);
+		}
+		else {
+			GLenum format = source.channels == 1 ? GL_RED : source.channels == 3 ? GL_RGB : GL_RGBA;
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexImage2D(GL_TEXTURE_2D, 0, format, source.width, source.height, 0, format, GL_UNSIGNED_BYTE, source.pixels.data());
+			glGenerateMipmap(GL_TEXTURE_2D);
+			trackMemory(texID, (size_t)source.width * source.height * source.channels * 4 / 3);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	// Cria a textura de arquivo com a imagem j lida por readSource (carga paralela da cena); depois disso
+	// loadTexture devolve esta textura para o caminho
+	static GLuint loadTextureFromSource(const string& filepath, const TextureSource& source)
+	{
+		auto cached = loadedTextures.find(filepath);
+		if (cached != loadedTextures.end())
+			return cached->second;
+
+		GLuint texID = source.compressed ? createCompressedTexture(source.image) : createTexture(source.pixels.data(), source.width, source.height, source.channels);
+		if (texID != 0)
+			loadedTextures[filepath] = texID;
+		return texID;
+	}
+
+	// Inverte a imagem verticalmente (o glTF usa a origem das coordenadas de textura no topo)
+	static void flipRows(unsigned char* data, int width, int height, int nrChannels)
+	{
+		size_t rowSize = (size_t)width * nrChannels;
+		vector<unsigned char> row(rowSize);
+		for (int y = 0; y < height / 2; ++y) {
+			unsigned char* top = data + y * rowSize;
+			unsigned char* bottom = data + (height - 1 - y) * rowSize;
+			memcpy(row.data(), top, rowSize);
+			memcpy(top, bottom, rowSize);
+			memcpy(bottom, row.data(), rowSize);
+		}
+	}
+
+private:
+	inline static unordered_map<string, GLuint> loadedTextures;
+	inline static vector<GLint> supportedFormats;
+	inline static unordered_map<GLuint, size_t> textureSizes;
+};
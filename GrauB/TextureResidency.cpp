@@ -0,0 +1,430 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+#include <glad/glad.h>
+#include "../Common/include/stb_image.h"
+#include "TextureBaker.cpp"
+#include "UploadManager.cpp"
+#include "LinearArena.cpp"
+
+using namespace std;
+
+// Mantm as texturas de arquivo dentro de um oramento de memria de vdeo. Cada textura comea s com a cauda
+// de mipmaps (nveis de at tailSize pixels); os nveis maiores so carregados em segundo plano, um de cada vez,
+// quando o tamanho projetado dos objetos na tela pede mais resoluo. Se o oramento estoura, os nveis mais altos
+// das texturas que h mais tempo no precisam deles so descartados. GL_TEXTURE_BASE_LEVEL aponta sempre para o
+// maior nvel residente, ento a textura continua completa (e com o mesmo identificador) enquanto os nveis entram e saem.
+class TextureResidency
+{
+public:
+	// Gerenciador ativo (nullptr quando as texturas so carregadas inteiras)
+	inline static TextureResidency* current = nullptr;
+
+	TextureResidency(size_t budget = 64u << 20, int tailSize = 128) : budget(budget), tailSize(std::max(tailSize, 1)) {}
+
+	~TextureResidency()
+	{
+		{
+			lock_guard<mutex> lock(queueMutex);
+			stopping = true;
+		}
+		queueCondition.notify_all();
+		if (worker.joinable())
+			worker.join();
+		if (current == this)
+			current = nullptr;
+	}
+
+	TextureResidency(const TextureResidency&) = delete;
+	TextureResidency& operator=(const TextureResidency&) = delete;
+
+	void initialize()
+	{
+		worker = thread(&TextureResidency::decodeLoop, this);
+	}
+
+	// Cria a textura s com a cauda de mipmaps (carregada na hora,  pequena). Com "compressed", os nveis
+	// vm do cache KTX2 no formato indicado; sem compresso, a imagem  expandida para RGBA.
+	GLuint registerTexture(const string& filepath, bool compressed = false, TextureCompressor::Format format = TextureCompressor::BC1)
+	{
+		Entry entry;
+		int channels;
+		if (!TextureBaker::getImageInfo(filepath, entry.width, entry.height, channels)) {
+			std::cerr << "Falha ao carregar a textura: " << filepath << std::endl;
+			return 0;
+		}
+		entry.path = filepath;
+		entry.compressed = compressed;
+		entry.format = format;
+		entry.numLevels = 1;
+		while (getLevelWidth(entry, entry.numLevels - 1) > 1 || getLevelHeight(entry, entry.numLevels - 1) > 1)
+			++entry.numLevels;
+		entry.tailLevel = 0;
+		while (entry.tailLevel < entry.numLevels - 1 &&
+			std::max(getLevelWidth(entry, entry.tailLevel), getLevelHeight(entry, entry.tailLevel)) > tailSize)
+			++entry.tailLevel;
+
+		vector<vector<unsigned char>> tail;
+		if (!decodeLevels(entry.path, compressed, format, entry.numLevels, entry.tailLevel, entry.numLevels - 1, tail))
+			return 0;
+
+		GLuint texID;
+		glGenTextures(1, &texID);
+		glBindTexture(GL_TEXTURE_2D, texID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.tailLevel);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, entry.numLevels - 1);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		for (int level = entry.tailLevel; level < entry.numLevels; ++level)
+			defineLevel(texID, entry, level, tail[level - entry.tailLevel].data());
+
+		entry.residentLevel = entry.tailLevel;
+		entry.requiredLevel = entry.tailLevel;
+		residentBytes += getResidentBytes(entry);
+		textures[texID] = entry;
+		return texID;
+	}
+
+	// A textura foi apagada: esquece a entrada e descarta o nvel que estava chegando
+	void releaseTexture(GLuint texID)
+	{
+		auto texture = textures.find(texID);
+		if (texture == textures.end())
+			return;
+		Entry& entry = texture->second;
+		if (entry.load) {
+			entry.load->cancelled = true;
+			pendingBytes -= getLevelBytes(entry, entry.load->level);
+		}
+		residentBytes -= getResidentBytes(entry);
+		textures.erase(texture);
+	}
+
+	// Informa que a textura aparece neste quadro cobrindo cerca de "pixels" pixels na tela
+	void requestSize(GLuint texID, float pixels)
+	{
+		auto texture = textures.find(texID);
+		if (texture == textures.end())
+			return;
+		Entry& entry = texture->second;
+
+		int level = entry.tailLevel;
+		if (pixels > 0.0f) {
+			float texels = (float)std::max(entry.width, entry.height);
+			level = std::min(std::max((int)std::floor(std::log2(texels / pixels)), 0), entry.tailLevel);
+		}
+		entry.requiredLevel = entry.lastNeededFrame == frame ? std::min(entry.requiredLevel, level) : level;
+		entry.lastNeededFrame = frame;
+	}
+
+	// Chamado uma vez por quadro, depois dos pedidos de requestSize
+	void update()
+	{
+		finishLoads();
+
+		// Das texturas que mais precisam de resoluo para as que menos precisam
+		// A lista s vale neste quadro: fica na arena do quadro
+		ArenaScope frameScope(LinearArena::frame());
+		std::pmr::vector<pair<int, GLuint>> requests(frameScope.resource());
+		for (const auto& texture : textures) {
+			const Entry& entry = texture.second;
+			if (!entry.load && entry.lastNeededFrame == frame && entry.requiredLevel < entry.residentLevel)
+				requests.push_back({ entry.residentLevel - entry.requiredLevel, texture.first });
+		}
+		std::sort(requests.begin(), requests.end(), [](const pair<int, GLuint>& a, const pair<int, GLuint>& b) {
+			return a.first > b.first;
+		});
+		for (const auto& request : requests)
+			startLoad(request.second);
+
+		++frame;
+	}
+
+	size_t getResidentBytes() const
+	{
+		return residentBytes;
+	}
+
+	size_t getBudget() const
+	{
+		return budget;
+	}
+
+	int getPendingRequests() const
+	{
+		int pending = 0;
+		for (const auto& texture : textures)
+			if (texture.second.load)
+				++pending;
+		return pending;
+	}
+
+	int getEvictions() const
+	{
+		return evictions;
+	}
+
+	// Maior nvel de mipmap residente da textura (0  a resoluo completa)
+	int getResidentLevel(GLuint texID) const
+	{
+		auto texture = textures.find(texID);
+		return texture != textures.end() ? texture->second.residentLevel : -1;
+	}
+
+private:
+	// Um nvel sendo decodificado pela thread de apoio e depois enviado para a GPU
+	struct Load {
+		string path;
+		bool compressed = false;
+		TextureCompressor::Format format = TextureCompressor::BC1;
+		int numLevels = 0, level = 0;
+		vector<unsigned char> data;
+		shared_ptr<bool> uploaded = make_shared<bool>(false);
+		bool sent = false;
+		atomic<bool> decoded{ false }, failed{ false }, cancelled{ false };
+	};
+
+	struct Entry {
+		string path;
+		bool compressed = false;
+		TextureCompressor::Format format = TextureCompressor::BC1;
+		int width = 0, height = 0, numLevels = 0, tailLevel = 0;
+		int residentLevel = 0, requiredLevel = 0;
+		long long lastNeededFrame = -1;
+		shared_ptr<Load> load;
+	};
+
+	size_t budget, residentBytes = 0, pendingBytes = 0;
+	int tailSize, evictions = 0;
+	long long frame = 0;
+	unordered_map<GLuint, Entry> textures;
+
+	thread worker;
+	mutex queueMutex;
+	condition_variable queueCondition;
+	deque<shared_ptr<Load>> decodeQueue;
+	bool stopping = false;
+
+	static int getLevelWidth(const Entry& entry, int level)
+	{
+		return std::max(1, entry.width >> level);
+	}
+
+	static int getLevelHeight(const Entry& entry, int level)
+	{
+		return std::max(1, entry.height >> level);
+	}
+
+	static size_t getLevelBytes(const Entry& entry, int level)
+	{
+		int width = getLevelWidth(entry, level), height = getLevelHeight(entry, level);
+		return entry.compressed ? TextureCompressor::getCompressedSize(width, height, entry.format) : (size_t)width * height * 4;
+	}
+
+	static size_t getResidentBytes(const Entry& entry)
+	{
+		size_t bytes = 0;
+		for (int level = entry.residentLevel; level < entry.numLevels; ++level)
+			bytes += getLevelBytes(entry, level);
+		return bytes;
+	}
+
+	static GLenum getGLFormat(const Entry& entry)
+	{
+		return entry.compressed ? TextureBaker::getGLFormat(TextureBaker::getVkFormat(entry.format)) : GL_RGBA;
+	}
+
+	static void defineLevel(GLuint texID, const Entry& entry, int level, const unsigned char* data)
+	{
+		int width = getLevelWidth(entry, level), height = getLevelHeight(entry, level);
+		glBindTexture(GL_TEXTURE_2D, texID);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		if (entry.compressed)
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, getGLFormat(entry), width, height, 0, (GLsizei)getLevelBytes(entry, level), data);
+		else
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	static void setBaseLevel(GLuint texID, int level)
+	{
+		glBindTexture(GL_TEXTURE_2D, texID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	// Nveis firstLevel..lastLevel da imagem: do cache KTX2 ou decodificando e reduzindo a imagem na CPU
+	static bool decodeLevels(const string& path, bool compressed, TextureCompressor::Format format, int numLevels, int firstLevel, int lastLevel,
+		vector<vector<unsigned char>>& levels)
+	{
+		levels.clear();
+		if (compressed) {
+			CompressedImage image;
+			if (!TextureBaker::loadOrBake(path, format, image))
+				return false;
+			if ((int)image.levels.size() != numLevels) {
+				std::cerr << "Nmero de mipmaps inesperado no cache da textura: " << path << std::endl;
+				return false;
+			}
+			for (int level = firstLevel; level <= lastLevel; ++level)
+				levels.push_back(std::move(image.levels[level]));
+			return true;
+		}
+
+		int width, height, channels;
+		unsigned char* data = TextureBaker::loadImage(path, width, height, channels, 4);
+		if (data == nullptr) {
+			std::cerr << "Falha ao carregar a textura: " << path << std::endl;
+			return false;
+		}
+		vector<unsigned char> pixels(data, data + (size_t)width * height * 4);
+		stbi_image_free(data);
+
+		for (int level = 0; level <= lastLevel; ++level) {
+			if (level >= firstLevel)
+				levels.push_back(pixels);
+			if (level < lastLevel) {
+				pixels = TextureBaker::downsample(pixels, width, height);
+				width = std::max(1, width / 2);
+				height = std::max(1, height / 2);
+			}
+		}
+		return true;
+	}
+
+	void decodeLoop()
+	{
+		while (true) {
+			shared_ptr<Load> load;
+			{
+				unique_lock<mutex> lock(queueMutex);
+				queueCondition.wait(lock, [this] { return stopping || !decodeQueue.empty(); });
+				if (stopping)
+					return;
+				load = decodeQueue.front();
+				decodeQueue.pop_front();
+			}
+			if (!load->cancelled) {
+				vector<vector<unsigned char>> levels;
+				if (decodeLevels(load->path, load->compressed, load->format, load->numLevels, load->level, load->level, levels))
+					load->data = std::move(levels.front());
+				else
+					load->failed = true;
+			}
+			load->decoded = true;
+		}
+	}
+
+	// Envia os nveis j decodificados e passa a usar os que terminaram de chegar
+	void finishLoads()
+	{
+		for (auto& texture : textures) {
+			Entry& entry = texture.second;
+			if (!entry.load || !entry.load->decoded)
+				continue;
+
+			Load& load = *entry.load;
+			if (load.failed) {
+				// Fica com o que j tem; um novo pedido tenta de novo
+				pendingBytes -= getLevelBytes(entry, load.level);
+				entry.load.reset();
+				continue;
+			}
+			if (!load.sent) {
+				if (UploadManager::current != nullptr) {
+					UploadManager::current->streamTextureLevel(texture.first, load.level, getLevelWidth(entry, load.level),
+						getLevelHeight(entry, load.level), getGLFormat(entry), entry.compressed, std::move(load.data), load.uploaded);
+				}
+				else {
+					defineLevel(texture.first, entry, load.level, load.data.data());
+					*load.uploaded = true;
+				}
+				load.sent = true;
+			}
+			if (*load.uploaded) {
+				setBaseLevel(texture.first, load.level);
+				entry.residentLevel = load.level;
+				size_t bytes = getLevelBytes(entry, load.level);
+				pendingBytes -= bytes;
+				residentBytes += bytes;
+				entry.load.reset();
+			}
+		}
+	}
+
+	// Pede o prximo nvel acima do residente, abrindo espao no oramento se preciso
+	void startLoad(GLuint texID)
+	{
+		Entry& entry = textures[texID];
+		int level = entry.residentLevel - 1;
+		size_t bytes = getLevelBytes(entry, level);
+		if (!makeRoom(bytes, texID))
+			return;
+
+		auto load = make_shared<Load>();
+		load->path = entry.path;
+		load->compressed = entry.compressed;
+		load->format = entry.format;
+		load->numLevels = entry.numLevels;
+		load->level = level;
+		entry.load = load;
+		pendingBytes += bytes;
+		{
+			lock_guard<mutex> lock(queueMutex);
+			decodeQueue.push_back(load);
+		}
+		queueCondition.notify_one();
+	}
+
+	// Descarta nveis at caber "bytes" a mais: primeiro das texturas que h mais tempo no so necessrias,
+	// nunca a cauda e nunca um nvel que alguma textura esteja usando neste quadro
+	bool makeRoom(size_t bytes, GLuint requester)
+	{
+		while (residentBytes + pendingBytes + bytes > budget) {
+			GLuint victim = 0;
+			long long oldest = frame + 1;
+			for (const auto& texture : textures) {
+				const Entry& entry = texture.second;
+				bool surplus = entry.lastNeededFrame < frame || entry.requiredLevel > entry.residentLevel;
+				if (texture.first == requester || entry.load || entry.residentLevel >= entry.tailLevel || !surplus)
+					continue;
+				if (entry.lastNeededFrame < oldest) {
+					oldest = entry.lastNeededFrame;
+					victim = texture.first;
+				}
+			}
+			if (victim == 0)
+				return false;
+			evictLevel(victim);
+		}
+		return true;
+	}
+
+	// Sobe o nvel base e redefine o nvel antigo como vazio, o que devolve a memria dele ao driver
+	void evictLevel(GLuint texID)
+	{
+		Entry& entry = textures[texID];
+		int level = entry.residentLevel;
+		setBaseLevel(texID, level + 1);
+		glBindTexture(GL_TEXTURE_2D, texID);
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		residentBytes -= getLevelBytes(entry, level);
+		entry.residentLevel = level + 1;
+		++evictions;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+// Troca de dados entre uma thread que escreve e outra que l sem travas: a escrita preenche back() e publica,
+// a leitura pega a ltima verso publicada com acquire(). Cada lado fica com a sua cpia e a terceira fica no
+// meio, ento nenhum dos dois espera pelo outro; verses que a leitura no chegou a pegar so descartadas.
+template <typename T>
+class TripleBuffer
+{
+public:
+	// Cpia em que a escrita trabalha (s a thread que escreve)
+	T& back() {
+		return buffers[backIndex];
+	}
+
+	// Troca a cpia de escrita pela do meio, que passa a ser a verso mais nova
+	void publish() {
+		uint8_t previous = middle.exchange((uint8_t)(backIndex | fresh), memory_order_acq_rel);
+		backIndex = previous & indexMask;
+	}
+
+	// Pega a ltima verso publicada, se houver uma nova, e retorna a cpia de leitura (s a thread que l)
+	const T& acquire() {
+		if (middle.load(memory_order_relaxed) & fresh) {
+			uint8_t previous = middle.exchange(frontIndex, memory_order_acq_rel);
+			frontIndex = previous & indexMask;
+		}
+		return buffers[frontIndex];
+	}
+
+	// Cpia de leitura atual, sem procurar verso nova
+	const T& front() const {
+		return buffers[frontIndex];
+	}
+
+private:
+	static const uint8_t indexMask = 3, fresh = 4;
+
+	T buffers[3];
+	uint8_t backIndex = 0, frontIndex = 1;
+	// ndice da cpia do meio; o bit fresh indica que ela foi publicada e ainda no lida
+	alignas(64) atomic<uint8_t> middle{ 2 };
+};
\ No newline at end of file
@@ -0,0 +1,448 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <glad/glad.h>
+#include "../Common/include/stb_image.h"
+#include "TextureBaker.cpp"
+
+using namespace std;
+
+// Envia texturas e vrtices para a GPU aos poucos, sem travar o quadro. Uma thread decodifica as imagens;
+// a cada quadro a thread da OpenGL copia no mximo frameBudget bytes para um buffer circular de staging
+// (pixel buffer object) e dispara glTexSubImage2D / glCopyBufferSubData a partir dele. Cada trecho do anel
+// ganha uma fence e s  reutilizado depois que a GPU terminou de l-lo, ento nenhuma chamada espera a GPU.
+class UploadManager
+{
+public:
+	// Gerenciador ativo (nullptr quando o envio em segundo plano est desligado)
+	inline static UploadManager* current = nullptr;
+
+	UploadManager(size_t ringSize = 32u << 20, size_t frameBudget = 4u << 20) : ringSize(ringSize), frameBudget(frameBudget) {}
+
+	~UploadManager()
+	{
+		{
+			lock_guard<mutex> lock(queueMutex);
+			stopping = true;
+		}
+		queueCondition.notify_all();
+		if (worker.joinable())
+			worker.join();
+
+		for (const auto& region : regions)
+			glDeleteSync(region.fence);
+		if (ringBuffer != 0)
+			glDeleteBuffers(1, &ringBuffer);
+		if (current == this)
+			current = nullptr;
+	}
+
+	UploadManager(const UploadManager&) = delete;
+	UploadManager& operator=(const UploadManager&) = delete;
+
+	// Cria o anel de staging; precisa de um contexto OpenGL ativo
+	void initialize()
+	{
+		glGenBuffers(1, &ringBuffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ringBuffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, ringSize, nullptr, GL_STREAM_DRAW);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		worker = thread(&UploadManager::decodeLoop, this);
+	}
+
+	// Retorna na hora uma textura 1x1 cinza; a imagem  decodificada em segundo plano e enviada nos prximos quadros.
+	// Com "compressed", os nveis vm do cache KTX2 no formato indicado.
+	GLuint streamTexture(const string& filepath, bool compressed = false, TextureCompressor::Format format = TextureCompressor::BC1)
+	{
+		GLuint texID;
+		glGenTextures(1, &texID);
+		glBindTexture(GL_TEXTURE_2D, texID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		auto job = make_shared<Job>();
+		job->texture = texID;
+		job->path = filepath;
+		job->compressed = compressed;
+		job->compressedFormat = format;
+		jobs.push_back(job);
+		{
+			lock_guard<mutex> lock(queueMutex);
+			decodeQueue.push_back(job);
+		}
+		queueCondition.notify_one();
+		return texID;
+	}
+
+	// Copia "data" para o buffer (j alocado com glBufferData) a partir de "offset"; "done" vira true no fim
+	void streamBuffer(GLuint buffer, vector<unsigned char> data, shared_ptr<bool> done = nullptr, size_t offset = 0)
+	{
+		auto job = make_shared<Job>();
+		job->buffer = buffer;
+		job->bufferOffset = offset;
+		job->done = done;
+		job->levels.push_back({ (int)data.size(), 1, 0, false, std::move(data), 1, 1 });
+		job->decoded = true;
+		jobs.push_back(job);
+	}
+
+	// Envia um nico nvel de mipmap de uma textura que j existe; os outros nveis dela no so tocados.
+	// "format"  o formato do bloco (comprimido) ou dos pixels (GL_RED, GL_RGB, GL_RGBA).
+	void streamTextureLevel(GLuint texID, int level, int width, int height, GLenum format, bool compressed, vector<unsigned char> data,
+		shared_ptr<bool> done = nullptr)
+	{
+		auto job = make_shared<Job>();
+		job->texture = texID;
+		job->compressed = compressed;
+		job->firstLevel = level;
+		job->done = done;
+		size_t rowBytes = compressed ? data.size() / ((height + 3) / 4) : data.size() / height;
+		job->levels.push_back({ width, height, format, compressed, std::move(data), rowBytes, compressed ? 4 : 1 });
+		job->decoded = true;
+		jobs.push_back(job);
+	}
+
+	// A textura foi apagada antes de terminar de chegar: descarta o que falta
+	void cancelTexture(GLuint texID)
+	{
+		for (auto& job : jobs)
+			if (job->texture == texID)
+				job->cancelled = true;
+	}
+
+	// O mesmo para um buffer apagado antes de receber todos os dados
+	void cancelBuffer(GLuint buffer)
+	{
+		for (auto& job : jobs)
+			if (job->texture == 0 && job->buffer == buffer)
+				job->cancelled = true;
+	}
+
+	// Chamado uma vez por quadro na thread da OpenGL
+	void update()
+	{
+		retireFences();
+		bytesLastFrame = 0;
+
+		for (auto& job : jobs) {
+			if (job->cancelled || !job->decoded)
+				continue;
+			if (job->failed) {
+				job->cancelled = true;
+				continue;
+			}
+			if (!job->allocated)
+				allocateTexture(*job);
+			while (bytesLastFrame < frameBudget && !job->finished()) {
+				if (!uploadNextChunk(*job))
+					break;
+			}
+			if (job->finished())
+				completeJob(*job);
+			if (bytesLastFrame >= frameBudget)
+				break;
+		}
+
+		jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [](const shared_ptr<Job>& job) {
+			return job->cancelled || (job->decoded && job->finished());
+		}), jobs.end());
+	}
+
+	bool isIdle() const
+	{
+		return jobs.empty();
+	}
+
+	int getPendingRequests() const
+	{
+		return (int)jobs.size();
+	}
+
+	size_t getBytesLastFrame() const
+	{
+		return bytesLastFrame;
+	}
+
+	size_t getTotalBytes() const
+	{
+		return totalBytes;
+	}
+
+private:
+	// Um nvel de textura (ou o contedo de um buffer), enviado em blocos de linhas inteiras.
+	// Em formatos comprimidos cada "linha"  uma linha de blocos 4x4.
+	struct Level {
+		int width, height;
+		GLenum format;
+		bool compressed;
+		vector<unsigned char> data;
+		size_t rowBytes;
+		int rowHeight;
+	};
+
+	struct Job {
+		GLuint texture = 0, buffer = 0;
+		size_t bufferOffset = 0;
+		string path;
+		bool compressed = false;
+		TextureCompressor::Format compressedFormat = TextureCompressor::BC1;
+		vector<Level> levels;
+		// Nvel da textura onde levels[0] entra (-1: textura inteira, que ganha armazenamento novo)
+		int firstLevel = -1;
+		shared_ptr<bool> done;
+		size_t level = 0, position = 0;
+		bool allocated = false;
+		atomic<bool> decoded{ false }, failed{ false }, cancelled{ false };
+
+		bool finished() const {
+			return level >= levels.size();
+		}
+	};
+
+	// Trecho do anel ainda em uso pela GPU
+	struct Region {
+		size_t start, end;
+		GLsync fence;
+	};
+
+	size_t ringSize, frameBudget;
+	GLuint ringBuffer = 0;
+	size_t head = 0;
+	deque<Region> regions;
+	vector<shared_ptr<Job>> jobs;
+	size_t bytesLastFrame = 0, totalBytes = 0;
+
+	thread worker;
+	mutex queueMutex;
+	condition_variable queueCondition;
+	deque<shared_ptr<Job>> decodeQueue;
+	bool stopping = false;
+
+	void decodeLoop()
+	{
+		while (true) {
+			shared_ptr<Job> job;
+			{
+				unique_lock<mutex> lock(queueMutex);
+				queueCondition.wait(lock, [this] { return stopping || !decodeQueue.empty(); });
+				if (stopping)
+					return;
+				job = decodeQueue.front();
+				decodeQueue.pop_front();
+			}
+			if (!job->cancelled)
+				decode(*job);
+			job->decoded = true;
+		}
+	}
+
+	// Roda na thread de decodificao: s CPU, nenhuma chamada OpenGL
+	static void decode(Job& job)
+	{
+		if (job.compressed) {
+			CompressedImage image;
+			if (!TextureBaker::loadOrBake(job.path, job.compressedFormat, image)) {
+				job.failed = true;
+				return;
+			}
+			int blockSize = TextureCompressor::getBlockSize(job.compressedFormat);
+			int width = image.width, height = image.height;
+			for (auto& data : image.levels) {
+				size_t rowBytes = (size_t)((width + 3) / 4) * blockSize;
+				job.levels.push_back({ width, height, TextureBaker::getGLFormat(image.vkFormat), true, std::move(data), rowBytes, 4 });
+				width = std::max(1, width / 2);
+				height = std::max(1, height / 2);
+			}
+			return;
+		}
+
+		int width, height, channels;
+		unsigned char* pixels = TextureBaker::loadImage(job.path, width, height, channels);
+		if (pixels == nullptr || (channels != 1 && channels != 3 && channels != 4)) {
+			std::cerr << "Falha ao carregar a textura: " << job.path << std::endl;
+			if (pixels != nullptr)
+				stbi_image_free(pixels);
+			job.failed = true;
+			return;
+		}
+		GLenum format = channels == 1 ? GL_RED : channels == 3 ? GL_RGB : GL_RGBA;
+		job.levels.push_back({ width, height, format, false, vector<unsigned char>(pixels, pixels + (size_t)width * height * channels),
+			(size_t)width * channels, 1 });
+		stbi_image_free(pixels);
+	}
+
+	// Troca o 1x1 provisrio pelo armazenamento com o tamanho final (sem dados: eles chegam pelo anel)
+	void allocateTexture(Job& job)
+	{
+		job.allocated = true;
+		if (job.texture == 0)
+			return;
+
+		glBindTexture(GL_TEXTURE_2D, job.texture);
+		if (job.firstLevel >= 0) {
+			const Level& data = job.levels.front();
+			if (data.compressed)
+				glCompressedTexImage2D(GL_TEXTURE_2D, job.firstLevel, data.format, data.width, data.height, 0, (GLsizei)data.data.size(), nullptr);
+			else
+				glTexImage2D(GL_TEXTURE_2D, job.firstLevel, data.format, data.width, data.height, 0, data.format, GL_UNSIGNED_BYTE, nullptr);
+		}
+		// O armazenamento novo comea sem dados: at completeJob a textura mostra s o ltimo nvel (1x1), que j
+		// chega preenchido, em vez de deixar a GPU ler os nveis maiores pela metade
+		else if (job.compressed) {
+			GLint last = (GLint)job.levels.size() - 1;
+			for (GLint level = 0; level < last; ++level) {
+				const Level& data = job.levels[level];
+				glCompressedTexImage2D(GL_TEXTURE_2D, level, data.format, data.width, data.height, 0, (GLsizei)data.data.size(), nullptr);
+			}
+			const Level& tail = job.levels.back();
+			glCompressedTexImage2D(GL_TEXTURE_2D, last, tail.format, tail.width, tail.height, 0, (GLsizei)tail.data.size(), tail.data.data());
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, last);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, last);
+			job.levels.pop_back();
+		}
+		else {
+			const Level& data = job.levels.front();
+			glTexImage2D(GL_TEXTURE_2D, 0, data.format, data.width, data.height, 0, data.format, GL_UNSIGNED_BYTE, nullptr);
+			// Cinza no nvel 1x1 com o mesmo formato; os nveis do meio so gerados no fim
+			GLint last = 0;
+			while (std::max(data.width, data.height) >> last > 1)
+				++last;
+			const unsigned char gray[4] = { 128, 128, 128, 255 };
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexImage2D(GL_TEXTURE_2D, last, data.format, 1, 1, 0, data.format, GL_UNSIGNED_BYTE, gray);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, last);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, last);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	// Copia o prximo bloco de linhas do nvel atual para o anel e agenda a cpia para a textura ou buffer
+	bool uploadNextChunk(Job& job)
+	{
+		Level& level = job.levels[job.level];
+		size_t remaining = level.data.size() - job.position;
+		size_t rows = std::max<size_t>(1, std::min(remaining, frameBudget - std::min(bytesLastFrame, frameBudget)) / level.rowBytes);
+		size_t bytes = std::min(remaining, rows * level.rowBytes);
+		bytes = std::min(bytes, std::max<size_t>(1, ringSize / 2 / level.rowBytes) * level.rowBytes);
+
+		size_t offset;
+		if (!allocate(bytes, offset))
+			return false;
+
+		GLenum target = job.texture != 0 ? GL_PIXEL_UNPACK_BUFFER : GL_COPY_READ_BUFFER;
+		glBindBuffer(target, ringBuffer);
+		void* mapped = glMapBufferRange(target, offset, bytes, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+		if (mapped == nullptr) {
+			glBindBuffer(target, 0);
+			return false;
+		}
+		memcpy(mapped, level.data.data() + job.position, bytes);
+		glUnmapBuffer(target);
+
+		if (job.texture != 0) {
+			GLint textureLevel = (GLint)(std::max(job.firstLevel, 0) + job.level);
+			int firstRow = (int)(job.position / level.rowBytes) * level.rowHeight;
+			int numRows = std::min((int)((bytes + level.rowBytes - 1) / level.rowBytes) * level.rowHeight, level.height - firstRow);
+			glBindTexture(GL_TEXTURE_2D, job.texture);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			if (level.compressed)
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, textureLevel, 0, firstRow, level.width, numRows, level.format, (GLsizei)bytes, (GLvoid*)offset);
+			else
+				glTexSubImage2D(GL_TEXTURE_2D, textureLevel, 0, firstRow, level.width, numRows, level.format, GL_UNSIGNED_BYTE, (GLvoid*)offset);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+		else {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, job.buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, job.bufferOffset + job.position, bytes);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+		glBindBuffer(target, 0);
+
+		regions.push_back({ offset, offset + bytes, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+		bytesLastFrame += bytes;
+		totalBytes += bytes;
+
+		job.position += bytes;
+		if (job.position >= level.data.size()) {
+			vector<unsigned char>().swap(level.data);
+			job.position = 0;
+			++job.level;
+		}
+		return true;
+	}
+
+	void completeJob(Job& job)
+	{
+		// Textura inteira: libera os nveis que acabaram de chegar (allocateTexture tirou o ltimo de job.levels)
+		if (job.texture != 0 && job.firstLevel < 0) {
+			glBindTexture(GL_TEXTURE_2D, job.texture);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+			if (job.compressed) {
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)job.levels.size());
+			}
+			else {
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+				glGenerateMipmap(GL_TEXTURE_2D);
+			}
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+		if (job.done)
+			*job.done = true;
+	}
+
+	// Libera os trechos do anel cujas fences a GPU j passou (sem esperar pelas demais)
+	void retireFences()
+	{
+		while (!regions.empty()) {
+			GLenum status = glClientWaitSync(regions.front().fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+				break;
+			glDeleteSync(regions.front().fence);
+			regions.pop_front();
+		}
+	}
+
+	// Reserva "bytes" contguos no anel; falha (sem bloquear) se a GPU ainda est lendo o espao necessrio
+	bool allocate(size_t bytes, size_t& offset)
+	{
+		if (regions.empty()) {
+			if (bytes > ringSize)
+				return false;
+			offset = 0;
+			head = bytes;
+			return true;
+		}
+
+		size_t tail = regions.front().start;
+		if (head > tail) {
+			if (head + bytes <= ringSize)
+				offset = head;
+			else if (bytes < tail)
+				offset = 0;
+			else
+				return false;
+		}
+		else if (head + bytes < tail) {
+			offset = head;
+		}
+		else {
+			return false;
+		}
+		head = offset + bytes;
+		return true;
+	}
+};
\ No newline at end of file
@@ -3,21 +3,37 @@ layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 color;
 layout (location = 2) in vec2 tex_coord;
 layout (location = 3) in vec3 normal;
+// Atributos por instncia, usados s no desenho instanciado (ocupam as posies 4 a 8)
+layout (location = 4) in mat4 instance_model;
+layout (location = 8) in float instance_layer;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+// Escala (xy) e deslocamento (zw) da textura dentro do atlas
+uniform vec4 uv_transform;
+// Camada da textura de array (-1 usa tex_buffer); no desenho instanciado vem de instance_layer
+uniform int texture_layer;
+uniform bool instanced;
 
 out vec2 tex_coord_shader;
 out vec3 final_color;
 out vec3 frag_pos;
 out vec3 scaled_normal;
+// Distncia ao plano da cmera, para a fatia dos aglomerados de luzes
+out float view_depth;
+flat out int layer_shader;
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(position, 1.0);
-    tex_coord_shader = vec2(tex_coord.x, 1 - tex_coord.y);
+	mat4 world = instanced ? instance_model : model;
+	vec4 world_pos = world * vec4(position, 1.0);
+	vec4 eye_pos = view * world_pos;
+	gl_Position = projection * eye_pos;
+    tex_coord_shader = vec2(tex_coord.x, 1 - tex_coord.y) * uv_transform.xy + uv_transform.zw;
 	final_color = color;
-	frag_pos = vec3(model * vec4(position, 1.0));
-	scaled_normal = vec3(model * vec4(normal, 1.0));
+	frag_pos = vec3(world_pos);
+	view_depth = -eye_pos.z;
+	scaled_normal = mat3(world) * normal;
+	layer_shader = instanced ? int(instance_layer) : texture_layer;
 }
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+#include "MappedFile.cpp"
+#include "AssetPack.cpp"
+
+using namespace std;
+
+// Sistema de arquivos dos assets: com um pacote montado, os caminhos so procurados primeiro nele e s
+// depois no disco. Entradas sem compresso so lidas direto da memria mapeada do pacote; as comprimidas
+// so descomprimidas s quando abertas, na thread que as abre (na carga da cena, as tarefas do JobSystem).
+// O buffer descomprimido pertence ao VirtualFile que abriu a entrada e  liberado com ele.
+class VirtualFileSystem
+{
+public:
+	static bool mount(const string& packPath) {
+		unmount();
+		auto newPack = make_unique<AssetPack>();
+		if (!newPack->open(packPath))
+			return false;
+		pack = std::move(newPack);
+		return true;
+	}
+
+	static void unmount() {
+		pack.reset();
+	}
+
+	static bool isMounted() {
+		return pack != nullptr;
+	}
+
+	static int getNumPackedFiles() {
+		return pack ? pack->size() : 0;
+	}
+
+	// O caminho est no pacote montado (e no ser lido do disco)
+	static bool isPacked(const string& path) {
+		return pack && pack->find(AssetPack::normalizePath(path)) >= 0;
+	}
+
+	static bool exists(const string& path) {
+		if (isPacked(path))
+			return true;
+		std::error_code error;
+		return std::filesystem::exists(path, error);
+	}
+
+	// Entrada do pacote: "data" aponta para a memria mapeada (sem compresso) ou para "owned" (descomprimida)
+	static bool openPacked(const string& path, const unsigned char*& data, size_t& size, shared_ptr<vector<unsigned char>>& owned) {
+		if (!pack)
+			return false;
+		int index = pack->find(AssetPack::normalizePath(path));
+		if (index < 0)
+			return false;
+
+		size = pack->getSize(index);
+		if (!pack->isCompressed(index)) {
+			data = pack->getStoredData(index);
+			return true;
+		}
+
+		owned = make_shared<vector<unsigned char>>();
+		if (!pack->decompress(index, *owned)) {
+			owned.reset();
+			return false;
+		}
+		data = owned->data();
+		return true;
+	}
+
+private:
+	inline static unique_ptr<AssetPack> pack;
+};
+
+// Arquivo aberto pelo VirtualFileSystem, com a mesma interface do MappedFile: vem do pacote montado
+// ou, se no estiver nele,  mapeado do disco
+class VirtualFile
+{
+public:
+	VirtualFile() {}
+
+	VirtualFile(const string& filepath)
+	{
+		open(filepath);
+	}
+
+	VirtualFile(const VirtualFile&) = delete;
+	VirtualFile& operator=(const VirtualFile&) = delete;
+
+	bool open(const string& filepath)
+	{
+		close();
+		if (VirtualFileSystem::openPacked(filepath, bytes, length, decompressed)) {
+			packed = opened = true;
+			return true;
+		}
+
+		looseFile = make_unique<MappedFile>();
+		if (!looseFile->open(filepath)) {
+			looseFile.reset();
+			return false;
+		}
+		bytes = looseFile->data();
+		length = looseFile->size();
+		opened = true;
+		return true;
+	}
+
+	void close()
+	{
+		looseFile.reset();
+		decompressed.reset();
+		bytes = nullptr;
+		length = 0;
+		opened = packed = false;
+	}
+
+	bool isOpen() const {
+		return opened;
+	}
+
+	// Veio do pacote de assets (e no de um arquivo solto)
+	bool isPacked() const {
+		return packed;
+	}
+
+	const unsigned char* data() const {
+		return bytes;
+	}
+
+	size_t size() const {
+		return length;
+	}
+
+	string toString() const {
+		return string((const char*)bytes, length);
+	}
+
+private:
+	const unsigned char* bytes = nullptr;
+	size_t length = 0;
+	bool opened = false, packed = false;
+	unique_ptr<MappedFile> looseFile;
+	shared_ptr<vector<unsigned char>> decompressed;
+};
\ No newline at end of file